@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "rsl.h"
 #include "africa.h"
 
 int africa_read_buffer(FILE *fp, Africa_buffer *buffer)
@@ -98,7 +99,7 @@ Africa_sweep *africa_read_sweep(FILE *fp)
    * when this is the first ray.  This is a
    * read-ahead buffer.
    */
-  static Africa_buffer *buf = NULL; /* The read ahead buffer, too. */
+  static RSL_THREAD_LOCAL Africa_buffer *buf = NULL; /* The read ahead buffer, too. */
   Africa_sweep *sweep = NULL;
   int cur_elev, ielev, iray;
   Africa_ray *ray = NULL;
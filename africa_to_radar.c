@@ -47,7 +47,6 @@ static void ymd(int jday, int year, int *mm, int *dd)
   *dd = jday - daytab[leap][i];
 }
 
-extern int radar_verbose_flag;
 
 Radar *RSL_africa_to_radar(char *infile)  
 {
@@ -83,9 +82,11 @@ Radar *RSL_africa_to_radar(char *infile)
   for(i=0; (sweep = africa_read_sweep(fp)); i++) {
 
 	/* Load the sweep into the radar volume */
+	if (RSL_reserve_sweeps(v, i+1) != 0) break;
+	if (v->h.nsweeps <= i) v->h.nsweeps = i+1;
 	v->sweep[i] = RSL_new_sweep((int)sweep->nrays);
 	s = v->sweep[i];
-	if (radar_verbose_flag) printf("NUMBER OF RAYS: %d\n", sweep->nrays);
+	if (rsl_verbose()) printf("NUMBER OF RAYS: %d\n", sweep->nrays);
 	for (n=0; n < sweep->nrays; n++) {
 	  ray = sweep->ray[n];
 	  if (ray == NULL) continue;
@@ -159,5 +160,5 @@ Radar *RSL_africa_to_radar(char *infile)
   sprintf(radar->h.country, "South Africa");
 
   radar_load_date_time(radar);
-  return radar;
+  return RSL_shrink_radar(radar);
 }
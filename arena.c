@@ -0,0 +1,208 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Ray arenas.
+ *
+ * Between RSL_arena_begin and RSL_arena_end, RSL_new_ray on the calling
+ * thread carves the Ray and its range array out of large chunks instead
+ * of calling calloc twice.  The chunks form one Rsl_block, which every
+ * ray allocated from it references; RSL_free_ray only drops the
+ * reference, and the chunks are freed together with the last ray.
+ *
+ * Memory of rays freed early, e.g. by RSL_prune_radar, is not reused;
+ * it is returned when the whole arena is.  Returned chunks are kept,
+ * zeroed, for the next arena, up to RSL_ARENA_CACHE bytes, so reading
+ * file after file does not go back to the system for memory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "rsl.h"
+
+#define RSL_ARENA_CHUNK (1024*1024)     /* Bytes. */
+#define RSL_ARENA_CACHE (64*1024*1024)  /* Bytes of free chunks kept. */
+#define RSL_ARENA_ALIGN 16
+
+typedef struct _rsl_arena_chunk {
+  struct _rsl_arena_chunk *next;
+  size_t len;    /* Bytes of data. */
+  size_t used;
+} Rsl_arena_chunk;
+
+#define ARENA_ROUND(n) (((n) + RSL_ARENA_ALIGN-1) & ~(size_t)(RSL_ARENA_ALIGN-1))
+#define ARENA_DATA(c)  ((char *)(c) + ARENA_ROUND(sizeof(Rsl_arena_chunk)))
+
+typedef struct _rsl_arena {
+  Rsl_block *block;        /* Referenced by each ray, and by the binding. */
+  Rsl_arena_chunk *chunk;  /* Being filled.  Older chunks follow 'next'. */
+  struct _rsl_arena *prev; /* Bound before RSL_arena_begin. */
+} Rsl_arena;
+
+static RSL_THREAD_LOCAL Rsl_arena *rsl_arena = NULL;
+
+/* Free chunks of RSL_ARENA_CHUNK bytes.  Arenas are released on any
+ * thread, hence the lock.
+ */
+static Rsl_arena_chunk *arena_cache = NULL;
+static size_t arena_cached = 0;
+static pthread_mutex_t arena_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static Rsl_arena_chunk *arena_new_chunk(size_t len)
+{
+  Rsl_arena_chunk *c = NULL;
+
+  if (len == RSL_ARENA_CHUNK) {
+	pthread_mutex_lock(&arena_cache_lock);
+	if ((c = arena_cache) != NULL) {
+	  arena_cache = c->next;
+	  arena_cached -= len;
+	}
+	pthread_mutex_unlock(&arena_cache_lock);
+  }
+  if (c == NULL) {
+	c = (Rsl_arena_chunk *)calloc(1, ARENA_ROUND(sizeof(Rsl_arena_chunk)) + len);
+	if (c == NULL) return NULL;
+	c->len = len;
+  }
+  c->next = NULL;
+  return c;
+}
+
+static void arena_release(Rsl_block *b)
+{
+  Rsl_arena *a = (Rsl_arena *)b->addr;
+  Rsl_arena_chunk *c, *next;
+  int keep;
+
+  for (c = a->chunk; c; c = next) {
+	next = c->next;
+	keep = 0;
+	if (c->len == RSL_ARENA_CHUNK) {
+	  /* Claim room in the cache, then clear the chunk unlocked. */
+	  pthread_mutex_lock(&arena_cache_lock);
+	  if (arena_cached < RSL_ARENA_CACHE) {
+		arena_cached += c->len;
+		keep = 1;
+	  }
+	  pthread_mutex_unlock(&arena_cache_lock);
+	}
+	if (!keep) {
+	  free(c);
+	  continue;
+	}
+	memset(ARENA_DATA(c), 0, c->used);
+	c->used = 0;
+	pthread_mutex_lock(&arena_cache_lock);
+	c->next = arena_cache;
+	arena_cache = c;
+	pthread_mutex_unlock(&arena_cache_lock);
+  }
+  free(a);
+}
+
+static void *arena_alloc(Rsl_arena *a, size_t n)
+{
+  /* Zeroed memory, like calloc. */
+  Rsl_arena_chunk *c;
+  size_t len;
+  void *p;
+
+  n = ARENA_ROUND(n);
+  c = a->chunk;
+  if (c == NULL || c->used + n > c->len) {
+	len = n > RSL_ARENA_CHUNK/4 ? n : RSL_ARENA_CHUNK;
+	if ((c = arena_new_chunk(len)) == NULL) return NULL;
+	if (n > RSL_ARENA_CHUNK/4 && a->chunk) {
+	  /* A chunk of its own; keep filling the current one. */
+	  c->next = a->chunk->next;
+	  a->chunk->next = c;
+	} else {
+	  c->next = a->chunk;
+	  a->chunk = c;
+	}
+	a->block->len += len;
+  }
+  p = ARENA_DATA(c) + c->used;
+  c->used += n;
+  return p;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                  RSL_arena_begin, RSL_arena_end                    */
+/*                                                                    */
+/*  Calls nest: RSL_arena_end goes back to the arena, if any, that    */
+/*  was in use at the matching RSL_arena_begin.                       */
+/*                                                                    */
+/**********************************************************************/
+void RSL_arena_begin(void)
+{
+  Rsl_arena *a;
+
+  a = (Rsl_arena *)calloc(1, sizeof(Rsl_arena));
+  if (a == NULL) {
+	perror("RSL_arena_begin");
+	return;
+  }
+  if ((a->block = rsl_new_block(a, 0, arena_release)) == NULL) {
+	free(a);
+	return;
+  }
+  a->block->holds_rays = 1;
+  a->prev = rsl_arena;
+  rsl_arena = a;
+}
+
+void RSL_arena_end(void)
+{
+  Rsl_arena *a;
+
+  if ((a = rsl_arena) == NULL) return;
+  rsl_arena = a->prev;
+  rsl_block_unref(a->block); /* The rays, if any, hold it now. */
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        rsl_arena_new_ray                           */
+/*                                                                    */
+/*  RSL_new_ray from the arena bound to this thread.  NULL when there */
+/*  is none.                                                          */
+/*                                                                    */
+/**********************************************************************/
+Ray *rsl_arena_new_ray(int max_bins)
+{
+  Rsl_arena *a;
+  Ray *r;
+
+  if ((a = rsl_arena) == NULL || max_bins < 0) return NULL;
+  r = (Ray *)arena_alloc(a, ARENA_ROUND(sizeof(Ray)) + max_bins*sizeof(Range));
+  if (r == NULL) return NULL;
+  r->range = (Range *)((char *)r + ARENA_ROUND(sizeof(Ray)));
+  r->block = a->block;
+  rsl_block_ref(a->block);
+  r->h.nbins = max_bins; /* A default setting. */
+  return r;
+}
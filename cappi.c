@@ -29,7 +29,6 @@
 #include <math.h>
 #include "rsl.h"
 
-extern int radar_verbose_flag;
 
 
 /*********************************************************************/
@@ -143,6 +142,114 @@ Cappi *RSL_cappi_at_h(Volume  *v, float height, float max_range)
    }
 
  
+/*********************************************************************/
+/*                                                                   */
+/*                        cappi_source_rays                          */
+/*                                                                   */
+/*********************************************************************/
+Ray **cappi_source_rays(Volume *v, Sweep *sweep)
+{
+  /* For each sweep of v, the rays closest to the rays of 'sweep', as
+   * RSL_get_ray_from_sweep finds them:  src[i*sweep->h.nrays + a] is
+   * for v->sweep[i] and sweep->ray[a].  They do not depend on height,
+   * so they serve every Cappi made from 'sweep'.  Free with free().
+   */
+  Ray **src;
+  int i, a, nrays;
+
+  if (v == NULL || sweep == NULL) return NULL;
+  nrays = sweep->h.nrays;
+  src = (Ray **)calloc(v->h.nsweeps*nrays + 1, sizeof(Ray *));
+  if (src == NULL) {
+	perror("cappi_source_rays");
+	return NULL;
+  }
+  for (i=0; i<v->h.nsweeps; i++) {
+	if (v->sweep[i] == NULL) continue;
+	for (a=0; a<nrays; a++)
+	  if (sweep->ray[a])
+		src[i*nrays + a] = RSL_get_ray_from_sweep(v->sweep[i],
+												  sweep->ray[a]->h.azimuth);
+  }
+  return src;
+}
+
+static int cappi_sweep_index(Volume *v, float elev)
+{
+  /* Index of the sweep RSL_get_sweep(v, elev) returns, or -1. */
+  int i, ci;
+  float delta_angle;
+
+  for (i=0; i<v->h.nsweeps && v->sweep[i] == NULL; i++);
+  if (i == v->h.nsweeps) return -1;
+  ci = get_closest_sweep_index(v, elev);
+  if (ci < 0 || v->sweep[ci] == NULL) return -1;
+  delta_angle = fabs((double)(v->sweep[ci]->h.elev - elev));
+  if (delta_angle <= v->sweep[i]->h.vert_half_bw) return ci;
+  return -1;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                        cappi_fill                                 */
+/*                                                                   */
+/*********************************************************************/
+int cappi_fill(Volume *v, Cappi *cap, int method, Ray **src)
+{
+  /* RSL_fill_cappi, given src = cappi_source_rays(v, cap->sweep), or
+   * of a sweep with the same rays.  The sweep for each bin is found
+   * once, rather than once per ray.
+   */
+  int a,b,nrays,nbins;
+  float x;
+  Ray *ray;
+  Sweep *sweep;
+  int *sweep_index;
+
+  if (v == NULL) return(-1);
+  if (cap == NULL) return(-1);
+  if (src == NULL) return(-1);
+
+  /* get data from frist ray. */
+  ray = RSL_get_first_ray_of_volume(v);
+  cap->month = ray->h.month;
+  cap->day        = ray->h.day;
+  cap->year       = ray->h.year;
+  cap->hour       = ray->h.hour;
+  cap->minute     = ray->h.minute;
+  cap->sec        = ray->h.sec;
+  cap->field_type = 1; /** default setting  -- PAK **/
+  cap->interp_method = method;    /* ?? nearest neighbor */
+
+  sweep = cap->sweep;
+  nrays = sweep->h.nrays;
+  ray = RSL_get_first_ray_of_sweep(sweep);
+  if (ray == NULL) return 1;
+  nbins = ray->h.nbins; /* The length of cap->loc; see RSL_new_cappi. */
+  if ((sweep_index = (int *)malloc(nbins * sizeof(int))) == NULL) {
+	perror("cappi_fill");
+	return(-1);
+  }
+  for(b=0; b < nbins; b++)
+	sweep_index[b] = cappi_sweep_index(v, cap->loc[b].elev);
+
+  for(a=0;a < nrays; a++)
+	{
+	ray = sweep->ray[a];
+	if (ray == NULL) continue;
+	for(b=0; b < ray->h.nbins && b < nbins; b++)
+	  {
+	  if (sweep_index[b] < 0) x = BADVAL;
+	  else x = RSL_get_value_from_ray(src[sweep_index[b]*nrays + a],
+									  cap->loc[b].srange);
+	  ray->range[b] = ray->h.invf(x);
+	  }
+	}
+
+  free(sweep_index);
+  return 1;
+}
+
 /*********************************************************************/
 /*                                                                   */
 /*                        RSL_fill_cappi                             */
@@ -150,43 +257,15 @@ Cappi *RSL_cappi_at_h(Volume  *v, float height, float max_range)
 /*********************************************************************/
 int RSL_fill_cappi(Volume *v, Cappi *cap, int method)
    {
-   int a,b;
-   float x;
-   Ray *ray;
-   Sweep *sweep;
+   Ray **src;
+   int n;
    
    if (v == NULL) return(-1);
    if (cap == NULL) return(-1);
 
-   /* get data from frist ray. */
-   ray = RSL_get_first_ray_of_volume(v);
-   cap->month = ray->h.month;
-   cap->day        = ray->h.day;
-   cap->year       = ray->h.year;
-   cap->hour       = ray->h.hour;
-   cap->minute     = ray->h.minute;
-   cap->sec        = ray->h.sec;
-   cap->field_type = 1; /** default setting  -- PAK **/
-   cap->interp_method = method;    /* ?? nearest neighbor */
-   
-   ray = RSL_get_first_ray_of_sweep(cap->sweep);
-   sweep = cap->sweep;
-   for(a=0;a < sweep->h.nrays; a++)
-      {
-      ray = sweep->ray[a];
-      for(b=0; b < ray->h.nbins; b++)
-         {
-         x = RSL_get_value(v,
-                           cap->loc[b].elev,
-                           cap->sweep->ray[a]->h.azimuth,
-                           cap->loc[b].srange);
-		   
-         ray->range[b] = ray->h.invf(x);
-         }
-      }
+   if ((src = cappi_source_rays(v, cap->sweep)) == NULL) return(-1);
+   n = cappi_fill(v, cap, method, src);
+   free(src);
 
-   return 1;
+   return n;
    }
-
-
-
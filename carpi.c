@@ -35,7 +35,6 @@
 #define RAD2DEG 57.29578 /* radian to degree conversion */
 #define MAXRAYS 512      /* loop safety valve when traversing a sweep */
 
-extern int radar_verbose_flag;
 
 
 /*************************************************************/
@@ -159,54 +158,43 @@ void RSL_find_rng_azm(float *r, float *ang, float x, float y)
 
 /*************************************************************/
 /*                                                           */
-/*                     RSL_cappi_to_carpi                    */
+/*                          carpi_map                        */
 /*                                                           */
 /*************************************************************/
-Carpi *RSL_cappi_to_carpi(Cappi *cappi, float dx, float dy, float lat,
-						  float lon, int nx, int ny, int radar_x, int radar_y)
-   /****** Simple and straightforward algorithm: 
-	  Divide each of the nx*ny carpi cells into scx*scy subcells. 
-	  Find the data value for each subcell from the cappi rays.
-	  Average the subcell data values over a cell to obtain the cell value.
-	  Store the cell value into the 2_D carpi array.
-	  ********/
+#define CARPI_NODATA  -1 /* Subcell value is BADVAL. */
+#define CARPI_OUTSIDE -2 /* Whole cell lies outside the data range. */
+
+static int range_bin_of_ray(Ray *ray, float r)
 {
-	Carpi *carpi;
-	Ray *first_ray;
-	int row, col, j, k, m, n, scx, scy, valid_subcells;
-	float x, y, rng, azm, cell, cell_diag, gate_size;
-	float carpi_max_rng, radar_max_rng;
-	float subcell[3][3];  /* Maximum of 9 subcells per carpi cell*/
-   
-	if (cappi == NULL) return NULL;
-	if (cappi->sweep == NULL) return NULL;
-	first_ray = RSL_get_first_ray_of_sweep(cappi->sweep);
-	if (first_ray == NULL) return NULL; /* No data. */
+	/* The bin RSL_get_value_from_ray(ray, r) reads, or -1. */
+	int bin_index;
+	float rm;
 
-	if (radar_verbose_flag) fprintf(stderr,"\nCreating carpi...\n");
+	rm = r * 1000;
+	if (ray == NULL) return -1;
+	if (ray->h.gate_size == 0) return -1;
+	bin_index = (int)(((rm - ray->h.range_bin1)/ray->h.gate_size) + 0.5);
+	if (bin_index >= ray->h.nbins || bin_index < 0) return -1;
+	return bin_index;
+}
 
-	/* Allcate space for a carpi, and fill in its values. */
-	carpi = RSL_new_carpi(ny, nx);
-	carpi->month = cappi->month;
-	carpi->day = cappi->day;
-	carpi->year = cappi->year;
-	carpi->hour = cappi->hour;
-	carpi->minute = cappi->minute;
-	carpi->sec = cappi->sec;
-	carpi->dx = dx;
-	carpi->dy = dy;
-	carpi->nx = nx;
-	carpi->ny = ny;
-	carpi->radar_x = radar_x;
-	carpi->radar_y = radar_y;
-	carpi->height = cappi->height;
-	carpi->lat = lat;
-	carpi->lon = lon;
-	strncpy(carpi->radar_type, cappi->radar_type, sizeof(cappi->radar_type));
-	carpi->field_type    = cappi->field_type;
-	carpi->interp_method = cappi->interp_method;
-	carpi->f = first_ray->h.f;
-	carpi->invf = first_ray->h.invf;
+Carpi_map *carpi_map(Sweep *sweep, float dx, float dy, int nx, int ny,
+					 int radar_x, int radar_y)
+	/* Locate, in 'sweep', the ray and bin of every carpi subcell.  These
+	 * are the same in every Cappi whose sweep is a copy of 'sweep'.
+	 */
+{
+	Carpi_map *map;
+	Ray *first_ray, *ray;
+	Hash_table *hash_table;
+	int *ray_index;
+	int row, col, k, m, n, scx, scy, bin, *gate;
+	float x, y, rng, azm, cell_diag, gate_size;
+	float carpi_max_rng, radar_max_rng;
+
+	if (sweep == NULL) return NULL;
+	first_ray = RSL_get_first_ray_of_sweep(sweep);
+	if (first_ray == NULL) return NULL; /* No data. */
 
 	gate_size = first_ray->h.gate_size / 1000.0;  /* km */
 	cell_diag = sqrt(dx*dx + dy*dy);   
@@ -237,14 +225,51 @@ Carpi *RSL_cappi_to_carpi(Cappi *cappi, float dx, float dy, float lat,
 	if (radar_max_rng < carpi_max_rng)
 	  carpi_max_rng = radar_max_rng;
 	
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"carpi_max_rng:%.1f(km) beam_width:%.1f gate_size:%d(m)\n",
-						carpi_max_rng, cappi->sweep->h.beam_width, first_ray->h.gate_size);
+						carpi_max_rng, sweep->h.beam_width, first_ray->h.gate_size);
+
+	map = (Carpi_map *)calloc(1, sizeof(Carpi_map));
+	if (map == NULL) {
+		perror("carpi_map");
+		return NULL;
+	}
+	map->gate = (int *)malloc((size_t)nx*ny*scx*scy * sizeof(int) + 1);
+	ray_index = (int *)malloc((sweep->h.nrays + 1) * sizeof(int));
+	/* A table of our own, not sweep->hash, which may be older than
+	 * sweep->ray.
+	 */
+	hash_table = construct_sweep_hash_table(sweep);
+	if (map->gate == NULL || ray_index == NULL || hash_table == NULL) {
+		perror("carpi_map");
+		FREE_HASH_TABLE(hash_table);
+		free(ray_index);
+		free(map->gate);
+		free(map);
+		return NULL;
+	}
+	map->dx = dx;
+	map->dy = dy;
+	map->nx = nx;
+	map->ny = ny;
+	map->radar_x = radar_x;
+	map->radar_y = radar_y;
+	map->scx = scx;
+	map->scy = scy;
+	map->stride = 0;
+	for (k=0; k<hash_table->nrays; k++) ray_index[k] = -1;
+	for (k=0; k<sweep->h.nrays; k++) {
+		if (sweep->ray[k] == NULL) continue;
+		ray_index[hash_find_ray(hash_table, sweep->ray[k])] = k;
+		if (sweep->ray[k]->h.nbins > map->stride)
+			map->stride = sweep->ray[k]->h.nbins;
+	}
 
 	/* For each cell (row,col) comprising the carpi...*/
+	gate = map->gate;
 	for (row=0; row<ny; row++)
 	{
-		for (col=0; col<nx; col++)
+		for (col=0; col<nx; col++, gate += scx*scy)
 		{
 			/* For each subcell (there are scx*scy subcells per cell) 
 				 of carpi cell (row,col)...*/
@@ -260,20 +285,119 @@ Carpi *RSL_cappi_to_carpi(Cappi *cappi, float dx, float dy, float lat,
 					RSL_find_rng_azm(&rng, &azm, x, y);
 					/* Check if carpi cell outside of data range by noting 
 						 location of lower left corner of cell */
-					if (m == 0)
+					if (m == 0 && n == 0 && (rng - cell_diag) > carpi_max_rng)
 					{
-					  if (n == 0)
-							if ((rng - cell_diag) > carpi_max_rng)
-							{
-								/* Totality of carpi cell lies outside data range. */
-								cell = (float) BADVAL;
-								goto escape;
-							}
-					}  /* end if (m == 0) */
-					/* cell lies in data range. Get data value from cappi. */		  
-					subcell[n][m] = RSL_get_value_from_cappi(cappi,rng,azm);
+						/* Totality of carpi cell lies outside data range. */
+						gate[0] = CARPI_OUTSIDE;
+						goto escape;
+					}
+					/* As RSL_get_value_from_cappi, which finds the ray
+					 * with RSL_get_ray_from_sweep.
+					 */
+					k = hash_closest(hash_table, azm);
+					ray = hash_table->ray[k];
+					if (angle_diff(azm, ray->h.azimuth) > sweep->h.horz_half_bw)
+						ray = NULL;
+					k = ray_index[k];
+					bin = range_bin_of_ray(ray, rng);
+					if (bin < 0 || k < 0)
+						gate[n*scx + m] = CARPI_NODATA;
+					else
+						gate[n*scx + m] = k*map->stride + bin;
 				}  /* end for (m=... */
 			} /* end for (n=... */
+escape:	
+			;
+		} /* end for (col=... */
+	}  /* end for (row=...  */
+
+	free(ray_index);
+	FREE_HASH_TABLE(hash_table);
+	return map;
+}
+
+void free_carpi_map(Carpi_map *map)
+{
+	if (map == NULL) return;
+	free(map->gate);
+	free(map);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       carpi_from_map                      */
+/*                                                           */
+/*************************************************************/
+Carpi *carpi_from_map(Cappi *cappi, Carpi_map *map, float lat, float lon)
+	/* RSL_cappi_to_carpi, with the subcells located by carpi_map.
+	 * cappi->sweep must have the rays of the sweep the map was made for.
+	 */
+{
+	Carpi *carpi;
+	Ray *first_ray, *ray;
+	Ray **rays;
+	int row, col, j, k, scx, scy, valid_subcells, *gate;
+	float cell;
+	float *f;  /* Table of the f() shared by all rays, or NULL. */
+	float subcell[3][3];  /* Maximum of 9 subcells per carpi cell*/
+   
+	if (cappi == NULL) return NULL;
+	if (cappi->sweep == NULL) return NULL;
+	if (map == NULL) return NULL;
+	first_ray = RSL_get_first_ray_of_sweep(cappi->sweep);
+	if (first_ray == NULL) return NULL; /* No data. */
+
+	if (rsl_verbose()) fprintf(stderr,"\nCreating carpi...\n");
+
+	/* Allcate space for a carpi, and fill in its values. */
+	carpi = RSL_new_carpi(map->ny, map->nx);
+	carpi->month = cappi->month;
+	carpi->day = cappi->day;
+	carpi->year = cappi->year;
+	carpi->hour = cappi->hour;
+	carpi->minute = cappi->minute;
+	carpi->sec = cappi->sec;
+	carpi->dx = map->dx;
+	carpi->dy = map->dy;
+	carpi->nx = map->nx;
+	carpi->ny = map->ny;
+	carpi->radar_x = map->radar_x;
+	carpi->radar_y = map->radar_y;
+	carpi->height = cappi->height;
+	carpi->lat = lat;
+	carpi->lon = lon;
+	strncpy(carpi->radar_type, cappi->radar_type, sizeof(cappi->radar_type));
+	carpi->field_type    = cappi->field_type;
+	carpi->interp_method = cappi->interp_method;
+	carpi->f = first_ray->h.f;
+	carpi->invf = first_ray->h.invf;
+
+	rays = cappi->sweep->ray;
+	f = RSL_f_table(first_ray->h.f);
+	for (j=0; j<cappi->sweep->h.nrays; j++)
+		if (rays[j] && rays[j]->h.f != first_ray->h.f) f = NULL;
+	scx = map->scx;
+	scy = map->scy;
+	gate = map->gate;
+	for (row=0; row<map->ny; row++)
+	{
+		for (col=0; col<map->nx; col++, gate += scx*scy)
+		{
+			if (gate[0] == CARPI_OUTSIDE)
+			{
+				carpi->data[row][col] = (Carpi_value) carpi->invf((float) BADVAL);
+				continue;
+			}
+			for (j=0; j<scy; j++)
+				for (k=0; k<scx; k++)
+					if (gate[j*scx + k] == CARPI_NODATA)
+						subcell[j][k] = BADVAL;
+					else
+					{
+						ray = rays[gate[j*scx + k] / map->stride];
+						if (f) subcell[j][k] = f[ray->range[gate[j*scx + k] % map->stride]];
+						else subcell[j][k] = ray->h.f(ray->range[gate[j*scx + k] % map->stride]);
+					}
 
 			/* All subcell values have now been determined. Average them
 				 to determine the cell value. */
@@ -293,10 +417,37 @@ Carpi *RSL_cappi_to_carpi(Cappi *cappi, float dx, float dy, float lat,
 			if (valid_subcells != 0) cell = cell/valid_subcells;
 			else cell = (float) BADVAL;
 
-escape:	
 			carpi->data[row][col] = (Carpi_value) carpi->invf(cell);
 		} /* end for (col=... */
 	}  /* end for (row=...  */
    
 	return(carpi);
 }
+
+/*************************************************************/
+/*                                                           */
+/*                     RSL_cappi_to_carpi                    */
+/*                                                           */
+/*************************************************************/
+Carpi *RSL_cappi_to_carpi(Cappi *cappi, float dx, float dy, float lat,
+						  float lon, int nx, int ny, int radar_x, int radar_y)
+   /****** Simple and straightforward algorithm: 
+	  Divide each of the nx*ny carpi cells into scx*scy subcells. 
+	  Find the data value for each subcell from the cappi rays.
+	  Average the subcell data values over a cell to obtain the cell value.
+	  Store the cell value into the 2_D carpi array.
+	  The subcells are located by carpi_map, and the values taken by
+	  carpi_from_map, so that RSL_volume_to_cube locates them once for
+	  all its levels.
+	  ********/
+{
+	Carpi_map *map;
+	Carpi *carpi;
+
+	if (cappi == NULL) return NULL;
+	if ((map = carpi_map(cappi->sweep, dx, dy, nx, ny, radar_x, radar_y)) == NULL)
+		return NULL;
+	carpi = carpi_from_map(cappi, map, lat, lon);
+	free_carpi_map(map);
+	return carpi;
+}
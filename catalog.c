@@ -0,0 +1,914 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Archive catalogs.
+ *
+ * A catalog holds the RSL_probe of every radar file under some
+ * directories, so volumes can be found by site, time, field and
+ * elevation without opening the files.  It is kept in a text file:
+ *
+ *   RSL catalog 1
+ *   V offset length size mtime type decoded site radar_type
+ *     year month day hour minute sec lat lon vcp nsweeps path
+ *   S fix_angle nrays fields       (nsweeps of these follow each V)
+ *   X offset length size mtime path
+ *
+ * all on one line each.  X records files that are not radar files, so
+ * they are not probed again.  The radar files in a plain (not
+ * compressed) ustar archive are recorded each as a volume, by its
+ * offset and length in the archive; a compressed archive is recorded
+ * as not a radar file.  Fields are RSL_ftype names separated by
+ * commas; empty names are written as '-' and blanks in names as '_'.
+ * A file is probed again when its size or modification time changes.
+ *
+ *   Rsl_catalog *RSL_open_catalog(char *catfile);
+ *   int RSL_catalog_add(Rsl_catalog *c, char *path, int nthreads);
+ *   int RSL_write_catalog(Rsl_catalog *c);
+ *   void RSL_free_catalog(Rsl_catalog *c);
+ *
+ * Queries.  Site and time are found by binary search of the volumes,
+ * which are kept by site and start; field and elevation then filter
+ * those volumes and their sweeps:
+ *
+ *   Rsl_catalog_volume **RSL_catalog_volumes(c, site, t0, t1, field, &n);
+ *   Rsl_catalog_volume *RSL_catalog_volume_at(c, site, t, field);
+ *   int RSL_catalog_sweep(v, field, elev, limit);
+ *   Radar *RSL_catalog_read(v, isweep);
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <pthread.h>
+#define USE_RSL_VARS
+#include "rsl.h"
+
+#define CATALOG_MAGIC "RSL catalog 1"
+#define CATALOG_LINE 8192
+#define CATALOG_MAX_THREADS 64
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_catalog_time                            */
+/*                                                                    */
+/*  Seconds since 1970 UTC, the time used by the catalog queries.     */
+/*                                                                    */
+/**********************************************************************/
+long long RSL_catalog_time(int year, int month, int day,
+						   int hour, int minute, float sec)
+{
+  /* Days from the civil date, for the proleptic Gregorian calendar. */
+  long long era, yoe, doy, doe, days;
+
+  year -= month <= 2;
+  era = (year >= 0 ? year : year - 399) / 400;
+  yoe = year - era * 400;
+  doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  days = era * 146097 + doe - 719468;
+  return days * 86400 + hour * 3600 + minute * 60 + (long long)sec;
+}
+
+static Rsl_catalog_volume *new_volume(char *path)
+{
+  Rsl_catalog_volume *v;
+
+  v = (Rsl_catalog_volume *)calloc(1, sizeof(Rsl_catalog_volume));
+  if (v == NULL) {
+	perror("RSL_catalog");
+	return NULL;
+  }
+  if ((v->path = strdup(path)) == NULL) {
+	perror("RSL_catalog");
+	free(v);
+	return NULL;
+  }
+  return v;
+}
+
+static void free_volume(Rsl_catalog_volume *v)
+{
+  if (v == NULL) return;
+  RSL_free_probe(v->probe);
+  free(v->path);
+  free(v);
+}
+
+static void volume_start(Rsl_catalog_volume *v)
+{
+  Rsl_probe *p = v->probe;
+
+  v->start = p ? RSL_catalog_time(p->year, p->month, p->day,
+								  p->hour, p->minute, p->sec) : 0;
+}
+
+static int cmp_volume(const void *a, const void *b)
+{
+  /* Site, then start, then path and offset; non-radar files last. */
+  Rsl_catalog_volume *va = *(Rsl_catalog_volume **)a;
+  Rsl_catalog_volume *vb = *(Rsl_catalog_volume **)b;
+  int rc;
+
+  if (va->probe == NULL || vb->probe == NULL) {
+	if (va->probe) return -1;
+	if (vb->probe) return 1;
+  } else {
+	if ((rc = strcmp(va->probe->name, vb->probe->name)) != 0) return rc;
+	if (va->start != vb->start) return va->start < vb->start ? -1 : 1;
+  }
+  if ((rc = strcmp(va->path, vb->path)) != 0) return rc;
+  if (va->offset != vb->offset) return va->offset < vb->offset ? -1 : 1;
+  return 0;
+}
+
+static int cmp_path(const void *a, const void *b)
+{
+  Rsl_catalog_volume *va = *(Rsl_catalog_volume **)a;
+  Rsl_catalog_volume *vb = *(Rsl_catalog_volume **)b;
+
+  return strcmp(va->path, vb->path);
+}
+
+static int add_volume(Rsl_catalog *c, Rsl_catalog_volume *v, int *size)
+{
+  /* Append v to c->volume, which has room for *size. */
+  Rsl_catalog_volume **vv;
+  int n;
+
+  if (c->nvolumes >= *size) {
+	n = 2 * *size + 64;
+	vv = (Rsl_catalog_volume **)realloc(c->volume,
+										n * sizeof(Rsl_catalog_volume *));
+	if (vv == NULL) {
+	  perror("RSL_catalog");
+	  return -1;
+	}
+	c->volume = vv;
+	*size = n;
+  }
+  c->volume[c->nvolumes++] = v;
+  return 0;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                   Reading and writing the file                     */
+/*                                                                    */
+/**********************************************************************/
+static void put_name(FILE *fp, char *name)
+{
+  /* A name as one word: '-' when empty, blanks as '_'. */
+  char *s;
+
+  if (*name == '\0') {
+	fputc('-', fp);
+	return;
+  }
+  for (s = name; *s; s++)
+	fputc(*s == ' ' || *s == '\t' || *s == '\n' ? '_' : *s, fp);
+}
+
+static int get_name(char *word, char *name, size_t size)
+{
+  /* The name written by put_name; -1 if it doesn't fit in 'size'. */
+  size_t len;
+
+  if (strcmp(word, "-") == 0) word = "";
+  if ((len = strlen(word)) >= size) return -1;
+  memcpy(name, word, len + 1);
+  return 0;
+}
+
+static void put_fields(FILE *fp, char *field)
+{
+  int i, n;
+
+  for (i=n=0; i<MAX_RADAR_VOLUMES; i++)
+	if (field[i]) fprintf(fp, "%s%s", n++ ? "," : "", RSL_ftype[i]);
+  if (n == 0) fputc('-', fp);
+}
+
+static void get_fields(char *word, char *field)
+{
+  char *s;
+  int i;
+
+  for (s = strtok(word, ","); s; s = strtok(NULL, ","))
+	for (i=0; i<MAX_RADAR_VOLUMES; i++)
+	  if (strcmp(s, RSL_ftype[i]) == 0) field[i] = 1;
+}
+
+static char *line_path(char *line, int n)
+{
+  /* The path that starts at line[n], without its newline. */
+  char *path;
+
+  path = line + n;
+  while (*path == ' ') path++;
+  path[strcspn(path, "\n")] = '\0';
+  return *path ? path : NULL;
+}
+
+static int read_catalog(Rsl_catalog *c, FILE *fp)
+{
+  Rsl_catalog_volume *v;
+  Rsl_probe *p;
+  Rsl_probe_sweep *s;
+  char *line, *path;
+  char site[64], radar_type[64], fields[CATALOG_LINE];
+  int size, n, type, i, nsweeps;
+
+  if ((line = (char *)malloc(CATALOG_LINE)) == NULL) {
+	perror("RSL_open_catalog");
+	return -1;
+  }
+  size = 0;
+  if (fgets(line, CATALOG_LINE, fp) == NULL ||
+	  strncmp(line, CATALOG_MAGIC, strlen(CATALOG_MAGIC)) != 0) goto bad;
+
+  while (fgets(line, CATALOG_LINE, fp)) {
+	if (strchr(line, '\n') == NULL) goto bad; /* Line too long. */
+	v = NULL;
+	if (line[0] == 'X') {
+	  v = (Rsl_catalog_volume *)calloc(1, sizeof(Rsl_catalog_volume));
+	  if (v == NULL) goto bad;
+	  n = 0;
+	  if (sscanf(line, "X %lld %lld %lld %ld %n", &v->offset, &v->length,
+				 &v->size, &v->mtime, &n) != 4 || n == 0 ||
+		  (path = line_path(line, n)) == NULL ||
+		  (v->path = strdup(path)) == NULL) {
+		free(v);
+		goto bad;
+	  }
+	} else if (line[0] == 'V') {
+	  v = (Rsl_catalog_volume *)calloc(1, sizeof(Rsl_catalog_volume));
+	  if (v == NULL) goto bad;
+	  p = v->probe = rsl_new_probe(UNKNOWN);
+	  n = 0;
+	  if (p == NULL ||
+		  sscanf(line, "V %lld %lld %lld %ld %d %d %63s %63s %d %d %d %d %d"
+				 " %f %f %f %d %d %n",
+				 &v->offset, &v->length, &v->size, &v->mtime,
+				 &type, &p->decoded, site, radar_type,
+				 &p->year, &p->month, &p->day, &p->hour, &p->minute,
+				 &p->sec, &p->lat, &p->lon, &p->vcp, &nsweeps, &n) != 18 ||
+		  n == 0 || nsweeps < 0 ||
+		  (path = line_path(line, n)) == NULL ||
+		  (v->path = strdup(path)) == NULL) {
+		free_volume(v);
+		goto bad;
+	  }
+	  p->type = (enum File_type)type;
+	  if (get_name(site, p->name, sizeof(p->name)) < 0 ||
+		  get_name(radar_type, p->radar_type, sizeof(p->radar_type)) < 0) {
+		free_volume(v);
+		goto bad;
+	  }
+	  for (i=0; i<nsweeps; i++) {
+		if (fgets(line, CATALOG_LINE, fp) == NULL ||
+			(s = rsl_probe_sweep(p, i)) == NULL ||
+			sscanf(line, "S %f %d %s", &s->fix_angle, &s->nrays,
+				   fields) != 3) {
+		  free_volume(v);
+		  goto bad;
+		}
+		if (strcmp(fields, "-") != 0) get_fields(fields, s->field);
+		for (type=0; type<MAX_RADAR_VOLUMES; type++)
+		  if (s->field[type]) p->field[type] = 1;
+	  }
+	  volume_start(v);
+	} else goto bad;
+	if (add_volume(c, v, &size) < 0) {
+	  free_volume(v);
+	  goto bad;
+	}
+  }
+  free(line);
+  return 0;
+
+ bad:
+  fprintf(stderr, "RSL_open_catalog: %s is not a catalog, or is damaged.\n",
+		  c->file);
+  free(line);
+  return -1;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                RSL_open_catalog, RSL_free_catalog                  */
+/*                                                                    */
+/**********************************************************************/
+Rsl_catalog *RSL_open_catalog(char *catfile)
+{
+  /* Read the catalog in 'catfile'.  If there is no such file, the
+   * catalog is empty; RSL_write_catalog will create it.
+   */
+  Rsl_catalog *c;
+  FILE *fp;
+
+  c = (Rsl_catalog *)calloc(1, sizeof(Rsl_catalog));
+  if (c == NULL || (c->file = strdup(catfile)) == NULL) {
+	perror("RSL_open_catalog");
+	free(c);
+	return NULL;
+  }
+  if ((fp = fopen(catfile, "r")) == NULL) return c;
+  if (read_catalog(c, fp) < 0) {
+	fclose(fp);
+	RSL_free_catalog(c);
+	return NULL;
+  }
+  fclose(fp);
+  qsort(c->volume, c->nvolumes, sizeof(Rsl_catalog_volume *), cmp_volume);
+  return c;
+}
+
+void RSL_free_catalog(Rsl_catalog *c)
+{
+  int i;
+
+  if (c == NULL) return;
+  for (i=0; i<c->nvolumes; i++)
+	free_volume(c->volume[i]);
+  free(c->volume);
+  free(c->file);
+  free(c);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_write_catalog                           */
+/*                                                                    */
+/*  Write c to its file, through a temporary file renamed over it.    */
+/*  Returns 0, or -1 on error.                                        */
+/*                                                                    */
+/**********************************************************************/
+int RSL_write_catalog(Rsl_catalog *c)
+{
+  Rsl_catalog_volume *v;
+  Rsl_probe *p;
+  char *tmp;
+  FILE *fp;
+  int i, j, rc;
+
+  if (c == NULL) return -1;
+  if ((tmp = (char *)malloc(strlen(c->file) + 5)) == NULL) {
+	perror("RSL_write_catalog");
+	return -1;
+  }
+  sprintf(tmp, "%s.tmp", c->file);
+  if ((fp = fopen(tmp, "w")) == NULL) {
+	perror(tmp);
+	free(tmp);
+	return -1;
+  }
+
+  fprintf(fp, "%s\n", CATALOG_MAGIC);
+  for (i=0; i<c->nvolumes; i++) {
+	v = c->volume[i];
+	if ((p = v->probe) == NULL) {
+	  fprintf(fp, "X %lld %lld %lld %ld %s\n", v->offset, v->length,
+			  v->size, v->mtime, v->path);
+	  continue;
+	}
+	fprintf(fp, "V %lld %lld %lld %ld %d %d ", v->offset, v->length,
+			v->size, v->mtime, (int)p->type, p->decoded);
+	put_name(fp, p->name);
+	fputc(' ', fp);
+	put_name(fp, p->radar_type);
+	fprintf(fp, " %d %d %d %d %d %.3f %.6f %.6f %d %d %s\n",
+			p->year, p->month, p->day, p->hour, p->minute, p->sec,
+			p->lat, p->lon, p->vcp, p->nsweeps, v->path);
+	for (j=0; j<p->nsweeps; j++) {
+	  fprintf(fp, "S %.3f %d ", p->sweep[j].fix_angle, p->sweep[j].nrays);
+	  put_fields(fp, p->sweep[j].field);
+	  fputc('\n', fp);
+	}
+  }
+
+  rc = 0;
+  if (ferror(fp)) rc = -1;
+  if (fclose(fp) != 0) rc = -1;
+  if (rc == 0 && rename(tmp, c->file) != 0) rc = -1;
+  if (rc < 0) {
+	perror(c->file);
+	remove(tmp);
+  } else
+	c->changed = 0;
+  free(tmp);
+  return rc;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         RSL_catalog_add                            */
+/*                                                                    */
+/**********************************************************************/
+
+/* A radar file inside an archive. */
+typedef struct _catalog_member {
+  long long offset, length;
+  Rsl_probe *probe;
+  struct _catalog_member *next;
+} Catalog_member;
+
+/* Files to probe; they are taken in turn by the threads. */
+typedef struct {
+  char **path;
+  struct stat *st;
+  Rsl_probe **probe;
+  Catalog_member **member;  /* Of the archives, in order. */
+  int n, size;
+  int next;          /* Next file to probe. */
+  pthread_mutex_t lock;
+} Catalog_job;
+
+static int add_file(Catalog_job *job, char *path, struct stat *st)
+{
+  char **pp;
+  struct stat *sp;
+  int n;
+
+  if (job->n >= job->size) {
+	n = 2 * job->size + 64;
+	pp = (char **)realloc(job->path, n * sizeof(char *));
+	if (pp) job->path = pp;
+	sp = (struct stat *)realloc(job->st, n * sizeof(struct stat));
+	if (sp) job->st = sp;
+	if (pp == NULL || sp == NULL) {
+	  perror("RSL_catalog_add");
+	  return -1;
+	}
+	job->size = n;
+  }
+  if ((job->path[job->n] = strdup(path)) == NULL) {
+	perror("RSL_catalog_add");
+	return -1;
+  }
+  job->st[job->n++] = *st;
+  return 0;
+}
+
+static int find_files(Catalog_job *job, char *path, char *skip)
+{
+  /* Add the regular files at or under 'path', except 'skip'.  Symbolic
+   * links to directories are not followed.  What cannot be read is
+   * reported and passed over.  Returns -1 only when out of memory.
+   */
+  struct stat st;
+  struct dirent *d;
+  DIR *dir;
+  char *sub;
+  int rc, len;
+
+  if (stat(path, &st) != 0) {
+	perror(path);
+	return 0;
+  }
+  if (S_ISREG(st.st_mode))
+	return strcmp(path, skip) == 0 ? 0 : add_file(job, path, &st);
+  if (!S_ISDIR(st.st_mode)) return 0;
+
+  if ((dir = opendir(path)) == NULL) {
+	perror(path);
+	return 0;
+  }
+  len = strlen(path);
+  rc = 0;
+  while (rc == 0 && (d = readdir(dir)) != NULL) {
+	if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
+	  continue;
+	if (strchr(d->d_name, '\n')) continue; /* Cannot be cataloged. */
+	if ((sub = (char *)malloc(len + strlen(d->d_name) + 2)) == NULL) {
+	  perror("RSL_catalog_add");
+	  rc = -1;
+	  break;
+	}
+	if (len > 0 && path[len-1] == '/') sprintf(sub, "%s%s", path, d->d_name);
+	else sprintf(sub, "%s/%s", path, d->d_name);
+	if (lstat(sub, &st) == 0 && S_ISLNK(st.st_mode) &&
+		stat(sub, &st) == 0 && S_ISDIR(st.st_mode)) {
+	  free(sub);
+	  continue;
+	}
+	rc = find_files(job, sub, skip);
+	free(sub);
+  }
+  closedir(dir);
+  return rc;
+}
+
+static int is_tar(char *path)
+{
+  /* 1 if 'path' starts with a ustar header. */
+  char h[512];
+  FILE *fp;
+  int rc;
+
+  if ((fp = fopen(path, "r")) == NULL) return 0;
+  rc = fread(h, 1, sizeof(h), fp) == sizeof(h) &&
+	strncmp(h + 257, "ustar", 5) == 0;
+  fclose(fp);
+  return rc;
+}
+
+static Catalog_member *probe_tar(char *path)
+{
+  /* Probe the members of the tar archive 'path'; the radar files, in
+   * order.  None for a compressed archive.
+   */
+  Catalog_member *list, **last, *m;
+  Rsl_tar *t;
+  Rsl_probe *p;
+  char *name, *buf;
+  size_t len;
+
+  list = NULL;
+  last = &list;
+  if ((t = RSL_tar_open(path)) == NULL) return NULL;
+  while (RSL_tar_next(t, &name, &buf, &len) == 1) {
+	if (rsl_tar_offset(t) < 0) {
+	  free(buf);
+	  break;
+	}
+	p = len >= 11 ? RSL_probe_mem(buf, len, NULL) : NULL;
+	free(buf);
+	if (p == NULL) continue;
+	if ((m = (Catalog_member *)calloc(1, sizeof(Catalog_member))) == NULL) {
+	  perror("RSL_catalog_add");
+	  RSL_free_probe(p);
+	  break;
+	}
+	m->offset = rsl_tar_offset(t);
+	m->length = len;
+	m->probe = p;
+	*last = m;
+	last = &m->next;
+  }
+  RSL_tar_close(t);
+  return list;
+}
+
+static void free_members(Catalog_member *m)
+{
+  Catalog_member *next;
+
+  for (; m; m = next) {
+	next = m->next;
+	RSL_free_probe(m->probe);
+	free(m);
+  }
+}
+
+static void *catalog_worker(void *arg)
+{
+  Catalog_job *job = (Catalog_job *)arg;
+  enum File_type type;
+  int i;
+
+  for (;;) {
+	pthread_mutex_lock(&job->lock);
+	i = job->next++;
+	pthread_mutex_unlock(&job->lock);
+	if (i >= job->n) break;
+	/* Files too short for a magic number, or of no known type, are
+	 * recorded without probing them.
+	 */
+	if (job->st[i].st_size < 11) continue;
+	type = RSL_filetype(job->path[i]);
+	if (type != UNKNOWN)
+	  job->probe[i] = RSL_probe(job->path[i], NULL);
+	else if (is_tar(job->path[i]))
+	  job->member[i] = probe_tar(job->path[i]);
+  }
+  return NULL;
+}
+
+int RSL_catalog_add(Rsl_catalog *c, char *path, int nthreads)
+{
+  /* Catalog 'path', a file or a directory tree, probing the files on
+   * 'nthreads' threads.  Files already in c, with the same size and
+   * modification time, are not probed again.  Files of c under the
+   * directory that are gone are removed from c.  Returns the number of
+   * files probed, or -1 on error.
+   */
+  Catalog_job job;
+  Rsl_catalog_volume **bypath, *v, key, *keyp, **found;
+  Catalog_member *m;
+  pthread_t threads[CATALOG_MAX_THREADS];
+  struct stat st;
+  char *seen;
+  int i, j, k, n, size, len, nprobed, rc;
+
+  if (c == NULL || path == NULL) return -1;
+  if (stat(path, &st) != 0) {
+	perror(path);
+	return -1;
+  }
+  memset(&job, 0, sizeof(job));
+  if (find_files(&job, path, c->file) < 0) goto out_of_memory;
+
+  /* Index c by path, to see which files are new or have changed. */
+  bypath = (Rsl_catalog_volume **)malloc((c->nvolumes + 1) *
+										 sizeof(Rsl_catalog_volume *));
+  seen = (char *)calloc(c->nvolumes + 1, 1);
+  job.probe = (Rsl_probe **)calloc(job.n + 1, sizeof(Rsl_probe *));
+  job.member = (Catalog_member **)calloc(job.n + 1, sizeof(Catalog_member *));
+  if (bypath == NULL || seen == NULL || job.probe == NULL ||
+	  job.member == NULL) {
+	free(bypath);
+	free(seen);
+	goto out_of_memory;
+  }
+  memcpy(bypath, c->volume, c->nvolumes * sizeof(Rsl_catalog_volume *));
+  qsort(bypath, c->nvolumes, sizeof(Rsl_catalog_volume *), cmp_path);
+
+  /* Keep in job only the files to probe.  An archive has a volume
+   * for each of its radar files; they go or stay together.
+   */
+  keyp = &key;
+  for (i=n=0; i<job.n; i++) {
+	key.path = job.path[i];
+	found = (Rsl_catalog_volume **)bsearch(&keyp, bypath, c->nvolumes,
+							sizeof(Rsl_catalog_volume *), cmp_path);
+	if (found) {
+	  for (j = found - bypath; j > 0 && cmp_path(&bypath[j-1], &keyp) == 0;
+		   j--);
+	  for (k = j; k < c->nvolumes && cmp_path(&bypath[k], &keyp) == 0; k++)
+		seen[k] = 1;
+	  if (bypath[j]->size == (long long)job.st[i].st_size &&
+		  bypath[j]->mtime == (long)job.st[i].st_mtime) {
+		free(job.path[i]);
+		continue;
+	  }
+	  for (; j < k; j++)
+		bypath[j]->size = -1; /* To be replaced. */
+	}
+	job.path[n] = job.path[i];
+	job.st[n++] = job.st[i];
+  }
+  job.n = n;
+
+  /* Probe them. */
+  pthread_mutex_init(&job.lock, NULL);
+  if (nthreads > CATALOG_MAX_THREADS) nthreads = CATALOG_MAX_THREADS;
+  if (nthreads > job.n) nthreads = job.n;
+  for (i=0; i<nthreads-1; i++)
+	if (pthread_create(&threads[i], NULL, catalog_worker, &job) != 0) break;
+  nthreads = i;
+  catalog_worker(&job);  /* This thread helps, too. */
+  for (i=0; i<nthreads; i++)
+	pthread_join(threads[i], NULL);
+  pthread_mutex_destroy(&job.lock);
+
+  /* Drop what was replaced or is gone from under a directory. */
+  len = strlen(path);
+  while (len > 1 && path[len-1] == '/') len--;
+  for (i=0; i<c->nvolumes; i++) {
+	v = bypath[i];
+	if (v->size == -1 ||
+		(!seen[i] && S_ISDIR(st.st_mode) &&
+		 strncmp(v->path, path, len) == 0 && v->path[len] == '/')) {
+	  free_volume(v);
+	  bypath[i] = NULL;
+	}
+  }
+  for (i=n=0; i<c->nvolumes; i++)
+	if (bypath[i]) c->volume[n++] = bypath[i];
+  if (n < c->nvolumes) c->changed = 1;
+  c->nvolumes = n;
+  free(bypath);
+  free(seen);
+
+  /* Add the new volumes: the file, or each radar file in it. */
+  size = c->nvolumes;
+  rc = 0;
+  for (i=0; i<job.n; i++) {
+	m = job.member[i];
+	do {
+	  if (rc == 0 && (v = new_volume(job.path[i])) != NULL) {
+		v->length = v->size = job.st[i].st_size;
+		v->mtime = job.st[i].st_mtime;
+		if (m) {
+		  v->offset = m->offset;
+		  v->length = m->length;
+		  v->probe = m->probe;
+		  m->probe = NULL;
+		} else {
+		  v->probe = job.probe[i];
+		  job.probe[i] = NULL;
+		}
+		volume_start(v);
+		if (add_volume(c, v, &size) < 0) {
+		  free_volume(v);
+		  rc = -1;
+		}
+	  } else rc = -1;
+	} while (m && (m = m->next) != NULL);
+	free_members(job.member[i]);
+	RSL_free_probe(job.probe[i]);
+	free(job.path[i]);
+  }
+  nprobed = job.n;
+  if (nprobed > 0) c->changed = 1;
+  free(job.path);
+  free(job.st);
+  free(job.probe);
+  free(job.member);
+  qsort(c->volume, c->nvolumes, sizeof(Rsl_catalog_volume *), cmp_volume);
+  return rc < 0 ? -1 : nprobed;
+
+ out_of_memory:
+  for (i=0; i<job.n; i++)
+	free(job.path[i]);
+  free(job.path);
+  free(job.st);
+  free(job.probe);
+  free(job.member);
+  return -1;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*             RSL_catalog_volumes, RSL_catalog_volume_at             */
+/*                                                                    */
+/**********************************************************************/
+static int has_field(Rsl_probe *p, int field)
+{
+  return field < 0 || (field < MAX_RADAR_VOLUMES && p->field[field]);
+}
+
+static int first_at(Rsl_catalog *c, char *site, long long t)
+{
+  /* Index of the first volume of 'site' starting at t or later, or of
+   * the volume after the last of 'site'.
+   */
+  Rsl_catalog_volume *v;
+  int lo, hi, mid, rc;
+
+  lo = 0;
+  hi = c->nvolumes;
+  while (lo < hi) {
+	mid = (lo + hi) / 2;
+	v = c->volume[mid];
+	if (v->probe == NULL) rc = 1;
+	else if ((rc = strcmp(v->probe->name, site)) == 0)
+	  rc = v->start < t ? -1 : 1;
+	if (rc < 0) lo = mid + 1;
+	else hi = mid;
+  }
+  return lo;
+}
+
+Rsl_catalog_volume **RSL_catalog_volumes(Rsl_catalog *c, char *site,
+										 long long t0, long long t1,
+										 int field, int *n)
+{
+  /* The volumes of 'site' (any, if NULL) starting from t0 through t1
+   * that have 'field' (any, if -1), by site and start.  The list ends
+   * with NULL and its length is in *n; free it with free().  The volumes
+   * belong to c.
+   */
+  Rsl_catalog_volume **list, *v;
+  int i, nlist;
+
+  *n = 0;
+  if (c == NULL) return NULL;
+  list = (Rsl_catalog_volume **)malloc((c->nvolumes + 1) *
+									   sizeof(Rsl_catalog_volume *));
+  if (list == NULL) {
+	perror("RSL_catalog_volumes");
+	return NULL;
+  }
+  nlist = 0;
+  i = site ? first_at(c, site, t0) : 0;
+  for (; i<c->nvolumes; i++) {
+	v = c->volume[i];
+	if (v->probe == NULL) break;
+	if (site) {
+	  if (strcmp(v->probe->name, site) != 0 || v->start > t1) break;
+	} else if (v->start < t0 || v->start > t1) continue;
+	if (has_field(v->probe, field)) list[nlist++] = v;
+  }
+  list[nlist] = NULL;
+  *n = nlist;
+  return list;
+}
+
+Rsl_catalog_volume *RSL_catalog_volume_at(Rsl_catalog *c, char *site,
+										  long long t, int field)
+{
+  /* The volume of 'site' in effect at t: the last to start at or before
+   * t that has 'field' (any, if -1).  NULL if there is none.
+   */
+  Rsl_catalog_volume *v;
+  int i;
+
+  if (c == NULL || site == NULL) return NULL;
+  for (i = first_at(c, site, t + 1) - 1; i >= 0; i--) {
+	v = c->volume[i];
+	if (strcmp(v->probe->name, site) != 0) break;
+	if (has_field(v->probe, field)) return v;
+  }
+  return NULL;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_catalog_sweep                           */
+/*                                                                    */
+/**********************************************************************/
+int RSL_catalog_sweep(Rsl_catalog_volume *v, int field,
+					  float elev, float limit)
+{
+  /* As RSL_get_closest_sweep: the index in v->probe->sweep of the sweep
+   * with 'field' (any, if -1) whose fixed angle is closest to 'elev' and
+   * within 'limit' of it.  -1 if there is none.
+   */
+  Rsl_probe_sweep *s;
+  float delta, best;
+  int i, ibest;
+
+  if (v == NULL || v->probe == NULL) return -1;
+  ibest = -1;
+  best = limit;
+  for (i=0; i<v->probe->nsweeps; i++) {
+	s = &v->probe->sweep[i];
+	if (field >= 0 && (field >= MAX_RADAR_VOLUMES || !s->field[field]))
+	  continue;
+	delta = s->fix_angle > elev ? s->fix_angle - elev : elev - s->fix_angle;
+	if (delta <= best) {
+	  best = delta;
+	  ibest = i;
+	}
+  }
+  return ibest;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_catalog_read                            */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_catalog_read(Rsl_catalog_volume *v, int isweep)
+{
+  /* Read volume v with all its fields.  When isweep >= 0, only sweep
+   * isweep of v->probe is read; WSR-88D split cuts are then not merged,
+   * so the radar's sweeps are numbered as the probe's are.
+   */
+  Rsl_reader *r;
+  Radar *radar;
+  FILE *fp;
+  char *buf, csweep[16];
+
+  if (v == NULL || v->probe == NULL) return NULL;
+  if ((r = RSL_new_reader()) == NULL) return NULL;
+  if (isweep >= 0) {
+	sprintf(csweep, "%d", isweep);
+	RSL_reader_read_these_sweeps(r, csweep, NULL);
+	RSL_reader_wsr88d_merge_split_cuts(r, 0);
+  }
+
+  radar = NULL;
+  if (v->offset == 0 && v->length == v->size)
+	radar = RSL_anyformat_to_radar_r(r, v->path, v->probe->name);
+  else if ((buf = (char *)malloc(v->length)) == NULL)
+	perror("RSL_catalog_read");
+  else {
+	/* A radar file inside another, e.g. a tar member. */
+	if ((fp = fopen(v->path, "r")) == NULL) perror(v->path);
+	else {
+	  if (fseeko(fp, (off_t)v->offset, SEEK_SET) == 0 &&
+		  fread(buf, 1, v->length, fp) == (size_t)v->length)
+		radar = RSL_anyformat_to_radar_mem_r(r, buf, v->length,
+											 v->probe->name);
+	  fclose(fp);
+	}
+	free(buf);
+  }
+  RSL_free_reader(r);
+  return radar;
+}
@@ -24,11 +24,16 @@
  * Space Applications Corporation
  * NASA/Goddard 910.1
  */
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "rsl.h"
 
-extern int radar_verbose_flag;
+#define CUBE_MAX_THREADS 64
+
+static int cube_nthreads = 0;
+
 
 /*************************************************************/
 /*                                                           */
@@ -127,6 +132,64 @@ void RSL_free_cube(Cube *cube)
 	}
 }
 
+/*************************************************************/
+/*                                                           */
+/*                     RSL_cube_threads                      */
+/*                                                           */
+/*************************************************************/
+void RSL_cube_threads(int nthreads)
+{
+  /* RSL_volume_to_cube fills its levels on 'nthreads' threads.
+   * 0 or 1 fills them in the calling thread, which is the default.
+   */
+  if (nthreads < 0) nthreads = 0;
+  if (nthreads > CUBE_MAX_THREADS) nthreads = CUBE_MAX_THREADS;
+  cube_nthreads = nthreads;
+}
+
+/* One RSL_volume_to_cube; the levels are taken in turn by the threads. */
+typedef struct {
+  Volume *v;
+  Cube *cube;
+  Sweep *sweep;     /* Every level's Cappi is made from this sweep, */
+  Ray **src;        /* is filled from these rays, */
+  Carpi_map *map;   /* and is mapped to its Carpi by this. */
+  int next;         /* Next level to fill. */
+  pthread_mutex_t lock;
+} Cube_job;
+
+static void cube_level(Cube_job *job, int i)
+{
+  /* As RSL_volume_to_carpi(v, (i+1)*dz, ...). */
+  Cappi *cappi;
+
+  cappi = RSL_new_cappi(job->sweep, (i+1)*job->cube->dz);
+  if (cappi == NULL) return;
+  if (cappi_fill(job->v, cappi, 0, job->src) >= 0) {
+	cappi->lat = job->cube->lat;
+	cappi->lon = job->cube->lon;
+	cappi->interp_method = 0;
+	job->cube->carpi[i] = carpi_from_map(cappi, job->map,
+										 job->cube->lat, job->cube->lon);
+  }
+  RSL_free_cappi(cappi);
+}
+
+static void *cube_worker(void *arg)
+{
+  Cube_job *job = (Cube_job *)arg;
+  int i;
+
+  for (;;) {
+	pthread_mutex_lock(&job->lock);
+	i = job->next++;
+	pthread_mutex_unlock(&job->lock);
+	if (i >= job->cube->nz) break;
+	cube_level(job, i);
+  }
+  return NULL;
+}
+
 /*************************************************************/
 /*                                                           */
 /*                     RSL_volume_to_cube                    */
@@ -137,10 +200,17 @@ Cube *RSL_volume_to_cube(Volume *v, float dx, float dy, float dz,
 					  int radar_x, int radar_y, int radar_z)
 /* radar_z = 0 is the only thing that makes sense. Why pass it? */
 {
+  /* Each level is RSL_volume_to_carpi(v, (i+1)*dz, ...).  What does
+   * not depend on the height -- the ray of each sweep under each Cappi
+   * ray, and the Cappi ray and bin under each Carpi subcell -- is
+   * found once, for all levels.
+   */
   float lat=0;
   float lon=0;
-  int i;
+  int i, nthreads;
   Cube *cube;
+  Cube_job job;
+  pthread_t threads[CUBE_MAX_THREADS];
   
   if (v == NULL) return NULL;
   /* check validity of radar site coordinates in cube. */
@@ -162,12 +232,32 @@ Cube *RSL_volume_to_cube(Volume *v, float dx, float dy, float dz,
   cube->lat = lat;
   cube->lon = lon;
   
+  job.v = v;
+  job.cube = cube;
+  job.sweep = RSL_get_first_sweep_of_volume(v); /* As RSL_cappi_at_h. */
+  job.src = cappi_source_rays(v, job.sweep);
+  job.map = carpi_map(job.sweep, dx, dy, nx, ny, radar_x, radar_y);
+  job.next = 0;
+  if (job.src == NULL || job.map == NULL) {
+	free(job.src);
+	free_carpi_map(job.map);
+	return cube;
+  }
+  pthread_mutex_init(&job.lock, NULL);
+
   /* Create nz carpis */
-  for (i=0; i<nz; i++)
-	  cube->carpi[i] = (Carpi *)RSL_volume_to_carpi(v, (i+1)*dz, grnd_r,
-																									dx, dy, nx, ny,
-																									radar_x, radar_y,
-																									lat, lon);
+  nthreads = cube_nthreads;
+  if (nthreads > nz) nthreads = nz;
+  for (i=0; i<nthreads-1; i++)
+	if (pthread_create(&threads[i], NULL, cube_worker, &job) != 0) break;
+  nthreads = i;
+  cube_worker(&job);  /* This thread helps, too. */
+  for (i=0; i<nthreads; i++)
+	pthread_join(threads[i], NULL);
+
+  pthread_mutex_destroy(&job.lock);
+  free(job.src);
+  free_carpi_map(job.map);
   return cube;
 }
 
@@ -252,7 +342,7 @@ Slice *RSL_get_slice_from_cube(Cube *cube, int x, int y, int z)
 
 	else  /* Invalid parameters. */
 	{
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		{
 			fprintf(stderr,"\nRSL_get_slice_from_cube(): passed invalid parameters\n");
 			fprintf(stderr,"nx:%d ny:%d nz:%d x:%d y:%d z:%d\n",cube->nx,
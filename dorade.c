@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <netinet/in.h>
 #include <string.h>
+#include "rsl.h"
 #include "dorade.h"
 
 int dorade_verbose = 0;
@@ -38,14 +39,14 @@ void dorade_verbose_off()
   dorade_verbose = 0;
 }
 
-static int do_swap = 0;
+static RSL_THREAD_LOCAL int do_swap = 0;
 
 /**********************************************************************/
 /*                                                                    */
 /*                      read_extra_bytes                              */
 /*                                                                    */
 /**********************************************************************/
-int read_extra_bytes(int nbytes, FILE *in)
+int read_extra_bytes(int nbytes, Rsl_source *in)
 {
   char *extra;
   int nread;
@@ -59,7 +60,7 @@ int read_extra_bytes(int nbytes, FILE *in)
     fprintf(stderr,"Tried to allocate %d bytes\n", nbytes);
     return 0;
   }
-  nread = fread(extra, sizeof(char), nbytes, in);
+  nread = rsl_source_read(extra, sizeof(char), nbytes, in);
   free(extra);
   return nread;
 }
@@ -69,7 +70,7 @@ int read_extra_bytes(int nbytes, FILE *in)
 /*                      dorade_read_comment_block                     */
 /*                                                                    */
 /**********************************************************************/
-Comment_block *dorade_read_comment_block(FILE *in)
+Comment_block *dorade_read_comment_block(Rsl_source *in)
 {
   Comment_block *cb;
   cb = (Comment_block *) calloc(1, sizeof(Comment_block));
@@ -77,8 +78,8 @@ Comment_block *dorade_read_comment_block(FILE *in)
 	perror("dorade_read_comment_block");
 	return NULL;
   }
-  fread(cb->code, sizeof(cb->code), 1, in);
-  fread(&cb->len, sizeof(cb->len), 1, in);
+  rsl_source_read(cb->code, sizeof(cb->code), 1, in);
+  rsl_source_read(&cb->len, sizeof(cb->len), 1, in);
 
   /* Check for big endian data on little endian platform.  The smallest value
    * cb->len could have is 8 (length of cb->code + cb->len), so we put that in
@@ -96,7 +97,7 @@ Comment_block *dorade_read_comment_block(FILE *in)
 	perror("dorade_read_comment_block: cb->comment");
 	return cb;
   }
-  fread(cb->comment, sizeof(char), cb->len-8, in);
+  rsl_source_read(cb->comment, sizeof(char), cb->len-8, in);
   return cb;
 }
 
@@ -105,7 +106,7 @@ Comment_block *dorade_read_comment_block(FILE *in)
 /*                      dorade_read_volume_desc                       */
 /*                                                                    */
 /**********************************************************************/
-Volume_desc    *dorade_read_volume_desc    (FILE *in)
+Volume_desc    *dorade_read_volume_desc    (Rsl_source *in)
 {
   Volume_desc *vd;
 
@@ -115,7 +116,7 @@ Volume_desc    *dorade_read_volume_desc    (FILE *in)
 	return NULL;
   }
 
-  fread(vd, sizeof(Volume_desc), 1, in);
+  rsl_source_read(vd, sizeof(Volume_desc), 1, in);
   /* Now, convert from Big Endian. */
   if (do_swap) {
       vd->len = ntohl(vd->len);
@@ -147,7 +148,7 @@ extern void swap_2_bytes(void *word);
 /*                      dorade_read_radar_desc                        */
 /*                                                                    */
 /**********************************************************************/
-Radar_desc     *dorade_read_radar_desc     (FILE *in)
+Radar_desc     *dorade_read_radar_desc     (Rsl_source *in)
 {
   Radar_desc *rd;
   int i;
@@ -158,7 +159,7 @@ Radar_desc     *dorade_read_radar_desc     (FILE *in)
 	return NULL;
   }
 
-  fread(rd, sizeof(Radar_desc), 1, in);
+  rsl_source_read(rd, sizeof(Radar_desc), 1, in);
   /* Now, convert from Big Endian. */
   if (do_swap) {
 	swap_4_bytes(&rd->len);
@@ -207,7 +208,7 @@ Radar_desc     *dorade_read_radar_desc     (FILE *in)
 /*                      dorade_read_parameter_desc                    */
 /*                                                                    */
 /**********************************************************************/
-Parameter_desc *dorade_read_parameter_desc (FILE *in)
+Parameter_desc *dorade_read_parameter_desc (Rsl_source *in)
 {
   Parameter_desc *pd;
 
@@ -217,7 +218,7 @@ Parameter_desc *dorade_read_parameter_desc (FILE *in)
 	return NULL;
   }
 
-  fread(pd, sizeof(Parameter_desc), 1, in);
+  rsl_source_read(pd, sizeof(Parameter_desc), 1, in);
   /* Now, convert from Big Endian. */
   if (do_swap) {
 	swap_4_bytes(&pd->len);
@@ -247,7 +248,7 @@ Parameter_desc *dorade_read_parameter_desc (FILE *in)
 /*                      dorade_read_cell_range_vector                 */
 /*                                                                    */
 /**********************************************************************/
-Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in)
+Cell_range_vector      *dorade_read_cell_range_vector     (Rsl_source *in)
 {
   Cell_range_vector *cv;
   char *buff;
@@ -259,9 +260,9 @@ Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in)
 	return NULL;
   }
 
-  fread(&cv->code, sizeof(cv->code), 1, in);
-  fread(&cv->len, sizeof(cv->len), 1, in);
-  fread(&cv->ncells, sizeof(cv->ncells), 1, in);
+  rsl_source_read(&cv->code, sizeof(cv->code), 1, in);
+  rsl_source_read(&cv->len, sizeof(cv->len), 1, in);
+  rsl_source_read(&cv->ncells, sizeof(cv->ncells), 1, in);
   if (do_swap) {
 	swap_4_bytes(&cv->len);
 	swap_4_bytes(&cv->ncells);
@@ -271,7 +272,7 @@ Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in)
 	perror("dorade_read_cell_range_vector: cv->range_cell");
 	return cv;
   }
-  fread(cv->range_cell, sizeof(float), cv->ncells, in);
+  rsl_source_read(cv->range_cell, sizeof(float), cv->ncells, in);
 
   if (do_swap) {
 	for (i=0; i<cv->ncells; i++)
@@ -289,7 +290,7 @@ Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in)
 	- cv->ncells*4;
   buff = (char *)malloc(i);
   if (!buff) return cv;
-  fread(buff, sizeof(char), i, in);
+  rsl_source_read(buff, sizeof(char), i, in);
   free(buff);
   return cv;
 }
@@ -299,7 +300,7 @@ Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in)
 /*                      dorade_read_correction_factor_desc            */
 /*                                                                    */
 /**********************************************************************/
-Correction_factor_desc *dorade_read_correction_factor_desc(FILE *in)
+Correction_factor_desc *dorade_read_correction_factor_desc(Rsl_source *in)
 {
   Correction_factor_desc *cf;
   char *remaining;
@@ -313,11 +314,11 @@ Correction_factor_desc *dorade_read_correction_factor_desc(FILE *in)
 
   /* Make sure we have Correction Factor Descriptor. */
   while (!is_cfac) {
-      fread(cf->code, sizeof(cf->code), 1, in);
+      rsl_source_read(cf->code, sizeof(cf->code), 1, in);
       if (strncmp(cf->code, "CFAC", 4) == 0)
 	  is_cfac = 1;
       else {
-	  fread(&cf->len, sizeof(cf->len), 1, in);
+	  rsl_source_read(&cf->len, sizeof(cf->len), 1, in);
 	  if (do_swap) swap_4_bytes(&cf->len);
 	  remaining = (char *) malloc(cf->len-8);
 	  if (!remaining) {
@@ -325,11 +326,11 @@ Correction_factor_desc *dorade_read_correction_factor_desc(FILE *in)
 	      fprintf(stderr,"cf->len = %d\n\n", cf->len);
 	      return NULL;
 	  }
-	  fread(remaining, sizeof(char), cf->len-8, in);
+	  rsl_source_read(remaining, sizeof(char), cf->len-8, in);
 	  free(remaining);
       }
   }
-  fread(&cf->len, sizeof(Correction_factor_desc)-4, 1, in);
+  rsl_source_read(&cf->len, sizeof(Correction_factor_desc)-4, 1, in);
   /* Now, convert from Big Endian. */
   if (do_swap) {
 	swap_4_bytes(&cf->len);
@@ -358,9 +359,9 @@ Correction_factor_desc *dorade_read_correction_factor_desc(FILE *in)
 /*                      dorade_read_sensor                            */
 /*                                                                    */
 /**********************************************************************/
-Sensor_desc            *dorade_read_sensor (FILE *in)
+Sensor_desc            *dorade_read_sensor (Rsl_source *in)
 
-	 /* Read one 'Sensor #n' descriptor from FILE. */
+	 /* Read one 'Sensor #n' descriptor from 'in'. */
 {
   Sensor_desc            *sd;
   int i;
@@ -394,7 +395,7 @@ Sensor_desc            *dorade_read_sensor (FILE *in)
 /*                      dorade_read_sweep_info                        */
 /*                                                                    */
 /**********************************************************************/
-Sweep_info *dorade_read_sweep_info(FILE *in)
+Sweep_info *dorade_read_sweep_info(Rsl_source *in)
 {
   Sweep_info *si;
 
@@ -404,7 +405,7 @@ Sweep_info *dorade_read_sweep_info(FILE *in)
 	return NULL;
   }
 
-  fread(si, sizeof(Sweep_info), 1, in);
+  rsl_source_read(si, sizeof(Sweep_info), 1, in);
   /* FIXME: ?? For now, VOLD is what we expect when there
    *           are no more SWIB.  This is a data driven EOF.
    *           Returning NULL should suffice.
@@ -436,7 +437,7 @@ Sweep_info *dorade_read_sweep_info(FILE *in)
 /*                      dorade_read_ray_info                          */
 /*                                                                    */
 /**********************************************************************/
-Ray_info       *dorade_read_ray_info      (FILE *in)
+Ray_info       *dorade_read_ray_info      (Rsl_source *in)
 {
   Ray_info *ri;
 
@@ -446,7 +447,7 @@ Ray_info       *dorade_read_ray_info      (FILE *in)
 	return NULL;
   }
 
-  fread(ri, sizeof(Ray_info), 1, in);
+  rsl_source_read(ri, sizeof(Ray_info), 1, in);
   /* Now, convert from Big Endian. */
   if (do_swap) {
 	swap_4_bytes(&ri->len);
@@ -471,7 +472,7 @@ Ray_info       *dorade_read_ray_info      (FILE *in)
 /*                      dorade_read_platform_info                     */
 /*                                                                    */
 /**********************************************************************/
-Platform_info  *dorade_read_platform_info (FILE *in)
+Platform_info  *dorade_read_platform_info (Rsl_source *in)
 {
   Platform_info *pi;
   int len_first_two;
@@ -489,13 +490,13 @@ Platform_info  *dorade_read_platform_info (FILE *in)
    * the place of ASIB when radar is grounded.
    */
 
-  fread(pi->code, sizeof(pi->code), 1, in);
-  fread(&pi->len, sizeof(pi->len), 1, in);
+  rsl_source_read(pi->code, sizeof(pi->code), 1, in);
+  rsl_source_read(&pi->len, sizeof(pi->len), 1, in);
   if (do_swap) swap_4_bytes(&pi->len);
   len_first_two = sizeof(pi->code) + sizeof(pi->len);
     
   if (strncmp(pi->code, "ASIB", 4) == 0) {
-      fread(&pi->longitude, sizeof(Platform_info)-len_first_two, 1, in);
+      rsl_source_read(&pi->longitude, sizeof(Platform_info)-len_first_two, 1, in);
       /* Read past any extra bytes. */
       if (pi->len > sizeof(Platform_info)) {
 	  if (read_extra_bytes(pi->len - sizeof(Platform_info), in) <= 0)
@@ -540,7 +541,7 @@ Platform_info  *dorade_read_platform_info (FILE *in)
 /*                                                                    */
 /**********************************************************************/
 
-Parameter_data *dorade_read_parameter_data(FILE *in)
+Parameter_data *dorade_read_parameter_data(Rsl_source *in)
 {
   Parameter_data *pd;
   int len;
@@ -551,9 +552,9 @@ Parameter_data *dorade_read_parameter_data(FILE *in)
 	return NULL;
   }
 
-  fread(&pd->code, sizeof(pd->code), 1, in);
-  fread(&pd->len, sizeof(pd->len), 1, in);
-  fread(&pd->name, sizeof(pd->name), 1, in);
+  rsl_source_read(&pd->code, sizeof(pd->code), 1, in);
+  rsl_source_read(&pd->len, sizeof(pd->len), 1, in);
+  rsl_source_read(&pd->name, sizeof(pd->name), 1, in);
   if (do_swap) swap_4_bytes(&pd->len);
   /* Length is in parameter data block? or calculate if from pd->len. */
 
@@ -566,7 +567,7 @@ Parameter_data *dorade_read_parameter_data(FILE *in)
 	perror("dorade_read_parameter_data: pd->data");
 	return pd;
   }
-  fread(pd->data, sizeof(char), len, in);
+  rsl_source_read(pd->data, sizeof(char), len, in);
   
   /* FIXME: Big endian conversion in caller?  Is that the right place? */
 
@@ -577,7 +578,7 @@ Parameter_data *dorade_read_parameter_data(FILE *in)
 /*                      dorade_read_sweep                             */
 /*                                                                    */
 /**********************************************************************/
-Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd)
+Sweep_record *dorade_read_sweep(Rsl_source *src, Sensor_desc **sd)
 {
   Sweep_record   *sr;
 
@@ -600,7 +601,7 @@ Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd)
   parameter_desc = sd[0]->p_desc;
 
  /* Expect SWIB */
-  sr->s_info = si = dorade_read_sweep_info(fp);
+  sr->s_info = si = dorade_read_sweep_info(src);
   if (!si) {
 	free(sr);
 	return NULL;  /* EOF or error. */
@@ -623,11 +624,11 @@ Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd)
 	  free(sr);
 	  return NULL;  /* EOF or error. */
 	}
-	ri = dorade_read_ray_info(fp);
+	ri = dorade_read_ray_info(src);
 	if (dorade_verbose) {
 	  dorade_print_ray_info(ri);
 	}
-	pi = dorade_read_platform_info(fp);
+	pi = dorade_read_platform_info(src);
 	if (dorade_verbose) {
 	  dorade_print_platform_info(pi);
 	}
@@ -639,7 +640,7 @@ Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd)
 	sr->data_ray[i]->nparam    = nparam;
 
 	for (j=0; j<nparam; j++) {
-	  pd = dorade_read_parameter_data(fp);
+	  pd = dorade_read_parameter_data(src);
 	  /* Perform big endian conversion. */
 	  len = pd->len  /* Use pd->len for now. */
 		- sizeof(pd->code) /* Remove a few bytes from */
@@ -667,6 +668,46 @@ Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd)
 }
 
 
+/**********************************************************************/
+/*                                                                    */
+/*                      dorade_skip_sweep                             */
+/*                                                                    */
+/**********************************************************************/
+Sweep_info *dorade_skip_sweep(Rsl_source *src, Sensor_desc **sd)
+{
+  /* As dorade_read_sweep, but only the SWIB is kept.  The ray blocks,
+   * RYIB, ASIB (or XSTF) and one RDAT per parameter, are passed over
+   * by their lengths.  Returns NULL at the end of the sweeps or if the
+   * input ends inside one.
+   */
+  Sweep_info *si;
+  char code[4];
+  int i, j, len;
+
+  si = dorade_read_sweep_info(src);
+  if (!si) return NULL;
+  if (dorade_verbose) {
+	printf("=====< NEW SWIB >=====\n");
+	dorade_print_sweep_info(si);
+  }
+
+  for (i=0; i<si->nrays; i++)
+	for (j=0; j<sd[0]->nparam + 2; j++) {
+	  if (rsl_source_read(code, sizeof(code), 1, src) != 1 ||
+		  rsl_source_read(&len, sizeof(len), 1, src) != 1) {
+		free(si);
+		return NULL;
+	  }
+	  if (do_swap) swap_4_bytes(&len);
+	  if (len < 8 || !rsl_source_skip(src, len - 8)) {
+		free(si);
+		return NULL;
+	  }
+	}
+  return si;
+}
+
+
 /* MEMORY MANAGEMENT ROUTINES */
 
 /**********************************************************************/
@@ -707,3 +748,27 @@ void dorade_free_sweep(Sweep_record *s)
   if (s->s_info) free(s->s_info);
   free(s);
 }
+
+/**********************************************************************/
+/*                                                                    */
+/*                      dorade_free_sensor                            */
+/*                                                                    */
+/**********************************************************************/
+void dorade_free_sensor(Sensor_desc *s)
+{
+  int i;
+  if (s == NULL) return;
+
+  free(s->radar_desc);
+  if (s->p_desc) {
+	for (i=0; i<s->nparam; i++)
+	  free(s->p_desc[i]);
+	free(s->p_desc);
+  }
+  if (s->cell_range_vector) {
+	free(s->cell_range_vector->range_cell);
+	free(s->cell_range_vector);
+  }
+  free(s->correction_factor_desc);
+  free(s);
+}
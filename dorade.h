@@ -284,30 +284,32 @@ typedef struct {
 } Sweep_record;
 
 /* PROTOTYPES */
-Comment_block *dorade_read_comment_block(FILE *in);
+Comment_block *dorade_read_comment_block(Rsl_source *in);
 
-Volume_desc    *dorade_read_volume_desc    (FILE *in);
+Volume_desc    *dorade_read_volume_desc    (Rsl_source *in);
 
 /* Sensor descriptor routines. */
-Radar_desc     *dorade_read_radar_desc     (FILE *in);
-Parameter_desc *dorade_read_parameter_desc (FILE *in);
-Cell_range_vector      *dorade_read_cell_range_vector     (FILE *in);
-Correction_factor_desc *dorade_read_correction_factor_desc(FILE *in);
-Sensor_desc            *dorade_read_sensor (FILE *in);
+Radar_desc     *dorade_read_radar_desc     (Rsl_source *in);
+Parameter_desc *dorade_read_parameter_desc (Rsl_source *in);
+Cell_range_vector      *dorade_read_cell_range_vector     (Rsl_source *in);
+Correction_factor_desc *dorade_read_correction_factor_desc(Rsl_source *in);
+Sensor_desc            *dorade_read_sensor (Rsl_source *in);
 
-Sweep_info *dorade_read_sweep_info(FILE *in);
-Sweep_record *dorade_read_sweep(FILE *fp, Sensor_desc **sd);
+Sweep_info *dorade_read_sweep_info(Rsl_source *in);
+Sweep_record *dorade_read_sweep(Rsl_source *src, Sensor_desc **sd);
+Sweep_info *dorade_skip_sweep(Rsl_source *src, Sensor_desc **sd);
 
 /* Data Ray routines. */
 
-Ray_info       *dorade_read_ray_info      (FILE *in);
-Platform_info  *dorade_read_platform_info (FILE *in);
-Parameter_data *dorade_read_parameter_data(FILE *in);
-Data_ray       *dorade_read_ray           (FILE *in);
+Ray_info       *dorade_read_ray_info      (Rsl_source *in);
+Platform_info  *dorade_read_platform_info (Rsl_source *in);
+Parameter_data *dorade_read_parameter_data(Rsl_source *in);
+Data_ray       *dorade_read_ray           (Rsl_source *in);
 
 /* Memory management routines. */
 void dorade_free_sweep(Sweep_record *s);
 void dorade_free_data_ray(Data_ray *r);
+void dorade_free_sensor(Sensor_desc *s);
 
 /* Print routines. */
 void dorade_print_sweep_info(Sweep_info *d);
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include "rsl.h"
 #include "dorade.h"
 void dorade_print_sweep_info(Sweep_info *d)
 {
@@ -29,7 +29,6 @@
 #include "rsl.h"
 #include "dorade.h"
 
-extern int radar_verbose_flag;
 
 /********************************************************************/
 /*                                                                  */
@@ -73,8 +72,8 @@ void prt_skipped_field_msg(char *dorade_field_name)
 #define MAXFIELDS 20
   char prtname[9];
   int i, already_printed;
-  static int nskipped = 0;
-  static char skipped_list[MAXFIELDS][9];
+  static RSL_THREAD_LOCAL int nskipped = 0;
+  static RSL_THREAD_LOCAL char skipped_list[MAXFIELDS][9];
 
   /* Make sure name is a properly formed string. */
   strncpy(prtname, dorade_field_name, 8);
@@ -140,18 +139,14 @@ static void ymd(int jday, int year, int *mm, int *dd)
   *dd = jday - daytab[leap][i];
 }
 
-/* Secretly defined in uf_to_radar.c */
-Volume *copy_sweeps_into_volume(Volume *new_volume, Volume *old_volume);
-
 /**********************************************************************/
 /*                                                                    */
-/*                       RSL_dorade_to_radar                          */
+/*                         dorade_to_radar                            */
 /*                                                                    */
 /**********************************************************************/
-Radar *RSL_dorade_to_radar(char *infile)
+static Radar *dorade_to_radar(Rsl_source *src)
 {
   Radar  *radar;
-  Volume *new_volume;
   Sweep  *sweep;
   Ray    *ray;
   int iv, iray, iparam;
@@ -167,7 +162,6 @@ Radar *RSL_dorade_to_radar(char *infile)
   float (*f)(Range x);
   Range (*invf)(float x);
 
-  FILE  *fp;
   Comment_block   *cb;
   Volume_desc     *vd;
   Sensor_desc    **sd;
@@ -181,6 +175,7 @@ Radar *RSL_dorade_to_radar(char *infile)
   int nsweep;
   int i;
   char buf[1024];
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
 
   int degree, minute;
   float second;
@@ -188,33 +183,21 @@ Radar *RSL_dorade_to_radar(char *infile)
   int year, month, day, jday, jday_vol;
 
   radar = NULL;
-  if (infile == NULL) {
-    int save_fd;
-    save_fd = dup(0);
-    fp = fdopen(save_fd, "r");
-  }  else
-    if((fp=fopen(infile, "r"))==(FILE *)NULL) {
-      perror(infile);
-      return radar;
-    }
-
-  fp = uncompress_pipe(fp); /* Transparently, use gunzip. */
-
-  cb = dorade_read_comment_block(fp);
+  cb = dorade_read_comment_block(src);
 
   /**********************************************************************/
 
-  vd = dorade_read_volume_desc(fp);   /* R E A D */
-  if (radar_verbose_flag)   dorade_print_volume_desc(vd);  /* P R I N T */
+  vd = dorade_read_volume_desc(src);   /* R E A D */
+  if (rsl_verbose())   dorade_print_volume_desc(vd);  /* P R I N T */
 
   /* R E A D */
   sd = (Sensor_desc **) calloc(vd->nsensors, sizeof(Sensor_desc *));
   for (i=0; i<vd->nsensors; i++) {
-    sd[i] = dorade_read_sensor(fp);
+    sd[i] = dorade_read_sensor(src);
   }
 
   /* P R I N T */
-  if (radar_verbose_flag) {
+  if (rsl_verbose()) {
     for (i=0; i<vd->nsensors; i++) {
       fprintf(stderr, "============ S E N S O R   # %d =====================\n", i);
       dorade_print_sensor(sd[i]);
@@ -298,7 +281,7 @@ Radar *RSL_dorade_to_radar(char *infile)
    * not the sweeps themselves.
    */
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     fprintf(stderr, "Number of parameters: %d\n", rd->nparam_desc);
 
   /* All the parameters are together, however, their order within
@@ -320,8 +303,9 @@ Radar *RSL_dorade_to_radar(char *infile)
 
 #define DORADE_MAX_SWEEP 20
   nsweep = 0;
-  while((sr = dorade_read_sweep(fp, sd))) {
-    for(iray = 0; iray < sr->nrays; iray++) {
+  while(!rsl_sweeps_done(nsweep) && (sr = dorade_read_sweep(src, sd))) {
+    /* A sweep not selected is read past, but not loaded. */
+    for(iray = 0; iray < sr->nrays && rsl_want_sweep(nsweep); iray++) {
       dray = sr->data_ray[iray];
 
       /* Now, loop through the parameters and fill the rsl structures. */
@@ -332,21 +316,18 @@ Radar *RSL_dorade_to_radar(char *infile)
           prt_skipped_field_msg(pd->name);
           continue;
         }
+        if (!reader->qfield[iv]) continue; /* Not selected. */
         if (radar->v[iv] == NULL) {
           radar->v[iv] = RSL_new_volume(DORADE_MAX_SWEEP); /* Expandable */
         } else if (nsweep >= radar->v[iv]->h.nsweeps) {
           /* Must expand the number of sweeps. */
-          /* Expand by another DORADE_MAX_SWEEP. */
-          if (radar_verbose_flag) {
+          if (rsl_verbose()) {
             fprintf(stderr, "nsweeps (%d) exceeds radar->v[%d]->h.nsweeps (%d)."
               "\n", nsweep, iv, radar->v[iv]->h.nsweeps);
-            fprintf(stderr, "Increasing it to %d sweeps\n",
-              radar->v[iv]->h.nsweeps+DORADE_MAX_SWEEP);
+            fprintf(stderr, "Increasing it to %d sweeps\n", nsweep+1);
           }
-          new_volume = RSL_new_volume(radar->v[iv]->h.nsweeps+DORADE_MAX_SWEEP);
-          /* Look in uf_to_radar.c for 'copy_sweeps_into_volume' */
-          new_volume = copy_sweeps_into_volume(new_volume, radar->v[iv]);
-          radar->v[iv] = new_volume;
+          if (RSL_reserve_sweeps(radar->v[iv], nsweep+1) != 0) continue;
+          radar->v[iv]->h.nsweeps = nsweep+1;
         }
 
         if ((sweep = radar->v[iv]->sweep[nsweep]) == NULL) {
@@ -374,7 +355,7 @@ Radar *RSL_dorade_to_radar(char *infile)
         /* Allocate the ray and load the parameter data. */
 
         if ((ray = sweep->ray[iray]) == NULL) {
-          if (radar_verbose_flag)
+          if (rsl_verbose())
             fprintf(stderr, "Allocating %d bins for ray %d\n",
 	      dray->data_len[iparam], iray);
           ray = sweep->ray[iray] = RSL_new_ray(nbins);
@@ -493,17 +474,117 @@ Radar *RSL_dorade_to_radar(char *infile)
       }
     }
     nsweep++;
-    if (radar_verbose_flag) fprintf(stderr, "______NEW SWEEP__<%d>____\n", nsweep);
+    if (rsl_verbose()) fprintf(stderr, "______NEW SWEEP__<%d>____\n", nsweep);
     /* Save for loading into volume structure. */
     dorade_free_sweep(sr);
   }
 
   /* The following avoids a broken pipe message, since a VOLD at the end
-   * is not read yet.
+   * is not read yet.  Not when we stopped early on purpose, though.
    */
-  while(fread(buf, sizeof(buf), 1, fp)) continue;  /* Read til EOF */
+  if (!rsl_sweeps_done(nsweep))
+    while(rsl_source_read(buf, sizeof(buf), 1, src)) continue; /* Read til EOF */
 
-  rsl_pclose(fp);
+  return RSL_shrink_radar(radar);
+}
 
+/**********************************************************************/
+/*                                                                    */
+/*           RSL_dorade_to_radar, RSL_dorade_to_radar_mem             */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_dorade_to_radar(char *infile)
+{
+  Rsl_source *src;
+  Radar *radar;
+
+  /* Transparently, use gunzip.  NULL infile is stdin. */
+  if ((src = rsl_source_open(infile)) == NULL) return NULL;
+  radar = dorade_to_radar(src);
+  rsl_source_close(src);
   return radar;
 }
+
+Radar *RSL_dorade_to_radar_mem(char *buf, size_t len)
+{
+  Rsl_source *src;
+  Radar *radar;
+
+  if ((src = rsl_source_open_mem(buf, len)) == NULL) return NULL;
+  radar = dorade_to_radar(src);
+  rsl_source_close(src);
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                          dorade_probe                              */
+/*                                                                    */
+/*  Fill 'p' (see RSL_probe) from the volume, sensor and sweep        */
+/*  descriptors.  Ray blocks are passed over without being read.      */
+/*  Returns 0, or -1 on error.                                        */
+/*                                                                    */
+/**********************************************************************/
+int dorade_probe(Rsl_source *src, Rsl_probe *p)
+{
+  Comment_block   *cb;
+  Volume_desc     *vd;
+  Sensor_desc    **sd;
+  Sweep_info      *si;
+  Rsl_probe_sweep *s;
+  int i, iv, nsweep, rc;
+
+  /* The first block, SSWB or COMM, is passed over as dorade_to_radar
+   * does.
+   */
+  cb = dorade_read_comment_block(src);
+  if (cb == NULL) return -1;
+  free(cb->comment);
+  free(cb);
+  vd = dorade_read_volume_desc(src);
+  if (vd == NULL) return -1;
+  if (vd->nsensors != 1) {
+    fprintf(stderr, "RSL_probe: Unable to process for %d DORADE sensors.\n",
+            vd->nsensors);
+    free(vd);
+    return -1;
+  }
+  sd = (Sensor_desc **) calloc(1, sizeof(Sensor_desc *));
+  if (sd == NULL || (sd[0] = dorade_read_sensor(src)) == NULL) {
+    free(sd);
+    free(vd);
+    return -1;
+  }
+
+  sprintf(p->radar_type, "dorade");
+  strncpy(p->name, vd->flight_num, sizeof(p->name)-1);
+  p->month  = vd->month;
+  p->day    = vd->day;
+  p->year   = vd->year;
+  p->hour   = vd->hour;
+  p->minute = vd->minute;
+  p->sec    = vd->second;
+  p->lat = sd[0]->radar_desc->latitude;
+  p->lon = sd[0]->radar_desc->longitude;
+  for (i=0; i<sd[0]->nparam; i++)
+    if ((iv = find_rsl_field_index(sd[0]->p_desc[i]->name)) >= 0)
+      p->field[iv] = 1;
+
+  rc = 0;
+  for (nsweep = 0; (si = dorade_skip_sweep(src, sd)) != NULL; nsweep++) {
+    if ((s = rsl_probe_sweep(p, nsweep)) == NULL) {
+      free(si);
+      rc = -1;
+      break;
+    }
+    s->fix_angle = si->fixed_angle;
+    s->nrays = si->nrays;
+    memmove(s->field, p->field, sizeof(s->field));
+    free(si);
+  }
+
+  dorade_free_sensor(sd[0]);
+  free(sd);
+  free(vd);
+  return rc;
+}
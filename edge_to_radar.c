@@ -93,7 +93,6 @@
 /*----------------------------------------------------------------------*/
 /* External (Import) Variables                                          */
 /*----------------------------------------------------------------------*/
-extern int radar_verbose_flag;
 
 /*----------------------------------------------------------------------*/
 /* External Functions                                                   */
@@ -110,16 +109,16 @@ extern int radar_verbose_flag;
 /*----------------------------------------------------------------------*/
 /* Local (Static) Variables                                             */
 /*----------------------------------------------------------------------*/
-static struct vol_struct *EDGE_vol=NULL;
-static int num_sweeps,num_rays,num_bins,gate_width;
-static float azimuth,elevation;
-static float prf,wavelength,nyq_vel,meansr;
-static struct tm *sweeptime;
-static float lat,lon;
-static int bytes_bin;
-static float beam_width;
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL struct vol_struct *EDGE_vol=NULL;
+static RSL_THREAD_LOCAL int num_sweeps,num_rays,num_bins,gate_width;
+static RSL_THREAD_LOCAL float azimuth,elevation;
+static RSL_THREAD_LOCAL float prf,wavelength,nyq_vel,meansr;
+static RSL_THREAD_LOCAL struct tm *sweeptime;
+static RSL_THREAD_LOCAL float lat,lon;
+static RSL_THREAD_LOCAL int bytes_bin;
+static RSL_THREAD_LOCAL float beam_width;
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
 /*----------------------------------------------------------------------*/
 /* Signal Catching Functions                                            */
@@ -185,7 +184,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 
 	float uz,cz,rv,sw,zdr=0;
 
-	if (radar_verbose_flag) printf("EDGE_to_radar(%s)\n",EDGE_filename);
+	if (rsl_verbose()) printf("EDGE_to_radar(%s)\n",EDGE_filename);
 
 /** Load the EDGE volume structure  **/
 	if (load_data((char **)&EDGE_vol,EDGE_filename,VOL_FILE) == -1)
@@ -205,11 +204,11 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 	bytes_bin = BYTES_BIN(EDGE_vol);
 	prf = (float)EDGE_vol->sweep[0].rad.prf1;
 	wavelength = EDGE_vol->sweep[0].rad.wavelength;
-	if (radar_verbose_flag) printf("bytes_bin: %d  prf %5.0f  wavelength %4.1f\n",
+	if (rsl_verbose()) printf("bytes_bin: %d  prf %5.0f  wavelength %4.1f\n",
 		bytes_bin,prf,wavelength*100.0);
 	nyq_vel = prf*wavelength/4.0;
 	num_sweeps = EDGE_vol->num_sweeps;
-	if (radar_verbose_flag) printf("nyq_vel %5.1f  num_sweeps %d\n",nyq_vel,num_sweeps);
+	if (rsl_verbose()) printf("nyq_vel %5.1f  num_sweeps %d\n",nyq_vel,num_sweeps);
 
 	meansr = 0.0;
 	for(i=0;i<num_sweeps-1;i++)
@@ -261,7 +260,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 	RSL_rad->h.height = EDGE_vol->sweep[0].rad.antenna_height;
 	RSL_rad->h.spulse = EDGE_vol->sweep[0].rad.pulse_width*1200 + 800;
 	RSL_rad->h.lpulse = EDGE_vol->sweep[0].rad.pulse_width*1200 + 800;
-	if (radar_verbose_flag) printf("Radar Header Filled\n");
+	if (rsl_verbose()) printf("Radar Header Filled\n");
 /* 
 	Done with Radar header
 	Now create the necessary volumes and fill the
@@ -269,19 +268,19 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 */
 
 	RSL_rad->v[DZ_INDEX] = RSL_new_volume(num_sweeps);
-	if (radar_verbose_flag) printf("DZ volume created index is %d\n",DZ_INDEX);
+	if (rsl_verbose()) printf("DZ volume created index is %d\n",DZ_INDEX);
 	if ((RSL_rad->v[DZ_INDEX]->h.type_str = malloc(25)) != NULL)
 	{
 		RSL_rad->v[DZ_INDEX]->h.type_str[24] = '\0';
 		strcpy(RSL_rad->v[DZ_INDEX]->h.type_str,"Uncorrected Reflectivity"); 
 	}
-	if (radar_verbose_flag) printf("Uncorrected Reflectivity\n");
+	if (rsl_verbose()) printf("Uncorrected Reflectivity\n");
 	RSL_rad->v[DZ_INDEX]->h.nsweeps = num_sweeps;
-	if (radar_verbose_flag) printf("num_sweeps %d assigned\n",num_sweeps);
+	if (rsl_verbose()) printf("num_sweeps %d assigned\n",num_sweeps);
 	RSL_rad->v[DZ_INDEX]->h.f = DZ_F;
-	if (radar_verbose_flag) printf("DZ_F assigned\n");
+	if (rsl_verbose()) printf("DZ_F assigned\n");
 	RSL_rad->v[DZ_INDEX]->h.invf = DZ_INVF;
-	if (radar_verbose_flag) printf("DZ volume created and header Filled\n");
+	if (rsl_verbose()) printf("DZ volume created and header Filled\n");
 
 	RSL_rad->v[CZ_INDEX] = RSL_new_volume(num_sweeps);
 	if ((RSL_rad->v[CZ_INDEX]->h.type_str = malloc(23)) != NULL)
@@ -292,7 +291,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 	RSL_rad->v[CZ_INDEX]->h.nsweeps = num_sweeps;
 	RSL_rad->v[CZ_INDEX]->h.f = CZ_F;
 	RSL_rad->v[CZ_INDEX]->h.invf = CZ_INVF;
-	if (radar_verbose_flag) printf("CZ volume created and header Filled\n");
+	if (rsl_verbose()) printf("CZ volume created and header Filled\n");
 
 	RSL_rad->v[VR_INDEX] = RSL_new_volume(num_sweeps);
 	if ((RSL_rad->v[VR_INDEX]->h.type_str = malloc(16)) != NULL)
@@ -303,7 +302,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 	RSL_rad->v[VR_INDEX]->h.nsweeps = num_sweeps;
 	RSL_rad->v[VR_INDEX]->h.f = VR_F;
 	RSL_rad->v[VR_INDEX]->h.invf = VR_INVF;
-	if (radar_verbose_flag) printf("VR volume created and header Filled\n");
+	if (rsl_verbose()) printf("VR volume created and header Filled\n");
 
 	RSL_rad->v[SW_INDEX] = RSL_new_volume(num_sweeps);
 	if ((RSL_rad->v[SW_INDEX]->h.type_str = malloc(15)) != NULL)
@@ -314,7 +313,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 	RSL_rad->v[SW_INDEX]->h.nsweeps = num_sweeps;
 	RSL_rad->v[SW_INDEX]->h.f = SW_F;
 	RSL_rad->v[SW_INDEX]->h.invf = SW_INVF;
-	if (radar_verbose_flag) printf("SW volume created and header Filled\n");
+	if (rsl_verbose()) printf("SW volume created and header Filled\n");
 
 	if (bytes_bin == 5) 
 	{
@@ -328,7 +327,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 		RSL_rad->v[ZD_INDEX]->h.nsweeps = num_sweeps;
 		RSL_rad->v[ZD_INDEX]->h.f = ZD_F;
 		RSL_rad->v[ZD_INDEX]->h.invf = ZD_INVF;
-		if (radar_verbose_flag) printf("ZD volume created and header Filled\n");
+		if (rsl_verbose()) printf("ZD volume created and header Filled\n");
 	}
 /*
 	Volume Headers complete now fill the sweeps
@@ -336,7 +335,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 
 	for (i=0;i<num_sweeps;i++)
 	{
-		if (radar_verbose_flag) printf("Sweep number %d\n",i);
+		if (rsl_verbose()) printf("Sweep number %d\n",i);
 		num_rays = EDGE_vol->sweep[i].num_rays;
 		sray = (unsigned short *)RAY_PTR(EDGE_vol,i,10);
                 elevation = ((float)(BINEL2IANG100(sray[1])) +
@@ -476,7 +475,7 @@ Radar *RSL_EDGE_to_radar(char *EDGE_filename)
 			}
 		}
 	}
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  printf("EDGE to RSL conversion complete\n");	
 	free(EDGE_vol);
 	RSL_rad = RSL_prune_radar(RSL_rad);
@@ -12,60 +12,17 @@
 #include <stdlib.h>
 #include "rsl.h"
 
-/* Exists in volume.c */
-int SWEEP_INDEX(Sweep *s);
-
-void print_link_list(Azimuth_hash *list)
-{
-  if (list == NULL) {
-	printf("\n");
-	return;
-  }
-  printf("ray# %d azim %f, hi# %d lo# %d|", list->ray->h.ray_num, list->ray->h.azimuth, list->ray_high->ray->h.ray_num, list->ray_low->ray->h.ray_num);
-  print_link_list(list->next);
-}
-  
-
-/*
- * Cannot compile if the hash table is static in volume.c.  For
- * testing we make it globally known.
- */
-
-typedef struct {
-  Sweep *s_addr;
-  Hash_table *hash;
-} Sweep_list;
-
-extern int RSL_max_sweeps; /* Initial allocation for sweep_list.
-							* RSL_new_sweep will allocate the space first
-							* time around.
-							*/
-extern int RSL_nsweep_addr; /* A count of sweeps in the table. */
-extern Sweep_list *RSL_sweep_list;
-extern int RSL_nextents;
-
 void print_hash_table (Sweep *s)
 {
   int i;
-  int sweep_index;
-  Azimuth_hash *index;
-  float azim;
-  float res;
+  Hash_table *hash;
 
   if (s == NULL) return;
-  sweep_index = SWEEP_INDEX(s);
-  res = 360.0/RSL_sweep_list[sweep_index].hash->nindexes;
-  printf("Azimuth resolution = %f for %d bins.\n", res, RSL_sweep_list[sweep_index].hash->nindexes);
-  for (i=0; i<RSL_sweep_list[sweep_index].hash->nindexes; i++) {
-	index = RSL_sweep_list[sweep_index].hash->indexes[i];
-	azim = i/res;
-	printf("RSL_sweep_list[%d].hash->indexes[%d] = ", sweep_index, i);
-	
-	if (index == NULL) 
-	  printf("IS NULL\n");
-	else 
-	  print_link_list(index);
-  }
+  hash = hash_table_for_sweep(s);
+  if (hash == NULL) return;
+  printf("%d rays, %d buckets of %f degrees.\n", hash->nrays, hash->nbuckets, hash->res);
+  for (i=0; i<hash->nrays; i++)
+	printf("hash->ray[%d] = ray# %d azim %f\n", i, hash->ray[i]->h.ray_num, hash->azimuth[i]);
 }
 
 void poke_about_sweep(Sweep *s)
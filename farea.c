@@ -67,11 +67,13 @@ float RSL_area_of_ray(Ray *r, float lo, float hi, float min_range, float max_ran
   int i;
   float start_km;
   float xdBZ;
-  float r1, r2, area;
+  float area;
   int nbins, bin1;
   float binsize;
+  float *f;
   
   if (r == NULL) return 0.0;
+  f = RSL_f_table(r->h.f);
   /* Check if min_range is closer to the radar than the first bin.
    * If so, we can't use it.
    */
@@ -90,16 +92,18 @@ float RSL_area_of_ray(Ray *r, float lo, float hi, float min_range, float max_ran
   /* Compute the number of pixels with lo < dBZ <= hi */
   area = 0.0;
 
-  for(i=bin1; i<nbins-1; i++) {
-	xdBZ = r->h.f(r->range[i]);
-	if(lo < xdBZ && xdBZ <= hi) { /*MAX_DBZ = hi (typically 70?) */
-	  /* get r1 and r2 in km */
-	  r1 = i * binsize + start_km;
-	  r2 = (i+1) * binsize + start_km;
-	  area += get_pixel_area(r, r1, r2);
- 	}
-	r1 = i * binsize + start_km;
-  }
+  if (f)
+	for(i=bin1; i<nbins-1; i++) {
+	  xdBZ = f[r->range[i]];
+	  if(lo < xdBZ && xdBZ <= hi) /*MAX_DBZ = hi (typically 70?) */
+		area += get_pixel_area(r, i*binsize + start_km, (i+1)*binsize + start_km);
+	}
+  else
+	for(i=bin1; i<nbins-1; i++) {
+	  xdBZ = r->h.f(r->range[i]);
+	  if(lo < xdBZ && xdBZ <= hi)
+		area += get_pixel_area(r, i*binsize + start_km, (i+1)*binsize + start_km);
+	}
 
   return area;
 }  
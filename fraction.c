@@ -53,17 +53,26 @@ Frac_ratio RSL_ratio_of_ray(Ray *r, float lo, float hi, float range)
   int i;
   int ibin_range;  /* Maximum bin include, based on range. */
   Frac_ratio fr;
+  float *f, x;
 
   fr.n = fr.ntotal = 0;
 
   if (r == NULL) return fr;
+  f = RSL_f_table(r->h.f);
   fr.n = 0;
   ibin_range = range /( (float)r->h.gate_size / 1000.0 );
   if (ibin_range > r->h.nbins) ibin_range = r->h.nbins;
-  for (i=0; i<ibin_range; i++) {
-	if (lo <= r->h.f(r->range[i]) && r->h.f(r->range[i]) <= hi) fr.n++;
-	fr.ntotal++;
-  }
+  if (f)
+	for (i=0; i<ibin_range; i++) {
+	  x = f[r->range[i]];
+	  if (lo <= x && x <= hi) fr.n++;
+	}
+  else
+	for (i=0; i<ibin_range; i++) {
+	  x = r->h.f(r->range[i]);
+	  if (lo <= x && x <= hi) fr.n++;
+	}
+  if (ibin_range > 0) fr.ntotal = ibin_range;
   return fr;
 }
 
@@ -25,7 +25,6 @@
 
 #include "rsl.h"
 
-extern int radar_verbose_flag;
 
 
 /***************************************************************************
@@ -49,7 +48,7 @@ Radar *RSL_get_window_from_radar(Radar *r, float min_range, float max_range,
   Radar *new_radar;
   
   if (min_range > max_range || min_range < 0 || max_range < 0){
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	fprintf(stderr,"Get win from radar: given invalid min range (%f) or max range (%f)\n",
 		   min_range, max_range);
 	return NULL;
@@ -60,7 +59,7 @@ Radar *RSL_get_window_from_radar(Radar *r, float min_range, float max_range,
   new_radar->h = r->h;
 
   for (i = 0; i < r->h.nvolumes; i++) {
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"Getting window from volume for v[%d] out of %d volumes\n",
 			 i,r->h.nvolumes );
 
@@ -79,7 +78,7 @@ Volume *RSL_get_window_from_volume(Volume *v, float min_range, float max_range,
   Sweep  *new_sweep;
 
   if (min_range > max_range || min_range < 0 || max_range < 0){
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	fprintf(stderr,"Get win from volume: given invalid min range (%f) or max range (%f)\n",
 		   min_range, max_range);
 	return NULL;
@@ -90,7 +89,7 @@ Volume *RSL_get_window_from_volume(Volume *v, float min_range, float max_range,
   new_volume->h = v->h;
 
   for (i = 0; i < v->h.nsweeps; i++) {
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"Getting window from sweep for s[%d] out of %d sweeps\n", 
 			 i,v->h.nsweeps); 
 
@@ -99,7 +98,7 @@ Volume *RSL_get_window_from_volume(Volume *v, float min_range, float max_range,
 	new_volume->sweep[i] = new_sweep;
   }
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Got win from volume: orig volume has %d sweeps, new "
 		   "volume has %d sweeps\n",v->h.nsweeps,new_volume->h.nsweeps);
   
@@ -114,7 +113,7 @@ Sweep *RSL_get_window_from_sweep(Sweep *s, float min_range, float max_range,
   Ray   *new_ray;
 
   if (min_range > max_range || min_range < 0 || max_range < 0){
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	fprintf(stderr,"Get win from sweep: given invalid min range (%f) or max range (%f)\n",
 		   min_range, max_range);
 	return NULL;
@@ -134,7 +133,7 @@ Sweep *RSL_get_window_from_sweep(Sweep *s, float min_range, float max_range,
   }
 
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Got win from sweep: orig sweep has %d rays, new sweep "
 		   "has %d rays.\n",s->h.nrays,new_sweep->h.nrays);
 
@@ -151,7 +150,7 @@ Ray *RSL_get_window_from_ray(Ray *r, float min_range, float max_range,
   int i;
 
   if (min_range > max_range || min_range < 0 || max_range < 0){
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	fprintf(stderr,"Get win from ray: given invalid min range (%f) or max range (%f)\n",
 		   min_range, max_range);
 	return NULL;
@@ -202,3 +201,103 @@ Ray *RSL_get_window_from_ray(Ray *r, float min_range, float max_range,
 
 
 
+
+/***************************************************************************
+ *                         RSL_read_window
+ *                         RSL_read_window_off
+ *                         RSL_reader_read_window
+ *                         RSL_reader_read_window_off
+ *
+ * Have the ingest routines keep only the window, without first decoding
+ * the whole radar.  Rays outside the azimuth sector are not read, and
+ * gates beyond max_range are neither converted nor allocated.  Gates
+ * short of min_range are zeroed, as RSL_get_window_from_ray does.
+ * When low_azim > hi_azim, the sector runs through north.
+ *
+ * This is not RSL_get_window_from_radar applied to the result: a ray's
+ * nbins ends at max_range instead of keeping zeroed gates out to the
+ * original nbins, and readers that append rays (UF, WSR-88D Message 1)
+ * leave out the rays outside the sector rather than leaving NULL slots,
+ * so ray indexes and nrays can differ.
+ ***************************************************************************/
+
+void RSL_reader_read_window(Rsl_reader *r, float min_range, float max_range,
+							float low_azim, float hi_azim)
+{
+  if (min_range > max_range || min_range < 0 || max_range < 0){
+	fprintf(stderr,"RSL_read_window: given invalid min range (%f) or max range (%f)\n",
+		   min_range, max_range);
+	return;
+  }
+  r->window = 1;
+  r->min_range = min_range;
+  r->max_range = max_range;
+  r->low_azim  = low_azim;
+  r->hi_azim   = hi_azim;
+}
+
+void RSL_reader_read_window_off(Rsl_reader *r)
+{
+  r->window = 0;
+}
+
+void RSL_read_window(float min_range, float max_range,
+					 float low_azim, float hi_azim)
+{
+  RSL_reader_read_window(rsl_reader(), min_range, max_range,
+						 low_azim, hi_azim);
+}
+
+void RSL_read_window_off(void)
+{
+  RSL_reader_read_window_off(rsl_reader());
+}
+
+/***************************************************************************
+ *                         rsl_want_azimuth
+ *                         rsl_window_bins
+ *
+ * The window, as set by RSL_read_window, for the ingest routines.
+ * rsl_want_azimuth says whether to read the ray at 'azimuth'.
+ * rsl_window_bins returns how many of the ray's 'nbins' gates to keep,
+ * and sets *first to the first gate inside min_range.  range_bin1 and
+ * gate_size are in meters.  Without a window, all gates are kept.
+ ***************************************************************************/
+
+int rsl_want_azimuth(float azimuth)
+{
+  Rsl_reader *r = rsl_reader();
+
+  if (!r->window) return 1;
+  if (r->low_azim <= r->hi_azim)
+	return azimuth >= r->low_azim && azimuth < r->hi_azim;
+  return azimuth >= r->low_azim || azimuth < r->hi_azim;
+}
+
+int rsl_window_bins(float range_bin1, float gate_size, int nbins, int *first)
+{
+  Rsl_reader *r = rsl_reader();
+  float start_km, binsize;
+  int start_index, end_index;
+
+  *first = 0;
+  if (!r->window || gate_size <= 0 || nbins <= 0) return nbins;
+
+  /* convert from meter to km */
+  start_km = range_bin1/1000.0;
+  binsize = gate_size/1000.0;
+
+  if (r->max_range < start_km) return 0;
+  end_index = (int) ( (r->max_range - start_km) / binsize) + 1;
+  if (end_index > nbins)
+	end_index = nbins;
+
+  if (r->min_range == 0.0 || r->min_range < start_km)
+	start_index = 0;
+  else
+	start_index = (int) ( (r->min_range - start_km) / binsize);
+  if (start_index > end_index) start_index = end_index;
+
+  *first = start_index;
+  return end_index;
+}
@@ -79,16 +79,19 @@ Ray *RSL_ray_z_to_r(Ray *z_ray, float k, float a)
 	Ray 	*r_ray;
 	int		i;	
 	Range (*invf)(float x);
-	float (*f)(Range x);
+	float *f;
 
 	if (z_ray == NULL) return NULL;
+	f = RSL_f_table(z_ray->h.f);
 	r_ray = RSL_new_ray(z_ray->h.nbins);
 	r_ray->h = z_ray->h;
-	f = r_ray->h.f;
 	invf = r_ray->h.invf;
-	for(i=0; i<z_ray->h.nbins; i++) {
-		r_ray->range[i] = invf(RSL_z_to_r( f(z_ray->range[i]), k, a));
-	}
+	if (f)
+		for(i=0; i<z_ray->h.nbins; i++)
+			r_ray->range[i] = invf(RSL_z_to_r(f[z_ray->range[i]], k, a));
+	else
+		for(i=0; i<z_ray->h.nbins; i++)
+			r_ray->range[i] = invf(RSL_z_to_r(z_ray->h.f(z_ray->range[i]), k, a));
 	return r_ray;
 	
 }
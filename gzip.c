@@ -20,21 +20,81 @@
     License along with this library; if not, write to the Free
     Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#define _GNU_SOURCE /* For fopencookie. */
 #include <stdio.h>
+#include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #define _USE_BSD
 #include <sys/types.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <zlib.h>
+#include <bzlib.h>
+#include <pthread.h>
+#include "rsl.h"
 
 /* Prototype definitions within this file. */
 int no_command (char *cmd);
 FILE *uncompress_pipe (FILE *fp);
 FILE *compress_pipe (FILE *fp);
+FILE *uncompress_pipe_ar2v (FILE *fp);
 
+/* Streams that came from popen, or from a command run by spawn_reader
+ * (pid > 0), perhaps with a thread feeding it.  Everything else
+ * rsl_pclose fclose's.  Shared by all threads, hence the lock.
+ */
+typedef struct _rsl_pipe {
+  FILE *fp;
+  pid_t pid;
+  int has_feeder;
+  pthread_t feeder;
+  struct _rsl_pipe *next;
+} Rsl_pipe;
+static Rsl_pipe *rsl_pipes = NULL;
+static pthread_mutex_t rsl_pipes_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void rsl_pipe_add(FILE *fp, pid_t pid, pthread_t *feeder)
+{
+  Rsl_pipe *p;
+  if (fp == NULL) return;
+  p = (Rsl_pipe *)malloc(sizeof(Rsl_pipe));
+  if (p == NULL) return;
+  p->fp = fp;
+  p->pid = pid;
+  p->has_feeder = feeder != NULL;
+  if (feeder) p->feeder = *feeder;
+  pthread_mutex_lock(&rsl_pipes_lock);
+  p->next = rsl_pipes;
+  rsl_pipes = p;
+  pthread_mutex_unlock(&rsl_pipes_lock);
+}
+
+static Rsl_pipe *rsl_pipe_remove(FILE *fp)
+{
+  /* If 'fp' is a pipe, remove it from the list and return it, for the
+   * caller to free.  Else NULL.
+   */
+  Rsl_pipe **pp, *p;
+  pthread_mutex_lock(&rsl_pipes_lock);
+  for (pp = &rsl_pipes; *pp != NULL; pp = &(*pp)->next)
+	if ((*pp)->fp == fp) {
+	  p = *pp;
+	  *pp = p->next;
+	  pthread_mutex_unlock(&rsl_pipes_lock);
+	  return p;
+	}
+  pthread_mutex_unlock(&rsl_pipes_lock);
+  return NULL;
+}
 
 /* Avoids the 'Broken pipe' message by reading the rest of the stream. */
 void rsl_readflush(FILE *fp)
@@ -48,7 +108,26 @@ void rsl_readflush(FILE *fp)
 	
 int rsl_pclose(FILE *fp)
 {
-  int rc;
+  Rsl_pipe *p;
+  pid_t pid;
+  int rc, status;
+
+  if ((p = rsl_pipe_remove(fp)) == NULL) {
+	if ((rc=fclose(fp)) == EOF)
+	  perror ("fclose");
+	return rc;
+  }
+  if (p->pid > 0) { /* From spawn_reader; as pclose, its exit status. */
+	if (fclose(fp) == EOF)
+	  perror ("fclose");
+	while ((pid = waitpid(p->pid, &status, 0)) < 0 && errno == EINTR)
+	  continue;
+	rc = pid < 0 ? -1 : status;
+	if (p->has_feeder) pthread_join(p->feeder, NULL);
+	free(p);
+	return rc;
+  }
+  free(p);
   if ((rc=pclose(fp)) == EOF) {
 	perror ("pclose");  /* This or fclose do the job. */
 	if ((rc=fclose(fp)) == EOF)
@@ -67,27 +146,503 @@ int no_command (char *cmd)
   else return !0;
 }
 
-FILE *uncompress_pipe (FILE *fp)
+extern char **environ;
+
+static FILE *spawn_reader (char *const argv[], int infd, pid_t *pid)
+{
+  /* Run argv[0], found in PATH, reading 'infd'; return a stream of its
+   * output, and its process id in *pid for rsl_pipe_add.  The command's
+   * standard input is set up in the child alone, so other threads are
+   * not disturbed.  NULL on error.
+   */
+  posix_spawn_file_actions_t fa;
+  FILE *fpipe;
+  int fd[2], rc;
+
+  if (pipe(fd) < 0) return NULL;
+  fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+  rc = posix_spawn_file_actions_init(&fa);
+  if (rc == 0) {
+	posix_spawn_file_actions_adddup2(&fa, infd, 0);
+	posix_spawn_file_actions_adddup2(&fa, fd[1], 1);
+	rc = posix_spawnp(pid, argv[0], &fa, NULL, argv, environ);
+	posix_spawn_file_actions_destroy(&fa);
+  }
+  close(fd[1]);
+  if (rc != 0) {
+	close(fd[0]);
+	errno = rc;
+	return NULL;
+  }
+  if ((fpipe = fdopen(fd[0], "r")) == NULL) {
+	close(fd[0]);
+	waitpid(*pid, NULL, 0);
+	return NULL;
+  }
+  return fpipe;
+}
+
+static FILE *gzip_pipe (FILE *fp)
 {
   /* Pass the file pointed to by 'fp' through the gzip pipe. */
 
+  static char *const gzip[] = {"gzip", "-q", "-d", "-f", "--stdout", NULL};
   FILE *fpipe;
-  int save_fd;
+  pid_t pid;
 
   if (no_command("gzip --version > /dev/null 2>&1")) return fp;
+  fpipe = spawn_reader(gzip, fileno(fp), &pid);
+  if (fpipe == NULL) perror("uncompress_pipe");
+  fclose(fp);
+  rsl_pipe_add(fpipe, pid, NULL);
+  return fpipe;
+}
+
+FILE *uncompress_pipe_ar2v (FILE *fp)
+{
+  /* Pass the file pointed to by 'fp' through the bzip2 pipe.
+   * Only used when wsr88d_ar2v_open can't make a stream.
+   */
+
+  FILE *fpipe;
+  int save_fd;
+
+  if (no_command("wsr88d_decode_ar2v > /dev/null")){
+    fprintf(stderr, "wsr88d_decode_ar2v not found, aborting ...\n");
+    return fp;
+  }
   save_fd = dup(0);
   close(0); /* Redirect stdin for gzip. */
   dup(fileno(fp));
 
-  fpipe = popen("gzip -q -d -f --stdout", "r");
-  if (fpipe == NULL) perror("uncompress_pipe");
+  fpipe = popen("wsr88d_decode_ar2v --stdout", "r");
+  if (fpipe == NULL) perror("uncompress_pipe_ar2v");
   close(0);
   dup(save_fd);
   close(save_fd);
   fclose(fp);
+  rsl_pipe_add(fpipe, 0, NULL);
+  return fpipe;
+}
+
+
+/**********************************************************************/
+/*                                                                    */
+/*                     rsl_fopen_reader                               */
+/*                                                                    */
+/*  Make a read-only stdio stream out of a read function and a close  */
+/*  function.  The read function returns the number of bytes placed   */
+/*  in 'buf', 0 at end of file, or -1 on error.  Returns NULL when    */
+/*  the C library has neither fopencookie nor funopen.                */
+/*                                                                    */
+/**********************************************************************/
+typedef struct {
+  void *cookie;
+  long (*read)(void *cookie, char *buf, size_t size);
+  int  (*close)(void *cookie);
+} Rsl_cookie;
+
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t rsl_cookie_read(void *cookie, char *buf, size_t size)
+#else
+static int rsl_cookie_read(void *cookie, char *buf, int size)
+#endif
+{
+  Rsl_cookie *r = (Rsl_cookie *)cookie;
+  return r->read(r->cookie, buf, size);
+}
+
+static int rsl_cookie_close(void *cookie)
+{
+  Rsl_cookie *r = (Rsl_cookie *)cookie;
+  int rc;
+  rc = r->close(r->cookie);
+  free(r);
+  return rc;
+}
+#endif
+
+FILE *rsl_fopen_reader(void *cookie,
+					   long (*read)(void *cookie, char *buf, size_t size),
+					   int  (*close)(void *cookie))
+{
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+  Rsl_cookie *r;
+  FILE *fp;
+#ifdef HAVE_FOPENCOOKIE
+  cookie_io_functions_t io = {rsl_cookie_read, NULL, NULL, rsl_cookie_close};
+#endif
+
+  r = (Rsl_cookie *)malloc(sizeof(Rsl_cookie));
+  if (r == NULL) return NULL;
+  r->cookie = cookie;
+  r->read   = read;
+  r->close  = close;
+#ifdef HAVE_FOPENCOOKIE
+  fp = fopencookie(r, "r", io);
+#else
+  fp = funopen(r, rsl_cookie_read, NULL, NULL, rsl_cookie_close);
+#endif
+  if (fp == NULL) free(r);
+  return fp;
+#else
+  return NULL;
+#endif
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*  In-process decompression.                                         */
+/*                                                                    */
+/*  uncompress_pipe wraps the input stream in a stdio stream whose    */
+/*  read function inflates gzip or bzip2 data on the fly.  No child   */
+/*  process is involved.  Uncompressed input is handed back as is.    */
+/*                                                                    */
+/**********************************************************************/
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+
+#define RSL_ZBUFSIZ 65536
+
+enum {RSL_Z_NONE, RSL_Z_GZIP, RSL_Z_BZIP2};
+
+typedef struct {
+  FILE *fp;         /* Compressed input.  Owned by this stream. */
+  int kind;         /* RSL_Z_NONE, RSL_Z_GZIP or RSL_Z_BZIP2. */
+  int eof;          /* No more input in 'fp'. */
+  int done;         /* Decoder finished; report end of file. */
+  int nstreams;     /* Number of gzip members or bzip2 streams begun. */
+  z_stream zs;
+  bz_stream bzs;
+  unsigned char *next_in;  /* Unconsumed input in 'in'. */
+  size_t avail_in;
+  unsigned char in[RSL_ZBUFSIZ];
+} Rsl_zstream;
+
+static void rsl_zfill(Rsl_zstream *z)
+{
+  size_t n;
+  if (z->avail_in > 0 || z->eof) return;
+  n = fread(z->in, 1, sizeof(z->in), z->fp);
+  if (n == 0) z->eof = 1;
+  z->next_in = z->in;
+  z->avail_in = n;
+}
+
+static int rsl_zinit(Rsl_zstream *z)
+{
+  memset(&z->zs, 0, sizeof(z->zs));
+  memset(&z->bzs, 0, sizeof(z->bzs));
+  z->nstreams++;
+  if (z->kind == RSL_Z_GZIP)
+	return inflateInit2(&z->zs, 15+32) == Z_OK; /* gzip or zlib header. */
+  if (z->kind == RSL_Z_BZIP2)
+	return BZ2_bzDecompressInit(&z->bzs, 0, 0) == BZ_OK;
+  return 1;
+}
+
+static void rsl_zend(Rsl_zstream *z)
+{
+  if (z->kind == RSL_Z_GZIP) inflateEnd(&z->zs);
+  if (z->kind == RSL_Z_BZIP2) BZ2_bzDecompressEnd(&z->bzs);
+}
+
+static long rsl_zread_gzip(Rsl_zstream *z, char *buf, size_t size)
+{
+  int rc;
+
+  z->zs.next_out  = (Bytef *)buf;
+  z->zs.avail_out = size;
+  while (z->zs.avail_out > 0 && !z->done) {
+	rsl_zfill(z);
+	if (z->avail_in == 0) { /* Truncated input; keep what we have. */
+	  z->done = 1;
+	  break;
+	}
+	z->zs.next_in  = z->next_in;
+	z->zs.avail_in = z->avail_in;
+	rc = inflate(&z->zs, Z_NO_FLUSH);
+	z->next_in  = z->zs.next_in;
+	z->avail_in = z->zs.avail_in;
+	if (rc == Z_STREAM_END) {
+	  /* Like 'gzip -d', continue with concatenated members. */
+	  rsl_zfill(z);
+	  if (z->avail_in == 0) z->done = 1;
+	  else {
+		inflateReset(&z->zs);
+		z->nstreams++;
+	  }
+	} else if (rc == Z_DATA_ERROR && z->nstreams > 1 && z->zs.total_out == 0) {
+	  z->done = 1; /* Trailing garbage after the last member. */
+	} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+	  fprintf(stderr, "uncompress_pipe: inflate: %s\n",
+			  z->zs.msg ? z->zs.msg : "error");
+	  z->done = 1;
+	  if (z->zs.avail_out == size) return -1;
+	}
+  }
+  return size - z->zs.avail_out;
+}
+
+static long rsl_zread_bzip2(Rsl_zstream *z, char *buf, size_t size)
+{
+  int rc;
+
+  z->bzs.next_out  = buf;
+  z->bzs.avail_out = size;
+  while (z->bzs.avail_out > 0 && !z->done) {
+	rsl_zfill(z);
+	if (z->avail_in == 0) {
+	  z->done = 1;
+	  break;
+	}
+	z->bzs.next_in  = (char *)z->next_in;
+	z->bzs.avail_in = z->avail_in;
+	rc = BZ2_bzDecompress(&z->bzs);
+	z->next_in  = (unsigned char *)z->bzs.next_in;
+	z->avail_in = z->bzs.avail_in;
+	if (rc == BZ_STREAM_END) {
+	  /* Concatenated streams, as written by pbzip2. */
+	  unsigned int avail_out = z->bzs.avail_out;
+	  char *next_out = z->bzs.next_out;
+	  rsl_zfill(z);
+	  BZ2_bzDecompressEnd(&z->bzs);
+	  if (z->avail_in == 0 || !rsl_zinit(z)) {
+		z->done = 1;
+		z->kind = RSL_Z_NONE; /* Nothing left to end. */
+	  }
+	  z->bzs.next_out  = next_out;
+	  z->bzs.avail_out = avail_out;
+	} else if (rc == BZ_DATA_ERROR_MAGIC && z->nstreams > 1) {
+	  z->done = 1; /* Trailing garbage after the last stream. */
+	} else if (rc != BZ_OK) {
+	  fprintf(stderr, "uncompress_pipe: BZ2_bzDecompress error %d\n", rc);
+	  z->done = 1;
+	  if (z->bzs.avail_out == size) return -1;
+	}
+  }
+  return size - z->bzs.avail_out;
+}
+
+static long rsl_zread_none(Rsl_zstream *z, char *buf, size_t size)
+{
+  size_t n;
+
+  /* First the bytes used to sniff the magic, then the rest of the file. */
+  if (z->avail_in > 0) {
+	n = size < z->avail_in ? size : z->avail_in;
+	memcpy(buf, z->next_in, n);
+	z->next_in  += n;
+	z->avail_in -= n;
+	return n;
+  }
+  return fread(buf, 1, size, z->fp);
+}
+
+static long rsl_zread(void *cookie, char *buf, size_t size)
+{
+  Rsl_zstream *z = (Rsl_zstream *)cookie;
+
+  switch (z->kind) {
+  case RSL_Z_GZIP:  return rsl_zread_gzip(z, buf, size);
+  case RSL_Z_BZIP2: return rsl_zread_bzip2(z, buf, size);
+  default:
+	if (z->done) return 0;
+	return rsl_zread_none(z, buf, size);
+  }
+}
+
+static int rsl_zclose(void *cookie)
+{
+  Rsl_zstream *z = (Rsl_zstream *)cookie;
+  int rc;
+
+  rsl_zend(z);
+  rc = fclose(z->fp);
+  free(z);
+  return rc;
+}
+
+static FILE *rsl_zopen(FILE *fp, int kind, unsigned char *magic, size_t nmagic)
+{
+  Rsl_zstream *z;
+  FILE *zfp;
+
+  z = (Rsl_zstream *)calloc(1, sizeof(Rsl_zstream));
+  if (z == NULL) {
+	perror("uncompress_pipe");
+	return fp;
+  }
+  z->fp = fp;
+  z->kind = kind;
+  memcpy(z->in, magic, nmagic);
+  z->next_in = z->in;
+  z->avail_in = nmagic;
+  if (!rsl_zinit(z)) {
+	fprintf(stderr, "uncompress_pipe: Unable to initialize decompression.\n");
+	free(z);
+	return fp;
+  }
+  zfp = rsl_fopen_reader(z, rsl_zread, rsl_zclose);
+  if (zfp == NULL) {
+	perror("uncompress_pipe");
+	rsl_zend(z);
+	free(z);
+	return fp;
+  }
+  return zfp;
+}
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef struct {
+  FILE *fp;
+  int fd;
+  unsigned char buf[3];
+  size_t n;
+} Rsl_feed;
+
+static int feed_send(int fd, char *buf, size_t n)
+{
+  /* Write all of buf; 0 once the reader has gone. */
+  ssize_t k;
+
+  while (n > 0) {
+	if ((k = send(fd, buf, n, MSG_NOSIGNAL)) < 0) {
+	  if (errno == EINTR) continue;
+	  return 0;
+	}
+	buf += k;
+	n -= k;
+  }
+  return 1;
+}
+
+static void *feed_thread(void *arg)
+{
+  /* Send f->buf, then the rest of f->fp, to f->fd; then close both. */
+  Rsl_feed *f = (Rsl_feed *)arg;
+  char copy[4096];
+  size_t k;
+
+  if (feed_send(f->fd, (char *)f->buf, f->n))
+	while ((k = fread(copy, 1, sizeof(copy), f->fp)) > 0)
+	  if (!feed_send(f->fd, copy, k)) break;
+  close(f->fd);
+  fclose(f->fp);
+  free(f);
+  return NULL;
+}
+
+static FILE *gzip_pipe_unread (FILE *fp, unsigned char *buf, size_t n)
+{
+  /* As gzip_pipe, for a pipe whose first 'n' bytes, 'buf', were already
+   * read.  A thread feeds them, then the rest of 'fp', to gzip through
+   * a socket; sending with MSG_NOSIGNAL, it raises no SIGPIPE if gzip
+   * quits early.  rsl_pclose waits for gzip and the thread.
+   */
+  static char *const gzip[] = {"gzip", "-q", "-d", "-f", "--stdout", NULL};
+  pthread_t thread;
+  Rsl_feed *f;
+  FILE *fpipe;
+  pid_t pid;
+  int fd[2];
+
+  if (n > sizeof(f->buf) || no_command("gzip --version > /dev/null 2>&1"))
+	return rsl_unread(fp, (char *)buf, n);
+  if ((f = (Rsl_feed *)malloc(sizeof(Rsl_feed))) == NULL ||
+	  socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0) {
+	perror("uncompress_pipe");
+	free(f);
+	return rsl_unread(fp, (char *)buf, n);
+  }
+  fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+  shutdown(fd[0], SHUT_WR);
+  if ((fpipe = spawn_reader(gzip, fd[0], &pid)) == NULL) {
+	perror("uncompress_pipe");
+	close(fd[0]);
+	close(fd[1]);
+	free(f);
+	return rsl_unread(fp, (char *)buf, n);
+  }
+  close(fd[0]);
+  f->fp = fp;
+  f->fd = fd[1];
+  memcpy(f->buf, buf, n);
+  f->n = n;
+  if (pthread_create(&thread, NULL, feed_thread, f) != 0) {
+	/* gzip gets no input and ends; there is no data. */
+	perror("uncompress_pipe");
+	close(fd[1]);
+	fclose(fp);
+	free(f);
+	rsl_pipe_add(fpipe, pid, NULL);
+  } else
+	rsl_pipe_add(fpipe, pid, &thread); /* rsl_pclose joins it. */
   return fpipe;
 }
 
+FILE *uncompress_pipe (FILE *fp)
+{
+  /* Return a stream that delivers the uncompressed contents of 'fp'.
+   * gzip and bzip2 data are decoded in this process.  The returned
+   * stream owns 'fp'; close it with rsl_pclose.
+   */
+  unsigned char magic[3];
+  size_t n;
+  long pos;
+
+  if (fp == NULL) return fp;
+  pos = ftell(fp);
+  n = fread(magic, 1, sizeof(magic), fp);
+
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+	return rsl_zopen(fp, RSL_Z_GZIP, magic, n);
+  if (n == 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h')
+	return rsl_zopen(fp, RSL_Z_BZIP2, magic, n);
+
+  /* Not compressed, or compress(1) data that only gzip can read.
+   * Put the magic back when the input is seekable; otherwise it is
+   * replayed, in front of the rest of the pipe.
+   */
+  if (pos >= 0 && fseek(fp, pos, SEEK_SET) == 0) {
+	if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x9d)
+	  return gzip_pipe(fp);
+	return fp;
+  }
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x9d)
+	return gzip_pipe_unread(fp, magic, n);
+  return rsl_zopen(fp, RSL_Z_NONE, magic, n);
+}
+
+FILE *rsl_unread(FILE *fp, char *buf, int n)
+{
+  /* Push 'n' bytes, already read from 'fp', back in front of it.  Used
+   * when the input is a pipe and cannot be rewound.  The returned
+   * stream owns 'fp'.
+   */
+  return rsl_zopen(fp, RSL_Z_NONE, (unsigned char *)buf, n);
+}
+
+#else /* No custom streams.  Use the gzip command. */
+
+FILE *uncompress_pipe (FILE *fp)
+{
+  return gzip_pipe(fp);
+}
+
+FILE *rsl_unread(FILE *fp, char *buf, int n)
+{
+  fprintf(stderr, "rsl_unread: Unable to push back %d bytes.\n", n);
+  return fp;
+}
+
+#endif
+
 FILE *compress_pipe (FILE *fp)
 {
   /* Pass the file pointed to by 'fp' through the gzip pipe. */
@@ -105,7 +660,6 @@ FILE *compress_pipe (FILE *fp)
   if (fpipe == NULL) perror("compress_pipe");
   close(1);
   dup(save_fd);
+  rsl_pipe_add(fpipe, 0, NULL);
   return fpipe;
 }
-
-
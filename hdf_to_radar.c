@@ -95,10 +95,9 @@ extern PARAMETER *TKnewGVL1parm(void);
 extern L1B_1C_GV *TKnewGVL1(void);
 
 
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
-extern int radar_verbose_flag;
 
 
 static void ymd(int jday, int yy, int *mm, int *dd);
@@ -367,8 +366,6 @@ Volume *VolumeBuild(L1B_1C_GV *gvl1, VosSize *vs, float calibr,
 {		
 	Volume *v;
 	int sindex, tk_sindex;
-	extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-	extern int rsl_qsweep_max;
 	
 	/* Create a Volume structure. */
 	v = RSL_new_volume(vs->tk.nsweep);
@@ -380,17 +377,15 @@ Volume *VolumeBuild(L1B_1C_GV *gvl1, VosSize *vs, float calibr,
 	/* Initialize the Volume_header values. */
 	Volume_headerFill(v, gvl1->sensor.parm[pindex]->parmDesc.parmDesc, 
 										vindex, vs->tk.nsweep, calibr);
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "RSL volume type: %s\n", v->h.type_str);
 
 	/* Build each of the sweeps of this radar volume structure. */
 	sindex = -1;
 	for (tk_sindex=0; tk_sindex<vs->tk.nsweep; tk_sindex++)
 	{
-	  if (rsl_qsweep != NULL) {
-		if (tk_sindex > rsl_qsweep_max) break;
-		if (rsl_qsweep[tk_sindex] == 0) continue;
-	  }
+	  if (rsl_sweeps_done(tk_sindex)) break;
+	  if (!rsl_want_sweep(tk_sindex)) continue;
 	  /* If data for this parm type exists in this toolkit sweep,
 		   then move it into a rsl sweep. */
 	  if (vs->tk.ncell[tk_sindex][pindex] > 0)
@@ -399,7 +394,7 @@ Volume *VolumeBuild(L1B_1C_GV *gvl1, VosSize *vs, float calibr,
 		  v->sweep[sindex] = SweepBuild(gvl1, vs, calibr, vindex, pindex,
 																		tk_sindex);
 			v->sweep[sindex]->h.sweep_num = sindex + 1;
-			if (radar_verbose_flag)
+			if (rsl_verbose())
 			  fprintf(stderr, "  rsl_sweep[%02d]  elev=%4.1f  nrays=%d  cells/ray=%d\n", 
 								v->sweep[sindex]->h.sweep_num-1, v->sweep[sindex]->h.elev,
 								vs->tk.nray[tk_sindex], vs->tk.ncell[tk_sindex][pindex]);
@@ -526,10 +521,10 @@ Radar *RadarBuild(L1B_1C_GV *gvl1, VosSize *vs, float zCal)
 */
 {
 	Radar *radar;
-	extern int rsl_qfield[];
+	Rsl_reader *reader = rsl_reader(); /* See reader.c */
 	int pindex, vindex;
 	
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	{
 	  fprintf(stderr, "\n****** Moving VOS from toolkit L1GV structure -> RSL structure ...\n");
 	}
@@ -557,9 +552,9 @@ Radar *RadarBuild(L1B_1C_GV *gvl1, VosSize *vs, float zCal)
 		}
 		/* Don't build mask volumes. */
 		else if ((vindex == MZ_INDEX) || (vindex == MD_INDEX)) continue;
-		else if (rsl_qfield[vindex] == 0) /* Don't build unselected volumes. */
+		else if (reader->qfield[vindex] == 0) /* Don't build unselected volumes. */
 		{
-		  if (radar_verbose_flag)
+		  if (rsl_verbose())
 			{
 			  fprintf(stderr, "Field %s not selected for retrieval from HDF file.\n",
 								gvl1->sensor.parm[pindex]->parmDesc.parmName);
@@ -568,15 +563,15 @@ Radar *RadarBuild(L1B_1C_GV *gvl1, VosSize *vs, float zCal)
 				else if (vindex == CD_INDEX)
 			    fprintf(stderr, "Field 'ZD' unselected for retrieval from 1C-51 file.\n");
 			}
-		}  /* end else if (rsl_qfield[vindex] == 0) */
+		}  /* end else if (reader->qfield[vindex] == 0) */
 		else if (vindex == CZ_INDEX)  /* Handle CZ and DZ volumes. */
 		{
 			/* Build the RSL CZ volume. */
 			radar->v[vindex] = VolumeBuild(gvl1, vs, zCal, vindex, pindex);
 			/* If required, build a RSL DZ volume. */
-			if (rsl_qfield[DZ_INDEX])
+			if (reader->qfield[DZ_INDEX])
 			{
-				if (radar_verbose_flag)
+				if (rsl_verbose())
 			    fprintf(stderr, "Constructing reflectivity volume 'DZ'\n");
 				radar->v[DZ_INDEX] = VolumeBuild(gvl1, vs, zCal, DZ_INDEX, pindex);
 			}
@@ -586,9 +581,9 @@ Radar *RadarBuild(L1B_1C_GV *gvl1, VosSize *vs, float zCal)
 			/* Build the RSL CD volume. */
 			radar->v[vindex] = VolumeBuild(gvl1, vs, 0.0, vindex, pindex);
 			/* If required, build a RSL ZD volume. */
-			if (rsl_qfield[ZD_INDEX])
+			if (reader->qfield[ZD_INDEX])
 			{
-				if (radar_verbose_flag)
+				if (rsl_verbose())
 			    fprintf(stderr, "Constructing reflectivity volume 'ZD'\n");
 				radar->v[ZD_INDEX] = VolumeBuild(gvl1, vs, 0.0, ZD_INDEX, pindex);
 			}
@@ -669,7 +664,7 @@ int commentsRead(VosSize *vs, float *zCal, char *comments, int productID)
 		  goto quit;
 		/* Print out the QC parameters we've just read in. */
 		/*
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		{
 			fprintf(stderr, "\n****** Reading VOS QC Parameters from HDF file...\n");
 			fprintf(stderr, "hThresh1: %.2f   hThresh2: %.2f   hThresh3: %.2f\n",
@@ -687,7 +682,7 @@ int commentsRead(VosSize *vs, float *zCal, char *comments, int productID)
 	return(OK);
 
  quit:
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "commentsRead(): Failure reading comments field\n");
 	return(ABORT);
 }
@@ -841,13 +836,13 @@ static int hdfFileOpen(char *infile, IO_HANDLE *granuleHandle,
 	nvos = (int)TKgetNvos(granuleHandle);
 	if (nvos == 0)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "\nEmpty granule.\n");
 		return(QUIT);
 	}		
 	else if (*vosNum+1 > nvos)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "\nAll VOSs read from HDF file: %s\n", hdfFileName);
 		return(QUIT);
 	}
@@ -900,7 +895,7 @@ Radar *RSL_hdf_to_radar(char *infile)
 	if (gvl1 == NULL) goto quit;
 	
 	/* Read VOS from HDF file into the toolkit L1B_1C_GV structure. */
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n\n***** Moving VOS from HDF file -> toolkit L1GV structure ...\n");
 	status = TKreadL1GV(&granuleHandle, gvl1);
 	if (status != TK_SUCCESS)
@@ -909,7 +904,7 @@ Radar *RSL_hdf_to_radar(char *infile)
 		goto quit;
 	}
 	
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	{
 		fprintf(stderr, "Input file: %s\n", hdfFileName);
 		fprintf(stderr, "VOS date:   %.2d/%.2d/%d\n", gvl1->volDes.month, 
@@ -34,7 +34,6 @@
 /*                                                                   */
 /*********************************************************************/
 
-extern int radar_verbose_flag;
 
 /**********************************************************/
 /* This set of functions and typedefs create a histogram  */
@@ -106,7 +105,7 @@ void RSL_print_histogram(Histogram *histogram, int min_range, int max_range,
 		return;
 	}
 
-    if (radar_verbose_flag) fprintf(stderr,"print_histogram: %s\n",filename);
+    if (rsl_verbose()) fprintf(stderr,"print_histogram: %s\n",filename);
 	if((fp = fopen(filename,"w")) == NULL ) {
 		perror(filename);
 		return;
@@ -214,33 +213,46 @@ int RSL_write_histogram(Histogram *histogram, char *outfile)
 /** DBW and JHM ******************************************/
 /*********************************************************/
 
+static void histogram_add(Histogram *histogram, float dbz)
+{
+	int index;
+
+	if(dbz >= histogram->low && dbz <= histogram->hi) {
+		index = dbz - histogram->low;
+		histogram->ccount++;
+		histogram->data[index]++;
+	}
+}
+
 Histogram *RSL_get_histogram_from_ray(Ray *ray, Histogram *histogram,
 	int low, int hi, int min_range, int max_range)
 {
-	int   i, index;
-	float dbz, ray_resolution, range;
-	float (*f)(Range x);
+	int   i, i0, i1;
+	float ray_resolution, range;
+	float *f;
 	
 	if (histogram == NULL ) {
-		if (radar_verbose_flag) fprintf(stderr,"Allocating histogram at ray level\n");
+		if (rsl_verbose()) fprintf(stderr,"Allocating histogram at ray level\n");
 		histogram = RSL_allocate_histogram(low, hi);
 	}
 
 	if(ray != NULL) {
 		ray_resolution = ray->h.gate_size/1000.0;
-		f = ray->h.f;
-		for(i=0; i<ray->h.nbins; i++) {
-			histogram->ucount++;
-			range = i*ray_resolution + ray->h.range_bin1/1000.;
-			if(range < min_range) continue;
+		/* Gates i0 up to i1 lie within [min_range, max_range]. */
+		for(i0=0; i0<ray->h.nbins; i0++) {
+			range = i0*ray_resolution + ray->h.range_bin1/1000.;
+			if(range >= min_range) break;
+		}
+		for(i1=i0; i1<ray->h.nbins; i1++) {
+			range = i1*ray_resolution + ray->h.range_bin1/1000.;
 			if(range > max_range) break;
-			dbz = f(ray->range[i]);
-			if(dbz >= histogram->low && dbz <= histogram->hi) {
-				index = dbz - histogram->low;
-				histogram->ccount++;
-				histogram->data[index]++;
-			}
 		}
+		histogram->ucount += (i1 < ray->h.nbins) ? i1+1 : i1;
+		f = RSL_f_table(ray->h.f);
+		if (f)
+			for(i=i0; i<i1; i++) histogram_add(histogram, f[ray->range[i]]);
+		else
+			for(i=i0; i<i1; i++) histogram_add(histogram, ray->h.f(ray->range[i]));
 	}
 	return histogram;
 }
@@ -250,7 +262,7 @@ Histogram *RSL_get_histogram_from_sweep(Sweep *sweep, Histogram *histogram,
 {
 	int i;
 	if (histogram == NULL ) {
-		if (radar_verbose_flag) fprintf(stderr,"Allocating histogram at sweep level\n");
+		if (rsl_verbose()) fprintf(stderr,"Allocating histogram at sweep level\n");
 		histogram = RSL_allocate_histogram(low, hi);
 	}
 	if(sweep != NULL) {
@@ -268,7 +280,7 @@ Histogram *RSL_get_histogram_from_volume(Volume *volume, Histogram *histogram,
 {
 	int i;
 	if (histogram == NULL ) {
-		if (radar_verbose_flag) fprintf(stderr,"Allocating histogram at volume level\n");
+		if (rsl_verbose()) fprintf(stderr,"Allocating histogram at volume level\n");
 		histogram = RSL_allocate_histogram(low, hi);
 	}
 	if(volume == NULL) return NULL;
@@ -38,6 +38,10 @@
  *   void RSL_bscan_sweep(Sweep *s, char *outfile);
  *   void RSL_bscan_volume(Volume *v, char *basename);
  *   unsigned char *RSL_sweep_to_cart(Sweep *s, int xdim, int ydim, float range);
+ *   Cart_plan *RSL_new_cart_plan(Sweep *s, int xdim, int ydim, float range);
+ *   void RSL_free_cart_plan(Cart_plan *plan);
+ *   int RSL_cart_plan_fits(Cart_plan *plan, Sweep *s);
+ *   unsigned char *RSL_sweep_to_cart_by_plan(Sweep *s, Cart_plan *plan);
  *   unsigned char *RSL_rhi_sweep_to_cart(Sweep *s, int xdim, int ydim, float range, int vert_scale);
  *   void RSL_write_gif(char *outfile, unsigned char *image, int xdim, int ydim, char c_table[256][3]);
  *   void RSL_write_pict(char *outfile, unsigned char *image, int xdim, int ydim, char c_table[256][3]);
@@ -64,7 +68,6 @@
 #include "rsl.h"
 extern FILE *popen(const char *, const char *);
 extern int pclose(FILE *stream);
-extern int radar_verbose_flag;
 
 static char color_table[256][3];
 static int ncolors = 0;
@@ -263,20 +266,24 @@ void RSL_load_rainfall_color_table()
 /**********************************************************************/
 static unsigned char *outvect;
 
+static unsigned char bscan_pixel(float x)
+{
+  if (x == BADVAL) return (unsigned char) (255 + x);
+  if (x >= 0) return (unsigned char) x;
+  return 0;
+}
+
 void RSL_bscan_ray(Ray *r, FILE *fp)
 {
   int i;
-  float (*f)(Range x);
+  float *f;
 
   if (r == NULL) return;
-  memset(outvect, 0, r->h.nbins);
-  f = r->h.f;
-  for (i=0; i<r->h.nbins; i++)
-	if (f(r->range[i]) != BADVAL) {
-	  if (f(r->range[i]) >= 0) outvect[i] = (unsigned char) f(r->range[i]);
-	}
-	else
-	  outvect[i] = (unsigned char) (255 + f(r->range[i]));
+  f = RSL_f_table(r->h.f);
+  if (f)
+	for (i=0; i<r->h.nbins; i++) outvect[i] = bscan_pixel(f[r->range[i]]);
+  else
+	for (i=0; i<r->h.nbins; i++) outvect[i] = bscan_pixel(r->h.f(r->range[i]));
   
   for(i=0; i<r->h.nbins; i++)
 	(void)fwrite(color_table[outvect[i]], sizeof(char), 3, fp);
@@ -329,7 +336,7 @@ void RSL_bscan_volume(Volume *v, char *basename)
 	(void)sprintf(outfile,"bscan.%2.2d.ppm", i);
 
 	RSL_bscan_sweep(v->sweep[i], outfile);
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"Output: %s\n", outfile);
   }
   free (outfile);
@@ -352,32 +359,90 @@ void RSL_bscan_volume(Volume *v, char *basename)
 
 /**********************************************************************/
 /*                                                                    */
-/*                    RSL_sweep_to_cart                               */
+/*                    RSL_new_cart_plan                               */
+/*                    RSL_free_cart_plan                              */
+/*                    RSL_cart_plan_fits                              */
+/*                                                                    */
+/*  The polar to cartesian mapping of RSL_sweep_to_cart, worked out   */
+/*  once: for every pixel, the ray and range bin it shows.  A plan    */
+/*  can be applied, with RSL_sweep_to_cart_by_plan, to every sweep    */
+/*  that RSL_cart_plan_fits; that is, sweeps with the same rays at    */
+/*  the same azimuths and the same range bins.                        */
 /*                                                                    */
-/*  By: John Merritt                                                  */
-/*      Space Applications Corporation                                */
-/*      April 7, 1994                                                 */
 /**********************************************************************/
-unsigned char *RSL_sweep_to_cart(Sweep *s, int xdim, int ydim, float range)
+Cart_plan *RSL_new_cart_plan(Sweep *s, int xdim, int ydim, float range)
 {
  /* Range specifies the maximum range to load that points into the image. */
 
-  int x, y;
+  int x, y, k, j, b;
   float azim, r;
-  float val;
   int the_index;
   Ray *ray;
   float beam_width;
-  
-
-  static unsigned char *cart_image = NULL;
+  Cart_plan *plan;
+  Hash_table *hash_table;
+  int *ray_index;
+  size_t size;
+  int nrays, npixels;
 
   if (s == NULL) return NULL;
   if (xdim != ydim || ydim < 0 || xdim < 0) {
 	fprintf(stderr, "(xdim=%d) != (ydim=%d) or either negative.\n", xdim, ydim);
 	return NULL;
   }
-  cart_image = (unsigned char *) calloc(xdim*ydim, sizeof(unsigned char));
+  nrays = s->h.nrays;
+  if (nrays < 0) nrays = 0;
+  npixels = xdim*ydim;
+
+  /* One block: header, ray[npixels], bin[npixels], then the geometry. */
+  size = sizeof(Cart_plan) + 2*npixels*sizeof(int)
+	+ nrays*(sizeof(float) + 3*sizeof(int));
+  plan = (Cart_plan *)calloc(1, size);
+  if (plan == NULL) {
+	perror("RSL_new_cart_plan");
+	return NULL;
+  }
+  plan->xdim = xdim;
+  plan->ydim = ydim;
+  plan->range = range;
+  plan->npixels = npixels;
+  plan->ray  = (int *)(plan + 1);
+  plan->bin  = plan->ray + npixels;
+  plan->nrays = nrays;
+  plan->beam_width = s->h.beam_width;
+  plan->azimuth    = (float *)(plan->bin + npixels);
+  plan->nbins      = (int *)(plan->azimuth + nrays);
+  plan->range_bin1 = plan->nbins + nrays;
+  plan->gate_size  = plan->range_bin1 + nrays;
+
+  for (k=0; k<nrays; k++) {
+	ray = s->ray[k];
+	if (ray == NULL) continue;
+	plan->azimuth[k]    = ray->h.azimuth;
+	plan->nbins[k]      = ray->h.nbins;
+	plan->range_bin1[k] = ray->h.range_bin1;
+	plan->gate_size[k]  = ray->h.gate_size;
+  }
+  for (the_index=0; the_index<npixels; the_index++) plan->ray[the_index] = -1;
+
+  /* A table of our own, not s->hash, which may be older than s->ray. */
+  hash_table = construct_sweep_hash_table(s);
+  if (hash_table == NULL || hash_table->nrays == 0) {
+	FREE_HASH_TABLE(hash_table);
+	return plan;
+  }
+
+  /* Map the sorted rays of the hash table back to Sweep.ray indexes. */
+  ray_index = (int *)malloc(hash_table->nrays * sizeof(int));
+  if (ray_index == NULL) {
+	perror("RSL_new_cart_plan");
+	FREE_HASH_TABLE(hash_table);
+	RSL_free_cart_plan(plan);
+	return NULL;
+  }
+  for (j=0; j<hash_table->nrays; j++) ray_index[j] = -1;
+  for (k=0; k<nrays; k++)
+	if (s->ray[k]) ray_index[hash_find_ray(hash_table, s->ray[k])] = k;
 
   beam_width = s->h.beam_width/2.0 * 1.2;
   if (beam_width == 0) beam_width = 1.2;  /* Sane image generation. */
@@ -403,20 +468,143 @@ unsigned char *RSL_sweep_to_cart(Sweep *s, int xdim, int ydim, float range)
 	  r = (float)sqrt((double)x*x + (double)y*y);
 	  if (ydim < xdim) r *= range/(.5*ydim);
 	  else r *= range/(.5*xdim);
-	  if (r > range) val = BADVAL;
-	  else {
-		ray = RSL_get_closest_ray_from_sweep(s, azim, beam_width);
-		val = RSL_get_value_from_ray(ray, r);
-	  }
+	  if (r > range) continue;
+
+	  j = hash_closest(hash_table, azim);
+	  if (angle_diff(azim, hash_table->ray[j]->h.azimuth) > beam_width) continue;
+	  k = ray_index[j];
+	  if (k < 0 || plan->gate_size[k] == 0) continue;
+	  /* As RSL_get_value_from_ray. */
+	  b = (int)(((r*1000 - plan->range_bin1[k])/plan->gate_size[k]) + 0.5);
+	  if (b >= plan->nbins[k] || b < 0) continue;
+
 	  the_index =  (y+ydim/2)*ydim + (xdim-1)-(x+xdim/2);
-	  if (val == BADVAL || val == NOTFOUND_V || val == NOTFOUND_H)
-		cart_image[the_index] = (unsigned char) 0;
-	  else if (val >= 0)
-	    cart_image[the_index] = (unsigned char) val;
-	  else 
-		cart_image[the_index] = (unsigned char) (256+val);
+	  plan->ray[the_index] = k;
+	  plan->bin[the_index] = b;
+	}
+  free(ray_index);
+  FREE_HASH_TABLE(hash_table);
+  return plan;
+}
+
+void RSL_free_cart_plan(Cart_plan *plan)
+{
+  if (plan == NULL) return;
+  free(plan);
+}
 
+int RSL_cart_plan_fits(Cart_plan *plan, Sweep *s)
+{
+  /* Returns 1 if plan was made for sweeps like s, 0 otherwise. */
+  int k;
+  Ray *ray;
+
+  if (plan == NULL || s == NULL) return 0;
+  if (s->h.nrays != plan->nrays) return 0;
+  if (s->h.beam_width != plan->beam_width) return 0;
+  for (k=0; k<plan->nrays; k++) {
+	ray = s->ray[k];
+	if (ray == NULL) {
+	  if (plan->gate_size[k] != 0 || plan->nbins[k] != 0) return 0;
+	  continue;
 	}
+	if (ray->h.azimuth    != plan->azimuth[k] ||
+		ray->h.nbins      != plan->nbins[k] ||
+		ray->h.range_bin1 != plan->range_bin1[k] ||
+		ray->h.gate_size  != plan->gate_size[k]) return 0;
+  }
+  return 1;
+}
+
+static unsigned char cart_pixel(float val)
+{
+  if (val == BADVAL || val == NOTFOUND_V || val == NOTFOUND_H)
+	return (unsigned char) 0;
+  else if (val >= 0)
+	return (unsigned char) val;
+  else 
+	return (unsigned char) (256+val);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                    RSL_sweep_to_cart_by_plan                       */
+/*                                                                    */
+/**********************************************************************/
+unsigned char *RSL_sweep_to_cart_by_plan(Sweep *s, Cart_plan *plan)
+{
+  /* Render s through plan.  The pixel for every Range value is taken
+   * from the table of f() (see RSL_f_table), so each pixel is just two
+   * loads.  Returns NULL when the plan does not fit s.
+   */
+  unsigned char *cart_image;
+  unsigned char pixel[1<<(8*sizeof(Range))];
+  Range **data;
+  float (*f)(Range x);
+  float *ftab;
+  int i, k, p, mixed;
+  int *plan_ray, *plan_bin;
+
+  if (!RSL_cart_plan_fits(plan, s)) return NULL;
+  cart_image = (unsigned char *) calloc(plan->npixels, sizeof(unsigned char));
+  if (cart_image == NULL) return NULL;
+  if (plan->nrays == 0) return cart_image;
+  data = (Range **)malloc(plan->nrays * sizeof(Range *));
+  if (data == NULL) {
+	free(cart_image);
+	return NULL;
+  }
+
+  f = NULL;
+  mixed = 0;
+  for (k=0; k<plan->nrays; k++) {
+	data[k] = NULL;
+	if (s->ray[k] == NULL) continue;
+	data[k] = s->ray[k]->range;
+	if (f == NULL) f = s->ray[k]->h.f;
+	else if (s->ray[k]->h.f != f) mixed = 1;
+  }
+
+  plan_ray = plan->ray;
+  plan_bin = plan->bin;
+  if (mixed) {  /* Rays of one sweep converted differently; unusual. */
+	for (p=0; p<plan->npixels; p++) {
+	  k = plan_ray[p];
+	  if (k >= 0) cart_image[p] = cart_pixel(s->ray[k]->h.f(data[k][plan_bin[p]]));
+	}
+  } else if (f != NULL) {
+	ftab = RSL_f_table(f);
+	for (i=0; i<(int)(sizeof(pixel)); i++)
+	  pixel[i] = cart_pixel(ftab ? ftab[i] : f((Range)i));
+	for (p=0; p<plan->npixels; p++) {
+	  k = plan_ray[p];
+	  if (k >= 0) cart_image[p] = pixel[data[k][plan_bin[p]]];
+	}
+  }
+  free(data);
+  return cart_image;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                    RSL_sweep_to_cart                               */
+/*                                                                    */
+/*  By: John Merritt                                                  */
+/*      Space Applications Corporation                                */
+/*      April 7, 1994                                                 */
+/**********************************************************************/
+unsigned char *RSL_sweep_to_cart(Sweep *s, int xdim, int ydim, float range)
+{
+  /* To render many sweeps of the same geometry, make a Cart_plan and
+   * use RSL_sweep_to_cart_by_plan.
+   */
+  Cart_plan *plan;
+  unsigned char *cart_image;
+
+  plan = RSL_new_cart_plan(s, xdim, ydim, range);
+  if (plan == NULL) return NULL;
+  cart_image = RSL_sweep_to_cart_by_plan(s, plan);
+  RSL_free_cart_plan(plan);
   return cart_image;
 }
 
@@ -740,6 +928,25 @@ void RSL_sweep_to_pgm(Sweep *s, char *outfile, int xdim, int ydim, float range)
   free(cart_image);
 }
 
+/**********************************************************************/
+/*                                                                    */
+/*                    volume_sweep_to_cart                            */
+/*                                                                    */
+/*  RSL_sweep_to_cart for the RSL_volume_to_* routines.  The plan is  */
+/*  kept from sweep to sweep and remade only when it does not fit.    */
+/*                                                                    */
+/**********************************************************************/
+static unsigned char *volume_sweep_to_cart(Sweep *s, Cart_plan **plan,
+										   int xdim, int ydim, float range)
+{
+  if (!RSL_cart_plan_fits(*plan, s)) {
+	RSL_free_cart_plan(*plan);
+	*plan = RSL_new_cart_plan(s, xdim, ydim, range);
+	if (*plan == NULL) return NULL;
+  }
+  return RSL_sweep_to_cart_by_plan(s, *plan);
+}
+
 /**********************************************************************/
 /*                                                                    */
 /*                    RSL_volume_to_gif                               */
@@ -756,6 +963,7 @@ void RSL_volume_to_gif(Volume *v, char *basename, int xdim, int ydim, float rang
   int i;
   char outfile[100];
   unsigned char *cart_image;
+  Cart_plan *plan = NULL;
 
   if (v == NULL) return;
   if (ncolors == 0) {
@@ -771,18 +979,19 @@ void RSL_volume_to_gif(Volume *v, char *basename, int xdim, int ydim, float rang
   for (i=0; i<v->h.nsweeps; i++) {
 	(void)sprintf(outfile,"%s.%2.2d.gif", basename, i); /* File name: sweep.[0-10] */
 	if (v->sweep[i] == NULL) continue;
-	cart_image = RSL_sweep_to_cart(v->sweep[i], xdim, ydim, range);
-	if (radar_verbose_flag)
+	cart_image = volume_sweep_to_cart(v->sweep[i], &plan, xdim, ydim, range);
+	if (rsl_verbose())
 	  fprintf(stderr,"==> Sweep %d of %d\n",i, v->h.nsweeps);
 	if (cart_image != NULL) {
 	  RSL_write_gif(outfile, cart_image, xdim, ydim, color_table);
 	  printf("%s\n", outfile);
 	  free (cart_image);
 	} else {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"No image.  cart_image for sweep %d is NULL.\n", i);
 	}
   }
+  RSL_free_cart_plan(plan);
 }
 
 /**********************************************************************/
@@ -801,6 +1010,7 @@ void RSL_volume_to_pict(Volume *v, char *basename, int xdim, int ydim, float ran
   int i;
   char outfile[100];
   unsigned char *cart_image;
+  Cart_plan *plan = NULL;
 
   if (v == NULL) return;
   if (ncolors == 0) {
@@ -814,20 +1024,21 @@ void RSL_volume_to_pict(Volume *v, char *basename, int xdim, int ydim, float ran
  *
  */
   for (i=0; i<v->h.nsweeps; i++) {
-	cart_image = RSL_sweep_to_cart(v->sweep[i], xdim, ydim, range);
-	if (radar_verbose_flag)
+	cart_image = volume_sweep_to_cart(v->sweep[i], &plan, xdim, ydim, range);
+	if (rsl_verbose())
 	  fprintf(stderr,"==> Sweep %d of %d\n",i, v->h.nsweeps);
 	(void)sprintf(outfile,"%s.%2.2d.pict", basename, i); /* File name: sweep.[0-10] */
 	if (cart_image != NULL) {
 	  RSL_write_pict(outfile, cart_image, xdim, ydim, color_table);
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"Wrote: %s\n", outfile);
 	  free (cart_image);
 	} else {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"No image.  cart_image for sweep %d is NULL.\n", i);
 	}
   }
+  RSL_free_cart_plan(plan);
 }
 
 /**********************************************************************/
@@ -846,6 +1057,7 @@ void RSL_volume_to_ppm(Volume *v, char *basename, int xdim, int ydim, float rang
   int i;
   char outfile[100];
   unsigned char *cart_image;
+  Cart_plan *plan = NULL;
 
   if (v == NULL) return;
   if (ncolors == 0) {
@@ -859,20 +1071,21 @@ void RSL_volume_to_ppm(Volume *v, char *basename, int xdim, int ydim, float rang
  *
  */
   for (i=0; i<v->h.nsweeps; i++) {
-	cart_image = RSL_sweep_to_cart(v->sweep[i], xdim, ydim, range);
-	if (radar_verbose_flag)
+	cart_image = volume_sweep_to_cart(v->sweep[i], &plan, xdim, ydim, range);
+	if (rsl_verbose())
 	  fprintf(stderr,"==> Sweep %d of %d\n",i, v->h.nsweeps);
 	(void)sprintf(outfile,"%s.%2.2d.ppm", basename, i); /* File name: sweep.[0-10] */
 	if (cart_image != NULL) {
 	  RSL_write_ppm(outfile, cart_image, xdim, ydim, color_table);
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"Wrote: %s\n", outfile);
 	  free (cart_image);
 	} else {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"No image.  cart_image for sweep %d is NULL.\n", i);
 	}
   }
+  RSL_free_cart_plan(plan);
 }
 /**********************************************************************/
 /*                                                                    */
@@ -890,6 +1103,7 @@ void RSL_volume_to_pgm(Volume *v, char *basename, int xdim, int ydim, float rang
   int i;
   char outfile[100];
   unsigned char *cart_image;
+  Cart_plan *plan = NULL;
 
 /*
  * Sweep 0 has Reflectivity only.
@@ -899,20 +1113,21 @@ void RSL_volume_to_pgm(Volume *v, char *basename, int xdim, int ydim, float rang
  */
   if (v == NULL) return;
   for (i=0; i<v->h.nsweeps; i++) {
-	cart_image = RSL_sweep_to_cart(v->sweep[i], xdim, ydim, range);
-	if (radar_verbose_flag)
+	cart_image = volume_sweep_to_cart(v->sweep[i], &plan, xdim, ydim, range);
+	if (rsl_verbose())
 	  fprintf(stderr,"==> Sweep %d of %d\n",i, v->h.nsweeps);
 	(void)sprintf(outfile,"%s.%2.2d.pgm", basename, i); /* File name: sweep.[0-10] */
 	if (cart_image != NULL) {
 	  RSL_write_pgm(outfile, cart_image, xdim, ydim);
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"Wrote: %s\n", outfile);
 	  free (cart_image);
 	} else {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 		fprintf(stderr,"No image.  cart_image for sweep %d is NULL.\n", i);
 	}
   }
+  RSL_free_cart_plan(plan);
 }
 
 
@@ -927,6 +1142,22 @@ void RSL_volume_to_pgm(Volume *v, char *basename, int xdim, int ydim, float rang
 /*      April 30, 1994                                                 */
 /*                                                                     */
 /***********************************************************************/
+static float rebin_velocity(float val, float nyquist, int ncbins)
+{
+  if (val == RFVAL) {
+	val = 16;
+  } else if (val != BADVAL) {
+/*
+	Okay, we want to shift the data to positive values
+	then we re-scale them by the number of color bins/nyquist
+*/
+	val = (int)(val/nyquist*(ncbins/2) + 1.0 + ncbins/2);
+  } else {
+	val = 0;
+  }
+  return val;
+}
+
 void RSL_rebin_velocity_ray(Ray *r)
 {
   /* Rebin the velocity data to the range -nyquist, +nyquist.
@@ -935,10 +1166,9 @@ void RSL_rebin_velocity_ray(Ray *r)
    */
   int i;
   float nyquist;
-  float val /*  val1 */;
 
   int ncbins = 15; /* Number of color bins */
-  float (*f)(Range x);
+  float *f;
   Range (*invf)(float x);
 
   if (r == NULL) return;
@@ -949,25 +1179,14 @@ void RSL_rebin_velocity_ray(Ray *r)
 	fprintf(stderr, "RSL_rebin_velocity_ray: Unable to rebin.\n");
 	return;
   }
-  f = r->h.f;
+  f = RSL_f_table(r->h.f);
   invf = r->h.invf;
-  for (i=0; i<r->h.nbins; i++) {
-	val = f(r->range[i]);
-	if (val == RFVAL) {
-		val = 16;
-	} else if (val != BADVAL) {
-/*
-	  Okay, we want to shift the data to positive values
-	  then we re-scale them by the number of color bins/nyquist
-*/
-	  val = (int)(val/nyquist*(ncbins/2) + 1.0 + ncbins/2);
-
-	} else {
-		val = 0;
-	}
-
-	r->range[i] = invf(val);
-  }
+  if (f)
+	for (i=0; i<r->h.nbins; i++)
+	  r->range[i] = invf(rebin_velocity(f[r->range[i]], nyquist, ncbins));
+  else
+	for (i=0; i<r->h.nbins; i++)
+	  r->range[i] = invf(rebin_velocity(r->h.f(r->range[i]), nyquist, ncbins));
 }
 
 
@@ -1141,12 +1360,28 @@ void RSL_carpi_to_pgm(Carpi *carpi, char *outfile, int xdim, int ydim, float ran
 /* Space Applications Corporation                                     */
 /* July 13, 1997                                                      */
 /**********************************************************************/
+static float rebin_width(float val, int width, float nyquist, int ncbins)
+{
+  if (val == width+1) {
+	val = ncbins + 1;
+  } else if (val != BADVAL) {
+/*
+	Okay, we want to shift the data to positive values
+	then we re-scale them by the number of color bins/nyquist
+*/
+	val = (int)(val/nyquist*(ncbins/2) + 1.0 + ncbins/2); 
+  } else {
+	val = 0;
+  }
+  return val;
+}
+
 void RSL_rebin_ray(Ray *r, int width)
 {
   int i;
-  float nyquist, val; 
+  float nyquist; 
   int ncbins = 15; /* Number of color bins */
-  float (*f)(Range x);
+  float *f;
   Range (*invf)(float x);
 
   if (r == NULL) return;
@@ -1157,24 +1392,14 @@ void RSL_rebin_ray(Ray *r, int width)
 	fprintf(stderr, "RSL_rebin_ray: Unable to rebin.\n");
 	return;
   }
-  f = r->h.f;
+  f = RSL_f_table(r->h.f);
   invf = r->h.invf;
-  for (i=0; i<r->h.nbins; i++) {
-	val = f(r->range[i]);
-	if (val == width+1) {
-		val = ncbins + 1;
-	} else if (val != BADVAL) {
-/*
-	  Okay, we want to shift the data to positive values
-	  then we re-scale them by the number of color bins/nyquist
-*/
-	  val = (int)(val/nyquist*(ncbins/2) + 1.0 + ncbins/2); 
-	} else {
-		val = 0;
-	}
-
-	r->range[i] = invf(val);
-  }
+  if (f)
+	for (i=0; i<r->h.nbins; i++)
+	  r->range[i] = invf(rebin_width(f[r->range[i]], width, nyquist, ncbins));
+  else
+	for (i=0; i<r->h.nbins; i++)
+	  r->range[i] = invf(rebin_width(r->h.f(r->range[i]), width, nyquist, ncbins));
 }
 
 void RSL_rebin_sweep(Sweep *s, int width)
@@ -1220,24 +1445,27 @@ void RSL_rebin_volume(Volume *v, int width)
 		July 13, 1997
 */
 
+static float rebin_zdr(float val)
+{
+  if ((val >= -6.0) && (val < 8.4)) val = (floor) ((val + 6.0) * 2.5);
+  else if (val < 10.0) val = 35.0;  /* Make all these white. */
+  else val = 0;  /* invalid zdr value */
+  return val;
+}
+
 void RSL_rebin_zdr_ray(Ray *r)
 {
   int i;
-  float val; 
-  float (*f)(Range x);
+  float *f;
   Range (*invf)(float x);
 
   if (r == NULL) return;
-  f = r->h.f;
+  f = RSL_f_table(r->h.f);
   invf = r->h.invf;
-  for (i=0; i<r->h.nbins; i++)
-	{
-		val = f(r->range[i]);
-		if ((val >= -6.0) && (val < 8.4)) val = (floor) ((val + 6.0) * 2.5);
-		else if (val < 10.0) val = 35.0;  /* Make all these white. */
-		else val = 0;  /* invalid zdr value */
-		r->range[i] = invf(val);
-  }
+  if (f)
+	for (i=0; i<r->h.nbins; i++) r->range[i] = invf(rebin_zdr(f[r->range[i]]));
+  else
+	for (i=0; i<r->h.nbins; i++) r->range[i] = invf(rebin_zdr(r->h.f(r->range[i])));
 }
 
 void RSL_rebin_zdr_sweep(Sweep *s)
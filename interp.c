@@ -219,37 +219,33 @@ void get_surrounding_ray(Ray **ccwise,Ray **cwise,Sweep *s,
     *  ray if this routine is going to be used for
     *  RHI scans.
 	*/
-   int hindex;
+   int closest, cw, ccw;
    double close_diff;
    Hash_table *hash_table;
-   
-   Azimuth_hash *closest;
 
-   /* Find hash index close to hindex we want.  This will
-    * used as a starting point for a search to the closest
-    * ray.
+   /* Find the closest ray, then its neighbor on the other side of
+    * ray_angle.
     */
    hash_table = hash_table_for_sweep(s);
-   if (hash_table == NULL) return; /* Nada. */
-
-   hindex = hash_bin(hash_table,ray_angle); 
+   if (hash_table == NULL || hash_table->nrays == 0) return; /* Nada. */
 
-   /* Find hash entry with closest Ray */
-   closest = the_closest_hash(hash_table->indexes[hindex],ray_angle);
+   closest = hash_closest(hash_table, ray_angle);
+   cw  = (closest + 1) % hash_table->nrays;
+   ccw = (closest + hash_table->nrays - 1) % hash_table->nrays;
 
-   close_diff = dir_angle_diff(ray_angle,closest->ray->h.azimuth);
+   close_diff = dir_angle_diff(ray_angle,hash_table->ray[closest]->h.azimuth);
    
    if(close_diff < 0)
       {
       /* Closest ray is counterclockwise to ray_angle */
-      *ccwise = closest->ray;
-      *cwise = closest->ray_high->ray;
+      *ccwise = hash_table->ray[closest];
+      *cwise = hash_table->ray[cw];
       }
    else
       {
       /* Closest ray is clockwise to ray_angle. */
-      *cwise = closest->ray;
-      *ccwise = closest->ray_low->ray;
+      *cwise = hash_table->ray[closest];
+      *ccwise = hash_table->ray[ccw];
       }
 
    }
@@ -41,6 +41,7 @@
 #include <string.h>
 #include <rpc/rpc.h>
 #include <netinet/in.h>
+#include "rsl.h"
 #include "lassen.h"
 
 /* xdr_destroy is broken on HPUX, SGI, and SUN; Linux, the only working one? */
@@ -54,55 +55,45 @@
 /*                     read_lassen_head                      */
 /*                                                           */
 /*************************************************************/
-int read_lassen_head(FILE *f, Lassen_head *head)
+int read_lassen_head(XDR *xdrs, Lassen_head *head)
 {
   int rc=1, i;
   char *tmp;
-  XDR xdrs;
   
   memset(head->magic, 0, sizeof(head->magic));
   
-  xdrstdio_create(&xdrs, f, XDR_DECODE);
-  
   /*
    * Can I read the first string? If not, then this is probably
    * not a valid header.  If this happens, then return.
    */
   tmp=head->magic;
-  if((rc &= xdr_string(&xdrs, &tmp, 8))==0) {
-#ifndef BROKEN_XDR_DESTROY
-	xdr_destroy(&xdrs);
-#endif
+  if((rc &= xdr_string(xdrs, &tmp, 8))==0) {
 	return(0);
   }
-  rc &= xdr_u_char(&xdrs, &head->mdate.year);
-  rc &= xdr_u_char(&xdrs, &head->mdate.month);
-  rc &= xdr_u_char(&xdrs, &head->mdate.day);
-  rc &= xdr_u_char(&xdrs, &head->mdate.hour);
-  rc &= xdr_u_char(&xdrs, &head->mdate.minute);
-  rc &= xdr_u_char(&xdrs, &head->mdate.second);
-  rc &= xdr_u_char(&xdrs, &head->cdate.year);
-  rc &= xdr_u_char(&xdrs, &head->cdate.month);
-  rc &= xdr_u_char(&xdrs, &head->cdate.day);
-  rc &= xdr_u_char(&xdrs, &head->cdate.hour);
-  rc &= xdr_u_char(&xdrs, &head->cdate.minute);
-  rc &= xdr_u_char(&xdrs, &head->cdate.second);
-  rc &= xdr_int(&xdrs, &head->type);
+  rc &= xdr_u_char(xdrs, &head->mdate.year);
+  rc &= xdr_u_char(xdrs, &head->mdate.month);
+  rc &= xdr_u_char(xdrs, &head->mdate.day);
+  rc &= xdr_u_char(xdrs, &head->mdate.hour);
+  rc &= xdr_u_char(xdrs, &head->mdate.minute);
+  rc &= xdr_u_char(xdrs, &head->mdate.second);
+  rc &= xdr_u_char(xdrs, &head->cdate.year);
+  rc &= xdr_u_char(xdrs, &head->cdate.month);
+  rc &= xdr_u_char(xdrs, &head->cdate.day);
+  rc &= xdr_u_char(xdrs, &head->cdate.hour);
+  rc &= xdr_u_char(xdrs, &head->cdate.minute);
+  rc &= xdr_u_char(xdrs, &head->cdate.second);
+  rc &= xdr_int(xdrs, &head->type);
   tmp=head->mwho;
-  rc &= xdr_string(&xdrs, &tmp, 16);
+  rc &= xdr_string(xdrs, &tmp, 16);
   tmp=head->cwho;
-  rc &= xdr_string(&xdrs, &tmp, 16);
-  rc &= xdr_int(&xdrs, &head->protection);
-  rc &= xdr_int(&xdrs, &head->checksum);
+  rc &= xdr_string(xdrs, &tmp, 16);
+  rc &= xdr_int(xdrs, &head->protection);
+  rc &= xdr_int(xdrs, &head->checksum);
   tmp=head->description;
-  rc &= xdr_string(&xdrs, &tmp, 40);
-  rc &= xdr_int(&xdrs, &head->id);
+  rc &= xdr_string(xdrs, &tmp, 40);
+  rc &= xdr_int(xdrs, &head->id);
   for(i=0;i<12;i++)
-	rc &= xdr_int(&xdrs, &head->spare[i]);
-
-#ifndef BROKEN_XDR_DESTROY
-  xdr_destroy(&xdrs);
-#endif
+	rc &= xdr_int(xdrs, &head->spare[i]);
   
   return rc;
 }
@@ -297,7 +288,7 @@ int read_lassen_ray(XDR *xdr, Lassen_ray *ray )
 /*                  read_entire_lassen_file                  */
 /*                                                           */
 /*************************************************************/
-int read_entire_lassen_file(FILE *f, Lassen_volume *vol)
+int read_entire_lassen_file(Rsl_source *src, Lassen_volume *vol)
 {
   Lassen_sweep	*sweep;
   int i;
@@ -309,13 +300,15 @@ int read_entire_lassen_file(FILE *f, Lassen_volume *vol)
   unsigned int      size;
   int tbytes = 0;
   unsigned char *p;
+  char *buf;
+  size_t len;
 
+  /*  Decode the file in place.  XDR_DECODE only reads the buffer. */
+  buf = rsl_source_rest(src, &len);
+  xdrmem_create(&xdr, buf, (u_int)len, XDR_DECODE);
 
   /* Skip the header. */
-  read_lassen_head(f, &head);
-
-  /*  Connect to the XDR stream. */
-  xdrstdio_create(&xdr, f, XDR_DECODE);
+  read_lassen_head(&xdr, &head);
 
   /*  Check the volume header. Is the version is correct? */
   if( read_lassen_volume( &xdr, vol ) == 0) {
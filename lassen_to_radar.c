@@ -41,11 +41,9 @@
 
 #ifdef HAVE_LASSEN
 #include "lassen.h"
-extern int radar_verbose_flag;
 
-/* Some parameter headaches are prevented when vol is declared global. */
-Lassen_volume vol;
-extern int read_entire_lassen_file(FILE *f, Lassen_volume *vol);
+extern int read_entire_lassen_file(Rsl_source *src, Lassen_volume *vol);
+extern void free_lassen_volume(Lassen_volume *vol);
 
 /**********************************************************************/
 /*                                                                    */
@@ -55,7 +53,8 @@ extern int read_entire_lassen_file(FILE *f, Lassen_volume *vol);
 /*      Space Applications Corporation                                */
 /*      May  26, 1994                                                 */
 /**********************************************************************/
-void lassen_load_sweep(Sweep *s, int isweep_num, int ifield, int period, Lassen_sweep *ptr)
+void lassen_load_sweep(Sweep *s, int isweep_num, int ifield, int period,
+					   Lassen_volume *vol, Lassen_sweep *ptr)
 {
   float c = RSL_SPEED_OF_LIGHT;
   float elev;
@@ -92,7 +91,7 @@ void lassen_load_sweep(Sweep *s, int isweep_num, int ifield, int period, Lassen_
   if (ifield == TI_INDEX) {kk = OFF_TIME; invf = TI_INVF; f = TI_F;}
   
   elev = (float)ptr->fangle*360.0/16384.0;
-  Vu = c*((float)vol.prf/10.)/(4.*(float)vol.freq*100000.0);
+  Vu = c*((float)vol->prf/10.)/(4.*(float)vol->freq*100000.0);
   
   s->h.sweep_num = ptr->sweep;
   s->h.elev = elev;
@@ -124,7 +123,7 @@ void lassen_load_sweep(Sweep *s, int isweep_num, int ifield, int period, Lassen_
 	s->ray[i]->h.vel_res  = 0.5; /* What is this really? */
 
 	s->ray[i]->h.fix_angle = s->h.elev;
-	s->ray[i]->h.frequency = 	(float)vol.freq*1.0e-4;  /* GHz */
+	s->ray[i]->h.frequency = 	(float)vol->freq*1.0e-4;  /* GHz */
 	s->ray[i]->h.wavelength = c / s->ray[i]->h.frequency * 1.0e-9;
 	s->ray[i]->h.prf      = (int)aray->prf/10;
 	s->ray[i]->h.nyq_vel = s->ray[i]->h.prf * s->ray[i]->h.wavelength / 4.0;
@@ -218,23 +217,21 @@ void lassen_load_sweep(Sweep *s, int isweep_num, int ifield, int period, Lassen_
 
 /**********************************************************************/
 /*                                                                    */
-/*                     RSL_lassen_to_radar                            */
+/*                       lassen_to_radar                              */
 /*                                                                    */
 /*  By: John Merritt                                                  */
 /*      Space Applications Corporation                                */
 /*      May  26, 1994                                                 */
 /**********************************************************************/
-Radar *RSL_lassen_to_radar(char *infile)
+static Radar *lassen_to_radar(Rsl_source *src)
 {
 /* Lassen specific. */
   Lassen_sweep *ptr;
   Lassen_ray *aray;
   int period;  /*   m.whimpey changed early variable to period  */
-  FILE *f;
   int q[MAX_RADAR_VOLUMES];
-  extern int rsl_qfield[];
-  extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-  extern int rsl_qsweep_max;
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
+  Lassen_volume *vol;
 
 /* Radar specific */
   Radar *radar;
@@ -275,47 +272,35 @@ Radar *RSL_lassen_to_radar(char *infile)
   unsigned long dt;	/* date time */
 	
 
-    /*   open Lassen file  */
-  if (infile == NULL) {
-	int save_fd;
-	save_fd = dup(0);
-	f = fdopen(save_fd, "r");
-  }  else
-    if((f=fopen(infile, "r"))==(FILE *)NULL) {
-	  perror(infile);
+    if ((vol = (Lassen_volume *)calloc(1, sizeof(Lassen_volume))) == NULL) {
+	  perror("RSL_lassen_to_radar");
 	  return NULL;
-    }
-  f = uncompress_pipe(f); /* Transparently, use gunzip. */
-#define NEW_BUFSIZ 16384
-  setvbuf(f,NULL,_IOFBF,(size_t)NEW_BUFSIZ); /* Faster i/o? */
-  
-    if((read_entire_lassen_file(f, &vol)) == 0)
+	}
+    if((read_entire_lassen_file(src, vol)) == 0)
     {
         perror("RSL_lassen_to_radar ... read_entire_lassen_file");
         exit(1);
     }
 
-	rsl_pclose(f);
-
-	if (radar_verbose_flag) {
-	  fprintf(stderr,"\n Version   = %d",vol.version);
-	  fprintf(stderr,"\n Volume    = %d",vol.volume);
-	  fprintf(stderr,"\n Numsweeps = %d",vol.numsweeps);
+	if (rsl_verbose()) {
+	  fprintf(stderr,"\n Version   = %d",vol->version);
+	  fprintf(stderr,"\n Volume    = %d",vol->volume);
+	  fprintf(stderr,"\n Numsweeps = %d",vol->numsweeps);
 	  fprintf(stderr,"\n Time      = %2.2d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d - %2.2d:%2.2d:%2.2d",
-		 (int)vol.month, (int)vol.day, (int)vol.year,
-		 (int)vol.shour, (int)vol.sminute, (int)vol.ssecond,
-		 (int)vol.ehour, (int)vol.eminute, (int)vol.esecond);
-	  fprintf(stderr,"\n Angle: start %d, stop %d", (int)vol.a_start, (int)vol.a_stop);
+		 (int)vol->month, (int)vol->day, (int)vol->year,
+		 (int)vol->shour, (int)vol->sminute, (int)vol->ssecond,
+		 (int)vol->ehour, (int)vol->eminute, (int)vol->esecond);
+	  fprintf(stderr,"\n Angle: start %d, stop %d", (int)vol->a_start, (int)vol->a_stop);
 	  fprintf(stderr,"\n");
 	}
   
 /*  determine which period the lassen volume belongs   m.whimpey   */
-	vt = (vol.year-90) * 32140800;
-	vt += vol.month * 2678400;
-	vt += vol.day * 86400;
-	vt += vol.shour * 3600;
-	vt += vol.sminute * 60;
-	vt += vol.ssecond;
+	vt = (vol->year-90) * 32140800;
+	vt += vol->month * 2678400;
+	vt += vol->day * 86400;
+	vt += vol->shour * 3600;
+	vt += vol->sminute * 60;
+	vt += vol->ssecond;
 
 	for(d=0; d<NUM_DATES; d++) {
 	    dt = (cvrt_date[d].year-1990) * 32140800;
@@ -331,8 +316,7 @@ Radar *RSL_lassen_to_radar(char *infile)
 	}
 
 	if(d==0) {
-	    fprintf(stderr, "%s: Error Vol date before first known!\n",
-		     infile);
+	    fprintf(stderr, "RSL_lassen_to_radar: Error Vol date before first known!\n");
 	    exit(3);
 	}
 	period = d-1;
@@ -340,21 +324,21 @@ Radar *RSL_lassen_to_radar(char *infile)
 /* Max. expected volumes. */
   radar = RSL_new_radar(MAX_RADAR_VOLUMES);
 
-  radar->h.month      = vol.month;
-  radar->h.day        = vol.day;
-  radar->h.year       = vol.year + 1900;
-  radar->h.hour       = vol.shour;
-  radar->h.minute     = vol.sminute;
-  radar->h.sec        = vol.ssecond;
+  radar->h.month      = vol->month;
+  radar->h.day        = vol->day;
+  radar->h.year       = vol->year + 1900;
+  radar->h.hour       = vol->shour;
+  radar->h.minute     = vol->sminute;
+  radar->h.sec        = vol->ssecond;
   strcpy(radar->h.radar_type, "lassen");
   radar->h.nvolumes   = MAX_RADAR_VOLUMES;
-  memcpy(&radar->h.radar_name, vol.radinfo.radar_name, 8);
-  memcpy(&radar->h.name, vol.radinfo.site_name, 8);
+  memcpy(&radar->h.radar_name, vol->radinfo.radar_name, 8);
+  memcpy(&radar->h.name, vol->radinfo.site_name, 8);
   memcpy(&radar->h.city, "????", 4);
   memcpy(&radar->h.state,"AU", 2);
-  radar->h.latd       = vol.radinfo.latitude.degree;
-  radar->h.latm       = vol.radinfo.latitude.minute;
-  radar->h.lats       = vol.radinfo.latitude.second;
+  radar->h.latd       = vol->radinfo.latitude.degree;
+  radar->h.latm       = vol->radinfo.latitude.minute;
+  radar->h.lats       = vol->radinfo.latitude.second;
   /* Is there a problem with the minutes/seconds when negative?
    * The degree/minute/sec all should have the same sign.
    */
@@ -362,14 +346,14 @@ Radar *RSL_lassen_to_radar(char *infile)
 	if (radar->h.latm > 0) radar->h.latm *= -1;
 	if (radar->h.lats > 0) radar->h.lats *= -1;
   }
-  radar->h.lond       = vol.radinfo.longitude.degree;
-  radar->h.lonm       = vol.radinfo.longitude.minute;
-  radar->h.lons       = vol.radinfo.longitude.second;
+  radar->h.lond       = vol->radinfo.longitude.degree;
+  radar->h.lonm       = vol->radinfo.longitude.minute;
+  radar->h.lons       = vol->radinfo.longitude.second;
   if (radar->h.lond < 0) {
 	if (radar->h.lonm > 0) radar->h.lonm *= -1;
 	if (radar->h.lons > 0) radar->h.lons *= -1;
   }
-  radar->h.height     = vol.radinfo.antenna_height;
+  radar->h.height     = vol->radinfo.antenna_height;
   radar->h.spulse     = 0;
   radar->h.lpulse     = 0;
 
@@ -393,30 +377,30 @@ Radar *RSL_lassen_to_radar(char *infile)
  * The OFFSET is really what is used, anyway, to extract the data.
  */
   memset(q, 0, sizeof(q));
-  for (i=0; i<vol.numsweeps; i++) {
-	ptr = vol.index[i];
+  for (i=0; i<vol->numsweeps; i++) {
+	ptr = vol->index[i];
 	for (j=0; j<ptr->numrays; j++) {
 	  aray = ptr->ray[j];
 	  for (k=0; k<NUMOFFSETS; k++) {
 		if (aray->offset[k] != 0 && !q[rsl_index[k]]) {
 		  /* From RSL_select_fields */
-		  if (rsl_qfield[rsl_index[k]] == 1) 
+		  if (reader->qfield[rsl_index[k]] == 1) 
 			q[rsl_index[k]]=1;
 		}
 	  }
 	}
   }
-  if (radar_verbose_flag) 
+  if (rsl_verbose()) 
 	fprintf(stderr,"\n Fields are (Lassen nomenclature):");
   for (k=0; k<NUMOFFSETS; k++) {
 	i = rsl_index[k]; /* Lassen index order to RSL index order translation. */
 	if (q[i])  {
-	  if (radar_verbose_flag) fprintf(stderr," %s", ltype[k]);
+	  if (rsl_verbose()) fprintf(stderr," %s", ltype[k]);
 	}
   }
-  if (radar_verbose_flag)   fprintf(stderr,"\n");
+  if (rsl_verbose())   fprintf(stderr,"\n");
   
-  if (radar_verbose_flag) fprintf(stderr," Fields are    (RSL nomenclature):");
+  if (rsl_verbose()) fprintf(stderr," Fields are    (RSL nomenclature):");
   for (k=0; k<NUMOFFSETS; k++) {
 
 	/* BTW, it doesn't matter if we allocate volumes, sweeps, or rays that
@@ -424,33 +408,61 @@ Radar *RSL_lassen_to_radar(char *infile)
 	 */
 	i = rsl_index[k]; /* Lassen index order to RSL index order translation. */
 	if (q[i])  {
-	  radar->v[i] = RSL_new_volume(vol.numsweeps);
+	  radar->v[i] = RSL_new_volume(vol->numsweeps);
 	  radar->v[i]->h.f    = RSL_f_list[i];
 	  radar->v[i]->h.invf = RSL_invf_list[i];
-	  if (radar_verbose_flag)  fprintf(stderr," %s", RSL_ftype[i]);
-	  if (k >= 2 && radar_verbose_flag) fprintf(stderr," "); /* Alignment. */
+	  if (rsl_verbose())  fprintf(stderr," %s", RSL_ftype[i]);
+	  if (k >= 2 && rsl_verbose()) fprintf(stderr," "); /* Alignment. */
 	}
   }
-  if (radar_verbose_flag)   fprintf(stderr,"\n");
+  if (rsl_verbose())   fprintf(stderr,"\n");
 
   for(j=0;j<radar->h.nvolumes; j++) {
-	for(i=0;i<(int)vol.numsweeps;i++) {
-	  if (rsl_qsweep != NULL) {
-		if (i > rsl_qsweep_max) break;
-		if (rsl_qsweep[i] == 0) continue;
-	  }
-	  ptr = vol.index[i];
+	for(i=0;i<(int)vol->numsweeps;i++) {
+	  if (rsl_sweeps_done(i)) break;
+	  if (!rsl_want_sweep(i)) continue;
+	  ptr = vol->index[i];
 	  if (radar->v[j]) {
 		radar->v[j]->sweep[i] = RSL_new_sweep(ptr->numrays);
 
 		/* 'period' is a flag for different calibrations */
-		lassen_load_sweep(radar->v[j]->sweep[i], i, j, period, ptr);
+		lassen_load_sweep(radar->v[j]->sweep[i], i, j, period, vol, ptr);
 	  }	  
 	}
   }
+  free_lassen_volume(vol);
   radar = RSL_prune_radar(radar);
   return radar;
 }
+
+/**********************************************************************/
+/*                                                                    */
+/*           RSL_lassen_to_radar, RSL_lassen_to_radar_mem             */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_lassen_to_radar(char *infile)
+{
+  Rsl_source *src;
+  Radar *radar;
+
+    /*   open Lassen file  */
+  /* Transparently, use gunzip. */
+  if ((src = rsl_source_open(infile)) == NULL) return NULL;
+  radar = lassen_to_radar(src);
+  rsl_source_close(src);
+  return radar;
+}
+
+Radar *RSL_lassen_to_radar_mem(char *buf, size_t len)
+{
+  Rsl_source *src;
+  Radar *radar;
+
+  if ((src = rsl_source_open_mem(buf, len)) == NULL) return NULL;
+  radar = lassen_to_radar(src);
+  rsl_source_close(src);
+  return radar;
+}
 #else
 Radar *RSL_lassen_to_radar(char *infile)
 {
@@ -458,4 +470,9 @@ Radar *RSL_lassen_to_radar(char *infile)
   fprintf(stderr, "Reinstall RSL w/ -DHAVE_LASSEN in the Makefile.\n");
   return NULL;
 }
+
+Radar *RSL_lassen_to_radar_mem(char *buf, size_t len)
+{
+  return RSL_lassen_to_radar(NULL);
+}
 #endif
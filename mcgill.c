@@ -52,6 +52,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "rsl.h"
 #include "mcgill.h"
 
 #define TRUE 1
@@ -102,13 +103,28 @@ static int num_bins_compressed[24] =
    120, 120, 120, 120
    };
 
-FILE *uncompress_pipe (FILE *fp);
-
 /**********************************************************************/
 mcgFile_t *mcgFileOpen(int *code, char *filename)
 /**********************************************************************/
    {
-   /* Open a Mcgill format radar data file, and read and verify 
+   /* Open a Mcgill format radar data file, as mcgFileOpenSource.
+	  Transparently, use gunzip. */
+   Rsl_source *src;
+
+   if ((src = rsl_source_open(filename)) == NULL)
+	  {
+	  *code = MCG_OPEN_FILE_ERR;
+	  return(NULL);
+	  }
+   return(mcgFileOpenSource(code, src));
+   }
+
+/**********************************************************************/
+mcgFile_t *mcgFileOpenSource(int *code, Rsl_source *src)
+/**********************************************************************/
+   {
+   /* Read Mcgill format radar data from 'src', which mcgFileClose
+      closes.  Read and verify 
       the content of the first (header) record from the file.
       This function returns one of the following coded integer values:
 		 MCG_OK: Normal return.
@@ -120,25 +136,18 @@ mcgFile_t *mcgFileOpen(int *code, char *filename)
          SYS_NO_SPACE: Error attempting to allocate memory space.
    */
    mcgFile_t *file;
-   char buffer[MCG_RECORD];
-   char *csp_buffer;
+   char *buffer;
    
    /* Allocate space for the mcgFile structure. */
    if ((file = (mcgFile_t *)malloc(sizeof(mcgFile_t))) == NULL)
 	  {
 	  *code = SYS_NO_SPACE;
+	  rsl_source_close(src);
       return(NULL);
 	  }
-   
-   /* Open Mcgill data file for reading */
-   if ((file->fp = fopen(filename, "r")) == NULL)
-	  {
-	  *code = MCG_OPEN_FILE_ERR;
-	  return(NULL);
-	  }
-   file->fp = uncompress_pipe(file->fp); /* Transparently, use gunzip. */
-   /* Read first (header) record from data file into buffer */
-   if (fread(buffer, sizeof(char), MCG_RECORD, file->fp) < MCG_RECORD)
+   file->src = src;
+   /* Get first (header) record from data file */
+   if ((buffer = rsl_source_get(file->src, MCG_RECORD)) == NULL)
 	  {
 	  *code = MCG_FORMAT_ERR;
 	  return(NULL);
@@ -218,28 +227,11 @@ mcgFile_t *mcgFileOpen(int *code, char *filename)
 	  Skip past it. It's useless for our purposes. */
    if (file->head.csp_rec == 1)
 	  {
-	  /* if (fseek(file->fp, MCG_CSP, SEEK_CUR) != 0)
+	  if (!rsl_source_skip(file->src, MCG_CSP))
 		 {
 		 *code = MCG_READ_ERR;
 		 return(NULL);
 		 }
-	  */
-	  /* Allocate buffer space for the csp block, read the block
-		 from the disk file into the buffer, then free the buffer.
-		 An ugly way to discard the block, but the fseek solution
-		 above won't work with stdin capabilities.
-	  */
-	  if ((csp_buffer=(char *)malloc(MCG_CSP)) == NULL)
-		 {
-		 *code = SYS_NO_SPACE;
-		 return(NULL);
-		 }
-	  if (fread(csp_buffer, sizeof(char), MCG_CSP, file->fp) < MCG_CSP)
-		 {
-		 *code = MCG_READ_ERR;
-		 return(NULL);
-		 }
-	  free(csp_buffer);
 	  }
    
    /* File is open and properly initialized. */
@@ -248,7 +240,6 @@ mcgFile_t *mcgFileOpen(int *code, char *filename)
    }
 
 
-int rsl_pclose( FILE *stream);
 /**********************************************************************/
 int mcgFileClose(mcgFile_t *file)
 /**********************************************************************/
@@ -261,13 +252,9 @@ int mcgFileClose(mcgFile_t *file)
    */
 
 
-   if (rsl_pclose(file->fp) == 0)
-	  {
-	  file->fp = NULL;
-	  return(MCG_OK);
-	  }
-   else
-	  return(MCG_CLOSE_FILE_ERR);
+   rsl_source_close(file->src);
+   file->src = NULL;
+   return(MCG_OK);
    }
 
 
@@ -285,9 +272,9 @@ int mcgRecordRead(mcgRecord_t *record, mcgFile_t *file)
    */
 
    /* Read data from file directly into the record structure. */
-   if (fread(record, sizeof(char), MCG_RECORD, file->fp) < MCG_RECORD)
+   if (rsl_source_read(record, sizeof(char), MCG_RECORD, file->src) < MCG_RECORD)
 	  {
-	  if (feof(file->fp))
+	  if (rsl_source_eof(file->src))
 	     return(MCG_EOF);
 	  else
 	     return(MCG_READ_ERR);
@@ -336,14 +323,14 @@ int mcgRayBuild(mcgRay_t *ray, mcgFile_t *file)
    /* This function is typically called about 9000 times while reading a
 	  Mcgill data file. The following static variables must retain their
 	  values between successive calls. */
-   static int seg_num=MCG_MAX_SEG_NUM;
-   static int eod_found = FALSE;
-   static int sweep_num=0;
-   static float elev=0.0;
-   static float azm;
+   static RSL_THREAD_LOCAL int seg_num=MCG_MAX_SEG_NUM;
+   static RSL_THREAD_LOCAL int eod_found = FALSE;
+   static RSL_THREAD_LOCAL int sweep_num=0;
+   static RSL_THREAD_LOCAL float elev=0.0;
+   static RSL_THREAD_LOCAL float azm;
    int base, j, n;
    mcgSegmentID seg_type;
-   static mcgRecord_t record;
+   static RSL_THREAD_LOCAL mcgRecord_t record;
 
 
    /* If we've previously found the end_of_data (eod) data segment in 
@@ -62,7 +62,7 @@ mcgHeader_t;
 
 typedef struct
    {
-   FILE *fp;            /* Pointer to Mcgill file */
+   Rsl_source *src;     /* Mcgill file, uncompressed; see source.c */
    int site;
    int *num_bins;       /* Points to array of 24 bin_counts,
 						   one bin_count per sweep. */
@@ -99,6 +99,7 @@ mcgRay_t;
 /*************** Function Prototypes **********************/
 /* Grouped by object operated on and/or returned. */
 mcgFile_t *mcgFileOpen(int *code, char *filename);
+mcgFile_t *mcgFileOpenSource(int *code, Rsl_source *src);
 int mcgFileClose(mcgFile_t *file);
 
 int mcgRecordRead(mcgRecord_t *record, mcgFile_t *file);
@@ -60,8 +60,8 @@
 
 #include <string.h>
 #include <stdlib.h>
-#include "mcgill.h"
 #include "rsl.h"
+#include "mcgill.h"
 
 #define MAX_RAYS   512
 #define MAX_SWEEPS  32
@@ -69,7 +69,6 @@
 #define MCG_DBZ_BIAS 16.5
 #define MCG_NOISE_BIAS 0.0
 
-extern int radar_verbose_flag;
 
 /*********************** Function Prototypes ***************************/
 static void RayFill(Ray *rsl_ray, mcgRay_t *mcg_ray);
@@ -80,8 +79,8 @@ static void Volume_headerInit(Volume *volume, short vol_scan_format);
 static void Radar_headerInit(Radar *radar, mcgHeader_t *mcg_head);
 Radar *RSL_mcgill_to_radar(char *infile);
 
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
 /* Fixed number_of_RSL_bins for Mcgill sweeps. Note that
    the number of bins in the RSL structure differs from
@@ -228,7 +227,7 @@ void Sweep_headerInit(Sweep *sweep, mcgRay_t *mcg_ray, int nrays)
 /*********************************************************************/
    /* Arrive here _after_ sweep ray data has been filled in. */
    {
-   if (radar_verbose_flag)
+   if (rsl_verbose())
       fprintf(stderr,"sweep_num:%02d  num_rays:%d\n",mcg_ray->sweep_num, nrays);
    if (sweep == NULL) return;
    sweep->h.sweep_num = mcg_ray->sweep_num;
@@ -298,22 +297,19 @@ void Radar_headerInit(Radar *radar, mcgHeader_t *mcg_head)
 
 
 /*********************************************************************/
-Radar *RSL_mcgill_to_radar(char *infile)
+static Radar *mcgill_to_radar(Rsl_source *src, char *infile)
 /*********************************************************************/
    {
    /* Ingest a Mcgill format radar data file and fill a Radar RSL
-	  structure with the data. 
+	  structure with the data.  'src' is closed.
    */
    int ray_num, code;
    int *num_bins_rsl;
    mcgFile_t *file;
    Radar *radar;
    mcgRay_t *mcg_ray, *mcg_ray_last, *swap;
-   extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-   extern int rsl_qsweep_max;
    
-   /* If no filename has been passed, there's nothing to do. */
-   if (infile == NULL) 
+   if (src == NULL)
       return NULL;
 
    /* Default conversion functions. */
@@ -324,17 +320,18 @@ Radar *RSL_mcgill_to_radar(char *infile)
    radar = (Radar *)RSL_new_radar(MAX_RADAR_VOLUMES);
    if (radar == NULL) {
 	 perror("RSL_mcgill_to_radar: RSL_new_radar:");
+	 rsl_source_close(src);
 	 return NULL;
    }
 
 
    /* Open the Mcgill data file and read Mcgill file header into the 
 	  mcgFile.head structure */
-   file = (mcgFile_t *)mcgFileOpen(&code, infile);
+   file = (mcgFile_t *)mcgFileOpenSource(&code, src);
    if (file == NULL)
       goto quit;
    
-   if (radar_verbose_flag)
+   if (rsl_verbose())
 	  {
 	  fprintf(stderr,"Input file:  %s\n", infile);
 	  fprintf(stderr,"Scan_date: %d/%d/%d\n", file->head.month, file->head.day, 
@@ -383,7 +380,7 @@ Radar *RSL_mcgill_to_radar(char *infile)
 	  /* Discard rays with bogus azimuth values. */
 	  if (mcg_ray->azm > 360.0)
 		 {
-		 if (radar_verbose_flag)
+		 if (rsl_verbose())
 		    fprintf(stderr,"**** Bogus azm:%.1f, discarding ray.\n", mcg_ray->azm);
 	     continue;
 		 }
@@ -409,10 +406,8 @@ Radar *RSL_mcgill_to_radar(char *infile)
 			RSL_free_radar(radar);
 			return NULL;
 			}
-		 if (rsl_qsweep != NULL) {
-		   if (mcg_ray->sweep_num > rsl_qsweep_max) break;
-		   if (rsl_qsweep[mcg_ray->sweep_num] == 0) continue;
-		 }
+		 if (rsl_sweeps_done(mcg_ray->sweep_num)) break;
+		 if (!rsl_want_sweep(mcg_ray->sweep_num)) continue;
 
 		 /* Create new sweep structure. */
 		 radar->v[DZ_INDEX]->sweep[mcg_ray->sweep_num] = RSL_new_sweep(MAX_RAYS);
@@ -459,7 +454,7 @@ Radar *RSL_mcgill_to_radar(char *infile)
    
    /* Check which flag the mcgill routines returned, and 
 	  print appropriate terminating message */
-quit: if (radar_verbose_flag)
+quit: if (rsl_verbose())
 	  {
 	  switch (code)
 		 {
@@ -482,7 +477,7 @@ quit: if (radar_verbose_flag)
 		 fprintf(stderr,"Error reading data file \n");
 		 break;
 		 }
-	  }  /* end if (radar_verbose_flag) */
+	  }  /* end if (rsl_verbose()) */
    
    if (code == MCG_EOD)  /* Successfully read in Mcgill file? */
 	  {
@@ -497,3 +492,21 @@ quit: if (radar_verbose_flag)
 	  }
    }
 
+
+/*********************************************************************/
+Radar *RSL_mcgill_to_radar(char *infile)
+/*********************************************************************/
+   {
+   /* If no filename has been passed, there's nothing to do. */
+   if (infile == NULL) 
+      return NULL;
+   /* Transparently, use gunzip. */
+   return mcgill_to_radar(rsl_source_open(infile), infile);
+   }
+
+/*********************************************************************/
+Radar *RSL_mcgill_to_radar_mem(char *buf, size_t len)
+/*********************************************************************/
+   {
+   return mcgill_to_radar(rsl_source_open_mem(buf, len), "(memory)");
+   }
@@ -50,70 +50,43 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "rsl.h"
 #include "nsig.h"
 
-FILE *uncompress_pipe(FILE *fp);
 int big_endian(void);
 int little_endian(void);
 void swap_4_bytes(void *word);
 void swap_2_bytes(void *word);
-int rsl_pclose(FILE *fp);
 
 /*********************************************************************
- * Open a file and possibly setup a gunzip pipe                      *
+ * Open a file, gunzip'ing it as need be.  NULL file_name is stdin.  *
  *********************************************************************/
-FILE *nsig_open(char *file_name)
+Rsl_source *nsig_open(char *file_name)
 {
-  FILE *fp;
-  int save_fd;
-
-   /* Open input file */
-  if (file_name == NULL) { /* Use stdin */
-    save_fd = dup(0);
-    fp = fdopen(save_fd, "r");
-  } else if((fp = fopen(file_name,"r")) == NULL) {
-    perror(file_name);
-    return fp;
-  }
-
-  fp = uncompress_pipe(fp); /* Transparently gunzip. */
-  return fp;
+  return rsl_source_open(file_name);
 }
 
 /**********************************************************************
  *   Given an opened file stream read in the headers and fill in      *
  *   the nsig_file data structure.                                    *
  **********************************************************************/
-int nsig_read_record(FILE *fp, char *nsig_rec)
+int nsig_read_record(Rsl_source *src, char *nsig_rec)
 {
-   int n;
-   int nbytes;
-   char *buf;
-   /* Input could be a chain of pipes. So read until no more data.
-    * For instance, a gzip pipe will write chunks of 4096 bytes, 
-    * even when there is really more that we want to read.
-    */
    /* Return the number of bytes read. */
-   buf = (char *)nsig_rec;
-
-   if (feof(fp)) return -1;
-   nbytes = 0;
-   while((n = fread(&buf[nbytes], sizeof(char), NSIG_BLOCK-nbytes, fp)) > 0) {
-     nbytes += n;
-   }
-   return nbytes;
+   if (rsl_source_eof(src)) return -1;
+   return rsl_source_read(nsig_rec, sizeof(char), NSIG_BLOCK, src);
 }
 
 
 /*********************************************************
  * Close nsig file                                       *
  *********************************************************/
-void nsig_close(FILE *fp)
+void nsig_close(Rsl_source *src)
    {
-     rsl_pclose(fp);
+     rsl_source_close(src);
    }
 
-static int do_swap;
+static RSL_THREAD_LOCAL int do_swap;
 
 int nsig_endianess(NSIG_Record1 *rec1)
 {
@@ -184,10 +157,10 @@ void nsig_free_sweep(NSIG_Sweep **s)
   free(s);
 }
 
-static int ipos = 0;  /* Current position in the data buffer. */
-static NSIG_Data_record data;
+static RSL_THREAD_LOCAL int ipos = 0;  /* Current position in the data buffer. */
+static RSL_THREAD_LOCAL NSIG_Data_record data;
 
-int nsig_read_chunk(FILE *fp, char *chunk)
+int nsig_read_chunk(Rsl_source *src, char *chunk)
 {
   int i, n;
   int the_code;
@@ -207,12 +180,12 @@ int nsig_read_chunk(FILE *fp, char *chunk)
 #define Vprint
 #undef  Vprint
   while(the_code != 1) {
-    if (feof(fp)) return -1;
+    if (rsl_source_eof(src)) return -1;
     if (ipos == sizeof(data)) { /* the_code is in the next chunk */
 #ifdef Vprint
       printf("Exceeded block size looking for the_code. Get it from next buffer.\n");
 #endif
-      n = nsig_read_record(fp, (char *)data);
+      n = nsig_read_record(src, (char *)data);
       if (n <= 0) return n;  /* Problem. */
 
 #ifdef Vprint
@@ -249,7 +222,7 @@ int nsig_read_chunk(FILE *fp, char *chunk)
         memmove(&chunk[i], &data[ipos], sizeof(twob)*end_nwords);
         i += end_nwords * sizeof(twob);
 
-        n = nsig_read_record(fp, (char *)data);
+        n = nsig_read_record(src, (char *)data);
         if (n <= 0) return n;  /* Problem. */
         /* New ipos */
         nwords -= end_nwords;
@@ -303,7 +276,7 @@ int nsig_read_chunk(FILE *fp, char *chunk)
       printf("Exceeded block size ... ipos = %d\n", ipos);
       printf("This should be right at the end of the block.\n");
 #endif
-      n = nsig_read_record(fp, (char *)data);
+      n = nsig_read_record(src, (char *)data);
       if (n <= 0) return n; /* Problem. */
       ipos = sizeof(NSIG_Raw_prod_bhdr);
     }
@@ -312,13 +285,13 @@ int nsig_read_chunk(FILE *fp, char *chunk)
   return i;
 }
 
-NSIG_Ext_header_ver0 *nsig_read_ext_header_ver0(FILE *fp)
+NSIG_Ext_header_ver0 *nsig_read_ext_header_ver0(Rsl_source *src)
 {
   NSIG_Data_record chunk;
   int n;
   NSIG_Ext_header_ver0 *xh0;
   xh0 = NULL;
-  n = nsig_read_chunk(fp, (char *)chunk);
+  n = nsig_read_chunk(src, (char *)chunk);
   if (n <= 0) return xh0;
 #ifdef Vprint
   printf("Ver0 x-header.  %d bytes found.\n", n);
@@ -330,13 +303,13 @@ NSIG_Ext_header_ver0 *nsig_read_ext_header_ver0(FILE *fp)
 }
 
 
-NSIG_Ext_header_ver1 *nsig_read_ext_header_ver1(FILE *fp)
+NSIG_Ext_header_ver1 *nsig_read_ext_header_ver1(Rsl_source *src)
 {
   NSIG_Data_record chunk;
   int n;
   NSIG_Ext_header_ver1 *xh1;
   xh1 = NULL;
-  n = nsig_read_chunk(fp, (char *)chunk);
+  n = nsig_read_chunk(src, (char *)chunk);
   if (n <= 0) return xh1;
 #ifdef Vprint
   printf("Ver1 x-header.  %d bytes found.\n", n);
@@ -347,14 +320,14 @@ NSIG_Ext_header_ver1 *nsig_read_ext_header_ver1(FILE *fp)
   return xh1;
 }
 
-NSIG_Ray *nsig_read_ray(FILE *fp, int *nsig_error)
+NSIG_Ray *nsig_read_ray(Rsl_source *src, int *nsig_error)
 {
   int n, nbins;
   NSIG_Ray_header rayh;
-  static NSIG_Data_record chunk;
+  static RSL_THREAD_LOCAL NSIG_Data_record chunk;
   NSIG_Ray *ray;
   
-  n = nsig_read_chunk(fp, (char *)chunk);
+  n = nsig_read_chunk(src, (char *)chunk);
   /* Size of chunk is n */
 
   if (n == 0) return NULL; /* Silent error. */
@@ -391,7 +364,7 @@ NSIG_Ray *nsig_read_ray(FILE *fp, int *nsig_error)
 }
 
 
-NSIG_Sweep **nsig_read_sweep(FILE *fp, NSIG_Product_file *prod_file,
+NSIG_Sweep **nsig_read_sweep(Rsl_source *src, NSIG_Product_file *prod_file,
         int *nsig_error)
 {
   NSIG_Sweep **s;
@@ -504,8 +477,8 @@ NSIG_Sweep **nsig_read_sweep(FILE *fp, NSIG_Product_file *prod_file,
   /* Ingest initial block for the sweep.  All remaining I/O will
    * be performed in the de-compression loop.
    */
-  if (feof(fp)) return NULL;
-  n = nsig_read_record(fp, (char *)data);
+  if (rsl_source_eof(src)) return NULL;
+  n = nsig_read_record(src, (char *)data);
   if (n <= 0) return NULL;
 #ifdef Vprint
   printf("Read %d bytes for data.\n", n);
@@ -592,7 +565,7 @@ NSIG_Sweep **nsig_read_sweep(FILE *fp, NSIG_Product_file *prod_file,
 #ifdef Vprint
     printf("---------------------- New Ray <%d> --------------------\n", iray);
 #endif
-    if (feof(fp)) { /* Premature eof */
+    if (rsl_source_eof(src)) { /* Premature eof */
       return NULL; /* This will have to do. */
     }
     /* For all parameters present. */
@@ -604,17 +577,17 @@ NSIG_Sweep **nsig_read_sweep(FILE *fp, NSIG_Product_file *prod_file,
        */
       nsig_ray = NULL;
       if (idtype[i] != 0) { /* Not an extended header. */
-        nsig_ray = nsig_read_ray(fp, nsig_error);
+        nsig_ray = nsig_read_ray(src, nsig_error);
 
       } else { /* Check extended header version. */
         if (xh_size <= 20) {
-          exh0 = nsig_read_ext_header_ver0(fp);
+          exh0 = nsig_read_ext_header_ver0(src);
           if (exh0) {
             nsig_ray = (NSIG_Ray *)calloc(1, sizeof(NSIG_Ray));
             nsig_ray->range = (unsigned char *)exh0;
           }
         } else {
-          exh1 = nsig_read_ext_header_ver1(fp);
+          exh1 = nsig_read_ext_header_ver1(src);
           if (exh1) {
             nsig_ray = (NSIG_Ray *)calloc(1, sizeof(NSIG_Ray));
             nsig_ray->range = (unsigned char *)exh1;
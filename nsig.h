@@ -899,7 +899,7 @@ typedef struct {
 /*============================================================*/
 
 /* FUNCTION PROTOTYPES */
-FILE *nsig_open(char *file_name);
+Rsl_source *nsig_open(char *file_name);
 void swap_nsig_record1(NSIG_Record1 *rec1);
 void swap_nsig_record2(NSIG_Record2 *rec2);
 void swap_nsig_raw_prod_bhdr(NSIG_Raw_prod_bhdr *rp);
@@ -967,13 +967,13 @@ typedef struct {
 
 void nsig_free_ray(NSIG_Ray *r);
 void nsig_free_sweep(NSIG_Sweep **s);
-NSIG_Sweep **nsig_read_sweep(FILE *fp, NSIG_Product_file *prod_file,
+NSIG_Sweep **nsig_read_sweep(Rsl_source *src, NSIG_Product_file *prod_file,
         int *nsig_error);
-int nsig_read_record(FILE *fp, char *nsig_rec);
+int nsig_read_record(Rsl_source *src, char *nsig_rec);
 int nsig_endianess(NSIG_Record1 *rec1);
 short NSIG_I2 (twob x);
 int NSIG_I4 (fourb x);
-void nsig_close(FILE *fp);
+void nsig_close(Rsl_source *src);
 
 float nsig_from_fourb_ang(fourb ang);
 float nsig_from_bang(bang in);
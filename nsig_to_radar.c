@@ -48,11 +48,9 @@
 #include<math.h>
 #include<string.h>
 
-#include"nsig.h"
 #include"rsl.h"
+#include"nsig.h"
 
-extern int radar_verbose_flag;
-extern int rsl_qfield[]; /* See RSL_select_fields */
 
    /*  We need this entry for various things esp in Ray_header  */
 #define MISSING_HEADER_DATA -9999
@@ -68,8 +66,8 @@ extern int rsl_qfield[]; /* See RSL_select_fields */
 #define NSIG_NO_ECHO       -32.0
 #define NSIG_NO_ECHO2     -999.0
 
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
 extern FILE *file;
 
@@ -83,7 +81,7 @@ void  get_extended_header_info(NSIG_Sweep **nsig_sweep, int xh_size, int iray,
                                float *lat, float *lon, int *alt, float *rvc,
                                float *vel_east, float *vel_north, float *vel_up)
 {
-  static NSIG_Ext_header_ver1 xh;
+  static RSL_THREAD_LOCAL NSIG_Ext_header_ver1 xh;
   int data_type, itype;
 
   *msec = *azm = *elev = *pitch = *roll = *heading =
@@ -134,16 +132,142 @@ void  get_extended_header_info(NSIG_Sweep **nsig_sweep, int xh_size, int iray,
   return;
 }
 
+/*************************************************************/
+/*                                                           */
+/*                        nsig_field                         */
+/*                                                           */
+/*  The RSL field for NSIG data type 'data_type', or -1.     */
+/*  Sets f and invf for it.                                  */
+/*                                                           */
+/*************************************************************/
+static int nsig_field(int data_type)
+{
+  int ifield;
+
+  switch (data_type) {
+  case NSIG_DTB_UCR:
+  case NSIG_DTB_UCR2:
+    ifield = ZT_INDEX;
+    f      = ZT_F; 
+    invf   = ZT_INVF;
+    break;
+  case NSIG_DTB_CR:
+  case NSIG_DTB_CR2:
+    ifield = DZ_INDEX;
+    f      = DZ_F; 
+    invf   = DZ_INVF;
+    break;
+  case NSIG_DTB_VEL:
+  case NSIG_DTB_VEL2:
+    ifield = VR_INDEX;
+    f      = VR_F; 
+    invf   = VR_INVF;
+    break;
+  case NSIG_DTB_WID:
+  case NSIG_DTB_WID2:
+    ifield = SW_INDEX;
+    f      = SW_F; 
+    invf   = SW_INVF;
+    break;
+  case NSIG_DTB_ZDR:             
+  case NSIG_DTB_ZDR2:
+    ifield = DR_INDEX;
+    f      = DR_F; 
+    invf   = DR_INVF;
+    break;
+  case NSIG_DTB_KDP:
+    ifield = KD_INDEX;
+    f      = KD_F; 
+    invf   = KD_INVF;
+    break;
+  case NSIG_DTB_PHIDP:     /* SRB 990127 */
+    ifield = PH_INDEX;
+    f      = PH_F; 
+    invf   = PH_INVF;
+    break;
+  case NSIG_DTB_RHOHV:     /* SRB 000414 */
+    ifield = RH_INDEX;
+    f      = RH_F; 
+    invf   = RH_INVF;
+    break;
+  case NSIG_DTB_VELC:
+  case NSIG_DTB_VELC2:
+    ifield = VC_INDEX;
+    f      = VC_F; 
+    invf   = VC_INVF;
+    break;
+  case NSIG_DTB_KDP2:
+    ifield = KD_INDEX;
+    f      = KD_F; 
+    invf   = KD_INVF;
+    break;
+  case NSIG_DTB_PHIDP2:
+    ifield = PH_INDEX;
+    f      = PH_F; 
+    invf   = PH_INVF;
+    break;
+  case NSIG_DTB_RHOHV2:
+    ifield = RH_INDEX;
+    f      = RH_F; 
+    invf   = RH_INVF;
+    break;
+  case NSIG_DTB_SQI:
+  case NSIG_DTB_SQI2:
+    ifield = SQ_INDEX;
+    f      = SQ_F; 
+    invf   = SQ_INVF;
+    break;
+  case NSIG_DTB_HCLASS:
+  case NSIG_DTB_HCLASS2:
+    ifield = HC_INDEX;
+    f      = HC_F; 
+    invf   = HC_INVF;
+    break;
+  case NSIG_DTB_DBZ2:
+    ifield = CZ_INDEX;
+    f      = CZ_F; 
+    invf   = CZ_INVF;
+    break;
+  case NSIG_DTB_ZDRC2:
+    ifield = ZD_INDEX;
+    f      = ZD_F; 
+    invf   = ZD_INVF;
+    break;
+  case NSIG_DTB_DBTE8:
+    ifield = ET_INDEX;
+    f      = ZT_F; 
+    invf   = ZT_INVF;
+    break;
+  case NSIG_DTB_DBZE8:
+    ifield = EZ_INDEX;
+    f      = DZ_F; 
+    invf   = DZ_INVF;
+    break;
+  case NSIG_DTB_DBTV2:
+    ifield = TV_INDEX;
+    f      = ZT_F; 
+    invf   = ZT_INVF;
+    break;
+  case NSIG_DTB_DBZV2:
+    ifield = ZV_INDEX;
+    f      = DZ_F; 
+    invf   = DZ_INVF;
+    break;
+  case NSIG_DTB_SNR2:
+    ifield = SN_INDEX;
+    f      = SN_F; 
+    invf   = SN_INVF;
+    break;
+  default:
+    ifield = -1;
+    break;
+  }
+  return ifield;
+}
+
 /** Main code **/
-Radar *
-#ifdef NSIG_VER2
-RSL_nsig2_to_radar
-#else
-RSL_nsig_to_radar
-#endif
-(char *filename)
+static Radar *nsig_to_radar(Rsl_source *src)
 {
-  FILE *fp;
   /* RSL structures */
   Radar                    *radar;
   Ray                      *ray;
@@ -202,17 +326,10 @@ RSL_nsig_to_radar
   float vel_east, vel_north, vel_up; /* Platform velocity vectors m/sec */
   int xh_size;
   float incr;
-  extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-  extern int rsl_qsweep_max;
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
   extern float rsl_kdp_wavelen;
 
   radar = NULL;
-  if (radar_verbose_flag)
-    fprintf(stderr, "open file: %s\n", filename);
-  
-  /** Opening nsig file **/
-  if((fp = nsig_open(filename)) == NULL) return NULL;
-  
 #ifdef NSIG_VER2
   sprintf(radar_type, "nsig2");
   radar_number = 22;  /** Arbitrary number given to nsig2 data **/
@@ -227,21 +344,21 @@ RSL_nsig_to_radar
   
   prod_file = (NSIG_Product_file *)calloc(1, sizeof(NSIG_Product_file));
 
-  n = nsig_read_record(fp, (char *)&prod_file->rec1);
+  n = nsig_read_record(src, (char *)&prod_file->rec1);
   nsig_endianess(&prod_file->rec1);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     fprintf(stderr, "Read %d bytes for rec1.\n", n);
 
   id = NSIG_I2(prod_file->rec1.struct_head.id);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     fprintf(stderr, "ID = %d\n", (int)id);
   if (id != 7 && id != 27) { /* testing: Use 27 for Version 2 data */
     fprintf(stderr, "File is not a SIGMET version 1 nor version 2 raw product file.\n");
     return NULL;
   }
 
-  n = nsig_read_record(fp, (char *)&prod_file->rec2);
-  if (radar_verbose_flag)
+  n = nsig_read_record(src, (char *)&prod_file->rec2);
+  if (rsl_verbose())
     fprintf(stderr, "Read %d bytes for rec2.\n", n);
 
   /* Count the bits set in 'data_mask' to determine the number
@@ -249,7 +366,7 @@ RSL_nsig_to_radar
    */
   xh_size = NSIG_I2(prod_file->rec2.ingest_head.size_ext_ray_headers);
   nrays = NSIG_I2(prod_file->rec2.ingest_head.num_rays);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     fprintf(stderr, "Expecting %d rays in each sweep.\n", nrays);
 #ifdef NSIG_VER2 
   memmove(&masks[0], prod_file->rec2.task_config.dsp_info.data_mask_cur.mask_word_0,
@@ -275,7 +392,7 @@ RSL_nsig_to_radar
 
    memmove(site_name, prod_file->rec1.prod_end.site_name, sizeof(prod_file->rec1.prod_end.site_name));
    site_name[sizeof(site_name)-1] = '\0';
-  if (radar_verbose_flag) {
+  if (rsl_verbose()) {
     fprintf(stderr, "nparams = %d, nsweeps = %d\n", nparams, nsweeps);
     fprintf(stderr, "Site name = <%s>\n", site_name);
   }
@@ -332,9 +449,9 @@ RSL_nsig_to_radar
 
    sea_lvl_hgt = NSIG_I2(prod_file->rec1.prod_end.grnd_sea_ht);
 
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "sea: %d\n", sea_lvl_hgt);
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "site_name: %s", site_name);
    
    /** Determine beamwidth from input variables (not saved in nsig file) **/
@@ -347,7 +464,7 @@ RSL_nsig_to_radar
    else
      beam_width = DEFAULT_BEAMWIDTH;
 
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "beamwidth: %f\n", beam_width);
    
    vert_half_bw = beam_width/2.0;
@@ -373,8 +490,9 @@ RSL_nsig_to_radar
    prf_mode = NSIG_I2(prod_file->rec2.task_config.dsp_info.prf_mode);
    prf2 = prf * prf_modes[prf_mode];
    wave = (NSIG_I4(prod_file->rec1.prod_end.wavelen))/100.0; /* wavelength (cm) */
-   rsl_kdp_wavelen = wave;  /* EXTERNAL (volume.c) This sets KD_F and KD_INVF
-                             * to operate with the proper wavelength.
+   rsl_kdp_wavelen = wave;  /* EXTERNAL (volume.c) Kept for programs that
+                             * read it; the KDP decoding below uses 'wave',
+                             * as concurrent calls may set it differently.
                              */
    numbins = NSIG_I4(prod_file->rec1.prod_end.num_bin);   /* # bins in ray */
    rng_first_bin = (float)NSIG_I4(prod_file->rec1.prod_end.rng_f_bin)/100.0;
@@ -411,7 +529,7 @@ RSL_nsig_to_radar
    speckle = NSIG_I2(prod_file->rec2.task_config.calib_info.speckle);
 
    /** Verbose calibration information **/
-   if (radar_verbose_flag)
+   if (rsl_verbose())
       {
       fprintf(stderr, "LOG = %5.2f\n", log);
       fprintf(stderr, "SQI = %5.2f\n", sqi);
@@ -429,7 +547,7 @@ RSL_nsig_to_radar
       fprintf(stderr, "speckle remover: %d\n", speckle);
       }
    
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "vel: %f prf: %f prf2: %f\n", max_vel, prf, prf2);
    
    /** Extracting Latitude and Longitude from nsig file **/
@@ -437,7 +555,7 @@ RSL_nsig_to_radar
    lon = nsig_from_fourb_ang(prod_file->rec2.ingest_head.lon_rad);
    if(lat > 180.0) lat -= 360.0;
    if(lon > 180.0) lon -= 360.0;
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "nsig_to_radar: lat %f, lon %f\n", lat, lon);
    /** Latitude deg, min, sec **/
    latd = (int)lat;
@@ -484,7 +602,7 @@ RSL_nsig_to_radar
    if(ant_scan_mode == 2 || ant_scan_mode == 7) radar->h.scan_mode = RHI;
    else radar->h.scan_mode = PPI;
 
-   if (radar_verbose_flag) {
+   if (rsl_verbose()) {
 #ifdef NSIG_VER2
      fprintf(stderr, "\nSIGMET version 2 raw product file.\n");
 #else
@@ -503,19 +621,22 @@ RSL_nsig_to_radar
    }
 
    /** Converting data **/
-   if (radar_verbose_flag) fprintf(stderr, "Expecting %d sweeps.\n", numsweep);
-   for(i = 0; i < numsweep; i++)
+   if (rsl_verbose()) fprintf(stderr, "Expecting %d sweeps.\n", numsweep);
+   for(i = 0; i < numsweep && !rsl_sweeps_done(i); i++)
       {
-        nsig_sweep = nsig_read_sweep(fp, prod_file, &nsig_error);
+        /* The sweep is read even when it is not wanted; the data is
+         * compressed, so this is the only way to get past it.
+         */
+        nsig_sweep = nsig_read_sweep(src, prod_file, &nsig_error);
         if (nsig_sweep == NULL) { /* EOF possibility */
-          if (feof(fp) || nsig_error) break;
+          if (rsl_source_eof(src) || nsig_error) break;
           else continue;
         }
-        if (rsl_qsweep != NULL) {
-          if (i > rsl_qsweep_max) break;
-          if (rsl_qsweep[i] == 0) continue;
+        if (!rsl_want_sweep(i)) {
+          nsig_free_sweep(nsig_sweep);
+          continue;
         }
-        if (radar_verbose_flag)
+        if (rsl_verbose())
           fprintf(stderr, "Read sweep # %d\n", i);
     /* The whole sweep is 'nsig_sweep' ... pretty slick.
          *
@@ -544,135 +665,18 @@ RSL_nsig_to_radar
 
       data_type = NSIG_I2(nsig_sweep[itype]->idh.data_type);
 
-      ifield = 0;
-      switch (data_type) {
-      case NSIG_DTB_EXH: 
-          ifield = -1; 
-          break;
-      case NSIG_DTB_UCR:
-      case NSIG_DTB_UCR2:
-        ifield = ZT_INDEX;
-        f      = ZT_F; 
-        invf   = ZT_INVF;
-        break;
-      case NSIG_DTB_CR:
-      case NSIG_DTB_CR2:
-        ifield = DZ_INDEX;
-        f      = DZ_F; 
-        invf   = DZ_INVF;
-        break;
-      case NSIG_DTB_VEL:
-      case NSIG_DTB_VEL2:
-        ifield = VR_INDEX;
-        f      = VR_F; 
-        invf   = VR_INVF;
-        break;
-      case NSIG_DTB_WID:
-      case NSIG_DTB_WID2:
-        ifield = SW_INDEX;
-        f      = SW_F; 
-        invf   = SW_INVF;
-        break;
-      case NSIG_DTB_ZDR:             
-      case NSIG_DTB_ZDR2:
-        ifield = DR_INDEX;
-        f      = DR_F; 
-        invf   = DR_INVF;
-        break;
-      case NSIG_DTB_KDP:
-        ifield = KD_INDEX;
-        f      = KD_F; 
-        invf   = KD_INVF;
-        break;
-      case NSIG_DTB_PHIDP:     /* SRB 990127 */
-        ifield = PH_INDEX;
-        f      = PH_F; 
-        invf   = PH_INVF;
-        break;
-      case NSIG_DTB_RHOHV:     /* SRB 000414 */
-        ifield = RH_INDEX;
-        f      = RH_F; 
-        invf   = RH_INVF;
-        break;
-      case NSIG_DTB_VELC:
-      case NSIG_DTB_VELC2:
-        ifield = VC_INDEX;
-        f      = VC_F; 
-        invf   = VC_INVF;
-        break;
-      case NSIG_DTB_KDP2:
-        ifield = KD_INDEX;
-        f      = KD_F; 
-        invf   = KD_INVF;
-        break;
-      case NSIG_DTB_PHIDP2:
-        ifield = PH_INDEX;
-        f      = PH_F; 
-        invf   = PH_INVF;
-        break;
-      case NSIG_DTB_RHOHV2:
-        ifield = RH_INDEX;
-        f      = RH_F; 
-        invf   = RH_INVF;
-        break;
-      case NSIG_DTB_SQI:
-      case NSIG_DTB_SQI2:
-        ifield = SQ_INDEX;
-        f      = SQ_F; 
-        invf   = SQ_INVF;
-        break;
-      case NSIG_DTB_HCLASS:
-      case NSIG_DTB_HCLASS2:
-        ifield = HC_INDEX;
-        f      = HC_F; 
-        invf   = HC_INVF;
-        break;
-      case NSIG_DTB_DBZ2:
-        ifield = CZ_INDEX;
-        f      = CZ_F; 
-        invf   = CZ_INVF;
-        break;
-      case NSIG_DTB_ZDRC2:
-        ifield = ZD_INDEX;
-        f      = ZD_F; 
-        invf   = ZD_INVF;
-        break;
-      case NSIG_DTB_DBTE8:
-        ifield = ET_INDEX;
-        f      = ZT_F; 
-        invf   = ZT_INVF;
-        break;
-      case NSIG_DTB_DBZE8:
-        ifield = EZ_INDEX;
-        f      = DZ_F; 
-        invf   = DZ_INVF;
-        break;
-      case NSIG_DTB_DBTV2:
-        ifield = TV_INDEX;
-        f      = ZT_F; 
-        invf   = ZT_INVF;
-        break;
-      case NSIG_DTB_DBZV2:
-        ifield = ZV_INDEX;
-        f      = DZ_F; 
-        invf   = DZ_INVF;
-        break;
-      case NSIG_DTB_SNR2:
-        ifield = SN_INDEX;
-        f      = SN_F; 
-        invf   = SN_INVF;
-        break;
-      default:
+      if (data_type == NSIG_DTB_EXH) ifield = -1;
+      else if ((ifield = nsig_field(data_type)) < 0) {
         fprintf(stderr,"Unknown field type: %d  Skipping it.\n", data_type);
         continue;
       }
 
-      if (radar_verbose_flag)
+      if (rsl_verbose())
         fprintf(stderr, "     nsig_sweep[%d], data_type = %d, rays(expected) = %d, nrays(actual) = %d\n", itype, data_type, num_rays, NSIG_I2(nsig_sweep[itype]->idh.num_rays_act));
 
       if (data_type != NSIG_DTB_EXH) {
         if ((radar->v[ifield] == NULL)) {
-          if (rsl_qfield[ifield]) {
+          if (reader->qfield[ifield]) {
              radar->v[ifield] = RSL_new_volume(numsweep);
              radar->v[ifield]->h.f = f;
              radar->v[ifield]->h.invf = invf;
@@ -852,18 +856,18 @@ RSL_nsig_to_radar
 
             case NSIG_DTB_KDP:
 		if (ray_p->range[k] == 0 || ray_p->range[k] == 255 ||
-		    rsl_kdp_wavelen == 0.0) {
+		    wave == 0.0) {
 		  ray_data = NSIG_NO_ECHO;
 		  break;
 		}
 		if (ray_p->range[k] < 128)
 		  ray_data = (-0.25 *
 		    pow((double)600.0,(double)((127-ray_p->range[k])/126.0))) /
-		      rsl_kdp_wavelen;
+		      wave;
 		else if (ray_p->range[k] > 128)
 		  ray_data = (0.25 *
 		    pow((double)600.0,(double)((ray_p->range[k]-129)/126.0))) /
-		      rsl_kdp_wavelen;
+		      wave;
 		else
 		  ray_data = 0.0;
                 break;
@@ -971,13 +975,10 @@ RSL_nsig_to_radar
       }
 
    /* Do not reset radar->h.nvolumes. It is already set properly. */
-   if (radar_verbose_flag)
+   if (rsl_verbose())
      fprintf(stderr, "Max index of radar->v[0..%d]\n", radar->h.nvolumes);
    
 
-   /** close nsig file **/
-   nsig_close(fp);
-
    radar = RSL_prune_radar(radar);
 
    if (nsig_error) fprintf(stderr,"RSL_nsig_to_radar: Ending with error.\n");
@@ -985,3 +986,134 @@ RSL_nsig_to_radar
    /** return radar pointer **/
    return radar;
 }
+
+Radar *
+#ifdef NSIG_VER2
+RSL_nsig2_to_radar
+#else
+RSL_nsig_to_radar
+#endif
+(char *filename)
+{
+  Rsl_source *src;
+  Radar *radar;
+
+  if (rsl_verbose())
+    fprintf(stderr, "open file: %s\n", filename);
+  
+  /** Opening nsig file **/
+  if((src = nsig_open(filename)) == NULL) return NULL;
+  radar = nsig_to_radar(src);
+
+  /** close nsig file **/
+  nsig_close(src);
+  return radar;
+}
+
+Radar *
+#ifdef NSIG_VER2
+RSL_nsig2_to_radar_mem
+#else
+RSL_nsig_to_radar_mem
+#endif
+(char *buf, size_t len)
+{
+  /* As RSL_nsig_to_radar, for the 'len' bytes at 'buf'. */
+  Rsl_source *src;
+  Radar *radar;
+
+  if((src = rsl_source_open_mem(buf, len)) == NULL) return NULL;
+  radar = nsig_to_radar(src);
+  nsig_close(src);
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      nsig_probe, nsig2_probe                       */
+/*                                                                    */
+/*  Fill 'p' (see RSL_probe) from the product and ingest headers,     */
+/*  the first two records of the file.  No sweep is read; the ray     */
+/*  count is the number of rays the ingest header says to expect in   */
+/*  each sweep.  Returns 0, or -1 if this is not a raw product file.  */
+/*                                                                    */
+/**********************************************************************/
+int
+#ifdef NSIG_VER2
+nsig2_probe
+#else
+nsig_probe
+#endif
+(Rsl_source *src, Rsl_probe *p)
+{
+  NSIG_Data_record buf1, buf2; /* rec2 is shorter than a record. */
+  NSIG_Record1 *rec1 = (NSIG_Record1 *)buf1;
+  NSIG_Record2 *rec2 = (NSIG_Record2 *)buf2;
+  Rsl_probe_sweep *s;
+  float lat, lon;
+  double tmp;
+  int i, j, sec, ifield, nrays, nsweeps;
+  int masks[5], nmasks;
+  short id;
+
+  if (nsig_read_record(src, (char *)buf1) != NSIG_BLOCK) return -1;
+  nsig_endianess(rec1);
+  id = NSIG_I2(rec1->struct_head.id);
+  if (id != 7 && id != 27) {
+    fprintf(stderr, "File is not a SIGMET version 1 nor version 2 raw product file.\n");
+    return -1;
+  }
+  if (nsig_read_record(src, (char *)buf2) != NSIG_BLOCK) return -1;
+
+#ifdef NSIG_VER2
+  sprintf(p->radar_type, "nsig2");
+  masks[0] = NSIG_I4(rec2->task_config.dsp_info.data_mask_cur.mask_word_0);
+  masks[1] = NSIG_I4(rec2->task_config.dsp_info.data_mask_cur.mask_word_1);
+  masks[2] = NSIG_I4(rec2->task_config.dsp_info.data_mask_cur.mask_word_2);
+  masks[3] = NSIG_I4(rec2->task_config.dsp_info.data_mask_cur.mask_word_3);
+  masks[4] = NSIG_I4(rec2->task_config.dsp_info.data_mask_cur.mask_word_4);
+  nmasks = 5;
+#else
+  sprintf(p->radar_type, "nsig");
+  masks[0] = NSIG_I4(rec2->task_config.dsp_info.data_mask);
+  nmasks = 1;
+#endif
+  memmove(p->name, rec1->prod_end.site_name, sizeof(p->name));
+  p->name[sizeof(p->name)-1] = '\0';
+
+  p->month = NSIG_I2(rec2->ingest_head.start_time.month);
+  p->year  = NSIG_I2(rec2->ingest_head.start_time.year);
+  p->day   = NSIG_I2(rec2->ingest_head.start_time.day);
+  sec      = NSIG_I4(rec2->ingest_head.start_time.sec);
+  tmp = sec/3600.0;
+  p->hour = (int)tmp;
+  tmp = (tmp - p->hour) * 60.0;
+  p->minute = (int)tmp;
+  p->sec = (tmp - p->minute) * 60.0;
+
+  lat = nsig_from_fourb_ang(rec2->ingest_head.lat_rad);
+  lon = nsig_from_fourb_ang(rec2->ingest_head.lon_rad);
+  if(lat > 180.0) lat -= 360.0;
+  if(lon > 180.0) lon -= 360.0;
+  p->lat = lat;
+  p->lon = lon;
+
+  /* Bit i of mask word j is set when data type 32*j + i was recorded. */
+  for (j=0; j<nmasks; j++)
+    for (i=0; i<32; i++)
+      if ((masks[j] >> i) & 0x1) {
+        ifield = nsig_field(32*j + i);
+        if (ifield >= 0) p->field[ifield] = 1;
+      }
+
+  nrays = NSIG_I2(rec2->ingest_head.num_rays);
+  nsweeps = NSIG_I2(rec2->task_config.scan_info.num_swp);
+  if (nsweeps > 40) nsweeps = 40; /* Size of scan_info.list */
+  for (i=0; i<nsweeps; i++) {
+    if ((s = rsl_probe_sweep(p, i)) == NULL) return -1;
+    s->fix_angle = nsig_from_bang(rec2->task_config.scan_info.list[i]);
+    s->nrays = nrays;
+    memmove(s->field, p->field, sizeof(s->field));
+  }
+  return 0;
+}
@@ -0,0 +1,280 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Header-only probes.
+ *
+ * RSL_probe summarizes a radar file (site, start time, VCP, fields,
+ * sweep angles and ray counts) from its metadata, without converting
+ * any data.  Each format with a header reader does the work:
+ *
+ *   WSR-88D  Message 5 and the Message 31 radial headers; for Message 1
+ *            files, the radial headers of each sweep.
+ *   UF       The mandatory and data headers of each record.
+ *   NSIG     The product and ingest headers, the first two records.
+ *   DORADE   The volume, sensor and sweep descriptors.
+ *
+ * Other formats are decoded in full and the radar summarized; 'decoded'
+ * is set in the result.
+ *
+ *   Rsl_probe *RSL_probe(char *infile, ...);
+ *   Rsl_probe *RSL_probe_mem(char *buf, size_t len, ...);
+ *   void RSL_free_probe(Rsl_probe *p);
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "rsl.h"
+#include "wsr88d.h"
+
+/* In uf_to_radar.c */
+int uf_probe_fp(FILE *fp, Rsl_probe *p);
+
+/* In wsr88d_to_radar.c */
+int wsr88d_probe(Wsr88d_file *wf, char *call_or_first_tape_file, Rsl_probe *p);
+
+/* In nsig_to_radar.c and nsig2_to_radar.c */
+int nsig_probe(Rsl_source *src, Rsl_probe *p);
+int nsig2_probe(Rsl_source *src, Rsl_probe *p);
+
+/* In dorade_to_radar.c */
+int dorade_probe(Rsl_source *src, Rsl_probe *p);
+
+/**********************************************************************/
+/*                                                                    */
+/*               rsl_new_probe, rsl_probe_sweep                       */
+/*                                                                    */
+/**********************************************************************/
+Rsl_probe *rsl_new_probe(enum File_type type)
+{
+  Rsl_probe *p;
+
+  p = (Rsl_probe *)calloc(1, sizeof(Rsl_probe));
+  if (p == NULL) {
+	perror("rsl_new_probe");
+	return NULL;
+  }
+  p->type = type;
+  return p;
+}
+
+Rsl_probe_sweep *rsl_probe_sweep(Rsl_probe *p, int isweep)
+{
+  /* Sweep 'isweep' of p, added if need be.  NULL on error. */
+  Rsl_probe_sweep *s;
+
+  if (isweep < 0) return NULL;
+  if (isweep >= p->nsweeps) {
+	s = (Rsl_probe_sweep *)realloc(p->sweep,
+								   (isweep+1) * sizeof(Rsl_probe_sweep));
+	if (s == NULL) {
+	  perror("rsl_probe_sweep");
+	  return NULL;
+	}
+	memset(s + p->nsweeps, 0, (isweep+1 - p->nsweeps) * sizeof(Rsl_probe_sweep));
+	p->sweep = s;
+	p->nsweeps = isweep+1;
+  }
+  return &p->sweep[isweep];
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                          RSL_free_probe                            */
+/*                                                                    */
+/**********************************************************************/
+void RSL_free_probe(Rsl_probe *p)
+{
+  if (p == NULL) return;
+  free(p->sweep);
+  free(p);
+}
+
+static void prune_probe(Rsl_probe *p)
+{
+  /* Drop the sweeps that have no rays. */
+  int i, n;
+
+  for (i=n=0; i<p->nsweeps; i++)
+	if (p->sweep[i].nrays > 0) p->sweep[n++] = p->sweep[i];
+  p->nsweeps = n;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                          probe_radar                               */
+/*                                                                    */
+/*  Summarize a decoded radar, for the formats without a header       */
+/*  reader.                                                           */
+/*                                                                    */
+/**********************************************************************/
+static int probe_radar(Radar *radar, Rsl_probe *p)
+{
+  Rsl_probe_sweep *s;
+  Sweep *sweep;
+  int i, j;
+
+  p->decoded = 1;
+  memmove(p->name, radar->h.name, sizeof(p->name));
+  p->name[sizeof(p->name)-1] = '\0';
+  memmove(p->radar_type, radar->h.radar_type, sizeof(p->radar_type));
+  p->radar_type[sizeof(p->radar_type)-1] = '\0';
+  p->month  = radar->h.month;
+  p->day    = radar->h.day;
+  p->year   = radar->h.year;
+  p->hour   = radar->h.hour;
+  p->minute = radar->h.minute;
+  p->sec    = radar->h.sec;
+  p->lat = radar->h.latd + radar->h.latm/60.0 + radar->h.lats/3600.0;
+  p->lon = radar->h.lond + radar->h.lonm/60.0 + radar->h.lons/3600.0;
+  p->vcp = radar->h.vcp;
+
+  for (i=0; i<radar->h.nvolumes; i++) {
+	if (radar->v[i] == NULL) continue;
+	for (j=0; j<radar->v[i]->h.nsweeps; j++) {
+	  if ((sweep = radar->v[i]->sweep[j]) == NULL) continue;
+	  if ((s = rsl_probe_sweep(p, j)) == NULL) return -1;
+	  s->fix_angle = radar->h.scan_mode == RHI ? sweep->h.azimuth
+		                                       : sweep->h.elev;
+	  if (sweep->h.nrays > s->nrays) s->nrays = sweep->h.nrays;
+	  s->field[i] = 1;
+	  p->field[i] = 1;
+	}
+  }
+  return 0;
+}
+
+static Rsl_probe *probe(enum File_type type, char *infile,
+						char *buf, size_t len, char *call)
+{
+  /* Probe 'infile', or when it is NULL the 'len' bytes at 'buf'. */
+  Rsl_probe *p;
+  Rsl_reader *r, *prev;
+  Rsl_source *src;
+  Wsr88d_file *wf;
+  Radar *radar;
+  FILE *fp;
+  int rc;
+
+  if (type == UNKNOWN) {
+	fprintf(stderr, "RSL_probe: Unknown input file type.\n");
+	return NULL;
+  }
+  if ((p = rsl_new_probe(type)) == NULL) return NULL;
+
+  rc = -1;
+  switch (type) {
+  case WSR88D_FILE:
+	wf = infile ? wsr88d_open(infile) : wsr88d_open_mem(buf, len);
+	if (wf) rc = wsr88d_probe(wf, call, p); /* Closes wf. */
+	break;
+
+  case UF_FILE:
+	if (infile) {
+	  if ((fp = fopen(infile, "r")) == NULL) perror(infile);
+	} else
+	  fp = rsl_mem_fopen(buf, len);
+	if (fp == NULL) break;
+	fp = uncompress_pipe(fp); /* Transparently gunzip. */
+	rc = uf_probe_fp(fp, p);
+	rsl_pclose(fp);
+	break;
+
+  case NSIG_FILE_V1:
+  case NSIG_FILE_V2:
+  case DORADE_FILE:
+	src = infile ? rsl_source_open(infile) : rsl_source_open_mem(buf, len);
+	if (src == NULL) break;
+	if (type == NSIG_FILE_V1)      rc = nsig_probe(src, p);
+	else if (type == NSIG_FILE_V2) rc = nsig2_probe(src, p);
+	else                           rc = dorade_probe(src, p);
+	rsl_source_close(src);
+	break;
+
+  default:
+	/* No header reader: decode all of it, with a fresh reader so the
+	 * caller's field and sweep selection do not apply.
+	 */
+	if ((r = RSL_new_reader()) == NULL) break;
+	prev = rsl_reader_bind(r);
+	radar = infile ? RSL_anyformat_to_radar(infile, call)
+	               : RSL_anyformat_to_radar_mem(buf, len, call);
+	rsl_reader_bind(prev);
+	RSL_free_reader(r);
+	if (radar == NULL) break;
+	rc = probe_radar(radar, p);
+	RSL_free_radar(radar);
+	break;
+  }
+
+  if (rc < 0) {
+	RSL_free_probe(p);
+	return NULL;
+  }
+  prune_probe(p);
+  return p;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_probe, RSL_probe_mem                       */
+/*                                                                    */
+/**********************************************************************/
+Rsl_probe *RSL_probe(char *infile, ...)
+{
+  /* As RSL_anyformat_to_radar, the second argument is used only for
+   * WSR-88D input: the call id of the site, the name of the tape header
+   * file, or NULL for the ICAO in the volume header.
+   * Returns NULL if the file cannot be read.
+   */
+  va_list ap;
+  char *callid_or_file;
+  enum File_type type;
+
+  callid_or_file = NULL;
+  type = RSL_filetype(infile);
+  if (type == WSR88D_FILE) {
+	va_start(ap, infile);
+	callid_or_file = va_arg(ap, char *);
+	va_end(ap);
+  }
+  return probe(type, infile, NULL, 0, callid_or_file);
+}
+
+Rsl_probe *RSL_probe_mem(char *buf, size_t len, ...)
+{
+  /* As RSL_probe, for the 'len' bytes at 'buf'. */
+  va_list ap;
+  char *callid_or_file;
+  enum File_type type;
+
+  callid_or_file = NULL;
+  type = RSL_filetype_mem(buf, len);
+  if (type == WSR88D_FILE) {
+	va_start(ap, len);
+	callid_or_file = va_arg(ap, char *);
+	va_end(ap);
+  }
+  return probe(type, NULL, buf, len, callid_or_file);
+}
@@ -34,7 +34,6 @@
  */
 
 #include "rsl.h"
-extern int radar_verbose_flag;
 
 Ray *RSL_prune_ray(Ray *ray)
 {
@@ -67,7 +66,8 @@ Sweep *RSL_prune_sweep(Sweep *s)
   }
   for (i=j; i<s->h.nrays; i++) s->ray[i] = NULL;
   s->h.nrays = j;
-  return s;
+  RSL_sweep_changed(s);
+  return RSL_shrink_sweep(s);
 }
 
 Volume *RSL_prune_volume(Volume *v)
@@ -92,7 +92,7 @@ Volume *RSL_prune_volume(Volume *v)
   }
   for (i=j; i<v->h.nsweeps; i++) v->sweep[i] = NULL;
   v->h.nsweeps = j;
-  return v;
+  return RSL_shrink_volume(v);
 }
 
 Radar *RSL_prune_radar(Radar *radar)
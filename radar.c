@@ -63,16 +63,14 @@ void RSL_print_version()
   printf("RSL version %s.\n", RSL_VERSION_STR);
 }
 
-/* Debug printing global variable: radar_verbose_flag */
-int radar_verbose_flag = 0;
-
+/* Debug printing.  Sets the verbosity of the current reader; see reader.c. */
 void RSL_radar_verbose_on()
 {
-  radar_verbose_flag = 1;
+  RSL_reader_verbose(rsl_reader(), 1);
 }
 void RSL_radar_verbose_off()
 {
-  radar_verbose_flag = 0;
+  RSL_reader_verbose(rsl_reader(), 0);
 }
 
 void print_vect(float v[], int istart, int istop)
@@ -96,7 +96,6 @@ int RSL_radar_to_hdf(Radar *radar, char *hdfFileName);
 
 extern L1B_1C_GV *gvl1Build(Radar *radar, float *qcParm, VosSize *vs,
 														int productID);
-extern int radar_verbose_flag;
 
 /* The 1st non-NULL ray in each volume is widely used. Hence global. */
 Ray *first_ray_in_volume[MAX_RADAR_VOLUMES];
@@ -152,7 +151,7 @@ void RSL_set_tkMetaDataString(char *string, int param)
   } else if (param == TK_SOFTWARE_VERSION) {
 	CP_TKMETA(SoftwareVersion, string);
 
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "TK_SOFTWARE_VERSION = <%s>\n", string);
 
   } else if (param == TK_PRODUCT_VERSION) {
@@ -515,7 +514,7 @@ int tkVosDimensions(VosSize *vs, Radar *radar)
 				tk_sindex++;
 				if (tk_sindex >= MAX_SWEEP)
 				{
-					if (radar_verbose_flag)
+					if (rsl_verbose())
 					  fprintf(stderr, "tkVosDimensions(): Too many toolkit sweeps.\n");
 					return(QUIT);
 				}
@@ -595,7 +594,7 @@ int rslVosDimensions(VosSize *vs, Radar *radar, float maxRange)
   vs->rsl.sweep[0] = NULL;
 
 /*
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     fprintf(stderr, "RSL VOS Dimensions...\n");
 */
   Vindex = -1;
@@ -686,7 +685,7 @@ int rslVosDimensions(VosSize *vs, Radar *radar, float maxRange)
 	  }
 	}
 /*
-  if (radar_verbose_flag)
+  if (rsl_verbose())
   {
   fprintf(stderr, 
   "  vIndex:%2d nsweeps:%d cellSize(m):%4d ncells:%d maxRng(km):%.1f\n",
@@ -749,14 +748,14 @@ int L1GVtemplateInit(VosSize *vs, Radar *radar, char *hdfFileName,
 	TKnsweep[0] = vs->tk.nsweep;
 	TKnray[0] = vs->rsl.maxNray;
 /*
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 		fprintf(stderr, "Toolkit VOS Dimensions...\n");
 */
 	for (pindex=0; pindex<vs->tk.nparm; pindex++)
 	{
 	  TKncell[0][pindex] = vs->rsl.ncell[pindex][0];
 /*
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "  pIndex:%d nsweep:%d nray:%d ncell:%d\n", pindex, 
 							(int)TKnsweep[0], (int)TKnray[0], (int)TKncell[0][pindex]);
 */
@@ -811,7 +810,7 @@ static int hdfFileOpen(IO_HANDLE *granuleHandle, VosSize *vs,
 
 	/* Create a L1BGV template node for the new VOS.  */
 /*
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n****** Creating toolkit template_node for VOS ...\n");
 */
 	status = L1GVtemplateInit(vs, radar, hdfFileName, maxRange);
@@ -822,14 +821,14 @@ static int hdfFileOpen(IO_HANDLE *granuleHandle, VosSize *vs,
 	{
 		/* The HDF file already exists. We will append this VOS to it. */
 	  fileAccessMode = TK_APPEND;
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		fprintf(stderr, "\n****** Opening HDF file: %s to append VOS ...\n",
 					 hdfFileName);
 	}
 	else  /* The HDF file does not exist. We must create it. */
 	{
 		fileAccessMode = TK_NEW_FILE;
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		fprintf(stderr, "\n****** Opening new HDF file: %s to write VOS ...\n",
 					 hdfFileName);
 	}
@@ -838,7 +837,7 @@ static int hdfFileOpen(IO_HANDLE *granuleHandle, VosSize *vs,
 	status = TKopen(hdfFileName, productID, fileAccessMode, granuleHandle); 
 	if (status != TK_SUCCESS)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "level_1(): ***** TKopen() error\n");
 		return(ABORT);
 	}
@@ -957,7 +956,7 @@ int nullGranuleCreate(char *hdfFileName, IO_HANDLE *granuleHandle,
 	/* Check if this HDF file already exists. If it exists, abort. */
 	if (stat(hdfFileName, &buf) == 0)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		fprintf(stderr, "\nnullGranuleCreate(): File %s already exists.\n",
 					 hdfFileName);
 		return(ABORT);
@@ -974,25 +973,25 @@ int nullGranuleCreate(char *hdfFileName, IO_HANDLE *granuleHandle,
 	}
 	
 	/* Open the HDF file. */
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n\n****** Opening new HDF file: %s for empty granule...\n",
 					hdfFileName);
 	status = TKopen(hdfFileName, TK_L1C_GV, TK_NEW_FILE, granuleHandle); 
 	if (status != TK_SUCCESS)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "nullGranuleCreate(): ***** TKopen() error\n");
 		return(ABORT);
 	}
 	/* Write metadata fields into HDF file. */
 	metaDataWrite(granuleHandle, radar, hdfFileName, TK_NEW_FILE);
 	/* Close the HDF file */
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n****** Closing HDF file: %s ...\n\n", hdfFileName);
 	status = TKclose(granuleHandle);
 	if (status != TK_SUCCESS)
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "nullGranuleCreate(): ***** TKclose() error\n");
 		return(ABORT);
 	}
@@ -1050,7 +1049,7 @@ int RSL_radar_to_hdf(Radar *radar, char *hdfFileName)
 	else  /* Unknown product. */
 	{
 		status = ABORT;
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "RSL_radar_to_hdf(): Unknown product requested: %s.\n",
 							product);
 	}
@@ -1061,32 +1060,32 @@ int RSL_radar_to_hdf(Radar *radar, char *hdfFileName)
 	if (status < 0) goto quit;
 	
 	/* Build toolkit 'L1B_1C_GV' structure using data from radar structure.*/
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n******  Moving VOS from RSL structure --> toolkit structure ...\n");
 	gvl1 = gvl1Build(radar, qcParm, &vs, (int)granuleHandle.productID);
 
 	/* Write data from toolkit 'L1B_1C_GV' structure to HDF file. */
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n****** Writing VOS to HDF file: %s ...\n", hdfFileName);
 	status = TKwriteL1GV(&granuleHandle, gvl1);
 	if (status != TK_SUCCESS)
 	{
 		TKclose(&granuleHandle);
 		status = ABORT;
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "RSL_radar_to_hdf(): *** TKwriteL1GV() error\n");
 		goto free_memory_and_quit;
 	}
 	
 	/* Close the HDF file */
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr, "\n****** Closing HDF file: %s ...\n\n", hdfFileName);
 	status = TKclose(&granuleHandle);
 	if (status == TK_SUCCESS)
 	  status = OK;
 	else
 	{
-		if (radar_verbose_flag)
+		if (rsl_verbose())
 		  fprintf(stderr, "RSL_radar_to_hdf(): *** TKclose() error\n");
 	  status = ABORT;
 	}
@@ -97,7 +97,6 @@ L1B_1C_GV *gvl1Build(Radar *radar, float *qcParm, VosSize *vs,
 										 int productID);
 
 extern int nextVolume(Radar *radar, int last_volume);
-extern int radar_verbose_flag;
 extern Ray *first_ray_in_volume[MAX_RADAR_VOLUMES];
 
 /*************************************************************/
@@ -614,7 +613,7 @@ void sensorFill(SENSORS *sensor, Radar *radar, VosSize *vs, int productID)
 		}  /* end for (pindex=0... */
 	}  /* end else 1C-51 */
 
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	{
 		for (pindex=0; pindex<vs->tk.nparm; pindex++)
 		{
@@ -633,7 +632,7 @@ void sensorFill(SENSORS *sensor, Radar *radar, VosSize *vs, int productID)
 									(int)sensor->sweepInfo[tk_sindex].numRays,
 									vs->tk.ncell[tk_sindex][pindex]);
 		} /* end for (pindex=0;... */
-	} /* end if (radar_verbose_flag) */
+	} /* end if (rsl_verbose()) */
 }
 
 /*************************************************************/
@@ -28,7 +28,6 @@
 
 #define USE_RSL_VARS
 #include "rsl.h"
-extern int radar_verbose_flag;
 /* Missing data flag : -32768 when a signed short. */
 #define UF_NO_DATA 0X8000
 
@@ -67,6 +66,13 @@ void swap_uf_buffer(UF_buffer uf);
 void swap2(short *buf, int n);
 Radar *wsr88d_align_split_cut_rays(Radar *radar);
 
+/* A gate value x as stored in UF field data. */
+static signed short uf_gate(float x, float scale_factor)
+{
+  if (x == BADVAL || x == RFVAL || x == APFLAG || x == NOECHO)
+    return (signed short)UF_NO_DATA;
+  return roundf(scale_factor * x);
+}
 
 /**********************************************************************/
 /*                                                                    */
@@ -134,7 +140,7 @@ void RSL_radar_to_uf_fp(Radar *r, FILE *fp)
   int nvolumes, maxsweeps, nrays;
   int true_nvolumes;
   int sweep_num, ray_num, rec_num;
-  float x;
+  float *f;
 
   Radar *r_save = NULL;
 
@@ -198,7 +204,7 @@ void RSL_radar_to_uf_fp(Radar *r, FILE *fp)
     }
   }
 
-  if (radar_verbose_flag) {
+  if (rsl_verbose()) {
     fprintf(stderr,"True number of volumes for UF is %d\n", true_nvolumes);
     fprintf(stderr,"Maximum #   of volumes for UF is %d\n", nvolumes);
   }
@@ -226,9 +232,9 @@ void RSL_radar_to_uf_fp(Radar *r, FILE *fp)
 
     sweep_num++;  /* I guess it will be ok to count NULL sweeps. */
     ray_num = 0;
-  if (radar_verbose_flag) 
+  if (rsl_verbose()) 
     fprintf(stderr,"Processing sweep %d for %d rays.", i, nrays);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     if (little_endian()) fprintf(stderr," ... On Little endian.\n");
     else fprintf(stderr,"\n");
 
@@ -467,13 +473,13 @@ void RSL_radar_to_uf_fp(Radar *r, FILE *fp)
               /* ---- Begining of FIELD DATA. */
               uf_data = uf+len_fh+current_fh_index;
               len_data = ray->h.nbins;
-              for (m=0; m<len_data; m++) {
-                x = ray->h.f(ray->range[m]);
-                if (x == BADVAL || x == RFVAL || x == APFLAG || x == NOECHO)
-                  uf_data[m] = (signed short)UF_NO_DATA;
-                else
-                  uf_data[m] = roundf(scale_factor * x);
-              }
+              f = RSL_f_table(ray->h.f);
+              if (f)
+                for (m=0; m<len_data; m++)
+                  uf_data[m] = uf_gate(f[ray->range[m]], scale_factor);
+              else
+                for (m=0; m<len_data; m++)
+                  uf_data[m] = uf_gate(ray->h.f(ray->range[m]), scale_factor);
               
               current_fh_index += (len_fh+len_data);
             }
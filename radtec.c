@@ -33,14 +33,11 @@
 #ifdef HAVE_LIBIMPLODE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "rsl.h"
 #include "radtec.h"
 #include <implode.h>
 
-static int nray_headers_expected = 0;
-static int nrays_expected        = 0;
-Radtec_ray_header *ray_header_array;
-Radtec_ray *ray_array;
-
 void radtec_print_header(Radtec_header *h)
 {
   printf("version = %d\n", h->version);
@@ -85,6 +82,13 @@ struct PassedParam
    FILE *InFile;
    FILE *OutFile;
    unsigned long CRC;
+   /* Unpacking state, per file, for radtec_load_rsl_ray_data. */
+   Radtec_ray_header *ray_header_array;
+   Radtec_ray *ray_array;
+   int nray_headers_expected, nrays_expected;
+   int nray_headers_seen, nrays_seen;
+   int i, bytes_remaining;
+   int total_bytes_read, total_bytes_written;
 };
 
 /*-------------------------------------------------------------------
@@ -98,15 +102,13 @@ struct PassedParam
 #define implode _implode
 #define crc32 _crc32
 
-int total_bytes_read = 0;
-int total_bytes_written = 0;
 unsigned int ReadFile(char *Buff, unsigned int *Size, void *Param)
 {
    size_t Read;
    struct PassedParam *Par = (struct PassedParam *)Param;
 
    Read = fread(Buff, 1, *Size, Par->InFile);
-   total_bytes_read += *Size;
+   Par->total_bytes_read += *Size;
    if (Par->CmpPhase)
       Par->CRC = crc32(Buff, (unsigned int *)&Read, &Par->CRC);
 
@@ -123,11 +125,13 @@ void radtec_load_rsl_ray_data(char *Buff, unsigned int *Size, void *Param)
 {
    struct PassedParam *Par = (struct PassedParam *)Param;
    Radtec_ray_header ray_header;
-   static int i = 0;
-   static int nray_headers_seen = 0;
-   static int nrays_seen = 0;
+   Radtec_ray_header *ray_header_array = Par->ray_header_array;
+   Radtec_ray *ray_array = Par->ray_array;
    int ray_size;
-   static int bytes_remaining = 0;
+   int i = Par->i;
+   int bytes_remaining = Par->bytes_remaining;
+   int nray_headers_seen = Par->nray_headers_seen;
+   int nrays_seen = Par->nrays_seen;
 
 
    /*   fwrite(Buff, 1, *Size, Par->OutFile); */
@@ -138,9 +142,9 @@ void radtec_load_rsl_ray_data(char *Buff, unsigned int *Size, void *Param)
 
    if (!Par->CmpPhase)
       Par->CRC = crc32(Buff, Size, &Par->CRC);
-   total_bytes_written += *Size;
+   Par->total_bytes_written += *Size;
 
-   while(i<*Size && nray_headers_seen < nray_headers_expected) {
+   while(i<*Size && nray_headers_seen < Par->nray_headers_expected) {
 	 /* Because of word alignment problems, use this painful memcpy approach. */
 	 memcpy(&ray_header.ray_num,    &Buff[i], sizeof(short)); i+=sizeof(short);
 	 memcpy(&ray_header.azim_angle, &Buff[i], sizeof(float)); i+=sizeof(float);
@@ -167,7 +171,7 @@ void radtec_load_rsl_ray_data(char *Buff, unsigned int *Size, void *Param)
 #ifdef RSL_DEBUG
 	 fprintf(stderr, "Need another Buff for ray headers.\n");
 #endif
-	 return;
+	 goto out;
    }
 
    /* Getting to this point means that i < *Size and we have seen
@@ -176,7 +180,7 @@ void radtec_load_rsl_ray_data(char *Buff, unsigned int *Size, void *Param)
     */
 
    ray_size = sizeof(Radtec_ray);
-   while(i<*Size && nrays_seen < nrays_expected) {
+   while(i<*Size && nrays_seen < Par->nrays_expected) {
 #ifdef RSL_DEBUG
 	 	 fprintf(stderr, "WHILE i=%d, i+ray_size=%d\n", i, i+ray_size);
 #endif
@@ -220,10 +224,13 @@ void radtec_load_rsl_ray_data(char *Buff, unsigned int *Size, void *Param)
 #ifdef RSL_DEBUG
 	 fprintf(stderr, "Need another Buff for ray data. i=%d *Size=%d\n", i, *Size);
 #endif
-	 return;
    }
 
-
+ out:
+   Par->i = i;
+   Par->bytes_remaining = bytes_remaining;
+   Par->nray_headers_seen = nray_headers_seen;
+   Par->nrays_seen = nrays_seen;
 }
 
 Radtec_file *radtec_read_file(char *infile)
@@ -249,17 +256,18 @@ Radtec_file *radtec_read_file(char *infile)
   if (rfile == NULL) { perror("calloc Radtec_file"); return NULL; }
   fread(&rfile->h, sizeof(Radtec_header), 1, fp);
 
-  /* Initialize the global for the unpacking routine. The unpacking
+  /* Initialize the state of the unpacking routine. The unpacking
    * routine is a callback for 'explode'; the second argument.
    */
-  nray_headers_expected = rfile->h.num_rays;
-  nrays_expected        = rfile->h.num_rays;
+  memset(&Param, 0, sizeof(Param));
+  Param.nray_headers_expected = rfile->h.num_rays;
+  Param.nrays_expected        = rfile->h.num_rays;
 
   /* Allocate space for all the headers and rays expected. */
-  ray_header_array = (Radtec_ray_header *)calloc(rfile->h.num_rays, sizeof(Radtec_ray_header));
-  if (ray_header_array == NULL) { perror("calloc Radtec_ray_header"); return NULL; }
-  ray_array = (Radtec_ray *)calloc(rfile->h.num_rays, sizeof(Radtec_ray));
-  if (ray_array == NULL) { perror("calloc Radtec_ray"); return NULL; }
+  Param.ray_header_array = (Radtec_ray_header *)calloc(rfile->h.num_rays, sizeof(Radtec_ray_header));
+  if (Param.ray_header_array == NULL) { perror("calloc Radtec_ray_header"); return NULL; }
+  Param.ray_array = (Radtec_ray *)calloc(rfile->h.num_rays, sizeof(Radtec_ray));
+  if (Param.ray_array == NULL) { perror("calloc Radtec_ray"); return NULL; }
 
   /* -------------- PKWARE ----------- */
   WorkBuff = (char *)malloc(EXP_BUFFER_SIZE);
@@ -283,11 +291,11 @@ Radtec_file *radtec_read_file(char *infile)
   fclose(Param.OutFile);
   if (Error != 0) {
 	fprintf(stderr, "RADTEC: uncompression completed - Error %d\n", Error);
-	fprintf(stderr, "RADTEC: Total bytes read    = %d\n", total_bytes_read);
-	fprintf(stderr, "RADTEC: Total bytes written = %d\n", total_bytes_written);
+	fprintf(stderr, "RADTEC: Total bytes read    = %d\n", Param.total_bytes_read);
+	fprintf(stderr, "RADTEC: Total bytes written = %d\n", Param.total_bytes_written);
   }
   /* -------------- PKWARE ----------- */
-  rfile->ray   = ray_array;
+  rfile->ray   = Param.ray_array;
 
   return rfile;
 }
@@ -27,7 +27,6 @@
 #ifdef HAVE_LIBIMPLODE
 #include "radtec.h"
 
-extern int radar_verbose_flag;
 
 static void fill_ray_header(Ray_header *h, Radtec_header *rh, Radtec_ray_header *rrh)
 {
@@ -102,7 +101,7 @@ Radar *RSL_radtec_to_radar(char *infile)
 
   rfile = radtec_read_file(infile);
 
-  if (radar_verbose_flag) {
+  if (rsl_verbose()) {
 	radtec_print_header(&rfile->h);
   }
 
@@ -125,7 +124,7 @@ Radar *RSL_radtec_to_radar(char *infile)
   }
   nbins = rfile->h.num_range_bins;
 
-  if (radar_verbose_flag) {
+  if (rsl_verbose()) {
 	fprintf(stderr,"Expecting %d sweeps.\n", nsweeps);
 	fprintf(stderr,"Expecting %d rays.\n", nrays);
 	fprintf(stderr,"Expecting %d bins.\n", nbins);
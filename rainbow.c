@@ -56,7 +56,7 @@ static char *get_param_string(char *buf)
 {
     /* Returns a string parameter from a header line. */
 
-    static char string[20];
+    static RSL_THREAD_LOCAL char string[20];
     char *substr;
 
     substr = index(buf, ':');
@@ -198,7 +198,7 @@ void W_label(Rainbow_hdr *rainbow_hdr, char* buf)
 /*                                                        */
 /**********************************************************/
 
-static int read_hdr_line(char *buf, int maxchars, FILE *fp)
+static int read_hdr_line(char *buf, int maxchars, Rsl_source *src)
 {
     /* Read a line from the Rainbow file header into character buffer.
      * Function returns the first character in buffer (the "label") if
@@ -216,10 +216,10 @@ static int read_hdr_line(char *buf, int maxchars, FILE *fp)
     int badline = 0, i;
 
     i = 0;
-    while ((c = getc(fp)) != CR && c != ETX) {
+    while ((c = rsl_source_getc(src)) != CR && c != ETX) {
 	if (c == ETB) {               
-	    c = getc(fp);                /* Read past both <ETB> and the */
-	    if (c == CR) c = getc(fp);   /* combination <ETB><CR>.       */
+	    c = rsl_source_getc(src);    /* Read past both <ETB> and the */
+	    if (c == CR) c = rsl_source_getc(src); /* combination <ETB><CR>. */
 	}
 
 	buf[i++] = c;
@@ -251,7 +251,7 @@ static int read_hdr_line(char *buf, int maxchars, FILE *fp)
 
 #define BUFSIZE 128
 
-void read_rainbow_header(Rainbow_hdr *rainbow_header, FILE *fp)
+void read_rainbow_header(Rainbow_hdr *rainbow_header, Rsl_source *src)
 {
     /* Reads parameters from Rainbow file header into a rainbow header
        structure. */
@@ -264,7 +264,7 @@ void read_rainbow_header(Rainbow_hdr *rainbow_header, FILE *fp)
      * of the line which indicates a category of parameters.
      */
 
-    while ((label = read_hdr_line(buf, BUFSIZE, fp)) != ETX && label > 0) {
+    while ((label = read_hdr_line(buf, BUFSIZE, src)) != ETX && label > 0) {
 	switch (label) {
 	    case 'H': H_label(rainbow_header, buf);
 		      break;
@@ -58,4 +58,4 @@ typedef struct {
 /* Function prototypes */
 
 Radar *RSL_rainbow_to_radar(char *infile);
-int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp);
+int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, Rsl_source *src);
@@ -26,10 +26,9 @@
 #include <string.h>
 #include "rsl.h"
 #include "rainbow.h"
-#include <unistd.h>
 
 /* Exists in rainbow.c but not in .h */
-void read_rainbow_header(Rainbow_hdr *rainbow_header, FILE *fp);
+void read_rainbow_header(Rainbow_hdr *rainbow_header, Rsl_source *src);
 
 struct dms {
     int deg;
@@ -56,54 +55,37 @@ struct dms deg_to_dms(float deg)
     return dms;
 }
 
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
 /**********************************************************/
 /*                                                        */
-/*                  RSL_rainbow_to_radar                  */
+/*                    rainbow_to_radar                    */
 /*                                                        */
 /**********************************************************/
 
-Radar *RSL_rainbow_to_radar(char *infile)
+static Radar *rainbow_to_radar(Rsl_source *src)
 {
     /* This function reads the Rainbow format scan data file and returns a
      * radar structure.
      */
 
     Radar *radar;
-    FILE *fp;
     int c;
     int nvolumes;
     Rainbow_hdr rainbow_hdr;
     struct dms latdms, londms;
 
-    /* These next lines allow program to read from a regular file, a
-     * compressed file, or standard input.  I lifted them from RSL_uf_to_radar
-     * by John Merritt.
-     */
-
-    if (infile == NULL) {
-  	int save_fd;
-  	save_fd = dup(0);
-  	fp = fdopen(save_fd, "r");
-    }
-    else if ((fp = fopen(infile, "r")) == NULL) {
-  	perror(infile);
-  	return NULL;
-    }
-    fp = uncompress_pipe(fp); /* Transparently gunzip. */
-
     /* Read first character and verify file format. */
 
-    if ((c = fgetc(fp)) != SOH) {
-	fprintf(stderr,"%s is not a valid Rainbow format file.\n",infile);
+    if ((c = rsl_source_getc(src)) != SOH) {
+	fprintf(stderr,"Input is not a valid Rainbow format file.\n");
   	return NULL;
     }
 
     /* Read Rainbow file header and check for correct product. */
 
-    read_rainbow_header(&rainbow_hdr, fp);
+    read_rainbow_header(&rainbow_hdr, src);
 
     if (rainbow_hdr.filetype != SCAN_DATA ) {
 	fprintf(stderr,"ERROR: File is not a scan data file.\n");
@@ -157,9 +139,43 @@ Radar *RSL_rainbow_to_radar(char *infile)
 
     /* Read the data portion of the file into the radar structure. */
 
-    if (rainbow_data_to_radar(radar, rainbow_hdr, fp) < 1)
+    if (rainbow_data_to_radar(radar, rainbow_hdr, src) < 1) {
+	RSL_free_radar(radar);
 	radar = NULL;
+    }
+
+    return RSL_shrink_radar(radar);
+}
+
+/**********************************************************/
+/*                                                        */
+/*                  RSL_rainbow_to_radar                  */
+/*                RSL_rainbow_to_radar_mem                */
+/*                                                        */
+/**********************************************************/
+
+Radar *RSL_rainbow_to_radar(char *infile)
+{
+    /* Reads from a regular file, a compressed file, or, when infile is
+     * NULL, standard input.
+     */
+    Rsl_source *src;
+    Radar *radar;
+
+    if ((src = rsl_source_open(infile)) == NULL) return NULL;
+    radar = rainbow_to_radar(src);
+    rsl_source_close(src);
+    return radar;
+}
+
+Radar *RSL_rainbow_to_radar_mem(char *buf, size_t len)
+{
+    Rsl_source *src;
+    Radar *radar;
 
+    if ((src = rsl_source_open_mem(buf, len)) == NULL) return NULL;
+    radar = rainbow_to_radar(src);
+    rsl_source_close(src);
     return radar;
 }
 
@@ -169,7 +185,7 @@ Radar *RSL_rainbow_to_radar(char *infile)
 /*                                                        */
 /**********************************************************/
 
-int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp)
+int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, Rsl_source *src)
 {
     /* Read Rainbow data into the radar structure.  Data in the file is stored
      * as bytes, where each byte contains the value for one range bin.  The
@@ -222,6 +238,7 @@ int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp)
 	fprintf(stderr,"Corresponding vol_INDEX number is %d\n", vol_index);
 	return 0;
     }
+    if (!rsl_reader()->qfield[vol_index]) return 1; /* Not selected. */
 
     nsweeps = rainbow_hdr.nsweeps;
     nrays = (rainbow_hdr.az_stop - rainbow_hdr.az_start + 1) /
@@ -244,7 +261,12 @@ int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp)
     
     /* Load sweeps. */
 
-    for (isweep = 0; isweep < nsweeps; isweep++) {
+    for (isweep = 0; isweep < nsweeps && !rsl_sweeps_done(isweep); isweep++) {
+	if (!rsl_want_sweep(isweep)) {
+	    /* Read past it. */
+	    if (!rsl_source_skip(src, (size_t)nrays * nbins)) break;
+	    continue;
+	}
 	sweep = RSL_new_sweep(nrays);
 	prf = rainbow_hdr.elev_params[isweep]->prf_high;
 	unam_rng = RSL_SPEED_OF_LIGHT / (2. * prf * 1000.);
@@ -254,12 +276,14 @@ int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp)
 	/* Load rays. */
 
 	for (iray = 0; iray < nrays; iray++) {
-	    nread = fread(rainbow_ray, 1, nbins, fp);
+	    nread = rsl_source_read(rainbow_ray, 1, nbins, src);
 	    if (nread != nbins) {
 		fprintf(stderr, "ERROR: Could not read enough bytes to fill "
 			"ray.\n");
 		fprintf(stderr, "Sweep = %d, ray = %d, number read = %d\n",
 			isweep, iray, nread);
+		RSL_free_sweep(sweep);
+		free(rainbow_ray);
 		return 0;
 	    }
 	    ray = RSL_new_ray(nbins);
@@ -309,5 +333,6 @@ int rainbow_data_to_radar(Radar *radar, Rainbow_hdr rainbow_hdr, FILE *fp)
 	sweep->h.invf = invf;
 	v->sweep[isweep] = sweep;
     } /* isweep */
+    free(rainbow_ray);
     return 1;
 }
@@ -0,0 +1,224 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Conversion tables.
+ *
+ * A data conversion function f(x) depends only on the Range value x (see
+ * volume.c), and there are only 1<<(8*sizeof(Range)) of those.  So f is
+ * evaluated once for every value, on first use, and the table is kept
+ * until RSL_f_table_forget.  Decoding a gate is then a load instead of
+ * an indirect call.  A table is only right while f gives the same value
+ * for the same x; whoever changes what f computes must forget its table.
+ *
+ * Tables are looked up by f.  Each thread remembers the last table it
+ * used, so a lookup per ray seldom takes the lock; forgetting a table
+ * bumps a generation number that voids those memories.
+ *
+ *   float *RSL_f_table(float (*f)(Range x));
+ *   void RSL_f_table_forget(float (*f)(Range x));
+ *   int RSL_ray_to_float(Ray *r, float *out);
+ *   int RSL_sweep_to_float(Sweep *s, float *out, int stride);
+ *   int RSL_float_to_ray(float *in, int n, Ray *r);
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "rsl.h"
+
+#define RSL_NRANGE (1<<(8*sizeof(Range))) /* Number of Range values. */
+
+typedef struct _rsl_f_table {
+  float (*f)(Range x);
+  float *table;                /* RSL_NRANGE values of f. */
+  struct _rsl_f_table *next;
+} Rsl_f_table;
+
+static Rsl_f_table *f_tables = NULL;
+static unsigned int f_tables_gen = 0;  /* Bumped when tables are freed. */
+static pthread_mutex_t f_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static RSL_THREAD_LOCAL Rsl_f_table *f_table_last = NULL;
+static RSL_THREAD_LOCAL unsigned int f_table_last_gen = 0;
+
+/**********************************************************************/
+/*                                                                    */
+/*                          RSL_f_table                               */
+/*                                                                    */
+/*  Return the table of f(x) for every Range x; NULL if f is NULL or  */
+/*  there is no memory, when callers convert with f itself.  The      */
+/*  table belongs to RSL; do not free it.  f must be pure: the same x */
+/*  always gives the same f(x).                                       */
+/*                                                                    */
+/**********************************************************************/
+float *RSL_f_table(float (*f)(Range x))
+{
+  Rsl_f_table *t;
+  int i;
+
+  if (f == NULL) return NULL;
+  if (f_table_last && f_table_last_gen == f_tables_gen &&
+	  f_table_last->f == f) return f_table_last->table;
+
+  pthread_mutex_lock(&f_tables_lock);
+  for (t = f_tables; t; t = t->next)
+	if (t->f == f) break;
+  if (t == NULL) {
+	t = (Rsl_f_table *)malloc(sizeof(Rsl_f_table));
+	if (t) t->table = (float *)malloc(RSL_NRANGE * sizeof(float));
+	if (t == NULL || t->table == NULL) {
+	  perror("RSL_f_table");
+	  free(t);
+	  pthread_mutex_unlock(&f_tables_lock);
+	  return NULL;
+	}
+	for (i=0; i<RSL_NRANGE; i++) t->table[i] = f((Range)i);
+	t->f = f;
+	t->next = f_tables;
+	f_tables = t;
+  }
+  f_table_last_gen = f_tables_gen;
+  pthread_mutex_unlock(&f_tables_lock);
+  f_table_last = t;
+  return t->table;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      RSL_f_table_forget                            */
+/*                                                                    */
+/*  Free the table of f, or every table when f is NULL.  Call this    */
+/*  after redefining what f computes; the next RSL_f_table(f) builds  */
+/*  a new table.  Tables returned earlier are gone, so no other       */
+/*  thread may be converting with f, and they must see this call      */
+/*  before their next conversion (e.g. through a lock of the caller). */
+/*                                                                    */
+/**********************************************************************/
+void RSL_f_table_forget(float (*f)(Range x))
+{
+  Rsl_f_table **p, *t;
+
+  pthread_mutex_lock(&f_tables_lock);
+  p = &f_tables;
+  while ((t = *p) != NULL) {
+	if (f == NULL || t->f == f) {
+	  *p = t->next;
+	  free(t->table);
+	  free(t);
+	  f_tables_gen++;
+	} else
+	  p = &t->next;
+  }
+  pthread_mutex_unlock(&f_tables_lock);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_ray_to_float                            */
+/*                                                                    */
+/*  Decode the r->h.nbins gates of r into out.  Returns the number of */
+/*  gates, or -1 when r has no conversion function.                   */
+/*                                                                    */
+/**********************************************************************/
+int RSL_ray_to_float(Ray *r, float *out)
+{
+  float *table;
+  Range *range;
+  int i, n;
+
+  if (r == NULL) return 0;
+  if (r->h.f == NULL) return -1;
+  table = RSL_f_table(r->h.f);
+  range = r->range;
+  n = r->h.nbins;
+  if (table)
+	for (i=0; i<n; i++) out[i] = table[range[i]];
+  else
+	for (i=0; i<n; i++) out[i] = r->h.f(range[i]);
+  return n;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                       RSL_sweep_to_float                           */
+/*                                                                    */
+/*  Decode s into out, ray i at out[i*stride].  Gates beyond a ray's  */
+/*  nbins, and rows of missing rays, are BADVAL; gates beyond stride  */
+/*  are dropped.  out holds s->h.nrays*stride values.  Returns the    */
+/*  number of rows, or -1 when a ray has no conversion function.      */
+/*                                                                    */
+/**********************************************************************/
+int RSL_sweep_to_float(Sweep *s, float *out, int stride)
+{
+  float *table;
+  float (*f)(Range x);
+  Range *range;
+  Ray *r;
+  int i, j, n;
+
+  if (s == NULL) return 0;
+  f = NULL;
+  table = NULL;
+  for (i=0; i<s->h.nrays; i++, out += stride) {
+	r = s->ray[i];
+	n = 0;
+	if (r) {
+	  if (r->h.f == NULL) return -1;
+	  if (r->h.f != f) {
+		f = r->h.f;
+		table = RSL_f_table(f);
+	  }
+	  n = r->h.nbins;
+	  if (n > stride) n = stride;
+	  range = r->range;
+	  if (table)
+		for (j=0; j<n; j++) out[j] = table[range[j]];
+	  else
+		for (j=0; j<n; j++) out[j] = f(range[j]);
+	}
+	for (j=n; j<stride; j++) out[j] = BADVAL;
+  }
+  return s->h.nrays;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_float_to_ray                            */
+/*                                                                    */
+/*  Encode n values of 'in' into the gates of r with r->h.invf, and   */
+/*  set r->h.nbins to n.  r must have room for n gates.  Returns n,   */
+/*  or -1 when r has no inverse conversion function.                  */
+/*                                                                    */
+/**********************************************************************/
+int RSL_float_to_ray(float *in, int n, Ray *r)
+{
+  Range (*invf)(float x);
+  Range *range;
+  int i;
+
+  if (r == NULL) return 0;
+  if ((invf = r->h.invf) == NULL) return -1;
+  range = r->range;
+  for (i=0; i<n; i++) range[i] = invf(in[i]);
+  r->h.nbins = n;
+  return n;
+}
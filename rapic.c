@@ -224,7 +224,6 @@ int station_id;
 
 int sweepcount[5];
 
-extern int radar_verbose_flag;
 float rapic_nyquist;
   
 
@@ -1629,7 +1628,7 @@ yyreduce:
         case 2:
 #line 335 "rapic.y"
     {
-  if (radar_verbose_flag) fprintf(stderr, "SUCCESSFUL parse\n");
+  if (rsl_verbose()) fprintf(stderr, "SUCCESSFUL parse\n");
   sprintf(radar->h.name, "%s", rh.namestr);
   sprintf(radar->h.radar_name, "%s", rh.namestr);
 
@@ -1644,7 +1643,7 @@ yyreduce:
 #line 350 "rapic.y"
     {
   /* Attach the sweep to the volume. */
-  if (radar_verbose_flag) fprintf(stderr, "Attach the sweep %d to the volume %d.\n",
+  if (rsl_verbose()) fprintf(stderr, "Attach the sweep %d to the volume %d.\n",
 		  isweep, ivolume);
   radar->v[ivolume]->sweep[isweep] = sweep;
   radar->v[ivolume]->h.f    = sweep->h.f;
@@ -1670,30 +1669,30 @@ yyreduce:
   case 8:
 #line 375 "rapic.y"
     {
-  if (radar_verbose_flag) fprintf(stderr, "sweepcount[0] = %d\n", sweepcount[0]);
+  if (rsl_verbose()) fprintf(stderr, "sweepcount[0] = %d\n", sweepcount[0]);
   if (sweepcount[0] > 0) {
 	radar->v[DZ_INDEX] = RSL_new_volume(sweepcount[0]);
 	radar->v[DZ_INDEX]->h.type_str = strdup("Reflectivity");
   }
-  if (radar_verbose_flag) fprintf(stderr, "sweepcount[1] = %d\n", sweepcount[1]);
+  if (rsl_verbose()) fprintf(stderr, "sweepcount[1] = %d\n", sweepcount[1]);
   if (sweepcount[1] > 0) {
 	volume = radar->v[VR_INDEX] = RSL_new_volume(sweepcount[1]);
 	volume->h.type_str = strdup("Velocity");
 	volume->h.calibr_const = 0.0;
   }
-  if (radar_verbose_flag) fprintf(stderr, "sweepcount[2] = %d\n", sweepcount[2]);
+  if (rsl_verbose()) fprintf(stderr, "sweepcount[2] = %d\n", sweepcount[2]);
   if (sweepcount[2] > 0) {
 	radar->v[SW_INDEX] = RSL_new_volume(sweepcount[2]);
 	volume->h.type_str = strdup("Spectral Width");
 	volume->h.calibr_const = 0.0;
   }
-  if (radar_verbose_flag) fprintf(stderr, "sweepcount[3] = %d\n", sweepcount[3]);
+  if (rsl_verbose()) fprintf(stderr, "sweepcount[3] = %d\n", sweepcount[3]);
   if (sweepcount[3] > 0) {
 	radar->v[ZD_INDEX] = RSL_new_volume(sweepcount[3]);
 	volume->h.type_str = strdup("Reflectivity Depolarization Ratio");
 	volume->h.calibr_const = 0.0;
   }
-  if (radar_verbose_flag) fprintf(stderr, "sweepcount[4] = %d\n", sweepcount[4]);
+  if (rsl_verbose()) fprintf(stderr, "sweepcount[4] = %d\n", sweepcount[4]);
   if (sweepcount[4] > 0) {
 	radar->v[ZT_INDEX] = RSL_new_volume(sweepcount[4]);
 	volume->h.type_str = strdup("Total Reflectivity");
@@ -26,21 +26,33 @@
 /*                     RSL_read_sweep                                 */
 /*                     RSL_read_volume                                */
 /*                     RSL_read_radar                                 */
+/*                     RSL_mmap_on, RSL_mmap_off                      */
 /*                                                                    */
 /*                     RSL_write_ray                                  */
 /*                     RSL_write_sweep                                */
 /*                     RSL_write_volume                               */
 /*                     RSL_write_radar                                */
 /*                                                                    */
+/*  The v2 format is in read_write_v2.c.                              */
+/*                                                                    */
 /*  By: John Merritt                                                  */
 /*      Space Applications Corporation                                */
 /*      April 7, 1994                                                 */
 /**********************************************************************/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "rsl.h"
 
-extern int radar_verbose_flag;
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define RSL_MMAP_RSL 1
+#endif
+
 /**********************************************************************/
 /**********************************************************************/
 /*                                                                    */
@@ -81,10 +93,10 @@ Sweep *RSL_read_sweep(FILE *fp)
   (void)fread(&nrays, sizeof(int), 1, fp);
   if (nrays == 0) return NULL;
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Reading %d rays. ", nrays);
   memcpy(&sweep_h, header_buf, sizeof(Sweep_header));
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"From header info nrays = %d\n", sweep_h.nrays);
   s = RSL_new_sweep(sweep_h.nrays);
   s->h = sweep_h;
@@ -107,21 +119,65 @@ Volume *RSL_read_volume(FILE *fp)
   (void)fread(&nsweeps, sizeof(int), 1, fp);
   if (nsweeps == 0)	return NULL;
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Reading %d sweeps. ", nsweeps);
   memcpy(&vol_h, header_buf, sizeof(Volume_header));
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"From header info nsweeps = %d\n", vol_h.nsweeps);
   v = RSL_new_volume(vol_h.nsweeps);
   v->h = vol_h;
   for (i=0; i<v->h.nsweeps; i++) {
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"RSL_read_sweep %d ", i);
 	v->sweep[i] = RSL_read_sweep(fp);
   }
   return v;
 }
 
+static int last_selected_field(int nvolumes)
+{
+  /* Index of the last field selected for ingest, or -1. */
+  Rsl_reader *reader = rsl_reader();
+  int i;
+
+  if (nvolumes > MAX_RADAR_VOLUMES) nvolumes = MAX_RADAR_VOLUMES;
+  for (i=nvolumes-1; i>=0; i--)
+	if (reader->qfield[i]) break;
+  return i;
+}
+
+static Volume *read_selected_volume(FILE *fp, int want, int last)
+{
+  /* RSL_read_volume, keeping only the sweeps selected with
+   * RSL_read_these_sweeps; none when !want.  For the 'last' volume
+   * to be read, stop after its last selected sweep.
+   */
+  char header_buf[512];
+  Volume_header vol_h;
+  int i;
+  Volume *v;
+  Sweep *s;
+  int nsweeps;
+
+  (void)fread(header_buf, sizeof(char), sizeof(header_buf), fp);
+  (void)fread(&nsweeps, sizeof(int), 1, fp);
+  if (nsweeps == 0)	return NULL;
+
+  memcpy(&vol_h, header_buf, sizeof(Volume_header));
+  v = NULL;
+  if (want) {
+	v = RSL_new_volume(vol_h.nsweeps);
+	v->h = vol_h;
+  }
+  for (i=0; i<vol_h.nsweeps; i++) {
+	if (last && rsl_sweeps_done(i)) break;
+	s = RSL_read_sweep(fp);
+	if (v && rsl_want_sweep(i)) v->sweep[i] = s;
+	else RSL_free_sweep(s);
+  }
+  return v;
+}
+
 Radar *set_default_function_pointers(Radar *radar)
 {
   int i,j,k;
@@ -171,26 +227,215 @@ Radar *set_default_function_pointers(Radar *radar)
   return radar;
 }
 
-Radar *RSL_read_radar(char *infile)
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_mmap_on, RSL_mmap_off                      */
+/*                                                                    */
+/*  With RSL_mmap_on, RSL_read_radar maps uncompressed RSL files into */
+/*  memory, and Ray->range points into the mapping instead of being   */
+/*  read into a calloc'ed array.  The mapping is private: changes to  */
+/*  the data are never written to the file.  Sets the current reader; */
+/*  see reader.c.                                                     */
+/*                                                                    */
+/**********************************************************************/
+void RSL_mmap_on()
 {
-  /* On disk each header buffer size is this big to reserve space for
+  rsl_reader()->mmap_rsl = 1;
+}
+void RSL_mmap_off()
+{
+  rsl_reader()->mmap_rsl = 0;
+}
+
+#ifdef RSL_MMAP_RSL
+/* The file image, and how far into it we have read. */
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t pos;
+  Rsl_block *block;
+} Rsl_map;
+
+static int map_read(Rsl_map *m, void *buf, size_t n)
+{
+  /* Like fread, but stops at end of image. */
+  if (n > m->len - m->pos) {
+	m->pos = m->len;
+	return 0;
+  }
+  memcpy(buf, m->buf + m->pos, n);
+  m->pos += n;
+  return 1;
+}
+
+static void map_release(Rsl_block *b)
+{
+  (void)munmap(b->addr, b->len);
+}
+
+static Ray *map_ray(Rsl_map *m)
+{
+  char header_buf[512];
+  Ray_header ray_h;
+  Ray *r;
+  int nbins;
+  size_t n;
+
+  if (!map_read(m, header_buf, sizeof(header_buf))) return NULL;
+  if (!map_read(m, &nbins, sizeof(int))) return NULL;
+  if (nbins == 0) return NULL;
+
+  memcpy(&ray_h, header_buf, sizeof(Ray_header));
+  if (ray_h.nbins < 0) return NULL;
+  n = ray_h.nbins * sizeof(Range);
+  if (n > m->len - m->pos) {
+	m->pos = m->len;
+	return NULL;
+  }
+
+  if (m->pos % sizeof(Range) != 0) { /* Misaligned; copy it. */
+	r = RSL_new_ray(ray_h.nbins);
+	r->h = ray_h;
+	memcpy(r->range, m->buf + m->pos, n);
+  } else {
+	r = (Ray *)calloc(1, sizeof(Ray));
+	if (r == NULL) {
+	  perror("map_ray");
+	  return NULL;
+	}
+	r->h = ray_h;
+	r->range = (Range *)(m->buf + m->pos);
+	r->block = m->block;
+	rsl_block_ref(m->block);
+  }
+  m->pos += n;
+  return r;
+}
+
+static Sweep *map_sweep(Rsl_map *m)
+{
+  char header_buf[512];
+  Sweep_header sweep_h;
+  int i;
+  Sweep *s;
+  int nrays;
+
+  if (!map_read(m, header_buf, sizeof(header_buf))) return NULL;
+  if (!map_read(m, &nrays, sizeof(int))) return NULL;
+  if (nrays == 0) return NULL;
+
+  memcpy(&sweep_h, header_buf, sizeof(Sweep_header));
+  if (sweep_h.nrays < 0) return NULL;
+  s = RSL_new_sweep(sweep_h.nrays);
+  s->h = sweep_h;
+  for (i=0; i<s->h.nrays; i++)
+	s->ray[i] = map_ray(m);
+  return s;
+}
+
+static Volume *map_volume(Rsl_map *m, int want, int last)
+{
+  /* As read_selected_volume. */
+  char header_buf[512];
+  Volume_header vol_h;
+  int i;
+  Volume *v;
+  Sweep *s;
+  int nsweeps;
+
+  if (!map_read(m, header_buf, sizeof(header_buf))) return NULL;
+  if (!map_read(m, &nsweeps, sizeof(int))) return NULL;
+  if (nsweeps == 0) return NULL;
+
+  memcpy(&vol_h, header_buf, sizeof(Volume_header));
+  if (vol_h.nsweeps < 0) return NULL;
+  v = NULL;
+  if (want) {
+	v = RSL_new_volume(vol_h.nsweeps);
+	v->h = vol_h;
+  }
+  for (i=0; i<vol_h.nsweeps; i++) {
+	if (last && rsl_sweeps_done(i)) break;
+	s = map_sweep(m);
+	if (v && rsl_want_sweep(i)) v->sweep[i] = s;
+	else RSL_free_sweep(s);
+  }
+  return v;
+}
+
+static Radar *map_radar(int fd, char *infile)
+{
+  /* RSL_read_radar for an uncompressed file, open on 'fd', that can be
+   * mapped.  Returns NULL, quietly, when the file cannot be mapped or is
+   * not an RSL file (e.g. it is compressed); the caller then reads it.
+   * 'fd' is left open.
+   */
+  char header_buf[512];
+  Radar_header radar_h;
+  Radar *radar;
+  Rsl_map m;
+  struct stat st;
+  void *addr;
+  int i, nradar, last;
+
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size < 100)
+	return NULL;
+  addr = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) return NULL;
+  if (strncmp((char *)addr, "RSL", 3) != 0 ||
+	  strncmp((char *)addr, "RSL2", 4) == 0) { /* v2 is read by index. */
+	(void)munmap(addr, st.st_size);
+	return NULL;
+  }
+  if ((m.block = rsl_new_block(addr, st.st_size, map_release)) == NULL) {
+	(void)munmap(addr, st.st_size);
+	return NULL;
+  }
+  m.buf = (char *)addr;
+  m.len = st.st_size;
+  m.pos = 100; /* Title. */
+
+  memset(header_buf, 0, sizeof(header_buf));
+  (void)map_read(&m, header_buf, sizeof(header_buf));
+  memcpy(&radar_h, header_buf, sizeof(Radar_header));
+  radar = RSL_new_radar(MAX_RADAR_VOLUMES);
+  radar->h = radar_h;
+
+  nradar = 0;
+  (void)map_read(&m, &nradar, sizeof(int));
+  if (rsl_verbose())
+	fprintf(stderr,"Mapped %s; reading %d volumes.\n", infile, nradar);
+  if (nradar > MAX_RADAR_VOLUMES) nradar = MAX_RADAR_VOLUMES;
+
+  last = last_selected_field(nradar);
+  for (i=0; i<=last; i++)
+	radar->v[i] = map_volume(&m, rsl_reader()->qfield[i], i == last);
+
+  rsl_block_unref(m.block); /* The rays hold it now. */
+  return set_default_function_pointers(radar);
+}
+#endif
+
+static Radar *read_radar_fp(FILE *fp)
+{
+  /* The radar, v1 or v2, in the uncompressed stream 'fp'.
+   *
+   * On disk each header buffer size is this big to reserve space for
    * any new members.  This will make older radar files readable as
    * development proceeds.
    */
   char header_buf[512];
   Radar_header radar_h;
   Radar *radar;
-  FILE *fp;
-  int i;
+  int i, last;
   int nradar;
   char title[100];
 
-  if ((fp = fopen(infile, "r")) == NULL) {
-	perror(infile);
-	return NULL;
-  }
-  fp = uncompress_pipe(fp);
-  (void)fread(title, sizeof(char), sizeof(title), fp);
+  memset(title, 0, sizeof(title));
+  (void)fread(title, sizeof(char), 4, fp);
+  if (strncmp(title, "RSL2", 4) == 0) /* v2, compressed or from memory. */
+	return rsl2_read_radar_fp(fp);
+  (void)fread(title+4, sizeof(char), sizeof(title)-4, fp);
   if (strncmp(title, "RSL", 3) != 0) return NULL;
 
   (void)fread(header_buf, sizeof(char), sizeof(header_buf), fp);
@@ -199,19 +444,72 @@ Radar *RSL_read_radar(char *infile)
   radar->h = radar_h;
 
   (void)fread(&nradar, sizeof(int), 1, fp);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Reading %d volumes.\n", nradar);
 
-  for (i=0; i<nradar; i++) {
-	if (radar_verbose_flag)
+  /* Nothing after the last selected sweep of the last selected field
+   * is read.
+   */
+  last = last_selected_field(nradar);
+  for (i=0; i<=last; i++) {
+	if (rsl_verbose())
 	  fprintf(stderr,"RSL_read_volume %d ", i);
-	radar->v[i] = RSL_read_volume(fp);
+	radar->v[i] = read_selected_volume(fp, rsl_reader()->qfield[i],
+									   i == last);
   }
 
-  rsl_pclose(fp);
   radar = set_default_function_pointers(radar);
   return radar;
 }
+
+Radar *RSL_read_radar(char *infile)
+{
+  Radar *radar;
+  FILE *fp;
+#ifdef RSL_MMAP_RSL
+  Radar *mapped;
+#endif
+
+  if ((fp = fopen(infile, "r")) == NULL) {
+	perror(infile);
+	return NULL;
+  }
+  /* A regular file is opened once: probed for a v2 index, then mapped,
+   * then read.  A pipe or FIFO cannot be rewound, so it is only read.
+   */
+  if (fseek(fp, 0L, SEEK_SET) == 0) {
+	/* Uncompressed v2 files: read only what was selected. */
+	if ((radar = rsl2_read_radar_indexed(fp, infile)) != NULL) {
+	  fclose(fp);
+	  return radar;
+	}
+#ifdef RSL_MMAP_RSL
+	if (rsl_reader()->mmap_rsl &&
+		(mapped = map_radar(fileno(fp), infile)) != NULL) {
+	  fclose(fp);
+	  return mapped;
+	}
+#endif
+	rewind(fp);
+  }
+  fp = uncompress_pipe(fp);
+  radar = read_radar_fp(fp);
+  rsl_pclose(fp);
+  return radar;
+}
+
+Radar *RSL_read_radar_mem(char *buf, size_t len)
+{
+  /* As RSL_read_radar, for the 'len' bytes at 'buf'. */
+  Radar *radar;
+  FILE *fp;
+
+  if ((fp = rsl_mem_fopen(buf, len)) == NULL) return NULL;
+  fp = uncompress_pipe(fp);
+  radar = read_radar_fp(fp);
+  rsl_pclose(fp);
+  return radar;
+}
   
 
 /**********************************************************************/
@@ -256,7 +554,7 @@ int RSL_write_sweep(Sweep *s, FILE *fp)
   }
   memcpy(header_buf, &s->h, sizeof(s->h));
   n += fwrite(header_buf, sizeof(char), sizeof(header_buf), fp);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Expect to output %d rays.\n", s->h.nrays);
   n += fwrite(&s->h.nrays, sizeof(int), 1, fp) * sizeof(int);
   for (i=0; i<s->h.nrays; i++) {
@@ -287,12 +585,12 @@ int RSL_write_volume(Volume *v, FILE *fp)
   memcpy(header_buf, &v->h, sizeof(v->h));
   n += fwrite(header_buf, sizeof(char), sizeof(header_buf), fp);
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Expect to output %d sweeps.\n", v->h.nsweeps);
   n += fwrite(&v->h.nsweeps, sizeof(int), 1, fp) * sizeof(int);
 
   for (i=0; i<v->h.nsweeps; i++) {
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"write_sweep %d ", i);
 	n += RSL_write_sweep(v->sweep[i], fp);
   }
@@ -323,17 +621,17 @@ int RSL_write_radar_fp(Radar *radar, FILE *fp)
   
   nradar = radar->h.nvolumes;
   n += fwrite(&nradar, sizeof(int), 1, fp) * sizeof(int);
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"Number of volumes to write: %d\n", nradar);
   
   for (i=0; i<nradar; i++) {
-	if (radar_verbose_flag)
+	if (rsl_verbose())
 	  fprintf(stderr,"write_volume %d ", i);
 	n += RSL_write_volume(radar->v[i], fp);
 	
   }
   
-  if (radar_verbose_flag)
+  if (rsl_verbose())
 	fprintf(stderr,"write_radar done.  Wrote %d bytes.\n", n);
   return n;
 }
@@ -0,0 +1,833 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_write_radar_v2                             */
+/*                                                                    */
+/*                     RSL_open_index, RSL_close_index                */
+/*                     RSL_read_volume_by_index                       */
+/*                     RSL_read_sweep_by_index                        */
+/*                     RSL_read_ray_by_index                          */
+/*                                                                    */
+/*  The RSL v2 file format.  RSL_read_radar reads both v1 and v2.     */
+/*                                                                    */
+/*  Layout:                                                           */
+/*                                                                    */
+/*    File header, 32 bytes:                                          */
+/*      "RSL2", byte order ('B' or 'L'), sizeof(Range), 2 pad bytes,  */
+/*      int format version, 20 bytes RSL_VERSION_STR.                 */
+/*    Radar header record.                                            */
+/*    For each volume:  volume header record,                         */
+/*      for each sweep: sweep header record,                          */
+/*        for each ray: ray header record, nbins Range values.        */
+/*    Index:                                                          */
+/*      int nvolumes,                                                 */
+/*      nvolumes     x {int64 offset, int nsweeps},                   */
+/*      total sweeps x {int64 offset, int nrays},                     */
+/*      total rays   x {int64 offset}.                                */
+/*    Trailer, 16 bytes: int64 index offset, int index length, "RSLX" */
+/*                                                                    */
+/*  A header record is an int byte count followed by the members      */
+/*  listed in the *_members tables below, packed.  A count of 0 is a  */
+/*  missing volume, sweep or ray, whose offset in the index is 0.     */
+/*  Readers ignore members past the ones they know and zero the ones  */
+/*  a shorter record lacks, so members may be appended to the tables  */
+/*  without changing the format version.  Numbers are written in the  */
+/*  writer's byte order and swapped by the reader when necessary.     */
+/*                                                                    */
+/**********************************************************************/
+/* Offsets are 64 bits even where long is not; see fseeko and ftello.
+ * configure's AC_SYS_LARGEFILE makes off_t 64 bits in config.h.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/types.h>
+#define USE_RSL_VARS
+#include "rsl.h"
+
+#define RSL2_MAGIC   "RSL2"
+#define RSL2_TRAILER "RSLX"
+#define RSL2_VERSION 2
+#define RSL2_HEADER_LEN 32
+#define RSL2_TRAILER_LEN 16
+#define RSL2_RECORD_MAX 1024 /* Longest record we keep; the rest is skipped. */
+
+/* 'keep' for v2_read_ray and v2_read_sweep. */
+#define V2_SKIP   0   /* Skip over it. */
+#define V2_KEEP   1   /* Read all of it. */
+#define V2_WINDOW 2   /* Read what is inside the window; see RSL_read_window. */
+
+typedef struct {
+  size_t offset;   /* Of the member within its header struct. */
+  int size;        /* 4: int or float, byte swapped as needed. 1: char. */
+  int count;
+} V2_member;
+
+#define V2_WORD(type, m)  {offsetof(type, m), 4, 1}
+#define V2_CHARS(type, m) {offsetof(type, m), 1, sizeof(((type *)0)->m)}
+#define V2_NMEMBERS(t) (sizeof(t)/sizeof(t[0]))
+
+/* Never reorder these; append only.  Function pointers are not stored,
+ * they are set from the volume's field type when read.
+ */
+static V2_member radar_members[] = {
+  V2_WORD(Radar_header, month),  V2_WORD(Radar_header, day),
+  V2_WORD(Radar_header, year),   V2_WORD(Radar_header, hour),
+  V2_WORD(Radar_header, minute), V2_WORD(Radar_header, sec),
+  V2_CHARS(Radar_header, radar_type),
+  V2_WORD(Radar_header, nvolumes),
+  V2_WORD(Radar_header, number),
+  V2_CHARS(Radar_header, name),  V2_CHARS(Radar_header, radar_name),
+  V2_CHARS(Radar_header, project),
+  V2_CHARS(Radar_header, city),  V2_CHARS(Radar_header, state),
+  V2_CHARS(Radar_header, country),
+  V2_WORD(Radar_header, latd),   V2_WORD(Radar_header, latm),
+  V2_WORD(Radar_header, lats),   V2_WORD(Radar_header, lond),
+  V2_WORD(Radar_header, lonm),   V2_WORD(Radar_header, lons),
+  V2_WORD(Radar_header, height), V2_WORD(Radar_header, spulse),
+  V2_WORD(Radar_header, lpulse), V2_WORD(Radar_header, scan_mode),
+  V2_WORD(Radar_header, vcp)
+};
+
+static V2_member volume_members[] = {
+  V2_WORD(Volume_header, nsweeps),
+  V2_WORD(Volume_header, calibr_const)
+};
+
+static V2_member sweep_members[] = {
+  V2_WORD(Sweep_header, sweep_num),    V2_WORD(Sweep_header, elev),
+  V2_WORD(Sweep_header, azimuth),      V2_WORD(Sweep_header, beam_width),
+  V2_WORD(Sweep_header, vert_half_bw), V2_WORD(Sweep_header, horz_half_bw),
+  V2_WORD(Sweep_header, nrays)
+};
+
+static V2_member ray_members[] = {
+  V2_WORD(Ray_header, month),      V2_WORD(Ray_header, day),
+  V2_WORD(Ray_header, year),       V2_WORD(Ray_header, hour),
+  V2_WORD(Ray_header, minute),     V2_WORD(Ray_header, sec),
+  V2_WORD(Ray_header, unam_rng),   V2_WORD(Ray_header, azimuth),
+  V2_WORD(Ray_header, ray_num),    V2_WORD(Ray_header, elev),
+  V2_WORD(Ray_header, elev_num),   V2_WORD(Ray_header, range_bin1),
+  V2_WORD(Ray_header, gate_size),  V2_WORD(Ray_header, vel_res),
+  V2_WORD(Ray_header, sweep_rate), V2_WORD(Ray_header, prf),
+  V2_WORD(Ray_header, prf2),       V2_WORD(Ray_header, azim_rate),
+  V2_WORD(Ray_header, fix_angle),  V2_WORD(Ray_header, pitch),
+  V2_WORD(Ray_header, roll),       V2_WORD(Ray_header, heading),
+  V2_WORD(Ray_header, pitch_rate), V2_WORD(Ray_header, roll_rate),
+  V2_WORD(Ray_header, heading_rate),
+  V2_WORD(Ray_header, lat),        V2_WORD(Ray_header, lon),
+  V2_WORD(Ray_header, alt),        V2_WORD(Ray_header, rvc),
+  V2_WORD(Ray_header, vel_east),   V2_WORD(Ray_header, vel_north),
+  V2_WORD(Ray_header, vel_up),     V2_WORD(Ray_header, pulse_count),
+  V2_WORD(Ray_header, pulse_width),V2_WORD(Ray_header, beam_width),
+  V2_WORD(Ray_header, frequency),  V2_WORD(Ray_header, wavelength),
+  V2_WORD(Ray_header, nyq_vel),    V2_WORD(Ray_header, nbins)
+};
+
+static void v2_swap(void *p, int size)
+{
+  unsigned char *b = (unsigned char *)p;
+  unsigned char t;
+  int i;
+
+  for (i=0; i<size/2; i++) {
+	t = b[i];
+	b[i] = b[size-1-i];
+	b[size-1-i] = t;
+  }
+}
+
+static int v2_read_int(FILE *fp, int swap, int *x)
+{
+  if (fread(x, sizeof(int), 1, fp) != 1) return 0;
+  if (swap) v2_swap(x, sizeof(int));
+  return 1;
+}
+
+static int v2_read_int64(FILE *fp, int swap, long long *x)
+{
+  if (fread(x, sizeof(long long), 1, fp) != 1) return 0;
+  if (swap) v2_swap(x, sizeof(long long));
+  return 1;
+}
+
+static int v2_seek(FILE *fp, long long off)
+{
+  /* Seek to 'off', which must fit an off_t. */
+  if (off < 0 || (long long)(off_t)off != off) return -1;
+  return fseeko(fp, (off_t)off, SEEK_SET);
+}
+
+static int v2_skip(FILE *fp, off_t n)
+{
+  /* Pipes can't seek; read through them. */
+  char buf[4096];
+  off_t k;
+
+  if (n <= 0) return 1;
+  if (fseeko(fp, n, SEEK_CUR) == 0) return 1;
+  while (n > 0) {
+	k = n < (off_t)sizeof(buf) ? n : (off_t)sizeof(buf);
+	if (fread(buf, 1, k, fp) != (size_t)k) return 0;
+	n -= k;
+  }
+  return 1;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        Header records                              */
+/*                                                                    */
+/**********************************************************************/
+static int v2_encode(V2_member *m, int nm, void *h, char *buf)
+{
+  /* Pack the members of 'h' into 'buf'.  Return the length. */
+  int i, n, len;
+
+  len = 0;
+  for (i=0; i<nm; i++) {
+	n = m[i].size * m[i].count;
+	memcpy(buf + len, (char *)h + m[i].offset, n);
+	len += n;
+  }
+  return len;
+}
+
+static int v2_write_record(V2_member *m, int nm, void *h, FILE *fp)
+{
+  /* 'h' NULL writes the empty record of a missing object. */
+  char buf[RSL2_RECORD_MAX];
+  int len;
+
+  len = h ? v2_encode(m, nm, h, buf) : 0;
+  if (fwrite(&len, sizeof(int), 1, fp) != 1) return -1;
+  if (len > 0 && fwrite(buf, 1, len, fp) != (size_t)len) return -1;
+  return sizeof(int) + len;
+}
+
+static int v2_read_record(V2_member *m, int nm, void *h, size_t hsize,
+						  FILE *fp, int swap)
+{
+  /* Unpack a record into 'h'.  Returns the record length, 0 for a
+   * missing object, -1 at end of file.
+   */
+  char buf[RSL2_RECORD_MAX];
+  int i, j, n, len, keep, pos;
+
+  memset(h, 0, hsize);
+  if (!v2_read_int(fp, swap, &len) || len < 0) return -1;
+  if (len == 0) return 0;
+  keep = len < (int)sizeof(buf) ? len : (int)sizeof(buf);
+  if (fread(buf, 1, keep, fp) != (size_t)keep) return -1;
+  if (!v2_skip(fp, len - keep)) return -1;
+
+  pos = 0;
+  for (i=0; i<nm; i++) {
+	n = m[i].size * m[i].count;
+	if (pos + n > keep) break;
+	memcpy((char *)h + m[i].offset, buf + pos, n);
+	if (swap && m[i].size > 1)
+	  for (j=0; j<m[i].count; j++)
+		v2_swap((char *)h + m[i].offset + j*m[i].size, m[i].size);
+	pos += n;
+  }
+  return len;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                             I N P U T                              */
+/*                                                                    */
+/**********************************************************************/
+static Ray *v2_read_ray(FILE *fp, int swap, int field, int keep)
+{
+  Ray_header ray_h;
+  Ray *r;
+  int i, nbins, first;
+
+  if (v2_read_record(ray_members, V2_NMEMBERS(ray_members),
+					 &ray_h, sizeof(ray_h), fp, swap) <= 0) return NULL;
+  if (ray_h.nbins < 0) return NULL;
+  nbins = ray_h.nbins;
+  first = 0;
+  if (keep == V2_WINDOW) {
+	if (!rsl_want_azimuth(ray_h.azimuth)) keep = V2_SKIP;
+	nbins = rsl_window_bins(ray_h.range_bin1, ray_h.gate_size,
+							ray_h.nbins, &first);
+	if (rsl_reader()->window && nbins <= 0) keep = V2_SKIP;
+  }
+  if (keep == V2_SKIP) {
+	(void)v2_skip(fp, (off_t)ray_h.nbins * sizeof(Range));
+	return NULL;
+  }
+  r = RSL_new_ray(nbins);
+  if (r == NULL) return NULL;
+  r->h = ray_h;
+  r->h.f = RSL_f_list[field];
+  r->h.invf = RSL_invf_list[field];
+  r->h.nbins = nbins;
+  if (fread(r->range, sizeof(Range), nbins, fp) != (size_t)nbins ||
+	  !v2_skip(fp, (off_t)(ray_h.nbins - nbins) * sizeof(Range))) {
+	RSL_free_ray(r);
+	return NULL;
+  }
+  memset(r->range, 0, first * sizeof(Range));
+  if (swap && sizeof(Range) > 1)
+	for (i=0; i<r->h.nbins; i++) v2_swap(&r->range[i], sizeof(Range));
+  return r;
+}
+
+static Sweep *v2_read_sweep(FILE *fp, int swap, int field, int keep)
+{
+  Sweep_header sweep_h;
+  Sweep *s;
+  int i;
+
+  if (v2_read_record(sweep_members, V2_NMEMBERS(sweep_members),
+					 &sweep_h, sizeof(sweep_h), fp, swap) <= 0) return NULL;
+  if (sweep_h.nrays < 0) return NULL;
+  if (keep == V2_SKIP) {
+	for (i=0; i<sweep_h.nrays; i++)
+	  (void)v2_read_ray(fp, swap, field, V2_SKIP);
+	return NULL;
+  }
+  s = RSL_new_sweep(sweep_h.nrays);
+  if (s == NULL) return NULL;
+  s->h = sweep_h;
+  s->h.f = RSL_f_list[field];
+  s->h.invf = RSL_invf_list[field];
+  for (i=0; i<s->h.nrays; i++)
+	s->ray[i] = v2_read_ray(fp, swap, field, keep);
+  return s;
+}
+
+static int v2_read_volume_header(FILE *fp, int swap, int field,
+								 Volume_header *vol_h)
+{
+  int len;
+
+  len = v2_read_record(volume_members, V2_NMEMBERS(volume_members),
+					   vol_h, sizeof(*vol_h), fp, swap);
+  if (len <= 0 || vol_h->nsweeps < 0) return 0;
+  vol_h->f = RSL_f_list[field];
+  vol_h->invf = RSL_invf_list[field];
+  return 1;
+}
+
+static int v2_read_file_header(FILE *fp, int *swap, int have_magic)
+{
+  /* Return 1 for an RSL v2 file we can read.  'have_magic' is set when
+   * the caller has already read the magic.
+   */
+  char header[RSL2_HEADER_LEN];
+  int version, n;
+
+  n = have_magic ? 4 : 0;
+  if (have_magic) memcpy(header, RSL2_MAGIC, 4);
+  if (fread(header + n, 1, sizeof(header) - n, fp) != sizeof(header) - n)
+	return 0;
+  if (strncmp(header, RSL2_MAGIC, 4) != 0) return 0;
+  *swap = (header[4] == 'B') != (big_endian() != 0);
+  if (header[5] != sizeof(Range)) {
+	fprintf(stderr, "RSL v2 file has sizeof(Range) %d; expected %d.\n",
+			header[5], (int)sizeof(Range));
+	return 0;
+  }
+  memcpy(&version, header + 8, sizeof(int));
+  if (*swap) v2_swap(&version, sizeof(int));
+  if (version != RSL2_VERSION) {
+	fprintf(stderr, "RSL v2 file format version %d is not supported.\n",
+			version);
+	return 0;
+  }
+  return 1;
+}
+
+static Radar *v2_read_radar_header(FILE *fp, int swap)
+{
+  Radar_header radar_h;
+  Radar *radar;
+
+  if (v2_read_record(radar_members, V2_NMEMBERS(radar_members),
+					 &radar_h, sizeof(radar_h), fp, swap) <= 0) return NULL;
+  if (radar_h.nvolumes < 0 || radar_h.nvolumes > MAX_RADAR_VOLUMES)
+	return NULL;
+  radar = RSL_new_radar(MAX_RADAR_VOLUMES);
+  if (radar == NULL) return NULL;
+  radar->h = radar_h;
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        rsl2_read_radar_fp                          */
+/*                                                                    */
+/*  Sequential read, for compressed v2 files.  'fp' is positioned     */
+/*  just past the magic.  Called by RSL_read_radar.                   */
+/*                                                                    */
+/**********************************************************************/
+Radar *rsl2_read_radar_fp(FILE *fp)
+{
+  Rsl_reader *reader = rsl_reader();
+  Volume_header vol_h;
+  Radar *radar;
+  Volume *v;
+  int swap, i, j, want, last;
+
+  if (!v2_read_file_header(fp, &swap, 1)) return NULL;
+  if ((radar = v2_read_radar_header(fp, swap)) == NULL) return NULL;
+  if (rsl_verbose())
+	fprintf(stderr,"Reading %d volumes, RSL v2.\n", radar->h.nvolumes);
+
+  /* Nothing after the last selected sweep of the last selected field
+   * is read.
+   */
+  for (last = radar->h.nvolumes-1; last >= 0; last--)
+	if (reader->qfield[last]) break;
+
+  for (i=0; i<=last; i++) {
+	if (!v2_read_volume_header(fp, swap, i, &vol_h)) continue;
+	want = reader->qfield[i];
+	v = NULL;
+	if (want) {
+	  v = RSL_new_volume(vol_h.nsweeps);
+	  v->h = vol_h;
+	}
+	for (j=0; j<vol_h.nsweeps; j++) {
+	  if (i == last && rsl_sweeps_done(j)) break;
+	  if (want && rsl_want_sweep(j))
+		v->sweep[j] = v2_read_sweep(fp, swap, i, V2_WINDOW);
+	  else
+		(void)v2_read_sweep(fp, swap, i, V2_SKIP);
+	}
+	radar->v[i] = v;
+  }
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                   RSL_open_index, RSL_close_index                  */
+/*                                                                    */
+/*  Read the header and index of an uncompressed RSL v2 file, so its  */
+/*  volumes, sweeps and rays may be read in any order.  Returns NULL  */
+/*  for any other file.                                               */
+/*                                                                    */
+/**********************************************************************/
+static Rsl_index *open_index_fp(FILE *fp, char *infile)
+{
+  /* The index of the v2 file open on 'fp', or NULL, quietly, if it is
+   * not one.  The index reads through 'fp'.  It is not closed on failure.
+   */
+  Rsl_index *idx;
+  char trailer[RSL2_TRAILER_LEN];
+  long long index_offset;
+  int index_len, swap, nvolumes, nsweeps, nrays, i, j;
+
+  if (!v2_read_file_header(fp, &swap, 0) ||
+	  fseeko(fp, -RSL2_TRAILER_LEN, SEEK_END) != 0 ||
+	  fread(trailer, 1, sizeof(trailer), fp) != sizeof(trailer) ||
+	  strncmp(trailer + 12, RSL2_TRAILER, 4) != 0)
+	return NULL;
+  memcpy(&index_offset, trailer, sizeof(long long));
+  memcpy(&index_len, trailer + 8, sizeof(int));
+  if (swap) {
+	v2_swap(&index_offset, sizeof(long long));
+	v2_swap(&index_len, sizeof(int));
+  }
+
+  idx = (Rsl_index *)calloc(1, sizeof(Rsl_index));
+  if (idx == NULL) {
+	perror("RSL_open_index");
+	return NULL;
+  }
+  idx->fp = fp;
+  idx->swap = swap;
+  idx->version = RSL2_VERSION;
+
+  /* Radar header follows the file header. */
+  if (fseeko(fp, RSL2_HEADER_LEN, SEEK_SET) != 0 ||
+	  v2_read_record(radar_members, V2_NMEMBERS(radar_members),
+					 &idx->h, sizeof(idx->h), fp, swap) <= 0)
+	goto bad;
+
+  /* Index: volumes, then sweeps, then rays.  Sizes of the sweep and ray
+   * tables are the sums of the counts before them.
+   */
+  if (v2_seek(fp, index_offset) != 0 ||
+	  !v2_read_int(fp, swap, &nvolumes) ||
+	  nvolumes < 0 || nvolumes > MAX_RADAR_VOLUMES) goto bad;
+  idx->nvolumes = nvolumes;
+  idx->nsweeps = (int *)calloc(nvolumes + 1, sizeof(int));
+  idx->sweep1  = (int *)calloc(nvolumes + 1, sizeof(int));
+  idx->volume_offset = (long long *)calloc(nvolumes + 1, sizeof(long long));
+  if (!idx->nsweeps || !idx->sweep1 || !idx->volume_offset) goto bad;
+
+  nsweeps = 0;
+  for (i=0; i<nvolumes; i++) {
+	if (!v2_read_int64(fp, swap, &idx->volume_offset[i]) ||
+		!v2_read_int(fp, swap, &idx->nsweeps[i]) ||
+		idx->nsweeps[i] < 0) goto bad;
+	idx->sweep1[i] = nsweeps;
+	nsweeps += idx->nsweeps[i];
+  }
+  idx->nrays = (int *)calloc(nsweeps + 1, sizeof(int));
+  idx->ray1  = (int *)calloc(nsweeps + 1, sizeof(int));
+  idx->sweep_offset = (long long *)calloc(nsweeps + 1, sizeof(long long));
+  if (!idx->nrays || !idx->ray1 || !idx->sweep_offset) goto bad;
+
+  nrays = 0;
+  for (j=0; j<nsweeps; j++) {
+	if (!v2_read_int64(fp, swap, &idx->sweep_offset[j]) ||
+		!v2_read_int(fp, swap, &idx->nrays[j]) ||
+		idx->nrays[j] < 0) goto bad;
+	idx->ray1[j] = nrays;
+	nrays += idx->nrays[j];
+  }
+  idx->ray_offset = (long long *)calloc(nrays + 1, sizeof(long long));
+  if (idx->ray_offset == NULL) goto bad;
+  for (j=0; j<nrays; j++)
+	if (!v2_read_int64(fp, swap, &idx->ray_offset[j])) goto bad;
+
+  if ((long long)ftello(fp) - index_offset != index_len) goto bad;
+  return idx;
+
+ bad:
+  if (rsl_verbose())
+	fprintf(stderr, "RSL_open_index: %s has a damaged index.\n", infile);
+  idx->fp = NULL;
+  RSL_close_index(idx);
+  return NULL;
+}
+
+Rsl_index *RSL_open_index(char *infile)
+{
+  Rsl_index *idx;
+  FILE *fp;
+
+  if ((fp = fopen(infile, "r")) == NULL) return NULL;
+  if ((idx = open_index_fp(fp, infile)) == NULL) fclose(fp);
+  return idx;
+}
+
+void RSL_close_index(Rsl_index *idx)
+{
+  if (idx == NULL) return;
+  if (idx->fp) fclose(idx->fp);
+  if (idx->nsweeps) free(idx->nsweeps);
+  if (idx->sweep1) free(idx->sweep1);
+  if (idx->volume_offset) free(idx->volume_offset);
+  if (idx->nrays) free(idx->nrays);
+  if (idx->ray1) free(idx->ray1);
+  if (idx->sweep_offset) free(idx->sweep_offset);
+  if (idx->ray_offset) free(idx->ray_offset);
+  free(idx);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      RSL_read_*_by_index                           */
+/*                                                                    */
+/*  'field' is the volume index, e.g. DZ_INDEX.  Return NULL when the */
+/*  file does not have the object.                                    */
+/*                                                                    */
+/**********************************************************************/
+static long long v2_sweep_offset(Rsl_index *idx, int field, int isweep)
+{
+  if (idx == NULL || field < 0 || field >= idx->nvolumes) return 0;
+  if (isweep < 0 || isweep >= idx->nsweeps[field]) return 0;
+  return idx->sweep_offset[idx->sweep1[field] + isweep];
+}
+
+static Sweep *v2_read_sweep_at(Rsl_index *idx, int field, int isweep,
+							   int keep)
+{
+  long long off;
+
+  if ((off = v2_sweep_offset(idx, field, isweep)) == 0) return NULL;
+  if (v2_seek(idx->fp, off) != 0) return NULL;
+  return v2_read_sweep(idx->fp, idx->swap, field, keep);
+}
+
+Sweep *RSL_read_sweep_by_index(Rsl_index *idx, int field, int isweep)
+{
+  return v2_read_sweep_at(idx, field, isweep, V2_KEEP);
+}
+
+Ray *RSL_read_ray_by_index(Rsl_index *idx, int field, int isweep, int iray)
+{
+  long long off;
+  int j;
+
+  if (v2_sweep_offset(idx, field, isweep) == 0) return NULL;
+  j = idx->sweep1[field] + isweep;
+  if (iray < 0 || iray >= idx->nrays[j]) return NULL;
+  if ((off = idx->ray_offset[idx->ray1[j] + iray]) == 0) return NULL;
+  if (v2_seek(idx->fp, off) != 0) return NULL;
+  return v2_read_ray(idx->fp, idx->swap, field, V2_KEEP);
+}
+
+Volume *RSL_read_volume_by_index(Rsl_index *idx, int field)
+{
+  /* Only the sweeps selected with RSL_read_these_sweeps, and the window
+   * set with RSL_read_window, are read.
+   */
+  Volume_header vol_h;
+  Volume *v;
+  int j;
+
+  if (idx == NULL || field < 0 || field >= idx->nvolumes) return NULL;
+  if (idx->volume_offset[field] == 0) return NULL;
+  if (v2_seek(idx->fp, idx->volume_offset[field]) != 0) return NULL;
+  if (!v2_read_volume_header(idx->fp, idx->swap, field, &vol_h)) return NULL;
+  if (vol_h.nsweeps != idx->nsweeps[field]) return NULL;
+
+  v = RSL_new_volume(vol_h.nsweeps);
+  v->h = vol_h;
+  for (j=0; j<v->h.nsweeps && !rsl_sweeps_done(j); j++)
+	if (rsl_want_sweep(j))
+	  v->sweep[j] = v2_read_sweep_at(idx, field, j, V2_WINDOW);
+  return v;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      rsl2_read_radar_indexed                       */
+/*                                                                    */
+/*  RSL_read_radar for an uncompressed v2 file, open on the seekable  */
+/*  'fp': only the fields and sweeps selected with RSL_select_fields  */
+/*  and RSL_read_these_sweeps are read from disk.  Returns NULL,      */
+/*  quietly, for any other file.  'fp' is left open either way.       */
+/*                                                                    */
+/**********************************************************************/
+Radar *rsl2_read_radar_indexed(FILE *fp, char *infile)
+{
+  Rsl_reader *reader = rsl_reader();
+  Rsl_index *idx;
+  Radar *radar;
+  int i;
+
+  if ((idx = open_index_fp(fp, infile)) == NULL) return NULL;
+  radar = RSL_new_radar(MAX_RADAR_VOLUMES);
+  if (radar == NULL) {
+	idx->fp = NULL;
+	RSL_close_index(idx);
+	return NULL;
+  }
+  radar->h = idx->h;
+  if (rsl_verbose())
+	fprintf(stderr,"Reading %d volumes, RSL v2 with index.\n",
+			radar->h.nvolumes);
+  for (i=0; i<idx->nvolumes && i<radar->h.nvolumes; i++)
+	if (reader->qfield[i])
+	  radar->v[i] = RSL_read_volume_by_index(idx, i);
+  idx->fp = NULL; /* The caller's. */
+  RSL_close_index(idx);
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                           O U T P U T                              */
+/*                                                                    */
+/**********************************************************************/
+/* Offsets recorded while writing, for the index. */
+typedef struct {
+  FILE *fp;
+  off_t pos;            /* Bytes written so far. */
+  int nvolumes;
+  long long *volume_offset;
+  int *nsweeps;
+  long long *sweep_offset;
+  int *nrays;
+  long long *ray_offset;
+  int isweep, iray;     /* Next free entries. */
+} V2_writer;
+
+static int v2_put(V2_writer *w, void *buf, size_t n)
+{
+  if (n > 0 && fwrite(buf, 1, n, w->fp) != n) return 0;
+  w->pos += n;
+  return 1;
+}
+
+static int v2_put_record(V2_writer *w, V2_member *m, int nm, void *h)
+{
+  int n;
+
+  if ((n = v2_write_record(m, nm, h, w->fp)) < 0) return 0;
+  w->pos += n;
+  return 1;
+}
+
+static int v2_write_ray(V2_writer *w, Ray *r)
+{
+  w->ray_offset[w->iray++] = r ? (long long)w->pos : 0;
+  if (r == NULL)
+	return v2_put_record(w, ray_members, V2_NMEMBERS(ray_members), NULL);
+  if (!v2_put_record(w, ray_members, V2_NMEMBERS(ray_members), &r->h))
+	return 0;
+  return v2_put(w, r->range, r->h.nbins * sizeof(Range));
+}
+
+static int v2_write_sweep(V2_writer *w, Sweep *s)
+{
+  int j, i;
+
+  j = w->isweep++;
+  w->sweep_offset[j] = s ? (long long)w->pos : 0;
+  w->nrays[j] = s ? s->h.nrays : 0;
+  if (s == NULL)
+	return v2_put_record(w, sweep_members, V2_NMEMBERS(sweep_members), NULL);
+  if (!v2_put_record(w, sweep_members, V2_NMEMBERS(sweep_members), &s->h))
+	return 0;
+  for (i=0; i<s->h.nrays; i++)
+	if (!v2_write_ray(w, s->ray[i])) return 0;
+  return 1;
+}
+
+static int v2_write_index(V2_writer *w)
+{
+  long long index_offset;
+  int i, j, k, nsweeps, nrays, len;
+  char trailer[RSL2_TRAILER_LEN];
+
+  index_offset = (long long)w->pos;
+  if (!v2_put(w, &w->nvolumes, sizeof(int))) return 0;
+  nsweeps = 0;
+  for (i=0; i<w->nvolumes; i++) {
+	if (!v2_put(w, &w->volume_offset[i], sizeof(long long)) ||
+		!v2_put(w, &w->nsweeps[i], sizeof(int))) return 0;
+	nsweeps += w->nsweeps[i];
+  }
+  nrays = 0;
+  for (j=0; j<nsweeps; j++) {
+	if (!v2_put(w, &w->sweep_offset[j], sizeof(long long)) ||
+		!v2_put(w, &w->nrays[j], sizeof(int))) return 0;
+	nrays += w->nrays[j];
+  }
+  for (k=0; k<nrays; k++)
+	if (!v2_put(w, &w->ray_offset[k], sizeof(long long))) return 0;
+
+  len = (int)((long long)w->pos - index_offset);
+  memcpy(trailer, &index_offset, sizeof(long long));
+  memcpy(trailer + 8, &len, sizeof(int));
+  memcpy(trailer + 12, RSL2_TRAILER, 4);
+  return v2_put(w, trailer, sizeof(trailer));
+}
+
+static int v2_write_radar(V2_writer *w, Radar *radar)
+{
+  char header[RSL2_HEADER_LEN];
+  Volume *v;
+  int i, j, version;
+
+  memset(header, 0, sizeof(header));
+  memcpy(header, RSL2_MAGIC, 4);
+  header[4] = big_endian() ? 'B' : 'L';
+  header[5] = sizeof(Range);
+  version = RSL2_VERSION;
+  memcpy(header + 8, &version, sizeof(int));
+  strncpy(header + 12, RSL_VERSION_STR, RSL2_HEADER_LEN - 12 - 1);
+  if (!v2_put(w, header, sizeof(header))) return 0;
+  if (!v2_put_record(w, radar_members, V2_NMEMBERS(radar_members), &radar->h))
+	return 0;
+
+  for (i=0; i<w->nvolumes; i++) {
+	v = radar->v[i];
+	w->volume_offset[i] = v ? (long long)w->pos : 0;
+	w->nsweeps[i] = v ? v->h.nsweeps : 0;
+	if (rsl_verbose())
+	  fprintf(stderr,"write_volume %d ", i);
+	if (!v2_put_record(w, volume_members, V2_NMEMBERS(volume_members),
+					   v ? &v->h : NULL)) return 0;
+	if (v == NULL) continue;
+	for (j=0; j<v->h.nsweeps; j++)
+	  if (!v2_write_sweep(w, v->sweep[j])) return 0;
+  }
+  return v2_write_index(w);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                       RSL_write_radar_v2                           */
+/*                                                                    */
+/*  Write 'radar' in the RSL v2 format.  Returns the number of bytes  */
+/*  written, which may exceed INT_MAX, or -1 on error.                */
+/*                                                                    */
+/**********************************************************************/
+long long RSL_write_radar_v2(Radar *radar, char *outfile)
+{
+  V2_writer w;
+  Volume *v;
+  Sweep *s;
+  int i, j, nsweeps, nrays, ok;
+
+  if (radar == NULL) return 0;
+  if (radar->h.nvolumes < 0 || radar->h.nvolumes > MAX_RADAR_VOLUMES) {
+	fprintf(stderr, "RSL_write_radar_v2: bad nvolumes %d\n",
+			radar->h.nvolumes);
+	return -1;
+  }
+
+  /* Size the index. */
+  memset(&w, 0, sizeof(w));
+  w.nvolumes = radar->h.nvolumes;
+  nsweeps = nrays = 0;
+  for (i=0; i<w.nvolumes; i++) {
+	if ((v = radar->v[i]) == NULL) continue;
+	nsweeps += v->h.nsweeps;
+	for (j=0; j<v->h.nsweeps; j++)
+	  if ((s = v->sweep[j]) != NULL) nrays += s->h.nrays;
+  }
+  w.volume_offset = (long long *)calloc(w.nvolumes + 1, sizeof(long long));
+  w.nsweeps = (int *)calloc(w.nvolumes + 1, sizeof(int));
+  w.sweep_offset = (long long *)calloc(nsweeps + 1, sizeof(long long));
+  w.nrays = (int *)calloc(nsweeps + 1, sizeof(int));
+  w.ray_offset = (long long *)calloc(nrays + 1, sizeof(long long));
+
+  ok = 0;
+  if (!w.volume_offset || !w.nsweeps || !w.sweep_offset ||
+	  !w.nrays || !w.ray_offset) {
+	perror("RSL_write_radar_v2");
+  } else if ((w.fp = fopen(outfile, "w")) == NULL) {
+	perror(outfile);
+  } else {
+	ok = v2_write_radar(&w, radar);
+	if (fclose(w.fp) != 0) ok = 0;
+	if (!ok) perror(outfile);
+  }
+
+  if (w.volume_offset) free(w.volume_offset);
+  if (w.nsweeps) free(w.nsweeps);
+  if (w.sweep_offset) free(w.sweep_offset);
+  if (w.nrays) free(w.nrays);
+  if (w.ray_offset) free(w.ray_offset);
+
+  if (!ok) return -1;
+  if (rsl_verbose())
+	fprintf(stderr,"RSL_write_radar_v2 done.  Wrote %lld bytes.\n",
+			(long long)w.pos);
+  return (long long)w.pos;
+}
@@ -0,0 +1,384 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Reader contexts.
+ *
+ * The ingest routines find their settings (field and sweep selection,
+ * verbosity, WSR-88D options) through rsl_reader(), which returns the
+ * reader bound to the calling thread.  The *_to_radar_r routines bind
+ * their Rsl_reader for the duration of the call.  Outside of them, the
+ * default reader is used; it is what RSL_select_fields,
+ * RSL_read_these_sweeps, RSL_radar_verbose_on and friends have always
+ * configured.
+ *
+ * Scratch state private to one decode is declared RSL_THREAD_LOCAL in
+ * the ingest modules, so threads reading different files do not share it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rsl.h"
+
+/*
+ * Unfortunately in C, there is no way around initializing static
+ * arrays by specifying repetition.
+ */
+static Rsl_reader rsl_default_reader = {
+  {1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1, 1, 1,
+   1, 1, 1},
+  NULL,           /* qsweep: read all sweeps. */
+  RSL_MAX_QSWEEP, /* qsweep_max */
+  0,              /* verbose */
+  1,              /* merge_split_cuts */
+  0,              /* keep_sails */
+  0,              /* decode_threads */
+  0,              /* mmap_rsl */
+  0,              /* window: off */
+  0, 0, 0, 0      /* min_range, max_range, low_azim, hi_azim */
+};
+
+static RSL_THREAD_LOCAL Rsl_reader *rsl_bound_reader = NULL;
+
+/*
+ * The settings of the default reader as they were before readers existed.
+ * Applications may still declare and test these; rsl_reader_sync keeps
+ * them equal to the default reader, and the default reader takes its
+ * verbosity from radar_verbose_flag, so setting it directly still works.
+ */
+int radar_verbose_flag = 0;
+int rsl_qfield[MAX_RADAR_VOLUMES] = {
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1,
+  1, 1, 1
+ };
+int *rsl_qsweep = NULL;  /* If NULL, then read all sweeps. */
+int rsl_qsweep_max = RSL_MAX_QSWEEP;
+
+/**********************************************************************/
+/*                                                                    */
+/*                           rsl_reader                               */
+/*                                                                    */
+/*  Return the reader bound to this thread, or the default reader.    */
+/*                                                                    */
+/**********************************************************************/
+Rsl_reader *rsl_reader(void)
+{
+  if (rsl_bound_reader) return rsl_bound_reader;
+  return &rsl_default_reader;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         rsl_reader_sync                            */
+/*                                                                    */
+/*  Copy the default reader's field and sweep selection to the        */
+/*  legacy globals after RSL_select_fields or RSL_read_these_sweeps   */
+/*  changes it.  Other readers have no globals.                       */
+/*                                                                    */
+/**********************************************************************/
+void rsl_reader_sync(Rsl_reader *r)
+{
+  if (r != &rsl_default_reader) return;
+  memcpy(rsl_qfield, r->qfield, sizeof(rsl_qfield));
+  rsl_qsweep = r->qsweep;
+  rsl_qsweep_max = r->qsweep_max;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         rsl_reader_bind                            */
+/*                                                                    */
+/*  Bind 'r' to this thread; NULL reverts to the default reader.      */
+/*  Returns the previous binding, so calls may be nested.             */
+/*                                                                    */
+/**********************************************************************/
+Rsl_reader *rsl_reader_bind(Rsl_reader *r)
+{
+  Rsl_reader *prev;
+
+  prev = rsl_bound_reader;
+  rsl_bound_reader = r;
+  return prev;
+}
+
+/* The default reader's verbosity is radar_verbose_flag. */
+int rsl_reader_is_verbose(Rsl_reader *r)
+{
+  if (r == &rsl_default_reader) return radar_verbose_flag;
+  return r->verbose;
+}
+
+int rsl_verbose(void)
+{
+  return rsl_reader_is_verbose(rsl_reader());
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                 rsl_want_sweep, rsl_sweeps_done                    */
+/*                                                                    */
+/*  Sweep selection, as set by RSL_read_these_sweeps, for the ingest  */
+/*  routines.  'isweep' is the index of the sweep in the file.        */
+/*  rsl_want_sweep says whether to decode sweep isweep;               */
+/*  rsl_sweeps_done says that no sweep from isweep on is wanted, so   */
+/*  the reader may stop there.                                        */
+/*                                                                    */
+/**********************************************************************/
+int rsl_want_sweep(int isweep)
+{
+  Rsl_reader *r = rsl_reader();
+
+  if (r->qsweep == NULL || r->qsweep_max >= RSL_MAX_QSWEEP) return 1;
+  if (isweep < 0 || isweep > r->qsweep_max) return 0;
+  return r->qsweep[isweep];
+}
+
+int rsl_sweeps_done(int isweep)
+{
+  Rsl_reader *r = rsl_reader();
+
+  if (r->qsweep == NULL || r->qsweep_max >= RSL_MAX_QSWEEP) return 0;
+  return isweep > r->qsweep_max;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                 RSL_new_reader, RSL_free_reader                    */
+/*                                                                    */
+/**********************************************************************/
+Rsl_reader *RSL_new_reader(void)
+{
+  /* A new reader ingests all fields and all sweeps, quietly, with the
+   * default WSR-88D options.  It does not inherit the settings of the
+   * default reader.
+   */
+  Rsl_reader *r;
+  int i;
+
+  r = (Rsl_reader *)calloc(1, sizeof(Rsl_reader));
+  if (r == NULL) {
+	perror("RSL_new_reader");
+	return NULL;
+  }
+  for (i=0; i<MAX_RADAR_VOLUMES; i++) r->qfield[i] = 1;
+  r->qsweep = NULL;
+  r->qsweep_max = RSL_MAX_QSWEEP;
+  r->merge_split_cuts = 1;
+  return r;
+}
+
+void RSL_free_reader(Rsl_reader *r)
+{
+  if (r == NULL) return;
+  if (rsl_bound_reader == r) rsl_bound_reader = NULL;
+  if (r->qsweep) free(r->qsweep);
+  free(r);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         rsl_reader_copy                            */
+/*                                                                    */
+/*  A new reader with the settings r has now, for work that outlasts  */
+/*  the call, such as a stream.  Free it with RSL_free_reader.        */
+/*                                                                    */
+/**********************************************************************/
+Rsl_reader *rsl_reader_copy(Rsl_reader *r)
+{
+  Rsl_reader *c;
+
+  c = (Rsl_reader *)malloc(sizeof(Rsl_reader));
+  if (c == NULL) {
+	perror("rsl_reader_copy");
+	return NULL;
+  }
+  *c = *r;
+  c->verbose = rsl_reader_is_verbose(r);
+  if (r->qsweep) {
+	c->qsweep = (int *)malloc(RSL_MAX_QSWEEP * sizeof(int));
+	if (c->qsweep == NULL) {
+	  perror("rsl_reader_copy");
+	  free(c);
+	  return NULL;
+	}
+	memcpy(c->qsweep, r->qsweep, RSL_MAX_QSWEEP * sizeof(int));
+  }
+  return c;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                       Reader option setters                        */
+/*                                                                    */
+/*  RSL_reader_wsr88d_decode_threads is in wsr88d_ar2v.c.             */
+/*                                                                    */
+/**********************************************************************/
+void RSL_reader_verbose(Rsl_reader *r, int on)
+{
+  r->verbose = on;
+  if (r == &rsl_default_reader) radar_verbose_flag = on;
+}
+
+void RSL_reader_wsr88d_merge_split_cuts(Rsl_reader *r, int on)
+{
+  r->merge_split_cuts = on;
+}
+
+void RSL_reader_wsr88d_keep_sails(Rsl_reader *r, int on)
+{
+  r->keep_sails = on;
+}
+
+void RSL_reader_mmap(Rsl_reader *r, int on)
+{
+  r->mmap_rsl = on;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        *_to_radar_r                                */
+/*                                                                    */
+/*  Run the ingest routine with 'r' bound to this thread.             */
+/*  RSL_anyformat_to_radar_r is in anyformat_to_radar.c.              */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_africa_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_africa_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_dorade_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_dorade_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_lassen_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_lassen_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_mcgill_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_mcgill_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_nsig_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_nsig_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_nsig2_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_nsig2_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_radtec_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_radtec_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_rainbow_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_rainbow_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_read_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_read_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_toga_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_toga_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_uf_to_radar_r(Rsl_reader *r, char *infile)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_uf_to_radar(infile);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_uf_to_radar_fp_r(Rsl_reader *r, FILE *fp)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_uf_to_radar_fp(fp);
+  rsl_reader_bind(prev);
+  return radar;
+}
+
+Radar *RSL_wsr88d_to_radar_r(Rsl_reader *r, char *infile,
+							 char *call_or_first_tape_file)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Radar *radar = RSL_wsr88d_to_radar(infile, call_or_first_tape_file);
+  rsl_reader_bind(prev);
+  return radar;
+}
@@ -178,6 +178,18 @@ typedef struct {
 } Ray_header;
 
 
+/* Memory that the range arrays of many rays point into, such as a
+ * memory-mapped RSL file or a ray arena.  It is released with the last
+ * ray that refers to it.  See rsl_new_block in volume.c.
+ */
+typedef struct _rsl_block {
+  void *addr;
+  size_t len;
+  int refs;
+  int holds_rays;  /* 1 = the Ray structs are in the block too (arena). */
+  void (*release)(struct _rsl_block *b); /* Frees addr. */
+} Rsl_block;
+
 typedef struct {              
    Ray_header h;
    Range *range;    /* range[0..nbins-1] 
@@ -185,17 +197,24 @@ typedef struct {
                      * 0..460 for reflectivity, 0..920 for velocity and
                      * spectrum width.
                      */
+   Rsl_block *block; /* Holds range, or NULL when range was calloc'ed
+                      * for this ray alone.  See RSL_arena_begin.
+                      */
    } Ray;
 
 
-typedef struct _azimuth_hash {
-  Ray *ray; 
-  struct _azimuth_hash *next, *ray_high, *ray_low;
-} Azimuth_hash;
+/* Azimuth index of a sweep; see ray_indexes.c. */
+#define HASH_BUCKET_RES 0.1 /* Degrees per bucket. */
 
 typedef struct {
-  Azimuth_hash **indexes;
-  int nindexes;
+  Ray **ray;       /* Rays sorted by azimuth. ray[0..nrays-1]. */
+  float *azimuth;  /* azimuth[i] is ray[i]'s azimuth, in [0,360). */
+  int nrays;
+  int *bucket;     /* bucket[b] is the first i with azimuth[i] >= b*res,
+                    * or nrays.
+                    */
+  int nbuckets;
+  float res;       /* Degrees per bucket. */
 } Hash_table;
 
 
@@ -215,6 +234,15 @@ typedef struct {
 typedef struct {           
   Sweep_header h;   
   Ray **ray;               /* ray[0..nrays-1]. */
+  Hash_table *hash;        /* Rays by azimuth. Built on first lookup;
+                            * see hash_table_for_sweep in volume.c.
+                            * Call RSL_sweep_changed after editing ray[].
+                            */
+  Rsl_block *gates;        /* Gate matrix that the rays' range arrays lie
+                            * in, or NULL.  See RSL_sweep_to_matrix.
+                            */
+  int stride;              /* Range values from one row to the next. */
+  int max_rays;            /* Length of the ray array; see RSL_reserve_rays. */
 } Sweep;
 
 typedef struct {
@@ -228,6 +256,9 @@ typedef struct {
 typedef struct {
     Volume_header h;           /* Specific info for each elev. */
     Sweep **sweep;             /* sweep[0..nsweeps-1]. */
+    int max_sweeps;            /* Length of the sweep array; see
+                                * RSL_reserve_sweeps.
+                                */
 } Volume;
 
 
@@ -255,6 +286,18 @@ typedef struct {
   Carpi_value **data;     /* data[ny][nx] */
 } Carpi;
 
+/* Where each subcell of a Carpi takes its value from, in any Cappi made
+ * from the same sweep.  Internal; see carpi_map in carpi.c.
+ */
+typedef struct {
+  float dx, dy;
+  int   nx, ny;
+  int   radar_x, radar_y;
+  int   scx, scy;         /* Subcells per cell. */
+  int   stride;           /* gate = ray index * stride + bin. */
+  int  *gate;             /* gate[((row*nx + col)*scy + n)*scx + m] */
+} Carpi_map;
+
 /** Cappi data structure info **/
 /*  Paul A. Kucera            **/
 
@@ -311,6 +354,25 @@ typedef struct
     Slice_value **data;           /* data[ny][nx]. */
 } Slice;
 
+/* A polar to cartesian mapping for RSL_sweep_to_cart.  It is made for
+ * the ray geometry of one sweep and may be used for any sweep with the
+ * same geometry; typically the same sweep of the other fields.
+ */
+typedef struct {
+  int xdim, ydim;    /* Image size. */
+  float range;       /* Range (km) at the image edge. */
+  int npixels;       /* xdim*ydim */
+  int *ray;          /* ray[p]: index into Sweep.ray for pixel p, or -1. */
+  int *bin;          /* bin[p]: range bin of that ray for pixel p. */
+  /* The geometry the plan was made for.  See RSL_cart_plan_fits. */
+  int nrays;
+  float beam_width;
+  float *azimuth;    /* [nrays] */
+  int *nbins;        /* [nrays] */
+  int *range_bin1;   /* [nrays] */
+  int *gate_size;    /* [nrays] */
+} Cart_plan;
+
 typedef struct {
   int nbins;
   int low;
@@ -491,8 +553,8 @@ typedef struct {
  *
  * Also, when adding new *_INDEXes, you must update the following three arrays
  * located near the end of this file: RSL_ftype, RSL_f_list, and  RSL_invf_list.
- * You also need to modify volume.c, updating the initialization of array
- * rsl_qfield by adding a '1' for each new volume index.
+ * You also need to modify reader.c, updating the initialization of
+ * rsl_default_reader.qfield by adding a '1' for each new volume index.
  */
 
 #define MAX_RADAR_VOLUMES 48
@@ -546,12 +608,133 @@ typedef struct {
 #define SN_INDEX 46
 #define DC_INDEX 47
 
+/*
+ * Reader context.  Everything the ingest routines consult while decoding
+ * a file lives here rather than in process-wide variables, so that one
+ * process may read several files at once, one Rsl_reader per thread.
+ * Create one with RSL_new_reader and pass it to the *_to_radar_r
+ * routines.  The plain *_to_radar routines use a built-in default
+ * reader, which RSL_select_fields, RSL_read_these_sweeps,
+ * RSL_radar_verbose_on and the RSL_wsr88d_* switches configure.
+ */
+#define RSL_MAX_QSWEEP 500
+
+typedef struct {
+  int qfield[MAX_RADAR_VOLUMES]; /* 1 = ingest this field. All 1 by default. */
+  int *qsweep;         /* NULL = read all sweeps.  Otherwise, qsweep[i] = 1
+                        * means read sweep i. See RSL_reader_read_these_sweeps.
+                        */
+  int qsweep_max;      /* Highest sweep index that may be set in qsweep. */
+  int verbose;         /* Diagnostic messages to stderr. */
+  int merge_split_cuts;/* WSR-88D: merge split cuts. Default 1. */
+  int keep_sails;      /* WSR-88D: keep SAILS sweeps in VCP 12 and 212. */
+  int decode_threads;  /* WSR-88D: threads for AR2V blocks and radials. */
+  int mmap_rsl;        /* RSL files: map the file instead of reading it. */
+  int window;          /* 1 = ingest only the window below. */
+  float min_range, max_range; /* Window, km.  See RSL_read_window. */
+  float low_azim, hi_azim;    /* Window, degrees. */
+} Rsl_reader;
+
+/* Storage class for ingest scratch variables that must be private to
+ * each decoding thread.
+ */
+#ifndef RSL_THREAD_LOCAL
+# if defined(__GNUC__)
+# define RSL_THREAD_LOCAL __thread
+# elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+# define RSL_THREAD_LOCAL _Thread_local
+# else
+# define RSL_THREAD_LOCAL
+# endif
+#endif
+
+/*
+ * Random access to an RSL v2 file; see RSL_open_index.  The offsets
+ * are byte positions in the file, 0 for a missing object.
+ */
+typedef struct {
+  FILE *fp;
+  int swap;                 /* 1 = the file's byte order is not ours. */
+  int version;              /* File format version. */
+  Radar_header h;
+  int nvolumes;
+  int *nsweeps;             /* nsweeps[0..nvolumes-1]. */
+  int *sweep1;              /* Entry of volume i's first sweep in nrays,
+                             * ray1 and sweep_offset.
+                             */
+  int *nrays;               /* nrays[sweep1[i]+j] for sweep j of volume i. */
+  int *ray1;                /* Entry of a sweep's first ray in ray_offset. */
+  long long *volume_offset; /* volume_offset[0..nvolumes-1]. */
+  long long *sweep_offset;
+  long long *ray_offset;
+} Rsl_index;
+
+/* A WSR-88D volume read as it arrives; see RSL_wsr88d_stream_open. */
+typedef struct _rsl_wsr88d_stream Rsl_wsr88d_stream;
+
+/* The members of a tar archive, read in one pass; see RSL_tar_open. */
+typedef struct _rsl_tar Rsl_tar;
+
+/* Input to the format readers: a mapped file, a buffered stream or a
+ * block of memory.  See source.c.
+ */
+typedef struct _rsl_source Rsl_source;
+
+/*
+ * What RSL_probe finds in a radar file from its headers alone, without
+ * decoding the data.  Sweeps are listed as recorded in the file: WSR-88D
+ * split cuts are not merged.
+ */
+typedef struct {
+  float fix_angle;  /* Elevation (PPI) or azimuth (RHI) of the sweep. */
+  int   nrays;      /* Rays in the sweep. */
+  char  field[MAX_RADAR_VOLUMES]; /* 1 = field recorded in the sweep. */
+} Rsl_probe_sweep;
+
+typedef struct {
+  enum File_type type;
+  char  name[8];        /* Site, as in Radar_header. */
+  char  radar_type[50]; /* As in Radar_header. */
+  int   month, day, year, hour, minute;
+  float sec;            /* Start of the volume. */
+  float lat, lon;       /* Site, degrees. */
+  int   vcp;            /* WSR-88D Volume Coverage Pattern, else 0. */
+  char  field[MAX_RADAR_VOLUMES]; /* 1 = field recorded in some sweep. */
+  int   nsweeps;
+  Rsl_probe_sweep *sweep; /* sweep[0..nsweeps-1]. */
+  int   decoded;        /* 1 = there is no header reader for the format;
+                         * the summary is of the decoded radar.
+                         */
+} Rsl_probe;
+
+/*
+ * A catalog of radar files, kept on disk; see RSL_open_catalog.  Each
+ * volume is the probe of one radar file: the 'length' bytes at 'offset'
+ * in 'path'.
+ */
+typedef struct {
+  char *path;
+  long long offset, length;
+  long long size;     /* Size and modification time of path when */
+  long  mtime;        /* it was probed. */
+  long long start;    /* Start of the volume, seconds since 1970 UTC. */
+  Rsl_probe *probe;   /* NULL: not a radar file. */
+} Rsl_catalog_volume;
+
+typedef struct {
+  char *file;         /* The catalog file. */
+  int nvolumes;
+  Rsl_catalog_volume **volume; /* By site, then start; non-radar files last. */
+  int changed;        /* 1 = differs from the file. */
+} Rsl_catalog;
+
 /* Prototypes for functions. */
 /* Alphabetical and grouped by object returned. */
 
 
 Radar *RSL_africa_to_radar(char *infile);
 Radar *RSL_anyformat_to_radar(char *infile, ...);
+Radar *RSL_anyformat_to_radar_r(Rsl_reader *r, char *infile, ...);
 Radar *RSL_dorade_to_radar(char *infile);
 Radar *RSL_fix_radar_header(Radar *radar);
 Radar *RSL_get_window_from_radar(Radar *r, float min_range, float max_range,float low_azim, float hi_azim);
@@ -574,6 +757,85 @@ Radar *RSL_uf_to_radar(char *infile);
 Radar *RSL_uf_to_radar_fp(FILE *fp);
 Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file);
 
+/* Reader-context variants; see RSL_new_reader. */
+Radar *RSL_africa_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_dorade_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_lassen_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_mcgill_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_nsig_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_nsig2_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_radtec_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_rainbow_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_read_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_toga_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_uf_to_radar_r(Rsl_reader *r, char *infile);
+Radar *RSL_uf_to_radar_fp_r(Rsl_reader *r, FILE *fp);
+Radar *RSL_wsr88d_to_radar_r(Rsl_reader *r, char *infile, char *call_or_first_tape_file);
+
+/* Input from the 'len' bytes at 'buf', which may be gzip'd or bzip2'd. */
+Radar *RSL_anyformat_to_radar_mem(char *buf, size_t len, ...);
+Radar *RSL_anyformat_to_radar_mem_r(Rsl_reader *r, char *buf, size_t len, ...);
+Radar *RSL_dorade_to_radar_mem(char *buf, size_t len);
+Radar *RSL_lassen_to_radar_mem(char *buf, size_t len);
+Radar *RSL_mcgill_to_radar_mem(char *buf, size_t len);
+Radar *RSL_nsig_to_radar_mem(char *buf, size_t len);
+Radar *RSL_nsig2_to_radar_mem(char *buf, size_t len);
+Radar *RSL_rainbow_to_radar_mem(char *buf, size_t len);
+Radar *RSL_read_radar_mem(char *buf, size_t len);
+Radar *RSL_toga_to_radar_mem(char *buf, size_t len);
+Radar *RSL_uf_to_radar_mem(char *buf, size_t len);
+Radar *RSL_wsr88d_to_radar_mem(char *buf, size_t len, char *call_or_first_tape_file);
+
+/* Summaries of radar files from their headers; see RSL_probe. */
+Rsl_probe *RSL_probe(char *infile, ...);
+Rsl_probe *RSL_probe_mem(char *buf, size_t len, ...);
+void RSL_free_probe(Rsl_probe *p);
+
+/* Archive catalogs; see RSL_open_catalog. */
+Rsl_catalog *RSL_open_catalog(char *catfile);
+int RSL_catalog_add(Rsl_catalog *c, char *path, int nthreads);
+int RSL_write_catalog(Rsl_catalog *c);
+void RSL_free_catalog(Rsl_catalog *c);
+Rsl_catalog_volume **RSL_catalog_volumes(Rsl_catalog *c, char *site,
+                                         long long t0, long long t1,
+                                         int field, int *n);
+Rsl_catalog_volume *RSL_catalog_volume_at(Rsl_catalog *c, char *site,
+                                          long long t, int field);
+int RSL_catalog_sweep(Rsl_catalog_volume *v, int field,
+                      float elev, float limit);
+Radar *RSL_catalog_read(Rsl_catalog_volume *v, int isweep);
+long long RSL_catalog_time(int year, int month, int day,
+                           int hour, int minute, float sec);
+
+/* Tar archives; see RSL_tar_open. */
+Rsl_tar *RSL_tar_open(char *infile);
+int RSL_tar_next(Rsl_tar *t, char **name, char **buf, size_t *len);
+void RSL_tar_close(Rsl_tar *t);
+int RSL_tar_to_radar(char *infile, char *call_or_first_tape_file,
+                     int nthreads,
+                     int (*radar_done)(char *name, Radar *radar, void *arg),
+                     void *arg);
+int RSL_tar_to_radar_r(Rsl_reader *r, char *infile,
+                       char *call_or_first_tape_file, int nthreads,
+                       int (*radar_done)(char *name, Radar *radar, void *arg),
+                       void *arg);
+
+Rsl_reader *RSL_new_reader(void);
+void RSL_free_reader(Rsl_reader *r);
+void RSL_reader_select_fields(Rsl_reader *r, char *field_type, ...);
+void RSL_reader_read_these_sweeps(Rsl_reader *r, char *csweep, ...);
+void RSL_reader_verbose(Rsl_reader *r, int on);
+void RSL_reader_wsr88d_merge_split_cuts(Rsl_reader *r, int on);
+void RSL_reader_wsr88d_keep_sails(Rsl_reader *r, int on);
+void RSL_reader_mmap(Rsl_reader *r, int on);
+void RSL_reader_wsr88d_decode_threads(Rsl_reader *r, int nthreads);
+void RSL_reader_read_window(Rsl_reader *r, float min_range, float max_range,
+                            float low_azim, float hi_azim);
+void RSL_reader_read_window_off(Rsl_reader *r);
+void RSL_read_window(float min_range, float max_range,
+                     float low_azim, float hi_azim);
+void RSL_read_window_off(void);
+
 Volume *RSL_clear_volume(Volume *v);
 Volume *RSL_copy_volume(Volume *v);
 Volume *RSL_fix_volume_header(Volume *v);
@@ -582,6 +844,7 @@ Volume *RSL_get_window_from_volume(Volume *v, float min_range, float max_range,
 Volume *RSL_new_volume(int max_sweeps);
 Volume *RSL_prune_volume(Volume *v);
 Volume *RSL_read_volume(FILE *fp);
+Volume *RSL_read_volume_by_index(Rsl_index *idx, int field);
 Volume *RSL_reverse_sweep_order(Volume *v);
 Volume *RSL_sort_rays_in_volume(Volume *v);
 Volume *RSL_sort_sweeps_in_volume(Volume *v);
@@ -600,6 +863,7 @@ Sweep *RSL_get_window_from_sweep(Sweep *s, float min_range, float max_range, flo
 Sweep *RSL_new_sweep(int max_rays);
 Sweep *RSL_prune_sweep(Sweep *s);
 Sweep *RSL_read_sweep (FILE *fp);
+Sweep *RSL_read_sweep_by_index(Rsl_index *idx, int field, int isweep);
 Sweep *RSL_sort_rays_in_sweep(Sweep *s);
 Sweep *RSL_sort_rays_by_time(Sweep *s);
 Sweep *RSL_sweep_z_to_r(Sweep *z_sweep, float k, float a);
@@ -621,6 +885,7 @@ Ray *RSL_new_ray(int max_bins);
 Ray *RSL_prune_ray(Ray *ray);
 Ray *RSL_ray_z_to_r(Ray *z_ray, float k, float a);
 Ray *RSL_read_ray   (FILE *fp);
+Ray *RSL_read_ray_by_index(Rsl_index *idx, int field, int isweep, int iray);
 
 
 float RSL_area_of_ray(Ray *r, float lo, float hi, float min_range, float max_range);
@@ -638,22 +903,41 @@ float RSL_get_value_from_cappi(Cappi *cappi, float rng, float azm);
 float RSL_get_value_from_ray(Ray *ray, float r);
 float RSL_get_value_from_sweep(Sweep *s, float azim, float r);
 float RSL_z_to_r(float z, float k, float a);
+float *RSL_f_table(float (*f)(Range x));
+void RSL_f_table_forget(float (*f)(Range x));
 
 int RSL_fill_cappi(Volume *v, Cappi *cap, int method);
+int RSL_float_to_ray(float *in, int n, Ray *r);
 int RSL_get_ray_index_from_sweep(Sweep *s, float azim,int *next_closest);
 int RSL_get_sweep_index_from_volume(Volume *v, float elev,int *next_closest);
 int RSL_radar_to_hdf(Radar *radar, char *outfile);
+int RSL_radar_to_matrix(Radar *radar);
+int RSL_ray_to_float(Ray *r, float *out);
+int RSL_sweep_to_float(Sweep *s, float *out, int stride);
+int RSL_sweep_to_matrix(Sweep *s);
+int RSL_volume_to_matrix(Volume *v);
 int RSL_write_histogram(Histogram *histogram, char *outfile);
 int RSL_write_ray(Ray *r, FILE *fp);
 int RSL_write_sweep(Sweep *s, FILE *fp);
 int RSL_write_radar(Radar *radar, char *outfile);
 int RSL_write_radar_gzip(Radar *radar, char *outfile);
+long long RSL_write_radar_v2(Radar *radar, char *outfile);
 int RSL_write_volume(Volume *v, FILE *fp);
 
 unsigned char *RSL_rhi_sweep_to_cart(Sweep *s, int xdim, int ydim, float range, 
                                      int vert_scale);
 unsigned char *RSL_sweep_to_cart(Sweep *s, int xdim, int ydim, float range);
+unsigned char *RSL_sweep_to_cart_by_plan(Sweep *s, Cart_plan *plan);
 
+Range *RSL_sweep_matrix(Sweep *s, int *stride);
+
+Cart_plan *RSL_new_cart_plan(Sweep *s, int xdim, int ydim, float range);
+int RSL_cart_plan_fits(Cart_plan *plan, Sweep *s);
+
+Rsl_index *RSL_open_index(char *infile);
+
+void RSL_arena_begin(void);
+void RSL_arena_end(void);
 void RSL_add_dbz_offset_to_ray(Ray *r, float dbz_offset);
 void RSL_add_dbz_offset_to_sweep(Sweep *s, float dbz_offset);
 void RSL_add_dbz_offset_to_volume(Volume *v, float dbz_offset);
@@ -664,7 +948,9 @@ void RSL_find_rng_azm(float *r, float *ang, float x, float y);
 void RSL_fix_time (Ray *ray);
 void RSL_float_to_char(float *x, Range *c, int n);
 
+void RSL_close_index(Rsl_index *idx);
 void RSL_free_cappi(Cappi *c);
+void RSL_free_cart_plan(Cart_plan *plan);
 void RSL_free_carpi(Carpi *carpi);
 void RSL_free_cube(Cube *cube);
 void RSL_free_histogram(Histogram *histogram);
@@ -692,6 +978,8 @@ void RSL_print_histogram(Histogram *histogram, int min_range, int max_range,
 void RSL_print_version();
 void RSL_radar_to_uf(Radar *r, char *outfile);
 void RSL_radar_to_uf_gzip(Radar *r, char *outfile);
+void RSL_mmap_off(void);
+void RSL_mmap_on(void);
 void RSL_radar_verbose_off(void);
 void RSL_radar_verbose_on(void);
 void RSL_read_these_sweeps(char *csweep, ...);
@@ -758,7 +1046,13 @@ int no_command (char *cmd);
 FILE *uncompress_pipe (FILE *fp);
 FILE *compress_pipe (FILE *fp);
 int rsl_pclose(FILE *fp);
+FILE *rsl_unread(FILE *fp, char *buf, int n);
+FILE *rsl_fopen_reader(void *cookie,
+                       long (*read)(void *cookie, char *buf, size_t size),
+                       int  (*close)(void *cookie));
+long long rsl_tar_offset(Rsl_tar *t);
 enum File_type RSL_filetype(char *infile);
+enum File_type RSL_filetype_mem(char *buf, size_t len);
 
 /* Carpi image generation functions. These are modified clones of the
      corresponding sweep image generation functions.
@@ -776,6 +1070,9 @@ void RSL_carpi_to_pgm(Carpi *carpi, char *outfile, int xdim, int ydim,
 
 /* Internal storage conversion functions. These may be any conversion and
  * may be dynamically defined; based on the input data conversion.
+ * They must be pure, the same x always giving the same value: RSL
+ * tabulates them (see RSL_f_table).  A function whose conversion is
+ * redefined needs RSL_f_table_forget before it is used again.
  */
 float DZ_F(Range x);
 float VR_F(Range x);
@@ -888,10 +1185,59 @@ void swap_4_bytes(void *word);
 void swap_2_bytes(void *word);
 Hash_table *hash_table_for_sweep(Sweep *s);
 int hash_bin(Hash_table *table,float angle);
-Azimuth_hash *the_closest_hash(Azimuth_hash *hash, float ray_angle);
+int hash_closest(Hash_table *table, float angle);
+int hash_find_ray(Hash_table *table, Ray *ray);
+void FREE_HASH_TABLE(Hash_table *table);
+int get_closest_sweep_index(Volume *v,float sweep_angle);
+Ray **cappi_source_rays(Volume *v, Sweep *sweep);
+int cappi_fill(Volume *v, Cappi *cap, int method, Ray **src);
+Radar *rsl2_read_radar_fp(FILE *fp);
+Radar *rsl2_read_radar_indexed(FILE *fp, char *infile);
+Carpi_map *carpi_map(Sweep *sweep, float dx, float dy, int nx, int ny,
+                     int radar_x, int radar_y);
+Carpi *carpi_from_map(Cappi *cappi, Carpi_map *map, float lat, float lon);
+void free_carpi_map(Carpi_map *map);
 Hash_table *construct_sweep_hash_table(Sweep *s);
 double       angle_diff(float x, float y);
 int rsl_query_field(char *c_field);
+Rsl_reader *rsl_reader(void);
+Rsl_reader *rsl_reader_bind(Rsl_reader *r);
+void rsl_reader_sync(Rsl_reader *r);
+Rsl_reader *rsl_reader_copy(Rsl_reader *r);
+int rsl_verbose(void);
+int rsl_reader_is_verbose(Rsl_reader *r);
+int rsl_want_sweep(int isweep);
+int rsl_sweeps_done(int isweep);
+int rsl_want_azimuth(float azimuth);
+int rsl_window_bins(float range_bin1, float gate_size, int nbins, int *first);
+Rsl_block *rsl_new_block(void *addr, size_t len,
+                         void (*release)(Rsl_block *b));
+void rsl_block_ref(Rsl_block *b);
+void rsl_block_unref(Rsl_block *b);
+Rsl_source *rsl_source_open(char *infile);
+Rsl_source *rsl_source_fp(FILE *fp);
+Rsl_source *rsl_source_mem(char *buf, size_t len);
+Rsl_source *rsl_source_open_mem(char *buf, size_t len);
+FILE *rsl_mem_fopen(char *buf, size_t len);
+void rsl_source_close(Rsl_source *s);
+char *rsl_source_get(Rsl_source *s, size_t n);
+size_t rsl_source_read(void *ptr, size_t size, size_t nmemb, Rsl_source *s);
+int rsl_source_getc(Rsl_source *s);
+char *rsl_source_rest(Rsl_source *s, size_t *len);
+int rsl_source_skip(Rsl_source *s, size_t n);
+long long rsl_source_tell(Rsl_source *s);
+int rsl_source_seek(Rsl_source *s, long long off);
+int rsl_source_eof(Rsl_source *s);
+FILE *rsl_source_fopen(Rsl_source *s);
+Rsl_probe *rsl_new_probe(enum File_type type);
+Rsl_probe_sweep *rsl_probe_sweep(Rsl_probe *p, int isweep);
+Ray *rsl_arena_new_ray(int max_bins);
+int RSL_reserve_sweeps(Volume *v, int nsweeps);
+int RSL_reserve_rays(Sweep *s, int nrays);
+Radar *RSL_shrink_radar(Radar *radar);
+Volume *RSL_shrink_volume(Volume *v);
+Sweep *RSL_shrink_sweep(Sweep *s);
+void RSL_sweep_changed(Sweep *s);
 
 /* Functions to control the handling of WSR-88D split cuts. */
 void RSL_wsr88d_merge_split_cuts_on();
@@ -902,6 +1248,17 @@ int wsr88d_merge_split_cuts_is_set();
 Radar *wsr88d_merge_split_cuts(Radar *radar);
 void RSL_wsr88d_asis();
 void RSL_wsr88d_keep_sails();
+void RSL_wsr88d_decode_threads(int nthreads);
+
+Rsl_wsr88d_stream *RSL_wsr88d_stream_open(char *call_or_first_tape_file,
+          void (*sweep_done)(Radar *radar, int isweep, void *arg), void *arg);
+Rsl_wsr88d_stream *RSL_wsr88d_stream_open_r(Rsl_reader *r,
+          char *call_or_first_tape_file,
+          void (*sweep_done)(Radar *radar, int isweep, void *arg), void *arg);
+int RSL_wsr88d_stream_feed(Rsl_wsr88d_stream *s, char *buf, size_t len);
+Radar *RSL_wsr88d_stream_close(Rsl_wsr88d_stream *s);
+
+void RSL_cube_threads(int nthreads);
 
 /* Debugging prototypes. */
 void poke_around_volume(Volume *v);
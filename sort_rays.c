@@ -131,6 +131,7 @@ Sweep *RSL_sort_rays_in_sweep(Sweep *s)
 	   break;
 	 }
    }
+   RSL_sweep_changed(s);
 
    return s;
    }
@@ -154,6 +155,7 @@ Sweep *RSL_sort_rays_by_time(Sweep *s)
 	   break;
 	 }
    }
+   RSL_sweep_changed(s);
 
    return s;
    }
@@ -0,0 +1,410 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Byte sources.
+ *
+ * The format readers take their input from an Rsl_source rather than
+ * making small fread calls on a stream.  There are three kinds:
+ *
+ *   map  An uncompressed regular file, mapped into memory.
+ *   buf  Any stream (pipe, decompressing stream, stdin), read into a
+ *        large buffer that grows to hold the biggest request.
+ *   mem  A block of memory owned by the caller.
+ *
+ * rsl_source_get returns the next n bytes in place: for map and mem, a
+ * pointer into the input itself; for buf, into the buffer, valid until
+ * the next call on the source.  Slices are not to be written to.
+ * rsl_source_read copies, like fread.
+ *
+ *   Rsl_source *rsl_source_open(char *infile);
+ *   Rsl_source *rsl_source_fp(FILE *fp);
+ *   Rsl_source *rsl_source_mem(char *buf, size_t len);
+ *   Rsl_source *rsl_source_open_mem(char *buf, size_t len);
+ *   void rsl_source_close(Rsl_source *s);
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "rsl.h"
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define RSL_MMAP_SOURCE 1
+#endif
+
+#define RSL_SOURCE_BUFSIZ (1 << 20) /* Smallest read into a buf source. */
+
+enum {RSL_SOURCE_MAP, RSL_SOURCE_BUF, RSL_SOURCE_MEM};
+
+struct _rsl_source {
+  int kind;        /* RSL_SOURCE_MAP, RSL_SOURCE_BUF or RSL_SOURCE_MEM. */
+  char *data;      /* The input, or for buf, the buffer. */
+  size_t len;      /* Bytes in data. */
+  size_t pos;      /* Next byte of data to hand out. */
+  long long base;  /* Offset in the input of data[0]. */
+  size_t size;     /* buf: bytes allocated for data.  map: bytes mapped. */
+  FILE *fp;        /* buf: the stream read from.  Owned by the source. */
+  int eof;         /* A request came up short. */
+};
+
+/**********************************************************************/
+/*                                                                    */
+/*                   rsl_source_mem, rsl_source_fp                    */
+/*                                                                    */
+/**********************************************************************/
+Rsl_source *rsl_source_mem(char *buf, size_t len)
+{
+  /* 'buf' is not copied; keep it until the source is closed. */
+  Rsl_source *s;
+
+  s = (Rsl_source *)calloc(1, sizeof(Rsl_source));
+  if (s == NULL) {
+	perror("rsl_source_mem");
+	return NULL;
+  }
+  s->kind = RSL_SOURCE_MEM;
+  s->data = buf;
+  s->len = len;
+  return s;
+}
+
+Rsl_source *rsl_source_fp(FILE *fp)
+{
+  /* Read 'fp' from where it is now.  The source owns 'fp', and closes
+   * it with rsl_pclose.  Plain files are mapped when possible.
+   */
+  Rsl_source *s;
+#ifdef RSL_MMAP_SOURCE
+  struct stat st;
+  void *addr;
+  long pos;
+  int fd;
+#endif
+
+  if (fp == NULL) return NULL;
+  s = (Rsl_source *)calloc(1, sizeof(Rsl_source));
+  if (s == NULL) {
+	perror("rsl_source_fp");
+	rsl_pclose(fp);
+	return NULL;
+  }
+
+#ifdef RSL_MMAP_SOURCE
+  /* Decompressing streams have no descriptor, and pipes are not
+   * regular files; both are buffered below.
+   */
+  fd = fileno(fp);
+  pos = ftell(fp);
+  if (fd >= 0 && pos >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+	  st.st_size > pos) {
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr != MAP_FAILED) {
+	  s->kind = RSL_SOURCE_MAP;
+	  s->data = (char *)addr;
+	  s->len = st.st_size;
+	  s->size = st.st_size;
+	  s->pos = pos;
+	  rsl_pclose(fp);
+	  return s;
+	}
+  }
+#endif
+
+  s->kind = RSL_SOURCE_BUF;
+  s->fp = fp;
+  return s;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        rsl_source_open                             */
+/*                                                                    */
+/*  Open 'infile', or stdin when 'infile' is NULL, decompressing it   */
+/*  as need be.  Returns NULL, with a message, when it can't be read. */
+/*                                                                    */
+/**********************************************************************/
+Rsl_source *rsl_source_open(char *infile)
+{
+  FILE *fp;
+  int save_fd;
+
+  if (infile == NULL) {
+	save_fd = dup(0);
+	fp = fdopen(save_fd, "r");
+  } else
+	fp = fopen(infile, "r");
+  if (fp == NULL) {
+	perror(infile ? infile : "stdin");
+	return NULL;
+  }
+  return rsl_source_fp(uncompress_pipe(fp)); /* Transparently gunzip. */
+}
+
+void rsl_source_close(Rsl_source *s)
+{
+  if (s == NULL) return;
+  switch (s->kind) {
+  case RSL_SOURCE_BUF:
+	free(s->data);
+	rsl_pclose(s->fp);
+	break;
+#ifdef RSL_MMAP_SOURCE
+  case RSL_SOURCE_MAP:
+	(void)munmap(s->data, s->size);
+	break;
+#endif
+  }
+  free(s);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                 rsl_mem_fopen, rsl_source_open_mem                 */
+/*                                                                    */
+/*  Input from memory, for the *_to_radar_mem routines.  'buf' is     */
+/*  not copied; keep it until the stream or source is closed.         */
+/*                                                                    */
+/**********************************************************************/
+FILE *rsl_mem_fopen(char *buf, size_t len)
+{
+  /* A stdio stream reading 'buf', for readers that take a FILE.  It is
+   * not decompressed; use uncompress_pipe for that.  Close it with
+   * rsl_pclose.
+   */
+  Rsl_source *s;
+  FILE *fp;
+
+  if ((s = rsl_source_mem(buf, len)) == NULL) return NULL;
+  if ((fp = rsl_source_fopen(s)) == NULL) {
+	fprintf(stderr, "rsl_mem_fopen: Unable to read from memory; "
+			"the C library has neither fopencookie nor funopen.\n");
+	rsl_source_close(s);
+  }
+  return fp;
+}
+
+Rsl_source *rsl_source_open_mem(char *buf, size_t len)
+{
+  /* As rsl_source_open.  Uncompressed input is read in place; gzip and
+   * bzip2 input is decoded as it is read.
+   */
+  unsigned char *m = (unsigned char *)buf;
+  FILE *fp;
+
+  if ((len >= 2 && m[0] == 0x1f && m[1] == 0x8b) ||
+	  (len >= 3 && m[0] == 'B' && m[1] == 'Z' && m[2] == 'h')) {
+	if ((fp = rsl_mem_fopen(buf, len)) == NULL) return NULL;
+	return rsl_source_fp(uncompress_pipe(fp));
+  }
+  return rsl_source_mem(buf, len);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         source_fill                                */
+/*                                                                    */
+/*  buf sources: have at least 'n' bytes at data+pos if the input has */
+/*  them.  Returns the number available.                              */
+/*                                                                    */
+/**********************************************************************/
+static size_t source_fill(Rsl_source *s, size_t n)
+{
+  size_t want, size, got;
+  char *p;
+
+  if (s->len - s->pos >= n || s->kind != RSL_SOURCE_BUF || s->fp == NULL)
+	return s->len - s->pos;
+
+  /* Slide what is left to the front, then read at least a buffer full. */
+  if (s->pos > 0) {
+	memmove(s->data, s->data + s->pos, s->len - s->pos);
+	s->base += s->pos;
+	s->len -= s->pos;
+	s->pos = 0;
+  }
+  want = n > RSL_SOURCE_BUFSIZ ? n : RSL_SOURCE_BUFSIZ;
+  if (want > s->size) {
+	size = s->size ? s->size : RSL_SOURCE_BUFSIZ;
+	while (size < want) size *= 2;
+	if ((p = (char *)realloc(s->data, size)) == NULL) {
+	  perror("rsl_source");
+	  return s->len;
+	}
+	s->data = p;
+	s->size = size;
+  }
+  while (s->len < n) {
+	got = fread(s->data + s->len, 1, s->size - s->len, s->fp);
+	if (got == 0) break;
+	s->len += got;
+  }
+  return s->len;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                 rsl_source_get, rsl_source_read                    */
+/*                                                                    */
+/**********************************************************************/
+char *rsl_source_get(Rsl_source *s, size_t n)
+{
+  /* The next 'n' bytes, in place.  When fewer are left, they are
+   * consumed, eof is set and NULL is returned, as fread would.
+   */
+  char *p;
+
+  if (source_fill(s, n) < n) {
+	s->pos = s->len;
+	s->eof = 1;
+	return NULL;
+  }
+  p = s->data + s->pos;
+  s->pos += n;
+  return p;
+}
+
+size_t rsl_source_read(void *ptr, size_t size, size_t nmemb, Rsl_source *s)
+{
+  /* fread on a source. */
+  size_t n, have;
+
+  if (size == 0 || nmemb == 0) return 0;
+  n = size * nmemb;
+  have = source_fill(s, n);
+  if (have < n) {
+	s->eof = 1;
+	n = have - have % size;
+  }
+  memcpy(ptr, s->data + s->pos, n);
+  s->pos += n;
+  if (s->eof) s->pos = s->len;
+  return n / size;
+}
+
+int rsl_source_getc(Rsl_source *s)
+{
+  unsigned char *p;
+
+  if ((p = (unsigned char *)rsl_source_get(s, 1)) == NULL) return EOF;
+  return *p;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         rsl_source_rest                            */
+/*                                                                    */
+/*  All of the input not yet read, in place, for parsers that want    */
+/*  the whole file in memory.  buf sources read it all in first.      */
+/*                                                                    */
+/**********************************************************************/
+char *rsl_source_rest(Rsl_source *s, size_t *len)
+{
+  size_t n;
+
+  for (n = s->len - s->pos; s->kind == RSL_SOURCE_BUF; n *= 2) {
+	if (n < RSL_SOURCE_BUFSIZ) n = RSL_SOURCE_BUFSIZ;
+	if (source_fill(s, n) < n) break;
+  }
+  *len = s->len - s->pos;
+  return s->data + s->pos;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*        rsl_source_skip, rsl_source_seek, rsl_source_tell,          */
+/*                         rsl_source_eof                             */
+/*                                                                    */
+/**********************************************************************/
+int rsl_source_skip(Rsl_source *s, size_t n)
+{
+  /* Returns 1, or 0 when the input ends first. */
+  size_t k;
+
+  while (n > 0) {
+	k = n < RSL_SOURCE_BUFSIZ ? n : RSL_SOURCE_BUFSIZ;
+	if (rsl_source_get(s, k) == NULL) return 0;
+	n -= k;
+  }
+  return 1;
+}
+
+long long rsl_source_tell(Rsl_source *s)
+{
+  return s->base + s->pos;
+}
+
+int rsl_source_seek(Rsl_source *s, long long off)
+{
+  /* Move to byte 'off' of the input.  buf sources go back only within
+   * the buffer, unless the stream can seek.  Returns 0, or -1.
+   */
+  s->eof = 0;
+  if (off >= s->base && off <= s->base + (long long)s->len) {
+	s->pos = off - s->base;
+	return 0;
+  }
+  if (s->kind != RSL_SOURCE_BUF || off < 0) return -1;
+  if (off > s->base + (long long)s->len) {
+	s->pos = s->len;
+	return rsl_source_skip(s, off - rsl_source_tell(s)) ? 0 : -1;
+  }
+  if (fseek(s->fp, (long)off, SEEK_SET) != 0) return -1;
+  s->base = off;
+  s->len = s->pos = 0;
+  return 0;
+}
+
+int rsl_source_eof(Rsl_source *s)
+{
+  /* As feof: 1 once a request has come up short. */
+  return s->eof;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        rsl_source_fopen                            */
+/*                                                                    */
+/*  A stdio stream that reads the rest of 's', for code that wants a  */
+/*  FILE.  The stream owns 's'; close it with rsl_pclose.  NULL when  */
+/*  the C library can't make one.                                     */
+/*                                                                    */
+/**********************************************************************/
+static long source_cookie_read(void *cookie, char *buf, size_t size)
+{
+  return rsl_source_read(buf, 1, size, (Rsl_source *)cookie);
+}
+
+static int source_cookie_close(void *cookie)
+{
+  rsl_source_close((Rsl_source *)cookie);
+  return 0;
+}
+
+FILE *rsl_source_fopen(Rsl_source *s)
+{
+  return rsl_fopen_reader(s, source_cookie_read, source_cookie_close);
+}
@@ -0,0 +1,166 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Gate matrices.
+ *
+ * RSL_sweep_to_matrix moves the gates of a sweep into one array,
+ * gates[i*stride + j] being ray[i]->range[j].  Each Ray's range points
+ * into its row, so code that goes ray by ray is unaffected, while code
+ * that wants the whole sweep gets it from RSL_sweep_matrix.
+ *
+ * The array is an Rsl_block held by the sweep and by each of its rays;
+ * it goes with the last of them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rsl.h"
+
+#define RSL_MATRIX_ALIGN 32 /* Bytes.  Each row starts on this boundary. */
+
+static void matrix_release(Rsl_block *b)
+{
+  free(b->addr);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_sweep_matrix                            */
+/*                                                                    */
+/*  Return the gate matrix of 's', and its stride, or NULL when 's'   */
+/*  has none or a ray has been replaced since RSL_sweep_to_matrix.    */
+/*                                                                    */
+/**********************************************************************/
+Range *RSL_sweep_matrix(Sweep *s, int *stride)
+{
+  Range *gates;
+  Ray *r;
+  int i;
+
+  if (s == NULL || s->gates == NULL) return NULL;
+  gates = (Range *)s->gates->addr;
+  for (i=0; i<s->h.nrays; i++) {
+	if ((r = s->ray[i]) == NULL) continue;
+	if (r->range != gates + (size_t)i*s->stride || r->block != s->gates ||
+		r->h.nbins > s->stride)
+	  return NULL;
+  }
+  if (stride) *stride = s->stride;
+  return gates;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                       RSL_sweep_to_matrix                          */
+/*                       RSL_volume_to_matrix                         */
+/*                       RSL_radar_to_matrix                          */
+/*                                                                    */
+/*  Move the gates of each sweep into a gate matrix.  Rays that came  */
+/*  from an arena are replaced.  Returns 1 on success, 0 when memory  */
+/*  runs out.                                                         */
+/*                                                                    */
+/**********************************************************************/
+int RSL_sweep_to_matrix(Sweep *s)
+{
+  Rsl_block *b;
+  Range *gates;
+  Ray *r, *nr;
+  size_t size;
+  int i, stride, per_row, ok;
+
+  if (s == NULL) return 0;
+  if (RSL_sweep_matrix(s, NULL)) return 1; /* Already. */
+
+  /* Rows hold the longest ray, rounded to whole RSL_MATRIX_ALIGN. */
+  stride = 0;
+  for (i=0; i<s->h.nrays; i++)
+	if (s->ray[i] && s->ray[i]->h.nbins > stride) stride = s->ray[i]->h.nbins;
+  per_row = RSL_MATRIX_ALIGN / sizeof(Range);
+  stride = (stride + per_row-1) / per_row * per_row;
+  if (stride == 0) stride = per_row;
+
+  size = (size_t)s->h.nrays * stride * sizeof(Range);
+  if (size == 0) size = RSL_MATRIX_ALIGN;
+  if (posix_memalign((void **)&gates, RSL_MATRIX_ALIGN, size) != 0) {
+	perror("RSL_sweep_to_matrix");
+	return 0;
+  }
+  memset(gates, 0, size);
+  if ((b = rsl_new_block(gates, size, matrix_release)) == NULL) {
+	free(gates);
+	return 0;
+  }
+
+  ok = 1;
+  for (i=0; i<s->h.nrays; i++) {
+	if ((r = s->ray[i]) == NULL) continue;
+	memcpy(gates + (size_t)i*stride, r->range, r->h.nbins*sizeof(Range));
+	if (r->block && r->block->holds_rays) {
+	  /* An arena's Ray; it can't be kept without the arena. */
+	  if ((nr = (Ray *)calloc(1, sizeof(Ray))) == NULL) {
+		perror("RSL_sweep_to_matrix");
+		ok = 0;
+		continue; /* Stays as it was. */
+	  }
+	  nr->h = r->h;
+	  RSL_free_ray(r);
+	  s->ray[i] = r = nr;
+	  RSL_sweep_changed(s); /* The hash points at the old ray. */
+	} else if (r->block) {
+	  rsl_block_unref(r->block);
+	} else if (r->range) {
+	  free(r->range);
+	}
+	r->range = gates + (size_t)i*stride;
+	r->block = b;
+	rsl_block_ref(b);
+  }
+
+  rsl_block_unref(s->gates);
+  s->gates = b;  /* The sweep keeps the creator's reference. */
+  s->stride = stride;
+  return ok;
+}
+
+int RSL_volume_to_matrix(Volume *v)
+{
+  int i, ok;
+
+  if (v == NULL) return 0;
+  ok = 1;
+  for (i=0; i<v->h.nsweeps; i++)
+	if (v->sweep[i] && !RSL_sweep_to_matrix(v->sweep[i])) ok = 0;
+  return ok;
+}
+
+int RSL_radar_to_matrix(Radar *radar)
+{
+  int i, ok;
+
+  if (radar == NULL) return 0;
+  ok = 1;
+  for (i=0; i<radar->h.nvolumes; i++)
+	if (radar->v[i] && !RSL_volume_to_matrix(radar->v[i])) ok = 0;
+  return ok;
+}
@@ -0,0 +1,489 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Tar archive ingest.
+ *
+ * The members of a tar archive, plain, gzipped or bzipped, are read in
+ * one pass over the stream, each into memory, and decoded there with
+ * RSL_anyformat_to_radar_mem.  Nothing is extracted to disk.  ustar,
+ * GNU long names and pax path records are understood.
+ *
+ *   Rsl_tar *RSL_tar_open(char *infile);
+ *   int      RSL_tar_next(Rsl_tar *t, char **name, char **buf, size_t *len);
+ *   void     RSL_tar_close(Rsl_tar *t);
+ *
+ *   int RSL_tar_to_radar(char *infile, char *call_or_first_tape_file,
+ *            int nthreads,
+ *            int (*radar_done)(char *name, Radar *radar, void *arg),
+ *            void *arg);
+ *
+ * RSL_tar_to_radar decodes on 'nthreads' threads while the calling
+ * thread reads ahead, at most two members per thread, and hands the
+ * radars back in archive order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rsl.h"
+
+#define TAR_BLOCK 512
+#define TAR_MAX_THREADS 64
+
+struct _rsl_tar {
+  FILE *fp;                  /* The archive, uncompressed. */
+  char *name;                /* Of the last member returned. */
+  char *longname;            /* From a GNU 'L' or pax 'x' header, for */
+                             /* the next member. */
+  int done;                  /* 1 = end of archive, -1 = error. */
+  int compressed;            /* The file is gzip or bzip2. */
+  long long pos;             /* Bytes of the archive read. */
+  long long offset;          /* Of the last member's data. */
+};
+
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_tar_open, RSL_tar_close                    */
+/*                                                                    */
+/**********************************************************************/
+Rsl_tar *RSL_tar_open(char *infile)
+{
+  /* Open the archive 'infile', or stdin when it is NULL.  gzip and
+   * bzip2 archives are decompressed as they are read.
+   */
+  Rsl_tar *t;
+  FILE *fp;
+
+  if (infile == NULL) fp = fdopen(dup(0), "r");
+  else if ((fp = fopen(infile, "r")) == NULL) {
+	perror(infile);
+	return NULL;
+  }
+  if (fp == NULL) {
+	perror("RSL_tar_open");
+	return NULL;
+  }
+  if ((t = (Rsl_tar *)calloc(1, sizeof(Rsl_tar))) == NULL) {
+	perror("RSL_tar_open");
+	fclose(fp);
+	return NULL;
+  }
+  t->fp = uncompress_pipe(fp); /* Transparently gunzip. */
+  t->compressed = t->fp != fp;
+  return t;
+}
+
+void RSL_tar_close(Rsl_tar *t)
+{
+  if (t == NULL) return;
+  rsl_pclose(t->fp);
+  free(t->name);
+  free(t->longname);
+  free(t);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                           RSL_tar_next                             */
+/*                                                                    */
+/**********************************************************************/
+static long long tar_number(unsigned char *field, int size)
+{
+  /* An octal field, or base-256 when the high bit is set (GNU). */
+  long long n;
+  int i;
+
+  n = 0;
+  if (field[0] & 0x80) {
+	n = field[0] & 0x3f;
+	for (i=1; i<size; i++) n = (n << 8) | field[i];
+	return (field[0] & 0x40) ? -1 : n; /* Negative: invalid here. */
+  }
+  for (i=0; i<size && field[i] == ' '; i++);
+  for (; i<size && field[i] >= '0' && field[i] <= '7'; i++)
+	n = n * 8 + (field[i] - '0');
+  return n;
+}
+
+static int tar_checksum_ok(unsigned char *h)
+{
+  /* The checksum counts its own field as blanks.  Some old tars summed
+   * signed chars, so accept either.
+   */
+  long long want;
+  long usum, ssum;
+  int i;
+
+  want = tar_number(h + 148, 8);
+  usum = ssum = 8 * ' ';
+  for (i=0; i<TAR_BLOCK; i++) {
+	if (i >= 148 && i < 156) continue;
+	usum += h[i];
+	ssum += (signed char)h[i];
+  }
+  return want == usum || want == ssum;
+}
+
+static char *tar_data(Rsl_tar *t, long long size)
+{
+  /* Read 'size' bytes of member data and the padding after them.  Also
+   * used to skip data: the result is then freed by the caller.
+   */
+  char *buf;
+  long long padded;
+
+  padded = (size + TAR_BLOCK-1) / TAR_BLOCK * TAR_BLOCK;
+  if ((size_t)padded != padded ||
+	  (buf = (char *)malloc(padded > 0 ? padded : 1)) == NULL) {
+	perror("RSL_tar_next");
+	return NULL;
+  }
+  if (fread(buf, 1, padded, t->fp) != (size_t)padded) {
+	fprintf(stderr, "RSL_tar_next: Archive is truncated.\n");
+	free(buf);
+	return NULL;
+  }
+  t->pos += padded;
+  return buf;
+}
+
+static char *pax_path(char *rec, long long size)
+{
+  /* The 'path' of pax records "len path=value\n", or NULL. */
+  char *p, *end, *key;
+  long len;
+
+  for (p = rec; p < rec + size; p += len) {
+	len = strtol(p, &key, 10);
+	if (len <= 0 || p + len > rec + size || *key != ' ') break;
+	key++;
+	end = p + len - 1; /* The newline. */
+	if (end - key > 5 && strncmp(key, "path=", 5) == 0) {
+	  *end = '\0';
+	  return strdup(key + 5);
+	}
+  }
+  return NULL;
+}
+
+int RSL_tar_next(Rsl_tar *t, char **name, char **buf, size_t *len)
+{
+  /* Read the next regular file of the archive into memory.  *buf, which
+   * the caller frees, gets its 'len' bytes; *name, good until the next
+   * call, its path in the archive.  Directories, links and the like are
+   * passed over.  Returns 1, 0 at the end of the archive, or -1 on error.
+   */
+  unsigned char h[TAR_BLOCK];
+  char *data, *path;
+  long long size;
+  int i, type;
+
+  *buf = NULL;
+  *len = 0;
+  while (t->done == 0) {
+	if (fread(h, 1, TAR_BLOCK, t->fp) != TAR_BLOCK) {
+	  /* No end-of-archive blocks; tar accepts that, and so do we. */
+	  t->done = ferror(t->fp) ? -1 : 1;
+	  break;
+	}
+	t->pos += TAR_BLOCK;
+	for (i=0; i<TAR_BLOCK && h[i] == 0; i++);
+	if (i == TAR_BLOCK) {    /* A zero block ends the archive. */
+	  t->done = 1;
+	  break;
+	}
+	if (!tar_checksum_ok(h)) {
+	  fprintf(stderr, "RSL_tar_next: Not a tar archive, or damaged.\n");
+	  t->done = -1;
+	  break;
+	}
+	size = tar_number(h + 124, 12);
+	type = h[156];
+	if (size < 0 || (type && strchr("123456", type))) size = 0; /* No data. */
+	t->offset = t->pos;
+	if ((data = tar_data(t, size)) == NULL) {
+	  t->done = -1;
+	  break;
+	}
+
+	if (type == 'L' || type == 'x') {
+	  /* The name of the next member. */
+	  if (type == 'L') {
+		data[size > 0 ? size-1 : 0] = '\0';
+		path = strdup(data);
+	  } else path = pax_path(data, size);
+	  free(data);
+	  if (path) {
+		free(t->longname);
+		t->longname = path;
+	  }
+	  continue;
+	}
+	if (type != '0' && type != '\0' && type != '7') { /* Not a file. */
+	  free(data);
+	  free(t->longname);
+	  t->longname = NULL;
+	  continue;
+	}
+
+	/* A regular file.  Its name: the long name, else prefix/name. */
+	free(t->name);
+	if (t->longname) {
+	  t->name = t->longname;
+	  t->longname = NULL;
+	} else if ((t->name = (char *)malloc(257)) != NULL) {
+	  if (strncmp((char *)h + 257, "ustar", 5) == 0 && h[345])
+		snprintf(t->name, 257, "%.155s/%.100s", (char *)h + 345, (char *)h);
+	  else
+		snprintf(t->name, 257, "%.100s", (char *)h);
+	}
+	if (t->name == NULL) {
+	  perror("RSL_tar_next");
+	  free(data);
+	  t->done = -1;
+	  break;
+	}
+	*name = t->name;
+	*buf = data;
+	*len = size;
+	return 1;
+  }
+  return t->done < 0 ? -1 : 0;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                          rsl_tar_offset                            */
+/*                                                                    */
+/*  Where, in the archive file, the data of the member last returned  */
+/*  by RSL_tar_next begins; -1 for a compressed archive, whose        */
+/*  members can't be reached by seeking.  Used by the catalogs.       */
+/*                                                                    */
+/**********************************************************************/
+long long rsl_tar_offset(Rsl_tar *t)
+{
+  return t->compressed ? -1 : t->offset;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                RSL_tar_to_radar, RSL_tar_to_radar_r                */
+/*                                                                    */
+/**********************************************************************/
+typedef struct {
+  char *name;
+  char *buf;                 /* The member, until decoded. */
+  size_t len;
+  char call[5];              /* ICAO of a WSR-88D volume header. */
+  Radar *radar;
+  int decoded;
+} Tar_slot;
+
+typedef struct {
+  Rsl_reader *reader;
+  char *call;                /* call_or_first_tape_file */
+  Tar_slot *slot;            /* Members read and not yet handed back, */
+  int nslots;                /* slot[head % nslots] on. */
+  int tail;                  /* Members queued. */
+  int next;                  /* Next member to decode. */
+  int eof, quit;
+  pthread_mutex_t lock;
+  pthread_cond_t queued, decoded;
+} Tar_job;
+
+static void tar_decode(Tar_job *job, Tar_slot *s)
+{
+  char *call;
+
+  call = job->call;
+  if (call == NULL || *call == '\0') call = s->call;
+  s->radar = RSL_anyformat_to_radar_mem_r(job->reader, s->buf, s->len, call);
+  free(s->buf);
+  s->buf = NULL;
+}
+
+static void *tar_worker(void *arg)
+{
+  Tar_job *job = (Tar_job *)arg;
+  Tar_slot *s;
+
+  pthread_mutex_lock(&job->lock);
+  for (;;) {
+	while (job->next == job->tail && !job->eof && !job->quit)
+	  pthread_cond_wait(&job->queued, &job->lock);
+	if (job->quit || job->next == job->tail) break;
+	s = &job->slot[job->next++ % job->nslots];
+	pthread_mutex_unlock(&job->lock);
+	tar_decode(job, s);
+	pthread_mutex_lock(&job->lock);
+	s->decoded = 1;
+	pthread_cond_signal(&job->decoded);
+  }
+  pthread_mutex_unlock(&job->lock);
+  return NULL;
+}
+
+static int tar_queue(Tar_job *job, Tar_slot *s, char *name,
+					 char *buf, size_t len)
+{
+  /* Fill s with the member, if it is a radar file.  Returns 1 if so. */
+  Rsl_source *src;
+  enum File_type type;
+  char *h;
+
+  type = RSL_filetype_mem(buf, len);
+  if (type == UNKNOWN) return 0;  /* README, checksums, ... */
+  memset(s, 0, sizeof(Tar_slot));
+  if ((s->name = strdup(name)) == NULL) {
+	perror("RSL_tar_to_radar");
+	return -1;
+  }
+  s->buf = buf;
+  s->len = len;
+  if (type == WSR88D_FILE && (src = rsl_source_open_mem(buf, len)) != NULL) {
+	/* For the site, when the caller does not name it. */
+	if ((h = rsl_source_get(src, 24)) != NULL) memcpy(s->call, h + 20, 4);
+	rsl_source_close(src);
+  }
+  return 1;
+}
+
+int RSL_tar_to_radar_r(Rsl_reader *r, char *infile,
+					   char *call_or_first_tape_file, int nthreads,
+					   int (*radar_done)(char *name, Radar *radar, void *arg),
+					   void *arg)
+{
+  /* Decode each radar file of the archive 'infile' (stdin when NULL)
+   * with the settings of 'r', and pass it to radar_done, in archive
+   * order, on the calling thread.  radar_done owns the radar, which is
+   * NULL if the member could not be decoded; it returns nonzero to stop.
+   * Members that are not radar files are passed over.
+   * call_or_first_tape_file is as for RSL_anyformat_to_radar; when it is
+   * NULL or "", each WSR-88D volume is named by the ICAO of its header.
+   * With nthreads > 1, members are decoded on that many threads while
+   * this one reads ahead, holding at most 2*nthreads members.
+   * Returns the number of radars passed, or -1 on error.
+   */
+  Rsl_tar *t;
+  Tar_job job;
+  Tar_slot *s;
+  pthread_t threads[TAR_MAX_THREADS];
+  char *name, *buf;
+  size_t len;
+  int head, ndone, stop, rc, i, nworkers;
+
+  if ((t = RSL_tar_open(infile)) == NULL) return -1;
+  if (nthreads > TAR_MAX_THREADS) nthreads = TAR_MAX_THREADS;
+  if (nthreads < 1) nthreads = 1;
+
+  memset(&job, 0, sizeof(job));
+  job.reader = r;
+  job.call = call_or_first_tape_file;
+  job.nslots = nthreads > 1 ? 2 * nthreads : 1;
+  job.slot = (Tar_slot *)calloc(job.nslots, sizeof(Tar_slot));
+  if (job.slot == NULL) {
+	perror("RSL_tar_to_radar");
+	RSL_tar_close(t);
+	return -1;
+  }
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.queued, NULL);
+  pthread_cond_init(&job.decoded, NULL);
+  nworkers = 0;
+  if (nthreads > 1)
+	for (; nworkers<nthreads; nworkers++)
+	  if (pthread_create(&threads[nworkers], NULL, tar_worker, &job) != 0)
+		break;
+
+  head = ndone = stop = rc = 0;
+  while (!stop) {
+	/* Read ahead while there is room. */
+	if (!job.eof && job.tail - head < job.nslots) {
+	  s = &job.slot[job.tail % job.nslots];
+	  i = RSL_tar_next(t, &name, &buf, &len);
+	  if (i > 0 && (i = tar_queue(&job, s, name, buf, len)) <= 0) {
+		free(buf);
+		if (i == 0) continue;  /* Not a radar file. */
+	  }
+	  if (i <= 0) rc = i;
+	  pthread_mutex_lock(&job.lock);
+	  if (i > 0) job.tail++;
+	  else job.eof = 1;
+	  pthread_cond_broadcast(&job.queued);
+	  pthread_mutex_unlock(&job.lock);
+	  if (nworkers == 0 && i > 0) {
+		tar_decode(&job, s);
+		s->decoded = 1;
+		job.next++;
+	  }
+	  if (nworkers > 0 && !job.eof && job.tail - head < job.nslots)
+		continue;
+	}
+
+	/* Hand back the next member once decoded. */
+	if (head == job.tail) break;  /* and eof. */
+	s = &job.slot[head % job.nslots];
+	pthread_mutex_lock(&job.lock);
+	while (!s->decoded && (job.eof || job.tail - head == job.nslots))
+	  pthread_cond_wait(&job.decoded, &job.lock);
+	i = s->decoded;
+	pthread_mutex_unlock(&job.lock);
+	if (!i) continue;  /* Read more meanwhile. */
+	head++;
+	ndone++;
+	stop = radar_done(s->name, s->radar, arg);
+	free(s->name);
+	memset(s, 0, sizeof(Tar_slot));
+  }
+
+  pthread_mutex_lock(&job.lock);
+  job.quit = 1;
+  pthread_cond_broadcast(&job.queued);
+  pthread_mutex_unlock(&job.lock);
+  for (i=0; i<nworkers; i++)
+	pthread_join(threads[i], NULL);
+  for (; head<job.tail; head++) {  /* Stopped early. */
+	s = &job.slot[head % job.nslots];
+	if (s->radar) RSL_free_radar(s->radar);
+	free(s->buf);
+	free(s->name);
+  }
+  pthread_cond_destroy(&job.decoded);
+  pthread_cond_destroy(&job.queued);
+  pthread_mutex_destroy(&job.lock);
+  free(job.slot);
+  RSL_tar_close(t);
+  return rc < 0 ? -1 : ndone;
+}
+
+int RSL_tar_to_radar(char *infile, char *call_or_first_tape_file,
+					 int nthreads,
+					 int (*radar_done)(char *name, Radar *radar, void *arg),
+					 void *arg)
+{
+  /* As RSL_tar_to_radar_r, with the settings of this thread's reader. */
+  return RSL_tar_to_radar_r(rsl_reader(), infile, call_or_first_tape_file,
+							nthreads, radar_done, arg);
+}
@@ -65,6 +65,7 @@
 #include <fcntl.h>
 #include <stdlib.h>
 
+#include "rsl.h"
 #include "toga.h"
 
 #ifdef USE_PLOG
@@ -75,6 +76,8 @@
 void swab(const void *from, void *to, size_t n);
 #endif
 int tg_open(char *,tg_file_str *);
+int tg_open_src(Rsl_source *,tg_file_str *);
+void tg_close(tg_file_str *);
 int tg_read_map_head(tg_file_str *);
 float tg_make_ang(unsigned short);
 int tg_read_map_bytes(tg_file_str *,void *,int);
@@ -84,25 +87,28 @@ void tg_decode_ray_data(tg_file_str *,short *);
 int tg_read_ray(tg_file_str *);
 void tg_prt_head(tg_map_head_str *,int);
 
-FILE *uncompress_pipe (FILE *fp);
 
 
 int tg_open(char *filename,tg_file_str *tg_file)
    {
-   /* open the toga data file */
-   if (filename == NULL) tg_file->fd = STDIN_FILENO; /* Stdin */
-   else 
-	 if ((tg_file->fd=open(filename,O_RDONLY)) == -1)
-	   {
+   /* open the toga data file, or stdin when filename is NULL.
+	  Transparently gunzip.  Close with tg_close. */
+   return(tg_open_src(rsl_source_open(filename),tg_file));
+   }
+
+
+
+int tg_open_src(Rsl_source *src,tg_file_str *tg_file)
+   {
+   /* read toga data from 'src', which tg_close closes.  'src' may be
+	  NULL, when it could not be opened. */
+   if ((tg_file->src = src) == NULL)
+	  {
 #ifdef USE_PLOG
-		 plog("tg_open: Error opening toga data file\n",PLOG_P);
+	  plog("tg_open: Error opening toga data file\n",PLOG_P);
 #endif
-		 return(TG_SYS_ERR);
-	   }
-   /* Unfortunately, there is no tg_close to modularize the following
-    * pipe close.  Shouldn't be any problems anyway.
-    */
-   (void) uncompress_pipe(fdopen(tg_file->fd, "r")); /* Redirect through gunzip. */
+	  return(TG_SYS_ERR);
+	  }
    /* initialize buffer pointers, flags */
    tg_file->buf_ind = 32769;
    tg_file->buf_end = 32769;
@@ -121,22 +127,24 @@ int tg_open(char *filename,tg_file_str *tg_file)
 
 
 
+void tg_close(tg_file_str *tg_file)
+   {
+   /* close the toga data file and any decompression stream on it */
+   rsl_source_close(tg_file->src);
+   tg_file->src = NULL;
+   }
+
+
+
 int tg_read_map_head(tg_file_str *tg_file)
    {
    int n;
    tg_map_head_str buf;
 
-   if((n = read(tg_file->fd,&buf,TG_HDSIZE)) != TG_HDSIZE)
+   if((n = rsl_source_read(&buf,1,TG_HDSIZE,tg_file->src)) != TG_HDSIZE)
 	  {
-	  if (n < 0)
-		 {
-		 fprintf(stderr,"tg_read_map_head: (%d)%s \n",errno,strerror(errno));
-		 }
-	  else
-		 {
-		 fprintf(stderr,"tg_read_map_head: Didn't read entire file header.\n\007");
-		 fprintf(stderr,"tg_read_map_head: Bytes read: %d \n",n);
-		 }
+	  fprintf(stderr,"tg_read_map_head: Didn't read entire file header.\n\007");
+	  fprintf(stderr,"tg_read_map_head: Bytes read: %d \n",n);
 	  return (-1);
 	  }
    
@@ -367,14 +375,14 @@ int tg_read_rec_bytes(tg_file_str *tg_file,char *buf,int size)
 int tg_read_map_rec(tg_file_str *tg_file)
    {
    int n;
-   static char buf[TG_RECSIZE];
+   char *buf;
+   long long pos;
    
-   if((n = read(tg_file->fd,buf,TG_RECSIZE)) < 0)
-	  {
-	  fprintf(stderr,"tg_read_map_rec: Error while reading data record.\n");
-	  fprintf(stderr,"tg_read_map_rec: (%d)%s\n",errno,strerror(errno));
-	  }
-   else if(n == 0)
+   /* The record is decoded straight out of the source. */
+   pos = rsl_source_tell(tg_file->src);
+   buf = rsl_source_get(tg_file->src,TG_RECSIZE);
+   n = rsl_source_tell(tg_file->src) - pos;
+   if(n == 0)
 	  {
 	  /* assume end of file */
 	  }
@@ -20,6 +20,8 @@
  *
  */
 
+#include <stdio.h>
+
 #define TG_OK   0
 #define TG_SYS_ERR  -1
 #define TG_END_RAY  -2
@@ -329,7 +331,7 @@ tg_ray_head_str;
 /* tg_file_str contains all info relevant to one open toga data file */
 typedef struct
    {
-   int fd;
+   Rsl_source *src;      /* Uncompressed input; see source.c. */
    int ray_num;
    int swap_bytes;
    short dec_buf[32768]; /*** Buffer and pointers for tg_read_map_bytes. */
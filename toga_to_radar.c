@@ -44,15 +44,15 @@
 
 #include <unistd.h>
 #include <string.h>
-#include "toga.h"
 #include "rsl.h"
+#include "toga.h"
 
 #define MAX_RAYS   512
 #define MAX_SWEEPS  20
 #define MISSING_VAL 0
 
-extern int radar_verbose_flag;
-int tg_open(char *infile, tg_file_str *tg_file);
+int tg_open_src(Rsl_source *src, tg_file_str *tg_file);
+void tg_close(tg_file_str *tg_file);
 int tg_read_ray(tg_file_str *tg_file);
 
 /* Toga radar routines */
@@ -145,7 +145,7 @@ void fill_sweep_header(Radar *radar, tg_map_head_str *map_head,
 					   int sweep_num, int nrays)
    /* Arrive here _after_ sweep ray data has been filled in. */
    {
-   if (radar_verbose_flag)
+   if (rsl_verbose())
       fprintf(stderr,"sweep_num:%02d  num_rays:%d\n",sweep_num, nrays);
    
    if (map_head->data_set == 1)
@@ -280,7 +280,7 @@ void fill_radar_header(Radar *radar, tg_map_head_str *map_head)
 
 
 
-Radar *RSL_toga_to_radar(char *infile)
+static Radar *toga_to_radar(Rsl_source *src, char *infile)
    /* Ingest a Darwin_Toga file and fill a Radar structure with the data.
 	  Darwin Type 1 data contains 4 fields: corrected & uncorrected refl,
 	  velocity, and spectrum width.
@@ -292,19 +292,17 @@ Radar *RSL_toga_to_radar(char *infile)
    Radar *radar;
    Ray *new_ray;
    tg_file_str tg_file;
-   extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-   extern int rsl_qsweep_max;
    
    /* open the toga data file and read toga file header into the 
 	  tg_file map_head_structure  */
-   if (tg_open(infile,&tg_file) < 0) /* Understands NULL 'infile' as stdin. */
+   if (tg_open_src(src,&tg_file) < 0)
 	  {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 	     fprintf(stderr,"Error opening/reading data file\n");
-	  close(tg_file.fd);
+	  tg_close(&tg_file);
 	  return NULL;
 	  }
-   if (radar_verbose_flag)
+   if (rsl_verbose())
 	  {
 	  fprintf(stderr,"Input file:  %s\n",infile);
 	  fprintf(stderr,"Scan_date: %.2d/%.2d/%d\n",tg_file.map_head.scan_mon,
@@ -316,21 +314,21 @@ Radar *RSL_toga_to_radar(char *infile)
 	  scan, do not bother with it. Just quit. */
    if (tg_file.map_head.scanmod != 1)
 	  {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 	     fprintf(stderr,"Darwtoga file %s does not contain a PPI scan.\n",infile);
-	  close(tg_file.fd);
+	  tg_close(&tg_file);
 	  return NULL;
 	  }
    /* Can handle only datatypes 1 and 19 */
    if ((tg_file.map_head.data_set != 1) &&
 	   (tg_file.map_head.data_set != 19))
 	  {
-	  if (radar_verbose_flag)
+	  if (rsl_verbose())
 	     fprintf(stderr,"File %s does not contain Doppler or refl data\n",infile);
-	  close(tg_file.fd);
+	  tg_close(&tg_file);
       return NULL;
 	  }
-   if (radar_verbose_flag)
+   if (rsl_verbose())
 	  {
 	  if (tg_file.map_head.data_set == 1) fprintf(stderr,"Type 1 data\n");
 	  else if (tg_file.map_head.data_set == 19) fprintf(stderr,"Type 19 data\n");
@@ -361,16 +359,14 @@ Radar *RSL_toga_to_radar(char *infile)
 			}		 
 		 tg_file.ray_num = -1;  /* Reset ray_num. */
 		 swp_num += 1;  /* increment sweep count */
-		 if (rsl_qsweep != NULL) {
-		   if (swp_num > rsl_qsweep_max) break;
-		   if (rsl_qsweep[swp_num] == 0) continue;
-		 }
+		 if (rsl_sweeps_done(swp_num)) break;
+		 if (!rsl_want_sweep(swp_num)) continue;
 		 /* Check for too many sweeps. */
 		 if ((tg_file.map_head.numfix_ang < swp_num + 1) ||
 			 (MAX_SWEEPS < swp_num + 1))
 			{
 			perror("toga_to_radar: Exceeded expected no. of sweeps");
-			close(tg_file.fd);
+			tg_close(&tg_file);
 			RSL_free_radar(radar);
 			return NULL;
 			}
@@ -394,7 +390,7 @@ Radar *RSL_toga_to_radar(char *infile)
 	  if (tg_file.ray_num > MAX_RAYS)
 		 {
 		 perror("toga_to_radar: Exceeded maximal no. of rays");
-		 close(tg_file.fd);
+		 tg_close(&tg_file);
 		 RSL_free_radar(radar);
 		 return NULL;
 		 }
@@ -439,7 +435,7 @@ Radar *RSL_toga_to_radar(char *infile)
    
    /* Check which flag the TOGA read_record routines returned, and 
 	  print appropriate terminating message */
-   if (radar_verbose_flag)
+   if (rsl_verbose())
 	  {
 	  switch (m)
 		 {
@@ -463,9 +459,9 @@ Radar *RSL_toga_to_radar(char *infile)
 		 fprintf(stderr,"Error reading toga file \n");
 		 break;
 		 }
-	  }  /* end if (radar_verbose_flag) */
+	  }  /* end if (rsl_verbose()) */
    
-   close(tg_file.fd);
+   tg_close(&tg_file);
    if (m == TG_END_DATA) {
 	 radar = RSL_prune_radar(radar);
 	 return radar;
@@ -476,3 +472,19 @@ Radar *RSL_toga_to_radar(char *infile)
 	  }
 
    }
+
+
+
+
+Radar *RSL_toga_to_radar(char *infile)
+   {
+   /* Understands NULL 'infile' as stdin. */
+   return toga_to_radar(rsl_source_open(infile), infile);
+   }
+
+
+
+Radar *RSL_toga_to_radar_mem(char *buf, size_t len)
+   {
+   return toga_to_radar(rsl_source_open_mem(buf, len), "(memory)");
+   }
@@ -30,7 +30,6 @@
 #define USE_RSL_VARS
 #include "rsl.h"
 
-extern int radar_verbose_flag;
 /* Changed old buffer size (16384) for larger dualpol files.  BLK 5/18/2011 */
 /* Changed old buffer size (20000) for larger dualpol files.  BLK 3/20/2014 */
 typedef short UF_buffer[26000]; /* Some UF files are bigger than 4096
@@ -40,8 +39,8 @@ typedef short UF_buffer[26000]; /* Some UF files are bigger than 4096
 #define UF_MORE 0
 #define UF_DONE 1
 
-static float (*f)(Range x);
-static Range (*invf)(float x);
+static RSL_THREAD_LOCAL float (*f)(Range x);
+static RSL_THREAD_LOCAL Range (*invf)(float x);
 
 Volume *reset_nsweeps_in_volume(Volume *volume)
 {
@@ -63,22 +62,6 @@ Radar *reset_nsweeps_in_all_volumes(Radar *radar)
   return radar;
 }
 
-Volume *copy_sweeps_into_volume(Volume *new_volume, Volume *old_volume)
-{
-  int i;
-  int nsweeps;
-  if (old_volume == NULL) return new_volume;
-  if (new_volume == NULL) return new_volume;
-  nsweeps = new_volume->h.nsweeps; /* Save before copying old header. */
-  new_volume->h = old_volume->h;
-  new_volume->h.nsweeps = nsweeps;
-  for (i=0; i<old_volume->h.nsweeps; i++)
-    new_volume->sweep[i] = old_volume->sweep[i]; /* Just copy pointers. */
-  /* Free the old sweep array, not the pointers to sweeps. */
-  free(old_volume->sweep);
-  return new_volume;
-}
-
 void swap2(short *buf, int n)
 {
   short *end_addr;
@@ -148,8 +131,8 @@ static void put_start_time_in_radar_header(Radar *radar)
 }
 
 /* These are used in uf_into_radar, set in caller RSL_uf_to_radar_fp. */
-static int pulled_time_from_first_ray;
-static int need_scan_mode;
+static RSL_THREAD_LOCAL int pulled_time_from_first_ray;
+static RSL_THREAD_LOCAL int need_scan_mode;
 
 /********************************************************************/
 /*********************************************************************/
@@ -209,12 +192,10 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
   Radar *radar;
   float x;
   short missing_data;
-  Volume *new_volume;
-  int nbins;
+  int nbins, first;
   float frequency;
-  extern int rsl_qfield[];
-  extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-  extern int rsl_qsweep_max;
+  float azimuth;
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
 
   radar = *the_radar;
 
@@ -233,10 +214,8 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
   nfields =  uf_dh[0];
   isweep = uf_ma[9] - 1;
 
-  if (rsl_qsweep != NULL) {
-    if (isweep > rsl_qsweep_max) return UF_DONE;
-    if (rsl_qsweep[isweep] == 0) return UF_MORE;
-  }
+  if (rsl_sweeps_done(isweep)) return UF_DONE;
+  if (!rsl_want_sweep(isweep)) return UF_MORE;
 
 
 /* Here is a sticky part.  We must make sure that if we encounter any
@@ -255,7 +234,7 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
     *the_radar = radar;
     pulled_time_from_first_ray = 0;
     for (i=0; i<MAX_RADAR_VOLUMES; i++)
-      if (rsl_qfield[i]) /* See RSL_select_fields in volume.c */
+      if (reader->qfield[i]) /* See RSL_select_fields in volume.c */
         radar->v[i] = RSL_new_volume(20);
   }
   
@@ -303,19 +282,40 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
     /* Do we place the data into this volume? */
     if (radar->v[ifield] == NULL) continue; /* Nope. */
 
+    current_fh_index = uf_dh[4+2*i];
+    uf_fh = uf + current_fh_index - 1;
+    azimuth = uf_ma[32] / 64.0;
+
+    /* If Local Use Header is present and contains azimuth, use that
+     * azimuth for VR and SW. This is for WSR-88D, which runs separate
+     * scans for DZ and VR/SW at the lower elevations, which means DZ
+     * VR/SW and have different azimuths in the "same" ray.
+     */
+    len_lu = uf_ma[4] - uf_ma[3];
+    if (len_lu == 2 && (ifield == VR_INDEX || ifield == SW_INDEX)) {
+        if (strncmp((char *)uf_lu,"ZA",2) == 0 ||
+            strncmp((char *)uf_lu,"AZ",2) == 0)
+        azimuth = uf_lu[1] / 64.0;
+    }
+    if (azimuth < 0.) azimuth += 360.; /* make it 0 to 360. */
+
+    /* Rays and gates outside the window, if one is set, are not loaded. */
+    if (!rsl_want_azimuth(azimuth)) continue;
+    nbins = rsl_window_bins(uf_fh[2] * 1000.0 + uf_fh[3], uf_fh[4],
+                            uf_fh[5], &first);
+    if (reader->window && nbins <= 0) continue;
+
     if (isweep >= radar->v[ifield]->h.nsweeps) { /* Exceeded sweep limit.
-                                                  * Allocate more sweeps.
-                                                  * Copy all previous sweeps.
+                                                  * Grow the sweep array.
                                                   */
-      if (radar_verbose_flag)
-        fprintf(stderr,"Exceeded sweep allocation of %d. Adding 20 more.\n", isweep);
-      new_volume = RSL_new_volume(radar->v[ifield]->h.nsweeps+20);
-      new_volume = copy_sweeps_into_volume(new_volume, radar->v[ifield]);
-      radar->v[ifield] = new_volume;
+      if (rsl_verbose())
+        fprintf(stderr,"Exceeded sweep allocation of %d. Adding more.\n", isweep);
+      if (RSL_reserve_sweeps(radar->v[ifield], isweep+1) != 0) return UF_DONE;
+      radar->v[ifield]->h.nsweeps = isweep+1;
     }
 
     if (radar->v[ifield]->sweep[isweep] == NULL) {
-      if (radar_verbose_flag)
+      if (rsl_verbose())
         fprintf(stderr,"Allocating new sweep for field %d, isweep %d\n", ifield, isweep);
       radar->v[ifield]->sweep[isweep] = RSL_new_sweep(1000);
       radar->v[ifield]->sweep[isweep]->h.nrays = 0; /* Increment this for each
@@ -331,11 +331,9 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
     
     
 
-    current_fh_index = uf_dh[4+2*i];
-    uf_fh = uf + current_fh_index - 1;
     sweep = radar->v[ifield]->sweep[isweep];
     iray =  sweep->h.nrays;
-    nbins = uf_fh[5];
+    if (RSL_reserve_rays(sweep, iray+1) != 0) return UF_DONE;
     radar->v[ifield]->sweep[isweep]->ray[iray] = RSL_new_ray(nbins);
     ray   = radar->v[ifield]->sweep[isweep]->ray[iray];
     sweep->h.nrays += 1;
@@ -369,20 +367,7 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
       ray->h.hour     = uf_ma[28];
       ray->h.minute   = uf_ma[29];
       ray->h.sec      = uf_ma[30];
-      ray->h.azimuth  = uf_ma[32] / 64.0;
-
-      /* If Local Use Header is present and contains azimuth, use that
-       * azimuth for VR and SW. This is for WSR-88D, which runs separate
-       * scans for DZ and VR/SW at the lower elevations, which means DZ
-       * VR/SW and have different azimuths in the "same" ray.
-       */
-      len_lu = uf_ma[4] - uf_ma[3];
-      if (len_lu == 2 && (ifield == VR_INDEX || ifield == SW_INDEX)) {
-          if (strncmp((char *)uf_lu,"ZA",2) == 0 ||
-              strncmp((char *)uf_lu,"AZ",2) == 0)
-          ray->h.azimuth = uf_lu[1] / 64.0;
-      }
-      if (ray->h.azimuth < 0.) ray->h.azimuth += 360.; /* make it 0 to 360. */
+      ray->h.azimuth  = azimuth; /* See above. */
       ray->h.elev     = uf_ma[33] / 64.0;
       ray->h.elev_num = sweep->h.sweep_num;
       ray->h.fix_angle  = sweep->h.elev = uf_ma[35] / 64.0;
@@ -432,7 +417,7 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
       ray->h.range_bin1 = uf_fh[2] * 1000.0 + uf_fh[3]; 
       ray->h.gate_size  = uf_fh[4];
 
-      ray->h.nbins      = uf_fh[5];
+      ray->h.nbins      = nbins;
       ray->h.pulse_width  = uf_fh[6]/(RSL_SPEED_OF_LIGHT/1.0e6);
 
         if (strncmp((char *)proj_name, "MCTEX", 5) == 0)  /* MCTEX? */
@@ -499,7 +484,8 @@ int uf_into_radar(UF_buffer uf, Radar **the_radar)
       uf_data = uf+uf_fh[0] - 1;
 
       len_data = ray->h.nbins;  /* Known because of RSL_new_ray. */
-      for (m=0; m<len_data; m++) {
+      for (m=0; m<first; m++) ray->range[m] = 0;
+      for (m=first; m<len_data; m++) {
         if (uf_data[m] == (short)UF_NO_DATA)
           ray->range[m] = invf(BADVAL); /* BADVAL */
         else {
@@ -532,37 +518,48 @@ void swap_uf_buffer(UF_buffer uf)
     swap_2_bytes(uf++);
 }
 
+static void swap_uf_record(UF_buffer uf, int nbytes)
+{
+  /* As swap_uf_buffer, for only the first 'nbytes' of uf: the record
+   * just read, not the whole buffer.
+   */
+  short *addr_end;
+
+  if (nbytes < 0) return;
+  if (nbytes > sizeof(UF_buffer)) nbytes = sizeof(UF_buffer);
+  addr_end = uf + nbytes/sizeof(short);
+  while (uf < addr_end)
+    swap_2_bytes(uf++);
+}
+
 enum UF_type {NOT_UF, TRUE_UF, TWO_BYTE_UF, FOUR_BYTE_UF};
 
 
 /*********************************************************************/
 /*                                                                   */
-/*                  RSL_uf_to_radar_fp                               */
+/*                  uf_read_records                                  */
+/*                                                                   */
+/*  Read the UF records of 'fp', passing each, in the host's byte    */
+/*  order, to 'record' until it returns UF_DONE.  Returns -1 when    */
+/*  'fp' is not UF.                                                  */
 /*                                                                   */
-/*  By: John Merritt                                                 */
-/*      Space Applications Corporation                               */
-/*      September 22, 1995                                           */
 /*********************************************************************/
-Radar *RSL_uf_to_radar_fp(FILE *fp)
+static int uf_read_records(FILE *fp, int (*record)(UF_buffer uf, void *arg),
+                           void *arg)
 {
   union {
     char buf[6];
     short sword;
     int word;
   } magic;
-  Radar *radar;
   int nbytes;
   short sbytes;
   UF_buffer uf;
   enum UF_type uf_type;
 #define NEW_BUFSIZ 16384
 
-  radar = NULL;
-  pulled_time_from_first_ray = 0;
-  need_scan_mode = 1;
-
   /* setvbuf(fp,NULL,_IOFBF,(size_t)NEW_BUFSIZ); * Faster i/o? */
-  if (fread(magic.buf, sizeof(char), 6, fp) <= 0) return NULL;
+  if (fread(magic.buf, sizeof(char), 6, fp) <= 0) return -1;
 /*
  * Check for fortran record length delimeters, NCAR kludge.
  */
@@ -573,7 +570,7 @@ Radar *RSL_uf_to_radar_fp(FILE *fp)
   
   switch (uf_type) {
   case FOUR_BYTE_UF:
-    if (radar_verbose_flag) fprintf(stderr,"UF file with 4 byte FORTRAN record delimeters.\n");
+    if (rsl_verbose()) fprintf(stderr,"UF file with 4 byte FORTRAN record delimeters.\n");
     /* Handle first record specially, since we needed magic information. */
     nbytes = magic.word;
     if (little_endian()) swap_4_bytes(&nbytes);
@@ -581,28 +578,28 @@ Radar *RSL_uf_to_radar_fp(FILE *fp)
         fprintf(stderr,"\nRSL_uf_to_radar_fp: Record size (%d bytes) exceeds "
                 "UF_buffer (%d bytes).\n", nbytes,sizeof(UF_buffer));
         fprintf(stderr,"Increase size of UF_buffer in uf_to_radar.c\n");
-        return NULL;
+        return -1;
     }
     memcpy(uf, &magic.buf[4], 2);
     (void)fread(&uf[1], sizeof(char), nbytes-2, fp);
-    if (little_endian()) swap_uf_buffer(uf);
+    if (little_endian()) swap_uf_record(uf, nbytes);
     (void)fread(&nbytes, sizeof(int), 1, fp);
-    if (uf_into_radar(uf, &radar) == UF_DONE) break;
+    if (record(uf, arg) == UF_DONE) break;
     /* Now the rest of the file. */
     while(fread(&nbytes, sizeof(int), 1, fp) > 0) {
       if (little_endian()) swap_4_bytes(&nbytes);
       
       (void)fread(uf, sizeof(char), nbytes, fp);
-      if (little_endian()) swap_uf_buffer(uf);
+      if (little_endian()) swap_uf_record(uf, nbytes);
       
       (void)fread(&nbytes, sizeof(int), 1, fp);
       
-      if (uf_into_radar(uf, &radar) == UF_DONE) break;
+      if (record(uf, arg) == UF_DONE) break;
     }
     break;
 
   case TWO_BYTE_UF:
-    if (radar_verbose_flag) fprintf(stderr,"UF file with 2 byte FORTRAN record delimeters.\n");
+    if (rsl_verbose()) fprintf(stderr,"UF file with 2 byte FORTRAN record delimeters.\n");
     /* Handle first record specially, since we needed magic information. */
     sbytes = magic.sword;
     if (little_endian()) swap_2_bytes(&sbytes);
@@ -610,28 +607,28 @@ Radar *RSL_uf_to_radar_fp(FILE *fp)
         fprintf(stderr,"\nRSL_uf_to_radar_fp: Record size (%d bytes) exceeds "
                 "UF_buffer (%d bytes).\n", sbytes,sizeof(UF_buffer));
         fprintf(stderr,"Increase size of UF_buffer in uf_to_radar.c\n");
-        return NULL;
+        return -1;
     }
     memcpy(uf, &magic.buf[2], 4);
     (void)fread(&uf[2], sizeof(char), sbytes-4, fp);
-    if (little_endian()) swap_uf_buffer(uf);
+    if (little_endian()) swap_uf_record(uf, sbytes);
     (void)fread(&sbytes, sizeof(short), 1, fp);
-    uf_into_radar(uf, &radar);
+    record(uf, arg);
     /* Now the rest of the file. */
     while(fread(&sbytes, sizeof(short), 1, fp) > 0) {
       if (little_endian()) swap_2_bytes(&sbytes);
       
       (void)fread(uf, sizeof(char), sbytes, fp);
-      if (little_endian()) swap_uf_buffer(uf);
+      if (little_endian()) swap_uf_record(uf, sbytes);
       
       (void)fread(&sbytes, sizeof(short), 1, fp);
       
-      if (uf_into_radar(uf, &radar) == UF_DONE) break;
+      if (record(uf, arg) == UF_DONE) break;
     }
     break;
 
   case TRUE_UF:
-    if (radar_verbose_flag) fprintf(stderr,"UF file with no FORTRAN record delimeters.  Good.\n");
+    if (rsl_verbose()) fprintf(stderr,"UF file with no FORTRAN record delimeters.  Good.\n");
     /* Handle first record specially, since we needed magic information. */
     memcpy(&sbytes, &magic.buf[2], 2); /* Record length is in word #2. */
     if (little_endian()) swap_2_bytes(&sbytes); /* # of 2 byte words. */
@@ -639,26 +636,51 @@ Radar *RSL_uf_to_radar_fp(FILE *fp)
         fprintf(stderr,"\nRSL_uf_to_radar_fp: Record size (%d bytes) exceeds "
                 "UF_buffer (%d bytes).\n", sbytes,sizeof(UF_buffer));
         fprintf(stderr,"Increase size of UF_buffer in uf_to_radar.c\n");
-        return NULL;
+        return -1;
     }
     memcpy(uf, &magic.buf[0], 6);
     (void)fread(&uf[3], sizeof(short), sbytes-3, fp);
-    if (little_endian()) swap_uf_buffer(uf);
-    uf_into_radar(uf, &radar);
+    if (little_endian()) swap_uf_record(uf, 2*sbytes);
+    record(uf, arg);
     /* Now the rest of the file. */
     while(fread(uf, sizeof(short), 2, fp) > 0) {
       memcpy(&sbytes, &uf[1], 2);  /* Record length is in word #2. */
       if (little_endian()) swap_2_bytes(&sbytes);
       
       (void)fread(&uf[2], sizeof(short), sbytes-2, fp);  /* Have words 1,2. */
-      if (little_endian()) swap_uf_buffer(uf);
+      if (little_endian()) swap_uf_record(uf, 2*sbytes);
       
-      if (uf_into_radar(uf, &radar) == UF_DONE) break;
+      if (record(uf, arg) == UF_DONE) break;
     }
     break;
     
-  case NOT_UF: return NULL; break;
+  case NOT_UF: return -1; break;
   }
+  return 0;
+}
+
+static int uf_radar_record(UF_buffer uf, void *arg)
+{
+  return uf_into_radar(uf, (Radar **)arg);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                  RSL_uf_to_radar_fp                               */
+/*                                                                   */
+/*  By: John Merritt                                                 */
+/*      Space Applications Corporation                               */
+/*      September 22, 1995                                           */
+/*********************************************************************/
+Radar *RSL_uf_to_radar_fp(FILE *fp)
+{
+  Radar *radar;
+
+  radar = NULL;
+  pulled_time_from_first_ray = 0;
+  need_scan_mode = 1;
+
+  if (uf_read_records(fp, uf_radar_record, &radar) < 0) return NULL;
   radar = reset_nsweeps_in_all_volumes(radar);
   put_start_time_in_radar_header(radar);
   radar = RSL_prune_radar(radar);
@@ -701,3 +723,117 @@ Radar *RSL_uf_to_radar(char *infile)
     
   return radar;
 }
+
+/*********************************************************************/
+/*                                                                   */
+/*                      RSL_uf_to_radar_mem                          */
+/*                                                                   */
+/*********************************************************************/
+Radar *RSL_uf_to_radar_mem(char *buf, size_t len)
+{
+  /* As RSL_uf_to_radar, for the 'len' bytes at 'buf'. */
+  FILE *fp;
+  Radar *radar;
+
+  if ((fp = rsl_mem_fopen(buf, len)) == NULL) return NULL;
+  fp = uncompress_pipe(fp); /* Transparently gunzip. */
+  radar = RSL_uf_to_radar_fp(fp);
+  rsl_pclose(fp);
+  return radar;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                      uf_probe_fp                                  */
+/*                                                                   */
+/*  Fill 'p' from the mandatory and data headers of the UF records   */
+/*  in 'fp'.  The field data are not converted.  Returns 0, or -1    */
+/*  when 'fp' is not UF.  See RSL_probe.                             */
+/*                                                                   */
+/*********************************************************************/
+typedef struct {
+  Rsl_probe *p;
+  int have_time;
+  int start_sweep; /* The volume starts with the earliest ray of the */
+  int start_date;  /* lowest numbered sweep, as in the radar header. */
+  float start_time;
+  int error;
+} UF_probe;
+
+static int uf_probe_record(UF_buffer uf, void *arg)
+{
+  UF_probe *up = (UF_probe *)arg;
+  Rsl_probe *p = up->p;
+  Rsl_probe_sweep *s;
+  short *uf_ma, *uf_dh, *uf_end;
+  char *field_type;
+  int nfields, isweep, i, j;
+  int year, date;
+  float time;
+
+  uf_ma = uf;
+  uf_end = uf + sizeof(UF_buffer)/sizeof(short);
+  if (uf_ma[4] < 1 || uf + uf_ma[4] + 2 > uf_end) return UF_MORE;
+  uf_dh = uf + uf_ma[4] - 1;
+  nfields = uf_dh[0];
+  isweep = uf_ma[9] - 1;
+  if (isweep < 0) return UF_MORE;
+
+  if ((s = rsl_probe_sweep(p, isweep)) == NULL) {
+    up->error = 1;
+    return UF_DONE;
+  }
+  s->nrays++;
+  s->fix_angle = uf_ma[35] / 64.0;
+  for (i=0; i<nfields && &uf_dh[4+2*i] < uf_end; i++) {
+    if (little_endian()) swap_2_bytes(&uf_dh[3+2*i]); /* Unswap. */
+    field_type = (char *)&uf_dh[3+2*i];
+    for (j=0; j<MAX_RADAR_VOLUMES; j++) {
+      if (strncmp(field_type, RSL_ftype[j], 2) == 0) {
+        s->field[j] = p->field[j] = 1;
+        break;
+      }
+    }
+  }
+
+  year = uf_ma[25];
+  if (year < 1900) {
+    year += 1900;
+    if (year < 1980) year += 100; /* Year >= 2000. */
+  }
+  date = year * 10000 + uf_ma[26] * 100 + uf_ma[27];
+  time = uf_ma[28] * 10000 + uf_ma[29] * 100 + uf_ma[30];
+  if (!up->have_time) {
+    memcpy(p->name, &uf_ma[14], 8);
+    if (little_endian()) swap2((short *)p->name, 8/2);
+    p->lat = uf_ma[18] + uf_ma[19]/60.0 + uf_ma[20]/64.0/3600;
+    p->lon = uf_ma[21] + uf_ma[22]/60.0 + uf_ma[23]/64.0/3600;
+  }
+  if (!up->have_time || isweep < up->start_sweep ||
+      (isweep == up->start_sweep &&
+       (date < up->start_date ||
+        (date == up->start_date && time < up->start_time)))) {
+    up->have_time = 1;
+    up->start_sweep = isweep;
+    up->start_date = date;
+    up->start_time = time;
+    p->year   = year;
+    p->month  = uf_ma[26];
+    p->day    = uf_ma[27];
+    p->hour   = uf_ma[28];
+    p->minute = uf_ma[29];
+    p->sec    = uf_ma[30];
+  }
+  return UF_MORE;
+}
+
+int uf_probe_fp(FILE *fp, Rsl_probe *p)
+{
+  UF_probe up;
+
+  memset(&up, 0, sizeof(up));
+  up.p = p;
+  if (uf_read_records(fp, uf_probe_record, &up) < 0 || up.error) return -1;
+  strcpy(p->radar_type, "uf");
+  return 0;
+}
@@ -27,6 +27,11 @@
  *   Volume *RSL_new_volume(int max_sweeps);
  *   Sweep *RSL_new_sweep(int max_rays);
  *   Ray *RSL_new_ray(int max_bins);
+ *   int RSL_reserve_sweeps(Volume *v, int nsweeps);
+ *   int RSL_reserve_rays(Sweep *s, int nrays);
+ *   Sweep *RSL_shrink_sweep(Sweep *s);
+ *   Volume *RSL_shrink_volume(Volume *v);
+ *   Radar *RSL_shrink_radar(Radar *radar);
  *   Ray *RSL_clear_ray(Ray *r);
  *   Sweep *RSL_clear_sweep(Sweep *s);
  *   Volume *RSL_clear_volume(Volume *v);
@@ -74,7 +79,6 @@ int strcasecmp(const char *s1, const char *s2);
 #define bin_elevation(x, dx) (float)((float)x/dx)
 #define bin_range(x, dx) (float)((float)x/dx)
 
-extern int radar_verbose_flag;
 
 /* Internal storage conversion functions. These may be any conversion and
  * may be dynamically defined; based on the input data conversion.  If you
@@ -465,136 +469,51 @@ Volume *RSL_new_volume(int max_sweeps)
   v->sweep = (Sweep **) calloc(max_sweeps, sizeof(Sweep*));
   if (v->sweep == NULL) perror("RSL_new_volume, Sweep*");
   v->h.nsweeps = max_sweeps; /* A default setting. */
+  v->max_sweeps = max_sweeps;
   return v;
 }
 
 /*
- * The 'Sweep_list' structure is internal to RSL.  It maintains a list
- * of sweeps allocated and it contains pointers to a hash table of Rays
- * separately for each sweep.  There is no reason to access this internal
- * structure except when optimizing new RSL routines that access Rays.
- * Otherwise, the RSL interfaces should suffice.
+ * Each sweep carries a hash table of its Rays, 's->hash'.  There is no
+ * reason to access it except when optimizing new RSL routines that access
+ * Rays.  Otherwise, the RSL interfaces should suffice.
  *
  * The hash table is a means of finding rays, by azimuth, quickly.
- * To find a ray is simple:  use the hash function to get close
- * to the ray, if not right on it the first time.  Collisions of rays in
- * the hash table are handled by a link list of rays from a hash entry.
- * Typically, the first ray of the sweep is not the ray with the smallest
- * azimuth angle.  We are confident that the order of Rays in the Sweep
- * is by azimuth angle, but that cannot be guarenteed.  Therefore, this
- * hash scheme is required.
+ * To find a ray is simple:  use the bucket for the azimuth to get close
+ * to the ray, if not right on it the first time, then step along the
+ * sorted azimuths.  Typically, the first ray of the sweep is not the ray
+ * with the smallest azimuth angle.  We are confident that the order of
+ * Rays in the Sweep is by azimuth angle, but that cannot be guarenteed.
+ * Therefore, this hash scheme is required.
  *
- * The 'Sweep_list' contains the address of the memory allocated to
- * sweep.  The list is sorted by addresses.  There is no
- * memory limit to the number of sweeps.  If the number of sweeps exceeds
- * the current allocation for the Sweep_list, then a new Sweep_list is
- * allocated, which is bigger, and the old list copied to it.
- *
- * Sweep_list is at least as long as the number of sweeps allocated.
- */
-
-typedef struct {
-  Sweep *s_addr;
-  Hash_table *hash;
-} Sweep_list;
-
-/*
- * By design of RSL, this should be "#define STATIC static"
- *
- * It is OK to "#define STATIC static", but, if you do, then
- * the examples (run by run_tests in examples/) will fail for
- * those programs that test these data structures.  I normally,
- * don't set this #define, for that reason.
+ * The table is built by hash_table_for_sweep the first time it is needed
+ * and freed by RSL_free_sweep.  It holds pointers to the Rays, so any
+ * routine that replaces, moves or drops entries of s->ray, or changes
+ * their azimuths, must call RSL_sweep_changed afterwards.  The RSL
+ * routines do; callers who edit s->ray themselves must do the same.
  */
 
-#define STATIC
-STATIC int RSL_max_sweeps = 0; /* Initial allocation for sweep_list.
-                                * RSL_new_sweep will allocate the space first
-                                * time around.
-                                */
-STATIC int RSL_nsweep_addr = 0; /* A count of sweeps in the table. */
-STATIC Sweep_list *RSL_sweep_list = NULL;
-STATIC int RSL_nextents = 0;
-
-void FREE_HASH_NODE(Azimuth_hash *node)
-{
-  if (node == NULL) return;
-  FREE_HASH_NODE(node->next); /* Tail recursive link list removal. */
-  free(node);
-}
-
 void FREE_HASH_TABLE(Hash_table *table)
 {
-  int i;
+  /* The table and its arrays are one allocation. */
   if (table == NULL) return;
-  for (i=0; i<table->nindexes; i++)
-    FREE_HASH_NODE(table->indexes[i]); /* A possible linked list of Rays. */
-  free(table->indexes);
   free(table);
 }
 
-void REMOVE_SWEEP(Sweep *s)
-{
-  int i;
-  int j;
-  /* Find where it goes, split the list and slide the tail down one. */
-  for (i=0; i<RSL_nsweep_addr; i++)
-    if (s == RSL_sweep_list[i].s_addr) break;
-
-  if (i == RSL_nsweep_addr) return; /* Not found. */
-  /* This sweep is at 'i'. */ 
-  /* Deallocate the memory for the hash table. */
-  FREE_HASH_TABLE(RSL_sweep_list[i].hash);
-
-  RSL_nsweep_addr--;
-  for (j=i; j<RSL_nsweep_addr; j++)
-    RSL_sweep_list[j] = RSL_sweep_list[j+1];
-
-  RSL_sweep_list[RSL_nsweep_addr].s_addr = NULL;
-  RSL_sweep_list[RSL_nsweep_addr].hash = NULL;
-}
-  
-
-int INSERT_SWEEP(Sweep *s)
-{
-  Sweep_list *new_list;
-  int i,j;
-
-  if (RSL_nsweep_addr >= RSL_max_sweeps) { /* Current list is too small. */
-    RSL_nextents++;
-    new_list = (Sweep_list *) calloc(100*RSL_nextents, sizeof(Sweep_list));
-    if (new_list == NULL) {
-      perror("INSERT_SWEEP");
-      exit(2);
-    }
-    /* Copy the old list to the new one. */
-    for (i=0; i<RSL_max_sweeps; i++) new_list[i] = RSL_sweep_list[i];
-    RSL_max_sweeps = 100*RSL_nextents;
-    free(RSL_sweep_list);
-    RSL_sweep_list = new_list;
-  }
-  /* Find where it goes, split the list and slide the tail down one. */
-  for (i=0; i<RSL_nsweep_addr; i++)
-    if (s < RSL_sweep_list[i].s_addr) break;
-    
-  /* This sweep goes at 'i'. But first we must split the list. */
-  for (j=RSL_nsweep_addr; j>i; j--)
-    RSL_sweep_list[j] = RSL_sweep_list[j-1];
-
-  RSL_sweep_list[i].s_addr = s;
-  RSL_sweep_list[i].hash = NULL;
-  RSL_nsweep_addr++;
-  return i;
-}
-
-int SWEEP_INDEX(Sweep *s)
+/**********************************************************************/
+/*                                                                    */
+/*                        RSL_sweep_changed                           */
+/*                                                                    */
+/*  Drop the sweep's hash table after s->ray has been edited; it is   */
+/*  rebuilt on the next lookup.  Not safe while another thread is     */
+/*  looking up rays in the same sweep.                                */
+/*                                                                    */
+/**********************************************************************/
+void RSL_sweep_changed(Sweep *s)
 {
-  /* Locate the sweep in the RSL_sweep_list.  Return the index. */
-  /* Simple linear search; but this will be a binary search. */
-  int i;
-  for (i=0; i<RSL_nsweep_addr; i++)
-    if (s == RSL_sweep_list[i].s_addr) return i;
-  return -1;
+  if (s == NULL) return;
+  FREE_HASH_TABLE(s->hash);
+  s->hash = NULL;
 }
 
 Sweep *RSL_new_sweep(int max_rays)
@@ -605,10 +524,10 @@ Sweep *RSL_new_sweep(int max_rays)
   Sweep *s;
   s = (Sweep  *)calloc(1, sizeof(Sweep));
   if (s == NULL) perror("RSL_new_sweep");
-  INSERT_SWEEP(s);
   s->ray = (Ray **) calloc(max_rays, sizeof(Ray*));
   if (s->ray == NULL) perror("RSL_new_sweep, Ray*");
   s->h.nrays = max_rays; /* A default setting. */
+  s->max_rays = max_rays;
   s->h.elev = -999.;
   s->h.azimuth = -999.;
   return s;
@@ -620,6 +539,7 @@ Ray *RSL_new_ray(int max_bins)
    * A ray consists of a header section and an array of Range types (floats).
    */
   Ray *r;
+  if ((r = rsl_arena_new_ray(max_bins)) != NULL) return r;
   r = (Ray *)calloc(1, sizeof(Ray));
   if (r == NULL) perror("RSL_new_ray");
   r->range = (Range *) calloc(max_bins, sizeof(Range));
@@ -629,6 +549,167 @@ Ray *RSL_new_ray(int max_bins)
   return r;
 }
 
+/**********************************************************************/
+/*                                                                    */
+/*                 RSL_reserve_sweeps, RSL_reserve_rays               */
+/*                                                                    */
+/*  Make room for sweep[0..nsweeps-1] (ray[0..nrays-1]), so a reader  */
+/*  need not know the count in advance.  The array at least doubles   */
+/*  when it grows, and new slots are NULL.  h.nsweeps (h.nrays) is    */
+/*  left to the caller.  Returns 0, or -1 if there is no memory.      */
+/*                                                                    */
+/**********************************************************************/
+static void **reserve_slots(void **slot, int *max, int n)
+{
+  void **p;
+  int m;
+
+  m = 2 * *max;
+  if (m < n) m = n;
+  if ((p = (void **)realloc(slot, m * sizeof(void *))) == NULL) return NULL;
+  memset(p + *max, 0, (m - *max) * sizeof(void *));
+  *max = m;
+  return p;
+}
+
+int RSL_reserve_sweeps(Volume *v, int nsweeps)
+{
+  Sweep **sweep;
+
+  if (v->max_sweeps < v->h.nsweeps) v->max_sweeps = v->h.nsweeps;
+  if (nsweeps > v->max_sweeps) {
+	sweep = (Sweep **)reserve_slots((void **)v->sweep, &v->max_sweeps, nsweeps);
+	if (sweep == NULL) {
+	  perror("RSL_reserve_sweeps");
+	  return -1;
+	}
+	v->sweep = sweep;
+  }
+  return 0;
+}
+
+int RSL_reserve_rays(Sweep *s, int nrays)
+{
+  Ray **ray;
+
+  if (s->max_rays < s->h.nrays) s->max_rays = s->h.nrays;
+  if (nrays > s->max_rays) {
+	ray = (Ray **)reserve_slots((void **)s->ray, &s->max_rays, nrays);
+	if (ray == NULL) {
+	  perror("RSL_reserve_rays");
+	  return -1;
+	}
+	s->ray = ray;
+	RSL_sweep_changed(s);
+  }
+  return 0;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*       RSL_shrink_sweep, RSL_shrink_volume, RSL_shrink_radar        */
+/*                                                                    */
+/*  Drop trailing NULL rays (sweeps) from the count, and give back    */
+/*  the unused end of the array.  Indexes do not change; see          */
+/*  RSL_prune_radar to squeeze out the NULLs as well.                 */
+/*                                                                    */
+/**********************************************************************/
+Sweep *RSL_shrink_sweep(Sweep *s)
+{
+  Ray **ray;
+  int n;
+
+  if (s == NULL) return NULL;
+  for (n = s->h.nrays; n > 0 && s->ray[n-1] == NULL; n--);
+  if (n < s->h.nrays) RSL_sweep_changed(s);
+  s->h.nrays = n;
+  if (s->max_rays > n && n > 0 &&
+	  (ray = (Ray **)realloc(s->ray, n * sizeof(Ray *))) != NULL) {
+	s->ray = ray;
+	s->max_rays = n;
+  }
+  return s;
+}
+
+Volume *RSL_shrink_volume(Volume *v)
+{
+  Sweep **sweep;
+  int i, n;
+
+  if (v == NULL) return NULL;
+  for (n = v->h.nsweeps; n > 0 && v->sweep[n-1] == NULL; n--);
+  v->h.nsweeps = n;
+  for (i=0; i<n; i++) RSL_shrink_sweep(v->sweep[i]);
+  if (v->max_sweeps > n && n > 0 &&
+	  (sweep = (Sweep **)realloc(v->sweep, n * sizeof(Sweep *))) != NULL) {
+	v->sweep = sweep;
+	v->max_sweeps = n;
+  }
+  return v;
+}
+
+Radar *RSL_shrink_radar(Radar *radar)
+{
+  int i;
+
+  if (radar == NULL) return NULL;
+  for (i=0; i<radar->h.nvolumes; i++)
+	RSL_shrink_volume(radar->v[i]);
+  return radar;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      rsl_new_block                                 */
+/*                      rsl_block_ref                                 */
+/*                      rsl_block_unref                               */
+/*                                                                    */
+/*  A block is shared by the rays whose range arrays lie in it.  Each */
+/*  such ray holds a reference; 'release' frees the memory when the   */
+/*  last reference goes.  The creator holds the first reference.      */
+/*                                                                    */
+/**********************************************************************/
+Rsl_block *rsl_new_block(void *addr, size_t len,
+						 void (*release)(Rsl_block *b))
+{
+  Rsl_block *b;
+
+  b = (Rsl_block *)calloc(1, sizeof(Rsl_block));
+  if (b == NULL) {
+	perror("rsl_new_block");
+	return NULL;
+  }
+  b->addr = addr;
+  b->len = len;
+  b->refs = 1;
+  b->release = release;
+  return b;
+}
+
+void rsl_block_ref(Rsl_block *b)
+{
+#ifdef __GNUC__
+  __sync_add_and_fetch(&b->refs, 1);
+#else
+  b->refs++;
+#endif
+}
+
+void rsl_block_unref(Rsl_block *b)
+{
+  int refs;
+
+  if (b == NULL) return;
+#ifdef __GNUC__
+  refs = __sync_sub_and_fetch(&b->refs, 1);
+#else
+  refs = --b->refs;
+#endif
+  if (refs > 0) return;
+  if (b->release) b->release(b);
+  free(b);
+}
+
 /**********************************************************************/
 /*                                                                    */
 /*                      clear_ray                                     */
@@ -670,7 +751,12 @@ Volume *RSL_clear_volume(Volume *v)
 void RSL_free_ray(Ray *r)
 {
   if (r == NULL) return;
-  if (r->range) free(r->range);
+  if (r->block && r->block->holds_rays) {
+	rsl_block_unref(r->block); /* May free 'r'. */
+	return;
+  }
+  if (r->block) rsl_block_unref(r->block);
+  else if (r->range) free(r->range);
   free(r);
 }
 void RSL_free_sweep(Sweep *s)
@@ -681,7 +767,8 @@ void RSL_free_sweep(Sweep *s)
     RSL_free_ray(s->ray[i]);
   }
   if (s->ray) free(s->ray);
-  REMOVE_SWEEP(s); /* Remove from internal Sweep list. */
+  FREE_HASH_TABLE(s->hash);
+  rsl_block_unref(s->gates);
   free(s);
 }
 void RSL_free_volume(Volume *v)
@@ -763,6 +850,25 @@ double angle_diff(float x, float y)
   return d;
 }
 
+/**********************************************************************/
+/*                                                                    */
+/*                        hash_find_ray                               */
+/*                                                                    */
+/*  Return the index of 'ray' in table->ray.  Rays sharing an azimuth */
+/*  are adjacent, so look through them; if 'ray' is not in the sweep, */
+/*  settle for the closest.                                           */
+/*                                                                    */
+/**********************************************************************/
+int hash_find_ray(Hash_table *table, Ray *ray)
+{
+  int i, first;
+
+  first = hash_bin(table, ray->h.azimuth);
+  for (i=first; i<table->nrays && table->azimuth[i] == table->azimuth[first]; i++)
+	if (table->ray[i] == ray) return i;
+  return hash_closest(table, ray->h.azimuth);
+}
+
 /**********************************************************************/
 /*                                                                    */
 /*                 RSL_get_next_cwise_ray                             */
@@ -772,25 +878,21 @@ double angle_diff(float x, float y)
 Ray *RSL_get_next_cwise_ray(Sweep *s, Ray *ray)
 {
   /* The fastest way to do this is to gain access to the hash table
-   * which maintains a linked list of sorted rays.
+   * which maintains an array of sorted rays.
    */
   Hash_table *hash_table;
-  Azimuth_hash *closest;
-  int hindex;
-  float ray_angle;
+  int closest;
 
   if (s == NULL) return NULL;
   if (ray == NULL) return NULL;
-  /* Find a non-NULL index close to hindex that we want. */
   hash_table = hash_table_for_sweep(s);
-  if (hash_table == NULL) return NULL; /* Nada. */
-  ray_angle = ray->h.azimuth;
-  hindex = hash_bin(hash_table,ray_angle); 
+  if (hash_table == NULL || hash_table->nrays == 0) return NULL; /* Nada. */
   
-  /* Find hash entry with closest Ray */
-  closest = the_closest_hash(hash_table->indexes[hindex],ray_angle);
+  /* Find the hash entry of this Ray */
+  closest = hash_find_ray(hash_table, ray);
+  if (++closest == hash_table->nrays) closest = 0;
  
-  return closest->ray_high->ray;
+  return hash_table->ray[closest];
 }
 
 /**********************************************************************/
@@ -801,25 +903,21 @@ Ray *RSL_get_next_cwise_ray(Sweep *s, Ray *ray)
 Ray *RSL_get_next_ccwise_ray(Sweep *s, Ray *ray)
 {
   /* The fastest way to do this is to gain access to the hash table
-   * which maintains a linked list of sorted rays.
+   * which maintains an array of sorted rays.
    */
   Hash_table *hash_table;
-  Azimuth_hash *closest;
-  int hindex;
-  float ray_angle;
+  int closest;
 
   if (s == NULL) return NULL;
   if (ray == NULL) return NULL;
-  /* Find a non-NULL index close to hindex that we want. */
   hash_table = hash_table_for_sweep(s);
-  if (hash_table == NULL) return NULL; /* Nada. */
-  ray_angle = ray->h.azimuth;  
-  hindex = hash_bin(hash_table,ray_angle); 
+  if (hash_table == NULL || hash_table->nrays == 0) return NULL; /* Nada. */
   
-  /* Find hash entry with closest Ray */
-  closest = the_closest_hash(hash_table->indexes[hindex],ray_angle);
+  /* Find the hash entry of this Ray */
+  closest = hash_find_ray(hash_table, ray);
+  if (closest-- == 0) closest = hash_table->nrays - 1;
  
-  return closest->ray_low->ray;
+  return hash_table->ray[closest];
 }
 
 
@@ -863,55 +961,31 @@ double ccwise_angle_diff(float x,float y)
 
 /*****************************************
  *                                       *
- * the_closest_hash                      *
+ * hash_closest                          *
  *                                       *
  * Dennis Flanigan,Jr. 4/29/95           *
  *****************************************/
-Azimuth_hash *the_closest_hash(Azimuth_hash *hash, float ray_angle)
+int hash_closest(Hash_table *table, float ray_angle)
    {
-   /* Return the hash pointer with the minimum ray angle difference. */
-
-   double clow,chigh,cclow;
-   Azimuth_hash *high,*low;
-
-   if (hash == NULL) return NULL;
-
-   /* Set low pointer to hash index with ray angle just below
-    * requested angle and high pointer to just above requested
-    * angle.
-    */
-
-   /* set low and high pointers to initial search locations*/
-   low = hash;         
-   high = hash->ray_high;
-   
-   /* Search until clockwise angle to high is less then clockwise
-    * angle to low.
+   /* Return the index, in table->ray, of the ray with the minimum ray
+    * angle difference.  Of two rays equally close, the clockwise one.
     */
 
-   clow   = cwise_angle_diff(ray_angle,low->ray->h.azimuth);
-   chigh  = cwise_angle_diff(ray_angle,high->ray->h.azimuth);
-   cclow  = ccwise_angle_diff(ray_angle,low->ray->h.azimuth);
+   int high,low;
 
-   while((chigh > clow) && (clow != 0))
-      {
-      if (clow < cclow)
-         {
-         low  = low->ray_low;
-         high = low->ray_high;  /* Not the same low as line before ! */
-         }
-      else
-         {
-         low  = low->ray_high;
-         high = low->ray_high;  /* Not the same low as line before ! */
-         }
+   if (table == NULL || table->nrays == 0) return -1;
+   ray_angle = fmod(ray_angle, 360.0);
+   if (ray_angle < 0) ray_angle += 360.0;
 
-      clow   = cwise_angle_diff(ray_angle,low->ray->h.azimuth);
-      chigh  = cwise_angle_diff(ray_angle,high->ray->h.azimuth);
-      cclow  = ccwise_angle_diff(ray_angle,low->ray->h.azimuth);
-      }
+   /* Set high to the ray at or just clockwise of the requested angle and
+    * low to the one before it.
+    */
+   high = hash_bin(table, ray_angle);
+   if (high == table->nrays) high = 0;
+   low = (high == 0) ? table->nrays - 1 : high - 1;
 
-   if(chigh <= cclow)
+   if (cwise_angle_diff(ray_angle, table->azimuth[high]) <=
+       ccwise_angle_diff(ray_angle, table->azimuth[low]))
       {
       return high;
       }
@@ -1025,44 +1099,43 @@ Ray *RSL_get_ray_from_sweep(Sweep *s, float ray_angle)
  **********************************************/
 int hash_bin(Hash_table *table,float angle)
 {
-  /* Internal Routine to calculate the hashing bin index 
-   * of a given angle.
+  /* Internal Routine to find, in the sorted rays of the table, the
+   * index of the first ray whose azimuth is >= angle.  Returns
+   * table->nrays when angle is past the last ray.
    */
-  int hash;
-  float res;
-  
-  res = 360.0/table->nindexes;
-  hash = (int)(angle/res + res/2.0);/*Centered about bin.*/
-  
-  if(hash >= table->nindexes) hash = hash - table->nindexes;
+  int i, b;
   
-  /* Could test see which direction is closer, but 
-   * why bother?
-   */
-  while(table->indexes[hash] == NULL) {
-    hash++;
-    if(hash >= table->nindexes) hash = 0;
-  }
+  angle = fmod(angle, 360.0);
+  if (angle < 0) angle += 360.0;
+  b = (int)(angle/table->res);
+  if (b >= table->nbuckets) b = table->nbuckets - 1;
+  i = table->bucket[b];
+
+  /* Usually no step is needed; these absorb rounding at bucket edges. */
+  while (i > 0 && table->azimuth[i-1] >= angle) i--;
+  while (i < table->nrays && table->azimuth[i] < angle) i++;
   
-  return hash;
+  return i;
 }
 
 Hash_table *hash_table_for_sweep(Sweep *s)
 {
-  int i;
-
-  i = SWEEP_INDEX(s);
-  if (i==-1) { /* Obviously, an unregistered sweep.  Most likely the
-                * result of pointer assignments.
-                */
-    i = INSERT_SWEEP(s);
-  }
+  /* Build the table the first time it is needed.  If two threads race
+   * to build it, the one that loses frees its copy.
+   */
+  Hash_table *table;
 
-  if (RSL_sweep_list[i].hash == NULL) { /* First time.  Construct the table. */
-    RSL_sweep_list[i].hash = construct_sweep_hash_table(s);
+  if (s->hash == NULL) {
+    table = construct_sweep_hash_table(s);
+#ifdef __GNUC__
+    if (!__sync_bool_compare_and_swap(&s->hash, NULL, table))
+      FREE_HASH_TABLE(table);
+#else
+    s->hash = table;
+#endif
   }
 
-  return RSL_sweep_list[i].hash;
+  return s->hash;
 }  
 
 /*********************************************************************/
@@ -1077,28 +1150,24 @@ Ray *RSL_get_closest_ray_from_sweep(Sweep *s,float ray_angle, float limit)
     * Return closest Ray in Sweep within limit (angle) specified
     * in parameter list.  Assume PPI mode.
     */
-   int hindex;
    Hash_table *hash_table;
-   Azimuth_hash *closest;
+   Ray *closest;
    double close_diff;
 
    if (s == NULL) return NULL;
-   /* Find a non-NULL index close to hindex that we want. */
    hash_table = hash_table_for_sweep(s);
-   if (hash_table == NULL) return NULL; /* Nada. */
-
-   hindex = hash_bin(hash_table,ray_angle); 
+   if (hash_table == NULL || hash_table->nrays == 0) return NULL; /* Nada. */
 
    /* Find hash entry with closest Ray */
-   closest = the_closest_hash(hash_table->indexes[hindex],ray_angle);
+   closest = hash_table->ray[hash_closest(hash_table, ray_angle)];
    
    /* Is closest ray within limit parameter ? If
     * so return ray, else return NULL.
     */
 
-   close_diff = angle_diff(ray_angle,closest->ray->h.azimuth);
+   close_diff = angle_diff(ray_angle,closest->h.azimuth);
    
-   if(close_diff <= limit) return closest->ray;
+   if(close_diff <= limit) return closest;
    
    return NULL;
  }
@@ -1150,7 +1219,7 @@ float RSL_get_value_from_ray(Ray *ray, float r)
 
    if(ray->h.gate_size == 0)
       {
-      if(radar_verbose_flag)
+      if(rsl_verbose())
          {
          fprintf(stderr,"RSL_get_value_from_ray: ray->h.gate_size == 0\n");
          }
@@ -1381,37 +1450,13 @@ Sweep *RSL_get_first_sweep_of_volume(Volume *v)
 }
 
 #define N_SPECIAL_NAMES 2
-/* 
- * Unfortunately in C, there is no way around initializing static
- * arrays by specifying repetition.
- *
- * There is another solution and that is to have RSL_new_radar set
- * a flag indicating if the application has called 'RSL_select_fields'
- * prior to calling the ingest routine.  I choose the static = {...}; method
- * for now.
- */
-
-/* Could be static and force use of 'rsl_query_field' */
-int rsl_qfield[MAX_RADAR_VOLUMES] = {
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1,
-  1, 1
- };
-
 
 /*********************************************************************/
 /*                                                                   */
 /*                 RSL_select_fields                                 */
 /*                                                                   */
 /*********************************************************************/
-void RSL_select_fields(char *field_type, ...)
+static void select_fields(Rsl_reader *r, char *field_type, va_list ap)
 {
   /*
    * 10/15/96
@@ -1435,16 +1480,14 @@ void RSL_select_fields(char *field_type, ...)
    *      RSL_select_fields("dz");  -  Read only DZ.
    *      RSL_select_fields("vr");  -  Read only VR, no DZ.
    *
-   * An RSL hidden array is set to flag which fields are selected.
-   * This array is examined inside all ingest code.  It is not available
-   * to the application.
+   * The reader's qfield array is set to flag which fields are selected.
+   * This array is examined inside all ingest code.
    */
 
-  va_list ap;
   char *c_field;
   int i;
 
-  for (i=0; i<MAX_RADAR_VOLUMES; i++) rsl_qfield[i] = 0;
+  for (i=0; i<MAX_RADAR_VOLUMES; i++) r->qfield[i] = 0;
 
   /* # arguments, should be <= MAX_RADAR_VOLUMES, but we can handle
    * typo's and redundancies.  Each is processed in the order they 
@@ -1452,35 +1495,54 @@ void RSL_select_fields(char *field_type, ...)
    */
    
   c_field = field_type;
-  va_start(ap, field_type);
 
-  if (radar_verbose_flag) fprintf(stderr,"Selected fields for ingest:");
+  if (rsl_reader_is_verbose(r)) fprintf(stderr,"Selected fields for ingest:");
   while (c_field) {
     /* CHECK EACH FIELD. This is a fancier case statement than C provides. */
-    if (radar_verbose_flag) fprintf(stderr," %s", c_field);
+    if (rsl_reader_is_verbose(r)) fprintf(stderr," %s", c_field);
     if (strcasecmp(c_field, "all") == 0) {
-      for (i=0; i<MAX_RADAR_VOLUMES; i++) rsl_qfield[i] = 1;
+      for (i=0; i<MAX_RADAR_VOLUMES; i++) r->qfield[i] = 1;
     } else if (strcasecmp(c_field, "none") == 0) {
-      for (i=0; i<MAX_RADAR_VOLUMES; i++) rsl_qfield[i] = 0;
+      for (i=0; i<MAX_RADAR_VOLUMES; i++) r->qfield[i] = 0;
     } else {
     
       for (i=0; i<MAX_RADAR_VOLUMES; i++)
         if (strcasecmp(c_field, RSL_ftype[i]) == 0) {
-          rsl_qfield[i] = 1;
+          r->qfield[i] = 1;
           break; /* Break the for loop. */
         }
       
       if (i == MAX_RADAR_VOLUMES) {
-        if (radar_verbose_flag)
+        if (rsl_reader_is_verbose(r))
           fprintf(stderr, "\nRSL_select_fields: Invalid field name <<%s>> specified.\n", c_field);
       }
     }
     c_field = va_arg(ap, char *);
   }
 
-  if (radar_verbose_flag) fprintf(stderr,"\n");
+  if (rsl_reader_is_verbose(r)) fprintf(stderr,"\n");
+}
+
+void RSL_select_fields(char *field_type, ...)
+{
+  /* Select the fields for the reader bound to this thread; normally
+   * the default reader used by the *_to_radar routines.
+   */
+  va_list ap;
+
+  va_start(ap, field_type);
+  select_fields(rsl_reader(), field_type, ap);
   va_end(ap);
+  rsl_reader_sync(rsl_reader());
+}
 
+void RSL_reader_select_fields(Rsl_reader *r, char *field_type, ...)
+{
+  va_list ap;
+
+  va_start(ap, field_type);
+  select_fields(r, field_type, ap);
+  va_end(ap);
 }
 
 
@@ -1490,7 +1552,7 @@ int rsl_query_field(char *c_field)
    * 10/15/96
    * RSL interface, for library code developers, to rsl ingest code,
    * which is intended to be part of RSL ingest code, which access
-   * the hidden array 'rsl_qfield' and reports if that field is to
+   * the current reader's 'qfield' array and reports if that field is to
    * be ingested.
    *
    * Return 1 if YES, meaning yes ingest this field type.
@@ -1508,6 +1570,7 @@ int rsl_query_field(char *c_field)
    *
    * The application interface is RSL_select_fields.
    */
+  Rsl_reader *r = rsl_reader();
   int i;
   
   /* Quiet the compilier when -pedantic. :-) */
@@ -1516,7 +1579,7 @@ int rsl_query_field(char *c_field)
 
   for (i=0; i<MAX_RADAR_VOLUMES; i++)
     if (strcasecmp(c_field, RSL_ftype[i]) == 0) {
-      rsl_qfield[i] = 1;
+      r->qfield[i] = 1;
       break; /* Break the for loop. */
     }
   
@@ -1526,26 +1589,19 @@ int rsl_query_field(char *c_field)
     fprintf(stderr, "rsl_query_field: Invalid field name <<%s>> specified.\n", c_field);
   }
   
+  rsl_reader_sync(r);
   /* 'i' is the index. Is it set? */
-  return rsl_qfield[i];
+  return r->qfield[i];
 }
 
 
-/* Could be static and force use of 'rsl_query_sweep' */
-int *rsl_qsweep = NULL;  /* If NULL, then read all sweeps. Otherwise,
-                          * read what is on the list.
-                          */
-#define RSL_MAX_QSWEEP 500 /* It'll be rediculious to have more. :-) */
-int rsl_qsweep_max = RSL_MAX_QSWEEP;
-
 /*********************************************************************/
 /*                                                                   */
 /*                 RSL_read_these_sweeps                             */
 /*                                                                   */
 /*********************************************************************/
-void RSL_read_these_sweeps(char *csweep, ...)
+static void read_these_sweeps(Rsl_reader *r, char *csweep, va_list ap)
 {
-  va_list ap;
   char *c_sweep;
   int i, isweep;
 
@@ -1557,11 +1613,10 @@ void RSL_read_these_sweeps(char *csweep, ...)
    */
    
   c_sweep = csweep;
-  va_start(ap, csweep);
 
-  rsl_qsweep_max = -1;
-  if (rsl_qsweep == NULL) 
-    rsl_qsweep = (int *)calloc(RSL_MAX_QSWEEP, sizeof(int));
+  r->qsweep_max = -1;
+  if (r->qsweep == NULL) 
+    r->qsweep = (int *)calloc(RSL_MAX_QSWEEP, sizeof(int));
 
   /* else Clear the array - a second call to this function over-rides
    * any previous settings.  This holds even if the second call has
@@ -1569,42 +1624,60 @@ void RSL_read_these_sweeps(char *csweep, ...)
    */
   else 
     for(i = 0;i< RSL_MAX_QSWEEP; i++) 
-      rsl_qsweep[i] = 0;
+      r->qsweep[i] = 0;
 
 
-  if (radar_verbose_flag) fprintf(stderr,"Selected sweeps for ingest:");
+  if (rsl_reader_is_verbose(r)) fprintf(stderr,"Selected sweeps for ingest:");
   for (;c_sweep;    c_sweep = va_arg(ap, char *))
     {
     /* CHECK EACH FIELD. This is a fancier case statement than C provides. */
-    if (radar_verbose_flag) fprintf(stderr," %s", c_sweep);
+    if (rsl_reader_is_verbose(r)) fprintf(stderr," %s", c_sweep);
     if (strcasecmp(c_sweep, "all") == 0) {
-      for (i=0; i<RSL_MAX_QSWEEP; i++) rsl_qsweep[i] = 1;
-      rsl_qsweep_max = RSL_MAX_QSWEEP;
+      for (i=0; i<RSL_MAX_QSWEEP; i++) r->qsweep[i] = 1;
+      r->qsweep_max = RSL_MAX_QSWEEP;
     } else if (strcasecmp(c_sweep, "none") == 0) {
      /* Commented this out to save runtime -GJW
-      * rsl_qsweep[] already initialized to 0 above.
+      * r->qsweep[] already initialized to 0 above.
       *
-      * for (i=0; i<RSL_MAX_QSWEEP; i++) rsl_qsweep[i] = 0;
-      * rsl_qsweep_max = -1;
+      * for (i=0; i<RSL_MAX_QSWEEP; i++) r->qsweep[i] = 0;
+      * r->qsweep_max = -1;
       */
     } else {
       i = sscanf(c_sweep,"%d", &isweep);
       if (i == 0) { /* No match, bad argument. */
-        if (radar_verbose_flag) fprintf(stderr,"\nRSL_read_these_sweeps: bad parameter %s.  Ignoring.\n", c_sweep);
+        if (rsl_reader_is_verbose(r)) fprintf(stderr,"\nRSL_read_these_sweeps: bad parameter %s.  Ignoring.\n", c_sweep);
         continue;
       }
 
-      if (isweep < 0 || isweep > RSL_MAX_QSWEEP) {
-        if (radar_verbose_flag) fprintf(stderr,"\nRSL_read_these_sweeps: parameter %s not in [0,%d).  Ignoring.\n", c_sweep, RSL_MAX_QSWEEP);
+      if (isweep < 0 || isweep >= RSL_MAX_QSWEEP) {
+        if (rsl_reader_is_verbose(r)) fprintf(stderr,"\nRSL_read_these_sweeps: parameter %s not in [0,%d).  Ignoring.\n", c_sweep, RSL_MAX_QSWEEP);
         continue;
       }
 
-      if (isweep > rsl_qsweep_max) rsl_qsweep_max = isweep;
-      rsl_qsweep[isweep] = 1;
+      if (isweep > r->qsweep_max) r->qsweep_max = isweep;
+      r->qsweep[isweep] = 1;
     }
   }
 
-  if (radar_verbose_flag) fprintf(stderr,"\n");
+  if (rsl_reader_is_verbose(r)) fprintf(stderr,"\n");
+}
+
+void RSL_read_these_sweeps(char *csweep, ...)
+{
+  va_list ap;
+
+  va_start(ap, csweep);
+  read_these_sweeps(rsl_reader(), csweep, ap);
+  va_end(ap);
+  rsl_reader_sync(rsl_reader());
+}
+
+void RSL_reader_read_these_sweeps(Rsl_reader *r, char *csweep, ...)
+{
+  va_list ap;
+
+  va_start(ap, csweep);
+  read_these_sweeps(r, csweep, ap);
   va_end(ap);
 }
 
@@ -1653,14 +1726,24 @@ void RSL_add_dbz_offset_to_ray(Ray *r, float dbz_offset)
 {
   int ibin;
   float val; 
+  float *f;
 
   if (r == NULL) return;
-  for (ibin=0; ibin<r->h.nbins; ibin++)
-  {
-    val = r->h.f(r->range[ibin]);
-    if ( val >= (float)NOECHO ) continue;  /* Invalid value */
-    r->range[ibin] = r->h.invf(val + dbz_offset);
-  }
+  f = RSL_f_table(r->h.f);
+  if (f)
+    for (ibin=0; ibin<r->h.nbins; ibin++)
+    {
+      val = f[r->range[ibin]];
+      if ( val >= (float)NOECHO ) continue;  /* Invalid value */
+      r->range[ibin] = r->h.invf(val + dbz_offset);
+    }
+  else
+    for (ibin=0; ibin<r->h.nbins; ibin++)
+    {
+      val = r->h.f(r->range[ibin]);
+      if ( val >= (float)NOECHO ) continue;  /* Invalid value */
+      r->range[ibin] = r->h.invf(val + dbz_offset);
+    }
 }
 
 /*********************************************************************/
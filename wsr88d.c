@@ -229,32 +229,6 @@ void wsr88d_print_sweep_info(Wsr88d_sweep *s)
 }
 
 
-// adapted from uncompress_pipe in gzip.c
-FILE *uncompress_pipe_ar2v (FILE *fp)
-{
-  /* Pass the file pointed to by 'fp' through the bzip2 pipe. */
-
-  FILE *fpipe;
-  int save_fd;
-
-  if (no_command("wsr88d_decode_ar2v > /dev/null")){
-    fprintf(stderr, "wsr88d_decode_ar2v not found, aborting ...\n");
-    return fp;
-  }
-  save_fd = dup(0);
-  close(0); /* Redirect stdin for gzip. */
-  dup(fileno(fp));
-
-  fpipe = popen("wsr88d_decode_ar2v --stdout", "r");
-  if (fpipe == NULL) perror("uncompress_pipe_ar2v");
-  close(0);
-  dup(save_fd);
-  close(save_fd);
-  fclose(fp);
-  return fpipe;
-}
-
-
 /**********************************************************************/
 /*                                                                    */
 /*  done 2/28             wsr88d_open                                 */
@@ -263,51 +237,65 @@ FILE *uncompress_pipe_ar2v (FILE *fp)
 
 Wsr88d_file *wsr88d_open(char *filename)
 {
-  Wsr88d_file *wf = (Wsr88d_file *)malloc(sizeof(Wsr88d_file));
   int save_fd;
+  FILE *fp;
 
   if ( strcmp(filename, "stdin") == 0 ) {
     save_fd = dup(0);
-    wf->fptr = fdopen(save_fd,"r");
+    fp = fdopen(save_fd,"r");
   } else {
-    wf->fptr = fopen(filename, "r");
+    fp = fopen(filename, "r");
   }
+  return wsr88d_open_fp(fp);
+}
+
+Wsr88d_file *wsr88d_open_mem(char *buf, size_t len)
+{
+  /* 'buf' is read in place; keep it until wsr88d_close. */
+  return wsr88d_open_fp(rsl_mem_fopen(buf, len));
+}
 
-  if (wf->fptr == NULL) return NULL;
+Wsr88d_file *wsr88d_open_fp(FILE *fptr)
+{
+  /* Read the volume from 'fptr', which is owned by the Wsr88d_file. */
+  Wsr88d_file *wf;
+  FILE *fp;
+
+  if (fptr == NULL) return NULL;
+  wf = (Wsr88d_file *)malloc(sizeof(Wsr88d_file));
+  if (wf == NULL) {
+    fclose(fptr);
+    return NULL;
+  }
+  wf->fptr = fptr;
 
   // first check how the data are compressed by reading first few of magic bytes
-  char hdrplus4[28];
-  char bzmagic[4];
-  int ar2v6bzip = 0;
+  char hdrplus4[28+4];
+  char *bzmagic = &hdrplus4[28];
   fpos_t pos;
-  fgetpos(wf->fptr, &pos);
+  int seekable;
+  seekable = fgetpos(wf->fptr, &pos) == 0;
   if (fread(hdrplus4, sizeof(hdrplus4), 1, wf->fptr) != 1) {
-     fprintf(stderr,"failed to read first 28 bytes of Wsr88d file");
-     return NULL;
-  }
-  if (fread(bzmagic, sizeof(bzmagic), 1, wf->fptr) != 1) {
-     fprintf(stderr,"failed to read bzip magic bytes from Wsr88d file");
+     fprintf(stderr,"failed to read first 32 bytes of Wsr88d file");
+     fclose(wf->fptr);
+     free(wf);
      return NULL;
   }
-  // test for bzip2 magic.
-  if (strncmp("BZ",bzmagic,2) == 0) ar2v6bzip = 1;
 
-  fclose(wf->fptr);
-
-  // reopen the file
-  if ( strcmp(filename, "stdin") == 0 ) {
-     save_fd = dup(0);
-     wf->fptr = fdopen(save_fd,"r");
-  } else {
-     wf->fptr = fopen(filename, "r");
+  // test for bzip2 magic.  Decode the bzip2 blocks in this process.
+  if (strncmp("BZ",bzmagic,2) == 0) {
+     fp = wsr88d_ar2v_open(wf->fptr, hdrplus4, sizeof(hdrplus4));
+     if (fp != NULL) wf->fptr = fp;
+     else { /* No custom stdio streams; use the external decoder. */
+       if (seekable) fsetpos(wf->fptr, &pos);
+       wf->fptr = uncompress_pipe_ar2v(wf->fptr);
+     }
   }
- 
-  // decompress
-  if(ar2v6bzip){
-     wf->fptr = uncompress_pipe_ar2v(wf->fptr);
-  }
-  else{
-     wf->fptr = uncompress_pipe(wf->fptr);
+  else {
+     // put back what we read, then decompress
+     if (seekable && fsetpos(wf->fptr, &pos) == 0) fp = wf->fptr;
+     else fp = rsl_unread(wf->fptr, hdrplus4, sizeof(hdrplus4));
+     wf->fptr = uncompress_pipe(fp);
   }
 
   #define NEW_BUFSIZ 16384
@@ -798,7 +786,7 @@ void wsr88d_get_date(Wsr88d_ray *ray, int *mm, int *dd, int *yy)
  * yy (ex. 93)
  */
   time_t itime;
-  struct tm *tm_time;
+  struct tm tm_time;
   if (ray == NULL) {
     *mm = *dd = *yy = 0;
     return;
@@ -807,10 +795,11 @@ void wsr88d_get_date(Wsr88d_ray *ray, int *mm, int *dd, int *yy)
   itime = ray->ray_date - 1;
   itime *= 24*60*60; /* Seconds/day * days. */
 
-  tm_time = gmtime(&itime);
-  *mm = tm_time->tm_mon+1;
-  *dd = tm_time->tm_mday;
-  *yy = tm_time->tm_year;
+  /* gmtime_r: Message 31 radials may be decoded on several threads. */
+  gmtime_r(&itime, &tm_time);
+  *mm = tm_time.tm_mon+1;
+  *dd = tm_time.tm_mday;
+  *yy = tm_time.tm_year;
 }
 
 void wsr88d_get_time(Wsr88d_ray *ray, int *hh, int *mm, int *ss, float *fsec)
@@ -873,7 +862,7 @@ int *wsr88d_get_vcp_info(int vcp_num,int el_num)
 /*
  * This routine from Dan Austin.  Program component of nex2uf.
  */
-    static int vcp_info[4];
+    static RSL_THREAD_LOCAL int vcp_info[4];
     int fix_angle;
     int pulse_cnt;
     int az_rate;
@@ -9,6 +9,17 @@
 #ifndef WSR88D_SITE_INFO_FILE
 #define WSR88D_SITE_INFO_FILE "/usr/local/trmm/lib/wsr88d_locations.dat"
 #endif
+
+/* Per-thread decoder scratch; see rsl.h. */
+#ifndef RSL_THREAD_LOCAL
+# if defined(__GNUC__)
+# define RSL_THREAD_LOCAL __thread
+# elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+# define RSL_THREAD_LOCAL _Thread_local
+# else
+# define RSL_THREAD_LOCAL
+# endif
+#endif
 /*===============================================================*/
 typedef struct {
   char archive2[8];    /* Always ARCHIVE2 */
@@ -142,6 +153,9 @@ typedef struct {
   FILE *fptr;
 } Wsr88d_file;
 
+/* Incremental Message 31 ingest; see wsr88d_m31.c. */
+typedef struct _wsr88d_m31_stream Wsr88d_m31_stream;
+
 #define PACKET_SIZE 2432
 typedef Wsr88d_packet Wsr88d_ray;    /* Same thing, different name. */
 
@@ -179,6 +193,8 @@ typedef struct {
 /*                                                                     */
 /***********************************************************************/
 Wsr88d_file *wsr88d_open(char *filename);
+Wsr88d_file *wsr88d_open_mem(char *buf, size_t len);
+Wsr88d_file *wsr88d_open_fp(FILE *fp);
 int wsr88d_perror(char *message);
 int wsr88d_close(Wsr88d_file *wf);
 int wsr88d_read_file_header(Wsr88d_file *wf,
@@ -215,5 +231,12 @@ int no_command (char *cmd);
 FILE *uncompress_pipe (FILE *fp);
 FILE *compress_pipe (FILE *fp);
 int rsl_pclose(FILE *fp);
+FILE *rsl_unread(FILE *fp, char *buf, int n);
+FILE *wsr88d_ar2v_open(FILE *fp, char *pend, int npend);
+int wsr88d_ar2v_decompress(char *block, unsigned int length,
+				char **oblock, unsigned int *osize,
+				unsigned int *olength);
+FILE *uncompress_pipe_ar2v (FILE *fp);
+FILE *rsl_mem_fopen(char *buf, size_t len);
 
 #endif
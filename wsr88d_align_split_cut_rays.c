@@ -34,13 +34,19 @@ void replace_ray_gaps_with_null(Sweep *sweep)
      * NULL where rays are missing.
      */
     for (i=0, j=0; i<maxrays; i++)
-        if (sweep->ray[j] && sweep->ray[j]->h.ray_num == i+1)
+        if (j < nrays && sweep->ray[j] && sweep->ray[j]->h.ray_num == i+1)
             newsweep->ray[i] = sweep->ray[j++];
 
-    /* Copy rays back to original sweep. */
+    /* Copy rays back to original sweep, which may be shorter than maxrays. */
+    if (RSL_reserve_rays(sweep, maxrays) < 0) {
+        free(newsweep->ray);
+        free(newsweep);
+        return;
+    }
     for (i=0; i<maxrays; i++) sweep->ray[i] = newsweep->ray[i];
 
     sweep->h.nrays = maxrays;
+    RSL_sweep_changed(sweep);
     free(newsweep);
 }
 
@@ -202,6 +208,7 @@ static void remove_excess_rays(Radar *radar, int iswp)
                 }
             }
             radar->v[ivol]->sweep[iswp]->h.nrays = nrays_vr;
+            RSL_sweep_changed(radar->v[ivol]->sweep[iswp]);
         }
     }
 
@@ -296,6 +303,8 @@ static void reorder_rays(Sweep *dzsweep, Sweep *vrsweep, Sweep *swsweep)
     /* Copy ray pointers in new order back to original sweeps. */
     /* TODO: Can we simply replace the sweeps themselves with the new sweeps? */
 
+    if (RSL_reserve_rays(vrsweep, maxrays) < 0 ||
+        (swsweep && RSL_reserve_rays(swsweep, maxrays) < 0)) return;
     for (i=0; i < maxrays; i++) {
         vrsweep->ray[i] = new_vrsweep->ray[i];
         if (swsweep) swsweep->ray[i] = new_swsweep->ray[i];
@@ -307,6 +316,8 @@ static void reorder_rays(Sweep *dzsweep, Sweep *vrsweep, Sweep *swsweep)
      */
     vrsweep->h.nrays = maxrays;
     if (swsweep) swsweep->h.nrays = maxrays;
+    RSL_sweep_changed(vrsweep);
+    RSL_sweep_changed(swsweep);
 }
 
 
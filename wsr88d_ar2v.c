@@ -0,0 +1,523 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Decoding of Archive II (AR2V0006 and later) files, whose LDM records are
+ * each compressed with bzip2.  The file is a 24 byte volume header
+ * followed by blocks of
+ *
+ *   4 byte big-endian length (negative for the last block)
+ *   'length' bytes of bzip2 data
+ *
+ * This is the block loop of wsr88d_decode_ar2v, done inside the library.
+ * wsr88d_ar2v_open returns a stdio stream of the decompressed volume so
+ * the Message 31 reader is unchanged.
+ *
+ * The blocks are independent.  With RSL_wsr88d_decode_threads(n), n > 1,
+ * the whole compressed file is read, the block lengths are scanned, and a
+ * pool of n threads decompresses blocks ahead of the reader, which still
+ * receives them in file order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <bzlib.h>
+#include <pthread.h>
+#include "rsl.h"
+#include "wsr88d.h"
+
+#define AR2V_HEADER_SIZE 24
+#define AR2V_OBLOCK_SIZE 262144
+#define AR2V_MAX_THREADS 64
+#define AR2V_WINDOW 4  /* Blocks decoded ahead of the reader, per thread. */
+#define AR2V_MAX_BLOCK (16*1024*1024) /* Far above any real block. */
+
+void RSL_reader_wsr88d_decode_threads(Rsl_reader *r, int nthreads)
+{
+  /* Number of threads used to decompress AR2V blocks and to decode
+   * Message 31 radials (see wsr88d_m31.c).  0 or 1 decodes sequentially,
+   * as the blocks are read.
+   */
+  if (nthreads < 0) nthreads = 0;
+  if (nthreads > AR2V_MAX_THREADS) nthreads = AR2V_MAX_THREADS;
+  r->decode_threads = nthreads;
+}
+
+void RSL_wsr88d_decode_threads(int nthreads)
+{
+  RSL_reader_wsr88d_decode_threads(rsl_reader(), nthreads);
+}
+
+typedef struct {
+  FILE *fp;              /* Compressed file.  Owned by this stream. */
+  char *pend;            /* Bytes read from 'fp' while sniffing. */
+  int   npend;
+  char *block;           /* Compressed block. */
+  unsigned int isize;
+  char *oblock;          /* Decompressed block. */
+  unsigned int osize;
+  unsigned int olength;  /* Bytes in oblock ... */
+  unsigned int opos;     /* ... and how many were delivered. */
+  int last;              /* The final block has been read. */
+} Ar2v_stream;
+
+int wsr88d_ar2v_decompress(char *block, unsigned int length,
+						   char **oblock, unsigned int *osize,
+						   unsigned int *olength)
+{
+  /* Decompress one block into *oblock, growing it as needed.
+   * Return 0 on success, -1 on error.  Also used by wsr88d_stream.c.
+   */
+  int error;
+  char *p;
+
+  for (;;) {
+	if (*osize > 0) {
+	  *olength = *osize;
+	  error = BZ2_bzBuffToBuffDecompress(*oblock, olength, block, length, 0, 0);
+	  if (error != BZ_OUTBUFF_FULL) break;
+	}
+	if ((p = (char *)realloc(*oblock, *osize + AR2V_OBLOCK_SIZE)) == NULL) {
+	  perror("wsr88d_ar2v");
+	  return -1;
+	}
+	*oblock = p;
+	*osize += AR2V_OBLOCK_SIZE;
+  }
+  if (error != BZ_OK) {
+	fprintf(stderr, "wsr88d_ar2v: decompress error - %d\n", error);
+	return -1;
+  }
+  return 0;
+}
+
+static size_t ar2v_fread(Ar2v_stream *s, void *buf, size_t n)
+{
+  /* fread, but first drain the bytes we already took from the file. */
+  size_t m = 0;
+
+  if (s->npend > 0) {
+	m = n < (size_t)s->npend ? n : (size_t)s->npend;
+	memcpy(buf, s->pend, m);
+	memmove(s->pend, s->pend + m, s->npend - m);
+	s->npend -= m;
+  }
+  if (m < n) m += fread((char *)buf + m, 1, n - m, s->fp);
+  return m;
+}
+
+static int ar2v_next_block(Ar2v_stream *s)
+{
+  /* Fill oblock with the next piece of the volume.
+   * Return 1 on success, 0 at end of file, -1 on error.
+   */
+  unsigned char clength[4];
+  unsigned int olength, length;
+  uint32_t word;
+  int i;
+
+  s->olength = s->opos = 0;
+  while (s->olength == 0) {
+	if (s->last) return 0;
+	if (ar2v_fread(s, clength, 4) != 4) return 0;
+
+	/* The volume header passes through uncompressed. */
+	if (memcmp(clength, "ARCH", 4) == 0 || memcmp(clength, "AR2V", 4) == 0) {
+	  memcpy(s->oblock, clength, 4);
+	  if (ar2v_fread(s, s->oblock+4, AR2V_HEADER_SIZE-4) != AR2V_HEADER_SIZE-4) {
+		fprintf(stderr, "wsr88d_ar2v: Missing header\n");
+		return -1;
+	  }
+	  s->olength = AR2V_HEADER_SIZE;
+	  return 1;
+	}
+
+	/* Negative, in two's complement, for the last compressed block. */
+	word = 0;
+	for (i=0; i<4; i++)
+	  word = (word << 8) | clength[i];
+	if (word & 0x80000000) {
+	  length = 0u - word;
+	  s->last = 1;
+	} else length = word;
+	if (length > AR2V_MAX_BLOCK) {
+	  fprintf(stderr, "wsr88d_ar2v: Bad block length %u\n", length);
+	  return -1;
+	}
+
+	if (length > s->isize) {
+	  char *block = (char *)realloc(s->block, length);
+	  if (block == NULL) {
+		perror("wsr88d_ar2v");
+		return -1;
+	  }
+	  s->block = block;
+	  s->isize = length;
+	}
+	if (ar2v_fread(s, s->block, length) != (size_t)length) {
+	  fprintf(stderr, "wsr88d_ar2v: Short block read!\n");
+	  return -1;
+	}
+	if (length <= 10) continue;
+
+	if (wsr88d_ar2v_decompress(s->block, length,
+						&s->oblock, &s->osize, &olength) < 0) return -1;
+	s->olength = olength;
+  }
+  return 1;
+}
+
+static long ar2v_read(void *cookie, char *buf, size_t size)
+{
+  Ar2v_stream *s = (Ar2v_stream *)cookie;
+  size_t n = 0, m;
+  int rc;
+
+  while (n < size) {
+	if (s->opos == s->olength) {
+	  rc = ar2v_next_block(s);
+	  if (rc < 0) return n > 0 ? (long)n : -1;
+	  if (rc == 0) break;
+	}
+	m = s->olength - s->opos;
+	if (m > size - n) m = size - n;
+	memcpy(buf + n, s->oblock + s->opos, m);
+	s->opos += m;
+	n += m;
+  }
+  return n;
+}
+
+static int ar2v_close(void *cookie)
+{
+  Ar2v_stream *s = (Ar2v_stream *)cookie;
+  int rc;
+
+  rc = fclose(s->fp);
+  free(s->pend);
+  free(s->block);
+  free(s->oblock);
+  free(s);
+  return rc;
+}
+
+
+/**********************************************************************/
+/*                                                                    */
+/*  Parallel decoding.                                                */
+/*                                                                    */
+/**********************************************************************/
+enum {AR2V_PENDING, AR2V_BUSY, AR2V_DONE, AR2V_FAILED};
+
+typedef struct {
+  char *data;            /* Compressed bytes, within the file image. */
+  unsigned int length;
+  int header;            /* Uncompressed volume header. */
+  char *out;             /* Decompressed block. */
+  unsigned int osize;
+  unsigned int olength;
+  int state;
+} Ar2v_block;
+
+typedef struct {
+  char *image;           /* The whole compressed file. */
+  Ar2v_block *blocks;
+  int nblocks;
+  int next;              /* Next block for a decoder. */
+  int deliver;           /* Block being handed to the reader. */
+  unsigned int opos;
+  int window;
+  int quit;
+  int nthreads;
+  pthread_t threads[AR2V_MAX_THREADS];
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} Ar2v_pstream;
+
+static char *ar2v_slurp(FILE *fp, char *pend, int npend, size_t *n)
+{
+  /* Read the rest of 'fp' into memory, after the 'npend' bytes in 'pend'. */
+  size_t size = 4*1024*1024, m;
+  char *image, *p;
+
+  if ((image = (char *)malloc(size)) == NULL) return NULL;
+  memcpy(image, pend, npend);
+  *n = npend;
+  while ((m = fread(image + *n, 1, size - *n, fp)) > 0) {
+	*n += m;
+	if (*n == size) {
+	  if ((p = (char *)realloc(image, 2*size)) == NULL) {
+		free(image);
+		return NULL;
+	  }
+	  image = p;
+	  size *= 2;
+	}
+  }
+  return image;
+}
+
+static int ar2v_scan_blocks(Ar2v_pstream *s, size_t nimage)
+{
+  /* Walk the length prefixes and record where each block is.
+   * Return the number of blocks.
+   */
+  size_t pos = 0;
+  unsigned int length;
+  uint32_t word;
+  int i, nalloc = 0, last = 0;
+  unsigned char *c;
+  Ar2v_block *b;
+
+  s->nblocks = 0;
+  while (!last && pos + 4 <= nimage) {
+	c = (unsigned char *)s->image + pos;
+	if (s->nblocks == nalloc) {
+	  nalloc = nalloc ? 2*nalloc : 256;
+	  b = (Ar2v_block *)realloc(s->blocks, nalloc*sizeof(Ar2v_block));
+	  if (b == NULL) return -1;
+	  s->blocks = b;
+	}
+	b = &s->blocks[s->nblocks];
+	memset(b, 0, sizeof(Ar2v_block));
+	if (memcmp(c, "ARCH", 4) == 0 || memcmp(c, "AR2V", 4) == 0) {
+	  if (pos + AR2V_HEADER_SIZE > nimage) {
+		fprintf(stderr, "wsr88d_ar2v: Missing header\n");
+		break;
+	  }
+	  b->data = (char *)c;
+	  b->length = AR2V_HEADER_SIZE;
+	  b->header = 1;
+	  pos += AR2V_HEADER_SIZE;
+	  s->nblocks++;
+	  continue;
+	}
+	word = 0;
+	for (i=0; i<4; i++)
+	  word = (word << 8) | c[i];
+	if (word & 0x80000000) {
+	  length = 0u - word;
+	  last = 1;
+	} else length = word;
+	pos += 4;
+	if (length > AR2V_MAX_BLOCK || pos + length > nimage) {
+	  fprintf(stderr, "wsr88d_ar2v: Short block read!\n");
+	  break;
+	}
+	b->data = s->image + pos;
+	b->length = length;
+	pos += length;
+	if (length > 10) s->nblocks++;
+  }
+  return s->nblocks;
+}
+
+static int ar2v_decode_block(Ar2v_block *b)
+{
+  /* Return the new state of the block. */
+  int rc = 0;
+
+  if (b->header) {
+	b->out = (char *)malloc(b->length);
+	if (b->out != NULL) memcpy(b->out, b->data, b->length);
+	b->olength = b->length;
+  } else {
+	b->osize = AR2V_OBLOCK_SIZE;
+	b->out = (char *)malloc(b->osize);
+	if (b->out != NULL)
+	  rc = wsr88d_ar2v_decompress(b->data, b->length, &b->out, &b->osize, &b->olength);
+  }
+  return (b->out == NULL || rc < 0) ? AR2V_FAILED : AR2V_DONE;
+}
+
+static void *ar2v_worker(void *arg)
+{
+  Ar2v_pstream *s = (Ar2v_pstream *)arg;
+  Ar2v_block *b;
+  int state;
+
+  pthread_mutex_lock(&s->lock);
+  for (;;) {
+	while (!s->quit &&
+		   (s->next >= s->nblocks || s->next >= s->deliver + s->window))
+	  pthread_cond_wait(&s->cond, &s->lock);
+	if (s->quit) break;
+	b = &s->blocks[s->next++];
+	b->state = AR2V_BUSY;
+	pthread_mutex_unlock(&s->lock);
+	state = ar2v_decode_block(b);
+	pthread_mutex_lock(&s->lock);
+	b->state = state;
+	pthread_cond_broadcast(&s->cond);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+static long ar2v_pread(void *cookie, char *buf, size_t size)
+{
+  Ar2v_pstream *s = (Ar2v_pstream *)cookie;
+  Ar2v_block *b;
+  size_t n = 0, m;
+  int state;
+
+  while (n < size && s->deliver < s->nblocks) {
+	b = &s->blocks[s->deliver];
+	pthread_mutex_lock(&s->lock);
+	if (b->state == AR2V_PENDING && s->next == s->deliver) {
+	  /* Nobody has it yet; decode it here rather than wait. */
+	  s->next++;
+	  b->state = AR2V_BUSY;
+	  pthread_mutex_unlock(&s->lock);
+	  state = ar2v_decode_block(b);
+	  pthread_mutex_lock(&s->lock);
+	  b->state = state;
+	}
+	while (b->state == AR2V_PENDING || b->state == AR2V_BUSY)
+	  pthread_cond_wait(&s->cond, &s->lock);
+	state = b->state;
+	if (state == AR2V_FAILED) {
+	  s->deliver = s->nblocks;
+	  pthread_cond_broadcast(&s->cond);
+	  pthread_mutex_unlock(&s->lock);
+	  return n > 0 ? (long)n : -1;
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	m = b->olength - s->opos;
+	if (m > size - n) m = size - n;
+	memcpy(buf + n, b->out + s->opos, m);
+	s->opos += m;
+	n += m;
+	if (s->opos == b->olength) { /* Done with this block. */
+	  free(b->out);
+	  b->out = NULL;
+	  s->opos = 0;
+	  pthread_mutex_lock(&s->lock);
+	  s->deliver++;
+	  pthread_cond_broadcast(&s->cond);
+	  pthread_mutex_unlock(&s->lock);
+	}
+  }
+  return n;
+}
+
+static int ar2v_pclose(void *cookie)
+{
+  Ar2v_pstream *s = (Ar2v_pstream *)cookie;
+  int i;
+
+  pthread_mutex_lock(&s->lock);
+  s->quit = 1;
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+  for (i=0; i<s->nthreads; i++)
+	pthread_join(s->threads[i], NULL);
+  for (i=0; i<s->nblocks; i++)
+	free(s->blocks[i].out);
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->cond);
+  free(s->blocks);
+  free(s->image);
+  free(s);
+  return 0;
+}
+
+static FILE *wsr88d_ar2v_popen(FILE *fp, char *pend, int npend, int nthreads)
+{
+  Ar2v_pstream *s;
+  FILE *zfp;
+  size_t nimage;
+  int i;
+
+  s = (Ar2v_pstream *)calloc(1, sizeof(Ar2v_pstream));
+  if (s == NULL) return NULL;
+  if ((s->image = ar2v_slurp(fp, pend, npend, &nimage)) == NULL ||
+	  ar2v_scan_blocks(s, nimage) < 0) {
+	perror("wsr88d_ar2v_open");
+	free(s->image);
+	free(s->blocks);
+	free(s);
+	return NULL;
+  }
+  s->window = AR2V_WINDOW * nthreads;
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->cond, NULL);
+
+  zfp = rsl_fopen_reader(s, ar2v_pread, ar2v_pclose);
+  if (zfp == NULL) {
+	ar2v_pclose(s);
+	return NULL;
+  }
+  fclose(fp); /* Everything is in memory now. */
+  /* The reader decodes blocks itself if no thread can be started. */
+  for (i=0; i<nthreads; i++) {
+	if (pthread_create(&s->threads[i], NULL, ar2v_worker, s) != 0) break;
+	s->nthreads++;
+  }
+  return zfp;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                     wsr88d_ar2v_open                               */
+/*                                                                    */
+/*  'fp' is an AR2V file from which the first 'npend' bytes, in       */
+/*  'pend', have already been read.  Return a stream of the           */
+/*  decompressed volume, or NULL if one cannot be made.  The stream   */
+/*  owns 'fp'.                                                        */
+/*                                                                    */
+/**********************************************************************/
+FILE *wsr88d_ar2v_open(FILE *fp, char *pend, int npend)
+{
+  Ar2v_stream *s;
+  FILE *zfp;
+  int nthreads;
+
+  nthreads = rsl_reader()->decode_threads;
+  if (nthreads > 1)
+	return wsr88d_ar2v_popen(fp, pend, npend, nthreads);
+
+  s = (Ar2v_stream *)calloc(1, sizeof(Ar2v_stream));
+  if (s == NULL) return NULL;
+  s->fp = fp;
+  s->isize = 8192;
+  s->osize = AR2V_OBLOCK_SIZE;
+  s->block  = (char *)malloc(s->isize);
+  s->oblock = (char *)malloc(s->osize);
+  s->pend   = (char *)malloc(npend > 0 ? npend : 1);
+  if (s->block == NULL || s->oblock == NULL || s->pend == NULL) {
+	perror("wsr88d_ar2v_open");
+	free(s->block); free(s->oblock); free(s->pend); free(s);
+	return NULL;
+  }
+  memcpy(s->pend, pend, npend);
+  s->npend = npend;
+
+  zfp = rsl_fopen_reader(s, ar2v_read, ar2v_close);
+  if (zfp == NULL) {
+	free(s->block); free(s->oblock); free(s->pend); free(s);
+  }
+  return zfp;
+}
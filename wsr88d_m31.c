@@ -32,7 +32,9 @@
 
 #include "rsl.h"
 #include "wsr88d.h"
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 /* Data descriptions in the following data structures are from the "Interface
  * Control Document for the RDA/RPG", Build 10.0 Draft, WSR-88D Radar
@@ -183,21 +185,29 @@ float wsr88d_get_azim_rate(short bitfield)
     return rate;
 }
 
-#define WSR88D_MAX_SWEEPS 30
+/* The most elevation cuts a Message Type 5 segment has room for. */
+#define WSR88D_MAX_CUTS 52
 
 typedef struct {
     int vcp;
     int num_cuts;
     float vel_res;
-    float fixed_angle[WSR88D_MAX_SWEEPS];
-    float azim_rate[WSR88D_MAX_SWEEPS];
-    int waveform[WSR88D_MAX_SWEEPS];
-    int super_res_ctrl[WSR88D_MAX_SWEEPS];
-    int surveil_prf_num[WSR88D_MAX_SWEEPS];
-    int doppler_prf_num[WSR88D_MAX_SWEEPS];
-} VCP_data;
+    float fixed_angle[WSR88D_MAX_CUTS+1];
+    float azim_rate[WSR88D_MAX_CUTS+1];
+    int waveform[WSR88D_MAX_CUTS+1];
+    int super_res_ctrl[WSR88D_MAX_CUTS+1];
+    int surveil_prf_num[WSR88D_MAX_CUTS+1];
+    int doppler_prf_num[WSR88D_MAX_CUTS+1];
+} VCP_data;  /* Cut WSR88D_MAX_CUTS is all 0, for sweeps not in the VCP. */
 
-static VCP_data vcp_data;
+static RSL_THREAD_LOCAL VCP_data vcp_data;
+
+static int vcp_cut(int i)
+{
+    /* Index of sweep i's cut in vcp_data. */
+    if (i < 0 || i >= vcp_data.num_cuts) return WSR88D_MAX_CUTS;
+    return i;
+}
 
 void wsr88d_get_vcp_data(short *msgtype5)
 {
@@ -206,12 +216,15 @@ void wsr88d_get_vcp_data(short *msgtype5)
     short chconf_and_waveform;
     int i;
     
+    memset(&vcp_data, 0, sizeof(vcp_data));
     vcp_data.vcp = (unsigned short) msgtype5[2];
     vcp_data.num_cuts = msgtype5[3];
     if (little_endian()) {
 	swap_2_bytes(&vcp_data.vcp);
 	swap_2_bytes(&vcp_data.num_cuts);
     }
+    if (vcp_data.num_cuts < 0) vcp_data.num_cuts = 0;
+    if (vcp_data.num_cuts > WSR88D_MAX_CUTS) vcp_data.num_cuts = WSR88D_MAX_CUTS;
     vel_res = msgtype5[5];
     if (little_endian()) swap_2_bytes(&vel_res);
     vel_res = vel_res >> 8;
@@ -276,11 +289,29 @@ void get_wsr88d_unamb_and_nyq_vel(Wsr88d_ray_m31 *wsr88d_ray, float *unamb_rng,
 }
 
 
+void wsr88d_m31_ray_from_data(Wsr88d_ray_m31 *wsr88d_ray)
+{
+    /* Set up the ray from the message in wsr88d_ray->data. */
+    float nyq_vel, unamb_rng;
+
+    /* Copy data header block to ray header structure. */
+    memcpy(&wsr88d_ray->ray_hdr, &wsr88d_ray->data, sizeof(Ray_header_m31));
+
+    if (little_endian()) wsr88d_swap_m31_ray_hdr(&wsr88d_ray->ray_hdr);
+
+    /* Retrieve unambiguous range and Nyquist velocity here so that we don't
+     * have to do it for each data moment later.
+     */
+    get_wsr88d_unamb_and_nyq_vel(wsr88d_ray, &unamb_rng, &nyq_vel);
+    wsr88d_ray->unamb_rng = unamb_rng;
+    wsr88d_ray->nyq_vel = nyq_vel;
+}
+
+
 int read_wsr88d_ray_m31(Wsr88d_file *wf, int msg_size,
 	Wsr88d_ray_m31 *wsr88d_ray)
 {
     int n;
-    float nyq_vel, unamb_rng;
 
     /* Read wsr88d ray. */
 
@@ -296,24 +327,17 @@ int read_wsr88d_ray_m31(Wsr88d_file *wf, int msg_size,
         }
     }
 
-    /* Copy data header block to ray header structure. */
-    memcpy(&wsr88d_ray->ray_hdr, &wsr88d_ray->data, sizeof(Ray_header_m31));
-
-    if (little_endian()) wsr88d_swap_m31_ray_hdr(&wsr88d_ray->ray_hdr);
-
-    /* Retrieve unambiguous range and Nyquist velocity here so that we don't
-     * have to do it for each data moment later.
-     */
-    get_wsr88d_unamb_and_nyq_vel(wsr88d_ray, &unamb_rng, &nyq_vel);
-    wsr88d_ray->unamb_rng = unamb_rng;
-    wsr88d_ray->nyq_vel = nyq_vel;
-
+    wsr88d_m31_ray_from_data(wsr88d_ray);
     return 1;
 }
 
 
-void wsr88d_load_ray_hdr(Wsr88d_ray_m31 *wsr88d_ray, Ray *ray)
+void wsr88d_load_ray_hdr(Wsr88d_ray_m31 *wsr88d_ray, Ray_header *h)
 {
+    /* Fill in the members of the ray header that are common to all data
+     * moments of this radial.  The caller sets f, invf, range_bin1,
+     * gate_size and nbins for each moment.
+     */
     int month, day, year, hour, minute, sec;
     float fsec;
     Wsr88d_ray m1_ray;
@@ -325,26 +349,26 @@ void wsr88d_load_ray_hdr(Wsr88d_ray_m31 *wsr88d_ray, Ray *ray)
 
     wsr88d_get_date(&m1_ray, &month, &day, &year);
     wsr88d_get_time(&m1_ray, &hour, &minute, &sec, &fsec);
-    ray->h.year = year + 1900;
-    ray->h.month = month;
-    ray->h.day = day;
-    ray->h.hour = hour;
-    ray->h.minute = minute;
-    ray->h.sec = sec + fsec;
-    ray->h.azimuth = ray_hdr.azm;
-    ray->h.ray_num = ray_hdr.azm_num;
-    ray->h.elev = ray_hdr.elev;
-    ray->h.elev_num = ray_hdr.elev_num;
-    ray->h.unam_rng = wsr88d_ray->unamb_rng;
-    ray->h.nyq_vel = wsr88d_ray->nyq_vel;
+    h->year = year + 1900;
+    h->month = month;
+    h->day = day;
+    h->hour = hour;
+    h->minute = minute;
+    h->sec = sec + fsec;
+    h->azimuth = ray_hdr.azm;
+    h->ray_num = ray_hdr.azm_num;
+    h->elev = ray_hdr.elev;
+    h->elev_num = ray_hdr.elev_num;
+    h->unam_rng = wsr88d_ray->unamb_rng;
+    h->nyq_vel = wsr88d_ray->nyq_vel;
     int elev_index;
-    elev_index = ray_hdr.elev_num - 1;
-    ray->h.azim_rate = vcp_data.azim_rate[elev_index];
-    ray->h.fix_angle = vcp_data.fixed_angle[elev_index];
-    ray->h.vel_res = vcp_data.vel_res;
+    elev_index = vcp_cut(ray_hdr.elev_num - 1);
+    h->azim_rate = vcp_data.azim_rate[elev_index];
+    h->fix_angle = vcp_data.fixed_angle[elev_index];
+    h->vel_res = vcp_data.vel_res;
     if (ray_hdr.azm_res != 1)
-	ray->h.beam_width = 1.0;
-    else ray->h.beam_width = 0.5;
+	h->beam_width = 1.0;
+    else h->beam_width = 0.5;
 
     /* For convenience, use message type 1 routines to get some values.
      * First load VCP and elevation numbers into a msg 1 ray.
@@ -354,11 +378,11 @@ void wsr88d_load_ray_hdr(Wsr88d_ray_m31 *wsr88d_ray, Ray *ray)
     m1_ray.unam_rng = (short) (wsr88d_ray->unamb_rng * 10.);
     m1_ray.nyq_vel = (short) wsr88d_ray->nyq_vel;
     /* Get values from message type 1 routines. */
-    ray->h.frequency = wsr88d_get_frequency(&m1_ray);
-    ray->h.pulse_width = wsr88d_get_pulse_width(&m1_ray);
-    ray->h.pulse_count = wsr88d_get_pulse_count(&m1_ray);
-    ray->h.prf = (int) wsr88d_get_prf(&m1_ray);
-    ray->h.wavelength = 0.1071;
+    h->frequency = wsr88d_get_frequency(&m1_ray);
+    h->pulse_width = wsr88d_get_pulse_width(&m1_ray);
+    h->pulse_count = wsr88d_get_pulse_count(&m1_ray);
+    h->prf = (int) wsr88d_get_prf(&m1_ray);
+    h->wavelength = 0.1071;
 }
 
 
@@ -376,13 +400,191 @@ int wsr88d_get_vol_index(char* dataname)
     return -1;
 }
 
+/* Azimuth numbers above this are taken to be bad data.  It is not a
+ * size; sweeps grow to the rays they get.
+ */
 #define MAXRAYS_M31 800
-#define MAXSWEEPS 30
 
-void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
-	Radar *radar)
+/* A moment map takes a raw data code straight to the Range stored in the
+ * ray: map[code] = invf((code - offset) / scale), or invf of BADVAL or
+ * RFVAL for codes 0 and 1.  There are 256 codes for 8-bit moments and
+ * 65536 for 16-bit ones.  Scale and offset seldom change within a
+ * volume, so a map is built on the first radial of a moment and used for
+ * all the others.  Maps are kept until the end of the volume.
+ */
+typedef struct {
+    Range (*invf)(float x);
+    float scale, offset;
+    int nbits;
+    Range *map;
+} Moment_map;
+
+#define MAX_MOMENT_MAPS 8
+
+typedef struct {
+    Moment_map map[MAX_MOMENT_MAPS];
+    int next;              /* Map to replace when all are used. */
+} Moment_maps;
+
+/* The maps of this thread's volume.  A stream, which may be fed from
+ * any thread, binds its own maps while it decodes.
+ */
+static RSL_THREAD_LOCAL Moment_maps thread_moment_maps;
+static RSL_THREAD_LOCAL Moment_maps *bound_moment_maps = NULL;
+
+static Moment_maps *bind_moment_maps(Moment_maps *maps)
+{
+    /* Bind maps to this thread; NULL reverts to its own.  Returns the
+     * previous binding.
+     */
+    Moment_maps *prev;
+
+    prev = bound_moment_maps;
+    bound_moment_maps = maps;
+    return prev;
+}
+
+static Range *wsr88d_moment_map(Range (*invf)(float x), float scale,
+	float offset, int nbits)
+{
+    Moment_maps *maps;
+    Moment_map *m;
+    int i, ncodes;
+    float value;
+
+    maps = bound_moment_maps ? bound_moment_maps : &thread_moment_maps;
+    for (i = 0; i < MAX_MOMENT_MAPS; i++) {
+	m = &maps->map[i];
+	if (m->map && m->invf == invf && m->scale == scale &&
+		m->offset == offset && m->nbits == nbits)
+	    return m->map;
+    }
+
+    /* Not found.  Build it, in place of the oldest map if all are used. */
+    m = &maps->map[maps->next];
+    maps->next = (maps->next + 1) % MAX_MOMENT_MAPS;
+    free(m->map);
+    ncodes = (nbits == 16) ? 65536 : 256;
+    m->map = (Range *) malloc(ncodes * sizeof(Range));
+    if (m->map == NULL) {
+	perror("wsr88d_moment_map");
+	return NULL;
+    }
+    m->invf = invf;
+    m->scale = scale;
+    m->offset = offset;
+    m->nbits = nbits;
+    m->map[0] = invf(BADVAL);
+    m->map[1] = invf(RFVAL);
+    for (i = 2; i < ncodes; i++) {
+	value = (i - offset) / scale;
+	m->map[i] = invf(value);
+    }
+    return m->map;
+}
+
+static void free_moment_maps(Moment_maps *maps)
+{
+    int i;
+
+    for (i = 0; i < MAX_MOMENT_MAPS; i++) {
+	free(maps->map[i].map);
+	maps->map[i].map = NULL;
+    }
+    maps->next = 0;
+}
+
+static void wsr88d_free_moment_maps(void)
+{
+    free_moment_maps(bound_moment_maps ? bound_moment_maps
+	    : &thread_moment_maps);
+}
+
+#define MAX_M31_MOMENTS 6
+
+/* Volumes and sweeps are made by whichever decoding thread first needs
+ * them.
+ */
+static pthread_mutex_t m31_radar_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* A volume starts with a slot for each cut of the VCP, or M31_NSWEEPS
+ * before the VCP is known, and grows as sweeps come.
+ */
+#define M31_NSWEEPS 20
+
+static int wsr88d_store_ray(Radar *radar, int vol_index, int isweep, int iray,
+	Ray *ray)
+{
+    /* Put ray in slot iray of sweep isweep of the volume, making the
+     * volume and sweep or growing them as needed.  Returns 0, or -1 if
+     * there is no memory.
+     */
+    Volume *volume;
+    Sweep *sweep;
+    int nsweeps, nrays;
+
+    nsweeps = vcp_data.num_cuts > 0 ? vcp_data.num_cuts : M31_NSWEEPS;
+    pthread_mutex_lock(&m31_radar_lock);
+    if (radar->v[vol_index] == NULL) {
+	radar->v[vol_index] = RSL_new_volume(nsweeps);
+	if (radar->v[vol_index] == NULL) goto fail;
+	radar->v[vol_index]->h.f = ray->h.f;
+	radar->v[vol_index]->h.invf = ray->h.invf;
+	switch (vol_index) {
+	    case DZ_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Reflectivity");
+		break;
+	    case VR_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Velocity");
+		break;
+	    case SW_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Spectrum width");
+		break;
+	    case DR_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Differential "
+		    "Reflectivity");
+		break;
+	    case PH_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Differential "
+		    "Phase (PhiDP)");
+		break;
+	    case RH_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Correlation "
+		    "Coefficient (RhoHV)");
+		break;
+	    case DC_INDEX:
+		radar->v[vol_index]->h.type_str = strdup("Clutter "
+		    "Filter Power removed (CFP)");
+		break;
+	}
+    }
+    volume = radar->v[vol_index];
+    if (RSL_reserve_sweeps(volume, isweep+1) < 0) goto fail;
+    if (volume->h.nsweeps <= isweep) volume->h.nsweeps = isweep+1;
+    if (volume->sweep[isweep] == NULL) {
+	/* 0.5 degree radials make 720 to a sweep, others 360. */
+	nrays = (ray->h.beam_width == 0.5) ? 720 : 360;
+	volume->sweep[isweep] = RSL_new_sweep(nrays);
+	volume->sweep[isweep]->h.f = ray->h.f;
+	volume->sweep[isweep]->h.invf = ray->h.invf;
+    }
+    sweep = volume->sweep[isweep];
+    if (RSL_reserve_rays(sweep, iray+1) < 0) goto fail;
+    sweep->ray[iray] = ray;
+    pthread_mutex_unlock(&m31_radar_lock);
+    return 0;
+
+  fail:
+    pthread_mutex_unlock(&m31_radar_lock);
+    return -1;
+}
+
+static int wsr88d_load_ray_moments(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
+	Radar *radar, int vol_loaded[MAX_M31_MOMENTS])
 {
-    /* Load data into ray structure for each data field. */
+    /* Load data into ray structure for each data field.  The volume index
+     * of each field loaded is put in vol_loaded; returns how many.
+     */
 
     int data_index;
     int *field_offset;
@@ -391,17 +593,20 @@ void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
     const int nconstblocks = 3;
 
     Data_moment_hdr data_hdr;
-    int ngates, do_swap;
+    int ngates, first, do_swap;
     int i, hdr_size;
-    unsigned short item;
-    float value, scale, offset;
+    float scale, offset;
     unsigned char *data;
+    Range *map, *range;
     Range (*invf)(float x);
     float (*f)(Range x);
     Ray *ray;
+    Ray_header radial_hdr;
+    int have_radial_hdr;
     int vol_index, waveform;
+    int nloaded = 0;
 
-    extern int rsl_qfield[]; /* See RSL_select_fields in volume.c */
+    Rsl_reader *reader = rsl_reader(); /* See reader.c */
 
     enum waveforms {surveillance=1, doppler_w_amb_res, doppler_no_amb_res,
 	batch};
@@ -411,10 +616,13 @@ void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
     merging_split_cuts =  wsr88d_merge_split_cuts_is_set();
     // FIXME: on newer radar data nfields is too large, causing for loop below to access unallocated memory
     nfields = wsr88d_ray->ray_hdr.data_block_count - nconstblocks;
-    if(nfields > 6) nfields=6; /* this effectively skips reading of CFP data FIXME */
+    if(nfields > MAX_M31_MOMENTS) nfields=MAX_M31_MOMENTS; /* this effectively skips reading of CFP data FIXME */
     field_offset = (int *) &wsr88d_ray->ray_hdr.radial_const;
     do_swap = little_endian();
     iray = wsr88d_ray->ray_hdr.azm_num - 1;
+    if (iray < 0 || !rsl_want_sweep(isweep)) return 0;
+    if (!rsl_want_azimuth(wsr88d_ray->ray_hdr.azm)) return 0;
+    have_radial_hdr = 0;
     for (ifield=0; ifield < nfields; ifield++) {
 	field_offset++;
 	data_index = *field_offset;
@@ -429,11 +637,11 @@ void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
 	    fprintf(stderr,"wsr88d_load_ray_into_radar: Unknown dataname %s.  "
 		    "isweep = %d, iray = %d.\n", data_hdr.dataname, isweep,
 		    iray);
-	    return;
+	    return nloaded;
 	}
 
 	/* Is this field in the selected fields list? */
-	if (!rsl_qfield[vol_index]) continue;
+	if (!reader->qfield[vol_index]) continue;
 
 	switch (vol_index) {
 	    case DZ_INDEX: f = DZ_F; invf = DZ_INVF; break;
@@ -444,7 +652,7 @@ void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
 	    case RH_INDEX: f = RH_F; invf = RH_INVF; break;
 	}
 
-	waveform = vcp_data.waveform[isweep];
+	waveform = vcp_data.waveform[vcp_cut(isweep)];
 
 	/* If this field is reflectivity, check to see if it's from the velocity
          * sweep in a split cut.  If so, we normally skip it since we already
@@ -454,85 +662,76 @@ void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
          * waveform is Contiguous Doppler with Ambiguity Resolution (range
          * unfolding), and we're merging split cuts.
 	 */
-	if (vol_index == DZ_INDEX && (vcp_data.surveil_prf_num[isweep] == 0 &&
-		    vcp_data.waveform[isweep] == doppler_w_amb_res &&
+	if (vol_index == DZ_INDEX &&
+		(vcp_data.surveil_prf_num[vcp_cut(isweep)] == 0 &&
+		    waveform == doppler_w_amb_res &&
 		    merging_split_cuts))
 	    continue;
 
-	/* Load the data for this field. */
-	if (radar->v[vol_index] == NULL) {
-	    radar->v[vol_index] = RSL_new_volume(MAXSWEEPS);
-	    radar->v[vol_index]->h.f = f;
-	    radar->v[vol_index]->h.invf = invf;
-            switch (vol_index) {
-                case DZ_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Reflectivity");
-                    break;
-                case VR_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Velocity");
-                    break;
-                case SW_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Spectrum width");
-                    break;
-                case DR_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Differential "
-                        "Reflectivity");
-                    break;
-                case PH_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Differential "
-                        "Phase (PhiDP)");
-                    break;
-                case RH_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Correlation "
-                        "Coefficient (RhoHV)");
-                    break;
-                case DC_INDEX:
-                    radar->v[vol_index]->h.type_str = strdup("Clutter "
-                        "Filter Power removed (CFP)");
-                    break;
-            }
-	   
-	}
-	if (radar->v[vol_index]->sweep[isweep] == NULL) {
-	    radar->v[vol_index]->sweep[isweep] = RSL_new_sweep(MAXRAYS_M31);
-	    radar->v[vol_index]->sweep[isweep]->h.f = f;
-	    radar->v[vol_index]->sweep[isweep]->h.invf = invf;
+	/* The header is the same for every moment of the radial, so build it
+	 * once, on the first moment loaded, and copy it into each ray.
+	 */
+	if (!have_radial_hdr) {
+	    memset(&radial_hdr, 0, sizeof(radial_hdr));
+	    wsr88d_load_ray_hdr(wsr88d_ray, &radial_hdr);
+	    have_radial_hdr = 1;
 	}
-	ngates = data_hdr.ngates;
+	/* Only the gates inside the window, if one is set, are kept. */
+	ngates = rsl_window_bins(data_hdr.range_first_gate,
+		data_hdr.range_samp_interval, data_hdr.ngates, &first);
+	if (reader->window && ngates <= 0) continue;
 	ray = RSL_new_ray(ngates);
 
-	/* Convert data to float, then use range function to store in ray.
+	/* Convert data codes to Range through the map for this moment.
 	 * Note: data range is 2-255. 0 means signal is below threshold, and 1
-	 * means range folded.
+	 * means range folded.  16-bit codes are big-endian.
 	 */
 
 	offset = data_hdr.offset;
 	scale = data_hdr.scale;
 	if (data_hdr.scale == 0) scale = 1.0; 
+	map = wsr88d_moment_map(invf, scale, offset,
+		data_hdr.datasize_bits == 16 ? 16 : 8);
+	if (map == NULL) {
+	    RSL_free_ray(ray);
+	    return nloaded;
+	}
 	data = &wsr88d_ray->data[data_index];
-	for (i = 0; i < ngates; i++) {
-	    if (data_hdr.datasize_bits != 16) {
-		item = *data;
-		data++;
-	    } else {
-		item = *(unsigned short *)data;
-		if (do_swap) swap_2_bytes(&item);
-		data += 2;
-	    }
-	    if (item > 1)
-		value = (item - offset) / scale;
-	    else value = (item == 0) ? BADVAL : RFVAL;
-	    ray->range[i] = invf(value);
-	    ray->h.f = f;
-	    ray->h.invf = invf;
+	range = ray->range;
+	if (first > 0) memset(range, 0, first * sizeof(Range));
+	if (data_hdr.datasize_bits != 16) {
+	    for (i = first; i < ngates; i++)
+		range[i] = map[data[i]];
+	} else {
+	    for (i = first; i < ngates; i++)
+		range[i] = map[data[2*i] << 8 | data[2*i+1]];
 	}
-	wsr88d_load_ray_hdr(wsr88d_ray, ray);
+	ray->h = radial_hdr;
+	ray->h.f = f;
+	ray->h.invf = invf;
 	ray->h.range_bin1 = data_hdr.range_first_gate;
 	ray->h.gate_size = data_hdr.range_samp_interval;
 	ray->h.nbins = ngates;
-	radar->v[vol_index]->sweep[isweep]->ray[iray] = ray;
-	radar->v[vol_index]->sweep[isweep]->h.nrays = iray+1;
+	if (wsr88d_store_ray(radar, vol_index, isweep, iray, ray) < 0) {
+	    RSL_free_ray(ray);
+	    return nloaded;
+	}
+	vol_loaded[nloaded++] = vol_index;
     } /* for each data field */
+    return nloaded;
+}
+
+
+void wsr88d_load_ray_into_radar(Wsr88d_ray_m31 *wsr88d_ray, int isweep,
+	Radar *radar)
+{
+    int vol_loaded[MAX_M31_MOMENTS];
+    int i, n, iray;
+
+    n = wsr88d_load_ray_moments(wsr88d_ray, isweep, radar, vol_loaded);
+    iray = wsr88d_ray->ray_hdr.azm_num - 1;
+    for (i = 0; i < n; i++)
+	radar->v[vol_loaded[i]]->sweep[isweep]->h.nrays = iray+1;
 }
 
 
@@ -544,13 +743,14 @@ void wsr88d_load_sweep_header(Radar *radar, int isweep)
 
     for (ivolume=0; ivolume < MAX_RADAR_VOLUMES; ivolume++) {
 	if (radar->v[ivolume] != NULL &&
+		isweep < radar->v[ivolume]->h.nsweeps &&
 		radar->v[ivolume]->sweep[isweep] != NULL) {
 	    sweep = radar->v[ivolume]->sweep[isweep];
 	    nrays = sweep->h.nrays;
 	    if (nrays == 0) continue;
 	    last_ray = sweep->ray[nrays-1];
 	    sweep->h.sweep_num = last_ray->h.elev_num;
-	    sweep->h.elev = vcp_data.fixed_angle[isweep];
+	    sweep->h.elev = vcp_data.fixed_angle[vcp_cut(isweep)];
 	    sweep->h.beam_width = last_ray->h.beam_width;
 	    sweep->h.vert_half_bw = sweep->h.beam_width / 2.;
 	    sweep->h.horz_half_bw = sweep->h.beam_width / 2.;
@@ -559,7 +759,7 @@ void wsr88d_load_sweep_header(Radar *radar, int isweep)
 }
 
 
-Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf)
+static Radar *load_m31_into_radar(Wsr88d_file *wf)
 {
     Wsr88d_msg_hdr msghdr;
     Wsr88d_ray_m31 wsr88d_ray;
@@ -627,13 +827,6 @@ Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf)
 		prev_elev_num = wsr88d_ray.ray_hdr.elev_num - 1;
 	    }
 
-            /* Check if this sweep number exceeds how many we allocated */
-            if (isweep > MAXSWEEPS) {
-		fprintf(stderr,"Error: isweep = %d, exceeds MAXSWEEPS (%d)\n", isweep, MAXSWEEPS);
-		RSL_free_radar(radar);
-		return NULL;                
-            }
-
 	    /* Load ray into radar structure. */
 	    wsr88d_load_ray_into_radar(&wsr88d_ray, isweep, radar);
 	    prev_raynum = raynum;
@@ -665,8 +858,367 @@ Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf)
 	    }
 	}
 
-	/* If not at end of volume scan, read next message header. */
-	if (wsr88d_ray.ray_hdr.radial_status != END_VOS) {
+	/* If not at end of volume scan, or past the last sweep selected,
+	 * read next message header.
+	 */
+	if (wsr88d_ray.ray_hdr.radial_status != END_VOS &&
+		!rsl_sweeps_done(isweep)) {
+	    n = fread(&msghdr, sizeof(Wsr88d_msg_hdr), 1, wf->fptr);
+	    if (n < 1) {
+		fprintf(stderr,"Warning: load_wsr88d_m31_into_radar: ");
+		if (feof(wf->fptr) != 0)
+		    fprintf(stderr,"Unexpected end of file.\n");
+		else fprintf(stderr,"Failed reading msghdr.\n");
+		fprintf(stderr,"Current sweep index: %d\n"
+			"Last ray read: %d\n", isweep, prev_raynum);
+		wsr88d_load_sweep_header(radar, isweep);
+		end_of_vos = 1;
+	    }
+	}
+	else {
+	    end_of_vos = 1;
+	    wsr88d_load_sweep_header(radar, isweep);
+	}
+    }  /* while not end of vos */
+
+    return radar;
+}
+
+
+/* Parallel ingest, used when the reader has decode_threads > 1.
+ *
+ * Messages are read as by load_m31_into_radar, but a radial is only framed:
+ * it is kept whole, and the sweep it belongs to is worked out from its
+ * header.  Each batch of M31_BATCH radials is then decoded on the threads,
+ * each radial straight into its slot, ray[azm_num-1] of its sweep.  Last,
+ * the ray counts and sweep headers are set in the order the radials were
+ * read, so the radar is the same as when it is read one radial at a time.
+ * The worker threads are started once per volume and wait for each batch,
+ * so they keep their moment maps until the volume ends.
+ */
+
+#define M31_BATCH 512
+#define M31_MAX_THREADS 64
+
+typedef struct {
+    size_t offset;         /* Of the message in M31_job.buf. */
+    int size;
+    int isweep, iray;
+    int skip;              /* A later radial of the batch has the same slot. */
+    int sweep_hdr_before;  /* Sweep to finish before this radial, or -1. */
+    int sweep_hdr_after;   /* Sweep to finish after this radial, or -1. */
+    int nloaded;
+    int vol_loaded[MAX_M31_MOMENTS];
+} M31_radial;
+
+typedef struct {
+    Radar *radar;
+    Rsl_reader *reader;    /* The workers decode with these settings, */
+    VCP_data vcp;          /* and this VCP. */
+    unsigned char *buf;    /* Messages of the batch. */
+    size_t buf_len, buf_size;
+    M31_radial radial[M31_BATCH];
+    int nradials;
+    int *slot;             /* Radial in each [isweep][iray] slot, or -1. */
+    int nslot_sweeps;      /* Sweeps that slot has room for. */
+    int next;              /* Next radial to decode. */
+    int batch;             /* Count of batches started. */
+    int busy;              /* Workers still on this batch. */
+    int quit;              /* 1 = end of volume. */
+    pthread_t threads[M31_MAX_THREADS];
+    int nworkers;
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+} M31_job;
+
+static void m31_decode(M31_job *job, Wsr88d_ray_m31 *wsr88d_ray)
+{
+    M31_radial *r;
+    int i;
+
+    for (;;) {
+	pthread_mutex_lock(&job->lock);
+	i = job->next++;
+	pthread_mutex_unlock(&job->lock);
+	if (i >= job->nradials) break;
+	r = &job->radial[i];
+	if (r->skip) continue;
+	memcpy(wsr88d_ray->data, job->buf + r->offset, r->size);
+	wsr88d_m31_ray_from_data(wsr88d_ray);
+	r->nloaded = wsr88d_load_ray_moments(wsr88d_ray, r->isweep,
+		job->radar, r->vol_loaded);
+    }
+}
+
+static void *m31_worker(void *arg)
+{
+    /* Decode each batch as it is started, until the volume ends. */
+    M31_job *job = (M31_job *) arg;
+    Wsr88d_ray_m31 *wsr88d_ray;
+    int batch = 0;
+
+    rsl_reader_bind(job->reader);
+    wsr88d_ray = (Wsr88d_ray_m31 *) malloc(sizeof(Wsr88d_ray_m31));
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+	while (job->batch == batch && !job->quit)
+	    pthread_cond_wait(&job->work, &job->lock);
+	if (job->quit) break;
+	batch = job->batch;
+	vcp_data = job->vcp;
+	pthread_mutex_unlock(&job->lock);
+	if (wsr88d_ray != NULL) m31_decode(job, wsr88d_ray);
+	pthread_mutex_lock(&job->lock);
+	if (--job->busy == 0) pthread_cond_signal(&job->done);
+    }
+    pthread_mutex_unlock(&job->lock);
+    free(wsr88d_ray);
+    wsr88d_free_moment_maps();
+    return NULL;
+}
+
+static void m31_start_workers(M31_job *job, int nthreads)
+{
+    /* nthreads-1 workers; the reading thread decodes, too. */
+    if (nthreads > M31_MAX_THREADS) nthreads = M31_MAX_THREADS;
+    for (job->nworkers = 0; job->nworkers < nthreads-1; job->nworkers++)
+	if (pthread_create(&job->threads[job->nworkers], NULL, m31_worker,
+		    job) != 0) break;
+}
+
+static void m31_stop_workers(M31_job *job)
+{
+    int i;
+
+    pthread_mutex_lock(&job->lock);
+    job->quit = 1;
+    pthread_cond_broadcast(&job->work);
+    pthread_mutex_unlock(&job->lock);
+    for (i = 0; i < job->nworkers; i++)
+	pthread_join(job->threads[i], NULL);
+    job->nworkers = 0;
+}
+
+static void m31_flush(M31_job *job, Wsr88d_ray_m31 *wsr88d_ray)
+{
+    /* Decode the batch, then set ray counts and sweep headers in order. */
+    M31_radial *r;
+    Radar *radar;
+    int i, j;
+
+    if (job->nradials == 0) return;
+    pthread_mutex_lock(&job->lock);
+    job->vcp = vcp_data;
+    job->next = 0;
+    job->busy = job->nworkers;
+    job->batch++;
+    pthread_cond_broadcast(&job->work);
+    pthread_mutex_unlock(&job->lock);
+    m31_decode(job, wsr88d_ray);  /* This thread helps, too. */
+    pthread_mutex_lock(&job->lock);
+    while (job->busy > 0)
+	pthread_cond_wait(&job->done, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+
+    radar = job->radar;
+    for (i = 0; i < job->nradials; i++) {
+	r = &job->radial[i];
+	if (r->sweep_hdr_before >= 0)
+	    wsr88d_load_sweep_header(radar, r->sweep_hdr_before);
+	for (j = 0; j < r->nloaded; j++)
+	    radar->v[r->vol_loaded[j]]->sweep[r->isweep]->h.nrays = r->iray+1;
+	if (r->sweep_hdr_after >= 0)
+	    wsr88d_load_sweep_header(radar, r->sweep_hdr_after);
+	if (r->iray >= 0 && r->isweep < job->nslot_sweeps)
+	    job->slot[r->isweep * MAXRAYS_M31 + r->iray] = -1;
+    }
+    job->nradials = 0;
+    job->buf_len = 0;
+}
+
+static int *m31_slot(M31_job *job, int isweep, int iray)
+{
+    /* The [isweep][iray] entry of job->slot, growing it as needed. */
+    int *slot;
+    int i, n;
+
+    if (isweep >= job->nslot_sweeps) {
+	n = 2*job->nslot_sweeps;
+	if (n <= isweep) n = isweep + 1;
+	slot = (int *) realloc(job->slot, n * MAXRAYS_M31 * sizeof(int));
+	if (slot == NULL) {
+	    perror("wsr88d_load_m31_into_radar");
+	    return NULL;
+	}
+	for (i = job->nslot_sweeps * MAXRAYS_M31; i < n * MAXRAYS_M31; i++)
+	    slot[i] = -1;
+	job->slot = slot;
+	job->nslot_sweeps = n;
+    }
+    return &job->slot[isweep * MAXRAYS_M31 + iray];
+}
+
+static M31_radial *m31_frame(M31_job *job, Wsr88d_file *wf, int msg_size)
+{
+    /* Read the rest of a message 31 into the batch. */
+    M31_radial *r;
+    unsigned char *buf;
+    size_t size;
+
+    if (msg_size < (int) sizeof(Ray_header_m31) ||
+	    msg_size > MAX_RADIAL_LENGTH) {
+	fprintf(stderr,"read_wsr88d_ray_m31: Bad message size %d.\n", msg_size);
+	return NULL;
+    }
+    if (job->buf_len + msg_size > job->buf_size) {
+	size = 2*job->buf_size + msg_size;
+	buf = (unsigned char *) realloc(job->buf, size);
+	if (buf == NULL) {
+	    perror("read_wsr88d_ray_m31");
+	    return NULL;
+	}
+	job->buf = buf;
+	job->buf_size = size;
+    }
+    if (fread(job->buf + job->buf_len, msg_size, 1, wf->fptr) != 1) {
+	fprintf(stderr,"read_wsr88d_ray_m31: Read failed.\n");
+	return NULL;
+    }
+    r = &job->radial[job->nradials];
+    r->offset = job->buf_len;
+    r->size = msg_size;
+    r->skip = 0;
+    r->sweep_hdr_before = r->sweep_hdr_after = -1;
+    r->nloaded = 0;
+    job->buf_len += msg_size;
+    return r;
+}
+
+static Radar *load_m31_parallel(Wsr88d_file *wf, int nthreads)
+{
+    Wsr88d_msg_hdr msghdr;
+    Ray_header_m31 ray_hdr;
+    Wsr88d_ray_m31 *wsr88d_ray;
+    M31_job *job;
+    M31_radial *r;
+    short non31_seg_remainder[1202]; /* Remainder after message header */
+    int end_of_vos = 0, isweep = 0;
+    int msg_hdr_size, msg_size, n, *slot;
+    int prev_elev_num = 1, prev_raynum = 0, raynum = 0;
+    int radial_status = 0;
+    Radar *radar = NULL;
+    enum radial_status {START_OF_ELEV, INTERMED_RADIAL, END_OF_ELEV, BEGIN_VOS,
+        END_VOS};
+
+    job = (M31_job *) calloc(1, sizeof(M31_job));
+    wsr88d_ray = (Wsr88d_ray_m31 *) malloc(sizeof(Wsr88d_ray_m31));
+    if (job == NULL || wsr88d_ray == NULL) {
+	perror("wsr88d_load_m31_into_radar");
+	free(job);
+	free(wsr88d_ray);
+	return NULL;
+    }
+    job->reader = rsl_reader();
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->work, NULL);
+    pthread_cond_init(&job->done, NULL);
+    m31_start_workers(job, nthreads);
+
+    bzero(&msghdr, sizeof(msghdr));
+    n = fread(&msghdr, sizeof(Wsr88d_msg_hdr), 1, wf->fptr);
+    msg_hdr_size = sizeof(Wsr88d_msg_hdr) - sizeof(msghdr.rpg);
+
+    radar = RSL_new_radar(MAX_RADAR_VOLUMES);
+    job->radar = radar;
+
+    while (! end_of_vos) {
+	if (msghdr.msg_type == 31) {
+	    if (little_endian()) wsr88d_swap_m31_hdr(&msghdr);
+	    msg_size = (int) msghdr.msg_size * 2 - msg_hdr_size;
+
+	    r = m31_frame(job, wf, msg_size);
+	    if (r == NULL) {
+                RSL_free_radar(radar);
+                fprintf(stderr,"Error: could not read ray.\n");
+                radar = NULL;
+		break;
+            }
+	    memcpy(&ray_hdr, job->buf + r->offset, sizeof(Ray_header_m31));
+	    if (little_endian()) wsr88d_swap_m31_ray_hdr(&ray_hdr);
+	    radial_status = ray_hdr.radial_status;
+	    raynum = ray_hdr.azm_num;
+	    if (raynum > MAXRAYS_M31) {
+		fprintf(stderr,"Error: raynum = %d, exceeds MAXRAYS_M31"
+			" (%d)\n", raynum, MAXRAYS_M31);
+		fprintf(stderr,"isweep = %d\n", isweep);
+		RSL_free_radar(radar);
+		radar = NULL;
+		break;
+	    }
+
+	    if (radial_status == START_OF_ELEV &&
+		    ray_hdr.elev_num-1 > isweep) {
+		fprintf(stderr,"Warning: Radial status is Start-of-Elevation, "
+			"but End-of-Elevation was not\n"
+			"issued for elevation number %d.  Number of rays = %d"
+			"\n", prev_elev_num, prev_raynum);
+		r->sweep_hdr_before = isweep;
+		isweep++;
+		prev_elev_num = ray_hdr.elev_num - 1;
+	    }
+
+	    /* Only the last radial for a slot in the batch is decoded. */
+	    r->isweep = isweep;
+	    r->iray = raynum - 1;
+	    if (r->iray < 0 || !rsl_want_sweep(isweep) ||
+		    !rsl_want_azimuth(ray_hdr.azm)) r->skip = 1;
+	    else {
+		if ((slot = m31_slot(job, isweep, r->iray)) == NULL) {
+		    RSL_free_radar(radar);
+		    radar = NULL;
+		    break;
+		}
+		if (*slot >= 0) job->radial[*slot].skip = 1;
+		*slot = job->nradials;
+	    }
+	    job->nradials++;
+	    prev_raynum = raynum;
+
+	    if (radial_status == END_OF_ELEV) {
+		r->sweep_hdr_after = isweep;
+		isweep++;
+		prev_elev_num = ray_hdr.elev_num;
+	    }
+	    if (job->nradials == M31_BATCH)
+		m31_flush(job, wsr88d_ray);
+	}
+	else { /* msg_type not 31 */
+	    n = fread(&non31_seg_remainder, sizeof(non31_seg_remainder), 1,
+		    wf->fptr);
+	    if (n < 1) {
+		fprintf(stderr,"Warning: load_wsr88d_m31_into_radar: ");
+		if (feof(wf->fptr) != 0)
+		    fprintf(stderr, "Unexpected end of file.\n");
+		else
+		    fprintf(stderr,"Read failed.\n");
+		fprintf(stderr,"Current sweep index: %d\n"
+			"Last ray read: %d\n", isweep, prev_raynum);
+		m31_flush(job, wsr88d_ray);
+		wsr88d_load_sweep_header(radar, isweep);
+		break;
+	    }
+	    if (msghdr.msg_type == 5) {
+		/* Radials already framed are decoded with the old VCP. */
+		m31_flush(job, wsr88d_ray);
+		wsr88d_get_vcp_data(non31_seg_remainder);
+		radar->h.vcp = vcp_data.vcp;
+	    }
+	}
+
+	/* If not at end of volume scan, or past the last sweep selected,
+	 * read next message header.
+	 */
+	if (radial_status != END_VOS && !rsl_sweeps_done(isweep)) {
 	    n = fread(&msghdr, sizeof(Wsr88d_msg_hdr), 1, wf->fptr);
 	    if (n < 1) {
 		fprintf(stderr,"Warning: load_wsr88d_m31_into_radar: ");
@@ -675,15 +1227,353 @@ Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf)
 		else fprintf(stderr,"Failed reading msghdr.\n");
 		fprintf(stderr,"Current sweep index: %d\n"
 			"Last ray read: %d\n", isweep, prev_raynum);
+		m31_flush(job, wsr88d_ray);
 		wsr88d_load_sweep_header(radar, isweep);
 		end_of_vos = 1;
 	    }
 	}
 	else {
 	    end_of_vos = 1;
+	    m31_flush(job, wsr88d_ray);
 	    wsr88d_load_sweep_header(radar, isweep);
 	}
     }  /* while not end of vos */
 
+    m31_stop_workers(job);
+    pthread_cond_destroy(&job->done);
+    pthread_cond_destroy(&job->work);
+    pthread_mutex_destroy(&job->lock);
+    free(job->slot);
+    free(job->buf);
+    free(job);
+    free(wsr88d_ray);
+    return radar;
+}
+
+
+Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf)
+{
+    Radar *radar;
+    int nthreads;
+
+    nthreads = rsl_reader()->decode_threads;
+    if (nthreads > 1)
+	radar = load_m31_parallel(wf, nthreads);
+    else
+	radar = load_m31_into_radar(wf);
+    wsr88d_free_moment_maps();
+    return radar;
+}
+
+
+/* Header-only reading, for RSL_probe.  Messages are read as by
+ * load_m31_into_radar, but of each radial only the header and the names
+ * of its data moments are looked at; no moment is decoded.
+ */
+
+int wsr88d_probe_m31(Wsr88d_file *wf, Rsl_probe *p)
+{
+    Wsr88d_msg_hdr msghdr;
+    Wsr88d_ray_m31 wsr88d_ray;
+    Ray_header_m31 *ray_hdr;
+    short non31_seg_remainder[1202]; /* Remainder after message header */
+    Rsl_probe_sweep *s;
+    Wsr88d_ray m1_ray;
+    unsigned int *field_offset;
+    int msg_hdr_size, msg_size, isweep, ifield, nfields, vol_index;
+    int month, day, year, hour, minute, sec;
+    float fsec;
+    int start_raynum = 0, end_of_vos = 0;
+    enum radial_status {START_OF_ELEV, INTERMED_RADIAL, END_OF_ELEV, BEGIN_VOS,
+        END_VOS};
+
+    memset(&vcp_data, 0, sizeof(vcp_data)); /* Nothing from another file. */
+    msg_hdr_size = sizeof(Wsr88d_msg_hdr) - sizeof(msghdr.rpg);
+    isweep = 0;
+
+    while (!end_of_vos &&
+	    fread(&msghdr, sizeof(Wsr88d_msg_hdr), 1, wf->fptr) == 1) {
+	if (msghdr.msg_type != 31) {
+	    if (fread(&non31_seg_remainder, sizeof(non31_seg_remainder), 1,
+			wf->fptr) != 1)
+		break;
+	    if (msghdr.msg_type == 5) {
+		wsr88d_get_vcp_data(non31_seg_remainder);
+		p->vcp = vcp_data.vcp;
+	    }
+	    continue;
+	}
+
+	if (little_endian()) wsr88d_swap_m31_hdr(&msghdr);
+	msg_size = (int) msghdr.msg_size * 2 - msg_hdr_size;
+	if (msg_size < (int) sizeof(Ray_header_m31) ||
+		msg_size > MAX_RADIAL_LENGTH) {
+	    fprintf(stderr,"wsr88d_probe_m31: Bad radial size %d.\n", msg_size);
+	    return -1;
+	}
+	if (!read_wsr88d_ray_m31(wf, msg_size, &wsr88d_ray)) return -1;
+	ray_hdr = &wsr88d_ray.ray_hdr;
+	if (ray_hdr->azm_num > MAXRAYS_M31) {
+	    fprintf(stderr,"Error: raynum = %d, exceeds MAXRAYS_M31"
+		    " (%d)\n", ray_hdr->azm_num, MAXRAYS_M31);
+	    return -1;
+	}
+
+	/* Sweeps are counted as load_m31_into_radar counts them. */
+	if (ray_hdr->radial_status == START_OF_ELEV &&
+		ray_hdr->elev_num-1 > isweep)
+	    isweep++;
+	if ((s = rsl_probe_sweep(p, isweep)) == NULL) return -1;
+	if (ray_hdr->azm_num > s->nrays) s->nrays = ray_hdr->azm_num;
+	if (vcp_data.num_cuts > 0)
+	    s->fix_angle = vcp_data.fixed_angle[vcp_cut(isweep)];
+	else s->fix_angle = ray_hdr->elev;
+
+	nfields = ray_hdr->data_block_count - 3;
+	if (nfields > MAX_M31_MOMENTS) nfields = MAX_M31_MOMENTS;
+	field_offset = &ray_hdr->field1;
+	for (ifield = 0; ifield < nfields; ifield++) {
+	    if (field_offset[ifield] > msg_size - 4) break;
+	    vol_index = wsr88d_get_vol_index(
+		    (char *) &wsr88d_ray.data[field_offset[ifield]]);
+	    if (vol_index < 0) break;
+	    s->field[vol_index] = p->field[vol_index] = 1;
+	}
+
+	/* The volume starts with the first ray of the first sweep. */
+	if (isweep == 0 && ray_hdr->azm_num > 0 &&
+		(start_raynum == 0 || ray_hdr->azm_num < start_raynum)) {
+	    start_raynum = ray_hdr->azm_num;
+	    m1_ray.ray_date = ray_hdr->ray_date;
+	    m1_ray.ray_time = ray_hdr->ray_time;
+	    wsr88d_get_date(&m1_ray, &month, &day, &year);
+	    wsr88d_get_time(&m1_ray, &hour, &minute, &sec, &fsec);
+	    p->year = year + 1900;
+	    p->month = month;
+	    p->day = day;
+	    p->hour = hour;
+	    p->minute = minute;
+	    p->sec = sec + fsec;
+	}
+
+	if (ray_hdr->radial_status == END_OF_ELEV) isweep++;
+	if (ray_hdr->radial_status == END_VOS) end_of_vos = 1;
+    }
+    return 0;
+}
+
+
+/* Incremental ingest, for RSL_wsr88d_stream_feed (see wsr88d_stream.c).
+ *
+ * The decompressed volume is taken a piece at a time.  Each message is
+ * handled as soon as it is complete, as by load_m31_into_radar, and
+ * sweep_done is called once a sweep has its last radial and its header.
+ */
+
+struct _wsr88d_m31_stream {
+    Radar *radar;
+    Rsl_reader *reader;    /* Settings to decode with. */
+    VCP_data vcp;          /* vcp_data between calls. */
+    Wsr88d_ray_m31 wsr88d_ray;
+    unsigned char *buf;    /* Bytes of messages not yet complete, */
+    size_t pos, len, size; /* from buf[pos] to buf[len]. */
+    int isweep, prev_elev_num, prev_raynum;
+    int end_of_vos, error;
+    void (*sweep_done)(Radar *radar, int isweep, void *arg);
+    void *arg;
+    Moment_maps maps;      /* Kept from one write to the next. */
+};
+
+Wsr88d_m31_stream *wsr88d_m31_stream_new(Radar *radar,
+	void (*sweep_done)(Radar *radar, int isweep, void *arg), void *arg)
+{
+    Wsr88d_m31_stream *st;
+
+    st = (Wsr88d_m31_stream *) calloc(1, sizeof(Wsr88d_m31_stream));
+    if (st == NULL) {
+	perror("wsr88d_m31_stream_new");
+	return NULL;
+    }
+    st->radar = radar;
+    st->reader = rsl_reader();
+    st->prev_elev_num = 1;
+    st->sweep_done = sweep_done;
+    st->arg = arg;
+    return st;
+}
+
+static void m31_stream_end_sweep(Wsr88d_m31_stream *st)
+{
+    wsr88d_load_sweep_header(st->radar, st->isweep);
+    if (st->sweep_done && rsl_want_sweep(st->isweep))
+	st->sweep_done(st->radar, st->isweep, st->arg);
+    st->isweep++;
+    if (rsl_sweeps_done(st->isweep)) st->end_of_vos = 1;
+}
+
+static int m31_stream_message(Wsr88d_m31_stream *st, unsigned char *msg,
+	int msg_len, int msg_type)
+{
+    /* Handle one message.  Returns 0, or -1 on error. */
+    Wsr88d_ray_m31 *wsr88d_ray = &st->wsr88d_ray;
+    short non31_seg_remainder[1202]; /* Remainder after message header */
+    int msg_size, raynum;
+    enum radial_status {START_OF_ELEV, INTERMED_RADIAL, END_OF_ELEV, BEGIN_VOS,
+        END_VOS};
+
+    msg += sizeof(Wsr88d_msg_hdr);
+    msg_size = msg_len - sizeof(Wsr88d_msg_hdr);
+    if (msg_type != 31) {
+	if (msg_type == 5) {
+	    memcpy(non31_seg_remainder, msg, sizeof(non31_seg_remainder));
+	    wsr88d_get_vcp_data(non31_seg_remainder);
+	    st->radar->h.vcp = vcp_data.vcp;
+	}
+	return 0;
+    }
+
+    if (msg_size < (int) sizeof(Ray_header_m31) ||
+	    msg_size > MAX_RADIAL_LENGTH) {
+	fprintf(stderr,"read_wsr88d_ray_m31: Bad message size %d.\n", msg_size);
+	return -1;
+    }
+    memcpy(wsr88d_ray->data, msg, msg_size);
+    wsr88d_m31_ray_from_data(wsr88d_ray);
+    raynum = wsr88d_ray->ray_hdr.azm_num;
+    if (raynum > MAXRAYS_M31) {
+	fprintf(stderr,"Error: raynum = %d, exceeds MAXRAYS_M31"
+		" (%d)\n", raynum, MAXRAYS_M31);
+	fprintf(stderr,"isweep = %d\n", st->isweep);
+	return -1;
+    }
+
+    if (wsr88d_ray->ray_hdr.radial_status == START_OF_ELEV &&
+	    wsr88d_ray->ray_hdr.elev_num-1 > st->isweep) {
+	fprintf(stderr,"Warning: Radial status is Start-of-Elevation, "
+		"but End-of-Elevation was not\n"
+		"issued for elevation number %d.  Number of rays = %d"
+		"\n", st->prev_elev_num, st->prev_raynum);
+	m31_stream_end_sweep(st);
+	st->prev_elev_num = wsr88d_ray->ray_hdr.elev_num - 1;
+    }
+
+    wsr88d_load_ray_into_radar(wsr88d_ray, st->isweep, st->radar);
+    st->prev_raynum = raynum;
+
+    if (wsr88d_ray->ray_hdr.radial_status == END_OF_ELEV) {
+	m31_stream_end_sweep(st);
+	st->prev_elev_num = wsr88d_ray->ray_hdr.elev_num;
+    }
+    else if (wsr88d_ray->ray_hdr.radial_status == END_VOS) {
+	m31_stream_end_sweep(st);
+	st->end_of_vos = 1;
+    }
+    return 0;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                     wsr88d_m31_stream_write                        */
+/*                                                                    */
+/*  Take 'len' more bytes of the decompressed volume.  Returns 0 when */
+/*  more are wanted, 1 once the volume has ended, or -1 on error.     */
+/*                                                                    */
+/**********************************************************************/
+int wsr88d_m31_stream_write(Wsr88d_m31_stream *st, char *buf, size_t len)
+{
+    Wsr88d_msg_hdr msghdr;
+    Rsl_reader *prev;
+    Moment_maps *prev_maps;
+    unsigned char *p;
+    size_t size, msg_len;
+    int msg_hdr_size;
+
+    if (st->error) return -1;
+    if (st->end_of_vos) return 1;
+
+    /* Append, first moving what is left to the front. */
+    if (st->pos > 0) {
+	memmove(st->buf, st->buf + st->pos, st->len - st->pos);
+	st->len -= st->pos;
+	st->pos = 0;
+    }
+    if (st->len + len > st->size) {
+	size = 2*st->size + len;
+	p = (unsigned char *) realloc(st->buf, size);
+	if (p == NULL) {
+	    perror("wsr88d_m31_stream_write");
+	    st->error = 1;
+	    return -1;
+	}
+	st->buf = p;
+	st->size = size;
+    }
+    memcpy(st->buf + st->len, buf, len);
+    st->len += len;
+
+    prev = rsl_reader_bind(st->reader);
+    prev_maps = bind_moment_maps(&st->maps);
+    vcp_data = st->vcp;
+    msg_hdr_size = sizeof(Wsr88d_msg_hdr) - sizeof(msghdr.rpg);
+    while (!st->end_of_vos &&
+	    st->len - st->pos >= sizeof(Wsr88d_msg_hdr)) {
+	memcpy(&msghdr, st->buf + st->pos, sizeof(Wsr88d_msg_hdr));
+	if (msghdr.msg_type == 31) {
+	    if (little_endian()) wsr88d_swap_m31_hdr(&msghdr);
+	    if ((int) msghdr.msg_size * 2 < msg_hdr_size) {
+		fprintf(stderr,"read_wsr88d_ray_m31: Bad message size %d.\n",
+			(int) msghdr.msg_size * 2 - msg_hdr_size);
+		st->error = 1;
+		break;
+	    }
+	    msg_len = sizeof(Wsr88d_msg_hdr) +
+		(int) msghdr.msg_size * 2 - msg_hdr_size;
+	}
+	else msg_len = sizeof(Wsr88d_msg_hdr) + 1202*sizeof(short);
+	if (st->len - st->pos < msg_len) break;
+
+	if (m31_stream_message(st, st->buf + st->pos, msg_len,
+		    msghdr.msg_type) < 0) {
+	    st->error = 1;
+	    break;
+	}
+	st->pos += msg_len;
+    }
+    st->vcp = vcp_data;
+    bind_moment_maps(prev_maps);
+    rsl_reader_bind(prev);
+
+    if (st->error) return -1;
+    return st->end_of_vos;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      wsr88d_m31_stream_end                         */
+/*                                                                    */
+/*  Free st.  Returns its radar, or NULL after an error, when the     */
+/*  radar is freed too.                                               */
+/*                                                                    */
+/**********************************************************************/
+Radar *wsr88d_m31_stream_end(Wsr88d_m31_stream *st)
+{
+    Radar *radar;
+
+    radar = st->radar;
+    if (st->error) {
+	RSL_free_radar(radar);
+	radar = NULL;
+    }
+    else if (!st->end_of_vos) {
+	/* Cut short, as at end of file. */
+	fprintf(stderr,"Warning: wsr88d_m31_stream_end: Volume incomplete.\n"
+		"Current sweep index: %d\n"
+		"Last ray read: %d\n", st->isweep, st->prev_raynum);
+	vcp_data = st->vcp;
+	wsr88d_load_sweep_header(radar, st->isweep);
+    }
+    free_moment_maps(&st->maps);
+    free(st->buf);
+    free(st);
     return radar;
 }
@@ -2,16 +2,14 @@
 #include <strings.h>
 #include "rsl.h"
 
-static int merge_split_cuts = 1;
-
 void RSL_wsr88d_merge_split_cuts_on()
 {
-    merge_split_cuts = 1;
+    RSL_reader_wsr88d_merge_split_cuts(rsl_reader(), 1);
 }
 
 void RSL_wsr88d_merge_split_cuts_off()
 {
-    merge_split_cuts = 0;
+    RSL_reader_wsr88d_merge_split_cuts(rsl_reader(), 0);
 }
 
 void RSL_wsr88d_keep_short_refl()
@@ -21,7 +19,7 @@ void RSL_wsr88d_keep_short_refl()
 
 int wsr88d_merge_split_cuts_is_set()
 {
-    return merge_split_cuts;
+    return rsl_reader()->merge_split_cuts;
 }
 
 void wsr88d_remove_extra_refl(Radar *radar)
@@ -5,29 +5,28 @@ void wsr88d_remove_sails_sweep(Radar *radar)
     /* Remove SAILS sweeps.  For VCPs 12 and 212 only. */
 
     int i, j;
-    int sails_loc[4];
-    int isails, nsails;
+    int nsails;
+    float elev, prev_elev;
 
     if (radar->h.vcp != 12 && radar->h.vcp != 212) return;
 
+    nsails = 0;
     for (j=0; j < MAX_RADAR_VOLUMES; j++) {
-        if (radar->v[j]) {
-            /* Find and save SAILS indices. */
+        if (radar->v[j] && radar->v[j]->h.nsweeps > 0 &&
+                radar->v[j]->sweep[0]) {
+            /* If a sweep's elevation is less than the previous sweep's,
+               remove the sweep. */
             nsails = 0;
+            prev_elev = radar->v[j]->sweep[0]->h.elev;
             for (i=1; i < radar->v[j]->h.nsweeps; i++) {
-                /* If this sweep's elevation is less than previous sweep,
-                   remove this sweep. */
-                if (radar->v[j]->sweep[i]->h.elev < 
-                        radar->v[j]->sweep[i-1]->h.elev) {
-                    sails_loc[nsails++] = i;
-                }
-            }
-            /* Remove sweeps at SAILS indices. */
-            if (nsails > 0) {
-                for (isails=0; isails < nsails; isails++) {
-                    RSL_free_sweep(radar->v[j]->sweep[sails_loc[isails]]);
-                    radar->v[j]->sweep[sails_loc[isails]] = NULL;
+                if (radar->v[j]->sweep[i] == NULL) continue;
+                elev = radar->v[j]->sweep[i]->h.elev;
+                if (elev < prev_elev) {
+                    RSL_free_sweep(radar->v[j]->sweep[i]);
+                    radar->v[j]->sweep[i] = NULL;
+                    nsails++;
                 }
+                prev_elev = elev;
             }
         } /* if radar->v[j] not NULL */
     } /* for volumes */
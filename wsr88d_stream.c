@@ -0,0 +1,291 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Radar Software Library.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+ * Streaming WSR-88D ingest.
+ *
+ * An AR2V (Message 31) volume is fed in pieces of any size as they
+ * arrive, e.g. the chunks of a real-time feed.  Each bzip2 record is
+ * decompressed and decoded as soon as it is complete, and the caller is
+ * told about each sweep once its last radial is in.  At close the radar
+ * is finished as RSL_wsr88d_to_radar finishes it.
+ *
+ *   Rsl_wsr88d_stream *RSL_wsr88d_stream_open(char *call_or_first_tape_file,
+ *              void (*sweep_done)(Radar *radar, int isweep, void *arg),
+ *              void *arg);
+ *   int    RSL_wsr88d_stream_feed(Rsl_wsr88d_stream *s, char *buf, size_t len);
+ *   Radar *RSL_wsr88d_stream_close(Rsl_wsr88d_stream *s);
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "rsl.h"
+#include "wsr88d.h"
+
+#define AR2V_HEADER_SIZE 24
+#define AR2V_MAX_BLOCK (16*1024*1024) /* Far above any real record. */
+
+/* In wsr88d_to_radar.c */
+Wsr88d_site_info *wsr88d_find_site(char *call_or_first_tape_file);
+void wsr88d_load_site_header(Radar *radar, Wsr88d_site_info *sitep);
+Radar *wsr88d_finish_radar(Radar *radar);
+
+/* In wsr88d_m31.c */
+Wsr88d_m31_stream *wsr88d_m31_stream_new(Radar *radar,
+	void (*sweep_done)(Radar *radar, int isweep, void *arg), void *arg);
+int wsr88d_m31_stream_write(Wsr88d_m31_stream *st, char *buf, size_t len);
+Radar *wsr88d_m31_stream_end(Wsr88d_m31_stream *st);
+
+struct _rsl_wsr88d_stream {
+  Rsl_reader *reader;        /* Copy of the settings at open. */
+  char *call;                /* Copy of call_or_first_tape_file, or NULL. */
+  void (*sweep_done)(Radar *radar, int isweep, void *arg);
+  void *arg;
+  Wsr88d_m31_stream *m31;    /* NULL until the volume header is in. */
+  char *buf;                 /* Input not yet used, */
+  size_t len, size;          /* buf[0] to buf[len]. */
+  char *oblock;              /* Decompressed record. */
+  unsigned int osize;
+  int done;                  /* 1 = end of volume, -1 = error. */
+};
+
+static void stream_sweep_done(Radar *radar, int isweep, void *arg)
+{
+  Rsl_wsr88d_stream *s = (Rsl_wsr88d_stream *)arg;
+
+  radar_load_date_time(radar);
+  if (s->sweep_done) s->sweep_done(radar, isweep, s->arg);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      RSL_wsr88d_stream_open                        */
+/*                                                                    */
+/**********************************************************************/
+Rsl_wsr88d_stream *RSL_wsr88d_stream_open(char *call_or_first_tape_file,
+			void (*sweep_done)(Radar *radar, int isweep, void *arg),
+			void *arg)
+{
+  /* Start a volume.  The site is named as for RSL_wsr88d_to_radar; when
+   * call_or_first_tape_file is NULL or "", the ICAO of the volume header
+   * is used.  sweep_done, if not NULL, is called with sweep index isweep
+   * of the radar as each selected sweep is read, before split cuts are
+   * merged.  The reader settings in effect now are used throughout;
+   * the stream keeps its own copy of them.
+   */
+  Rsl_wsr88d_stream *s;
+
+  s = (Rsl_wsr88d_stream *)calloc(1, sizeof(Rsl_wsr88d_stream));
+  if (s == NULL) {
+	perror("RSL_wsr88d_stream_open");
+	return NULL;
+  }
+  s->reader = rsl_reader_copy(rsl_reader());
+  if (s->reader == NULL) {
+	free(s);
+	return NULL;
+  }
+  if (call_or_first_tape_file && strlen(call_or_first_tape_file) > 0) {
+	s->call = strdup(call_or_first_tape_file);
+	if (s->call == NULL) {
+	  perror("RSL_wsr88d_stream_open");
+	  RSL_free_reader(s->reader);
+	  free(s);
+	  return NULL;
+	}
+  }
+  s->sweep_done = sweep_done;
+  s->arg = arg;
+  return s;
+}
+
+Rsl_wsr88d_stream *RSL_wsr88d_stream_open_r(Rsl_reader *r,
+			char *call_or_first_tape_file,
+			void (*sweep_done)(Radar *radar, int isweep, void *arg),
+			void *arg)
+{
+  Rsl_reader *prev = rsl_reader_bind(r);
+  Rsl_wsr88d_stream *s = RSL_wsr88d_stream_open(call_or_first_tape_file,
+												sweep_done, arg);
+  rsl_reader_bind(prev);
+  return s;
+}
+
+static int stream_header(Rsl_wsr88d_stream *s)
+{
+  /* Start the radar from the volume header in buf.  0 or -1 on error. */
+  Wsr88d_site_info *sitep;
+  Radar *radar;
+  char site_id_str[5];
+  int vnum;
+
+  vnum = 0;
+  if (strncmp(s->buf, "AR2V", 4) == 0) sscanf(s->buf, "AR2V%4d", &vnum);
+  if (vnum <= 1) {
+	fprintf(stderr, "RSL_wsr88d_stream_feed: Not a Message 31 volume: "
+			"'%.8s'\n", s->buf);
+	return -1;
+  }
+
+  if (s->call) sitep = wsr88d_find_site(s->call);
+  else {
+	memcpy(site_id_str, s->buf + 20, 4);
+	site_id_str[4] = '\0';
+	sitep = wsr88d_get_site(site_id_str);
+	if (sitep == NULL)
+	  fprintf(stderr, "RSL_wsr88d_stream_feed: No site info for '%s'.\n",
+			  site_id_str);
+  }
+  if (sitep == NULL) return -1;
+
+  radar = RSL_new_radar(MAX_RADAR_VOLUMES);
+  if (radar == NULL) {
+	free(sitep);
+	return -1;
+  }
+  wsr88d_load_site_header(radar, sitep);
+  free(sitep);
+
+  s->m31 = wsr88d_m31_stream_new(radar, stream_sweep_done, s);
+  if (s->m31 == NULL) {
+	RSL_free_radar(radar);
+	return -1;
+  }
+  return 0;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      RSL_wsr88d_stream_feed                        */
+/*                                                                    */
+/*  Take the next 'len' bytes of the AR2V file.  Returns 0 when more  */
+/*  are wanted, 1 once the volume has ended, or -1 on error.          */
+/*                                                                    */
+/**********************************************************************/
+int RSL_wsr88d_stream_feed(Rsl_wsr88d_stream *s, char *buf, size_t len)
+{
+  Rsl_reader *prev;
+  unsigned char *c;
+  unsigned int olength;
+  uint32_t word;
+  size_t pos, size, length;
+  char *p;
+  int last, rc;
+
+  if (s == NULL) return -1;
+  if (s->done) return s->done;
+
+  if (s->len + len > s->size) {
+	size = 2*s->size + len;
+	if ((p = (char *)realloc(s->buf, size)) == NULL) {
+	  perror("RSL_wsr88d_stream_feed");
+	  return s->done = -1;
+	}
+	s->buf = p;
+	s->size = size;
+  }
+  memcpy(s->buf + s->len, buf, len);
+  s->len += len;
+
+  prev = rsl_reader_bind(s->reader);
+  pos = 0;
+  rc = 0;
+  if (s->m31 == NULL) {
+	if (s->len < AR2V_HEADER_SIZE) goto out;
+	if (stream_header(s) < 0) {
+	  rc = -1;
+	  goto out;
+	}
+	pos = AR2V_HEADER_SIZE;
+  }
+
+  /* Records: a 4 byte big endian length, negative (two's complement) for
+   * the last one, then that many bytes of bzip2 data.  The length is
+   * negated unsigned, so even 0x80000000 is well defined, and rejected.
+   */
+  while (rc == 0 && s->len - pos >= 4) {
+	c = (unsigned char *)s->buf + pos;
+	word = (uint32_t)c[0] << 24 | (uint32_t)c[1] << 16 |
+	       (uint32_t)c[2] << 8 | (uint32_t)c[3];
+	last = (word & 0x80000000) != 0;
+	length = last ? 0u - word : word;
+	if (length > AR2V_MAX_BLOCK) {
+	  fprintf(stderr, "RSL_wsr88d_stream_feed: Bad record length %lu.\n",
+			  (unsigned long)length);
+	  rc = -1;
+	  break;
+	}
+	if (s->len - pos - 4 < length) break;
+	pos += 4;
+	if (length > 10) {
+	  if (wsr88d_ar2v_decompress(s->buf + pos, length,
+								 &s->oblock, &s->osize, &olength) < 0)
+		rc = -1;
+	  else
+		rc = wsr88d_m31_stream_write(s->m31, s->oblock, olength);
+	}
+	pos += length;
+	if (rc == 0 && last) rc = 1;
+  }
+
+ out:
+  rsl_reader_bind(prev);
+  memmove(s->buf, s->buf + pos, s->len - pos);
+  s->len -= pos;
+  s->done = rc;
+  return rc;
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                      RSL_wsr88d_stream_close                       */
+/*                                                                    */
+/*  Free s.  Returns the radar, or NULL if no volume could be read.   */
+/*  A volume cut short is kept as far as it got, with a warning.      */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_wsr88d_stream_close(Rsl_wsr88d_stream *s)
+{
+  Rsl_reader *prev;
+  Radar *radar;
+
+  if (s == NULL) return NULL;
+  radar = NULL;
+  prev = rsl_reader_bind(s->reader);
+  if (s->m31) {
+	radar = wsr88d_m31_stream_end(s->m31);
+	if (radar && s->done < 0) {
+	  RSL_free_radar(radar);
+	  radar = NULL;
+	}
+	if (radar) radar = wsr88d_finish_radar(radar);
+  }
+  rsl_reader_bind(prev);
+  RSL_free_reader(s->reader);
+  free(s->call);
+  free(s->buf);
+  free(s->oblock);
+  free(s);
+  return radar;
+}
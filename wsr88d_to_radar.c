@@ -28,30 +28,25 @@
 #include "rsl.h"
 #include "wsr88d.h"
 
-extern int radar_verbose_flag;
 /*
  * These externals can be found in the wsr88d library; secret code.
  */
 void print_head(Wsr88d_file_header wsr88d_file_header);
 void clear_sweep(Wsr88d_sweep *wsr88d_sweep, int x, int n);
 void free_and_clear_sweep(Wsr88d_sweep *wsr88d_sweep, int x, int n);
-/*
- * Secretly in uf_to_radar.c
- */
-Volume *copy_sweeps_into_volume(Volume *new_volume, Volume *old_volume);
 
 /* Exists in file wsr88d_remove_sails_sweep.c */
 void wsr88d_remove_sails_sweep(Radar *radar);
 
 Radar *wsr88d_load_m31_into_radar(Wsr88d_file *wf);
+int wsr88d_probe_m31(Wsr88d_file *wf, Rsl_probe *p);
 
 /* Function to specify keeping the extra split-cut inserted into middle of
  * volume scan when SAILS is in effect for VCPs 12 and 212.
  */
-static int keep_sails = 0;
 void RSL_wsr88d_keep_sails()
 {
-    keep_sails = 1;
+    RSL_reader_wsr88d_keep_sails(rsl_reader(), 1);
 }
 
 /* Function to specify that all sweeps are to be stored as read.  Don't combine
@@ -88,7 +83,8 @@ int wsr88d_load_sweep_into_volume(Wsr88d_sweep ws,
   int iray;
   float v_data[1000];
   Range  c_data[1000];
-  int n;
+  int n, first;
+  float azim;
 
   int mon, day, year;
   int hh, mm, ss;
@@ -121,8 +117,19 @@ int wsr88d_load_sweep_into_volume(Wsr88d_sweep ws,
 
   for (i=0,iray=0; i<MAX_RAYS_IN_SWEEP; i++) {
     if (ws.ray[i] != NULL) {
+      /* Rays and gates outside the window, if one is set, are not loaded. */
+      azim = wsr88d_get_azimuth(ws.ray[i]);
+      if (azim < 0) azim += 360;
+      if (!rsl_want_azimuth(azim)) continue;
       wsr88d_ray_to_float(ws.ray[i], vmask, v_data, &n);
-      float_to_range(v_data, c_data, n, invf);
+      if (vmask & WSR88D_DZ)
+        n = rsl_window_bins(ws.ray[i]->refl_rng, ws.ray[i]->refl_size,
+                            n, &first);
+      else
+        n = rsl_window_bins(ws.ray[i]->dop_rng, ws.ray[i]->dop_size,
+                            n, &first);
+      memset(c_data, 0, first*sizeof(Range));
+      float_to_range(v_data+first, c_data+first, n-first, invf);
       if (n > 0) {
         wsr88d_get_date(ws.ray[i], &mon, &day, &year);
         wsr88d_get_time(ws.ray[i], &hh, &mm, &ss, &fsec);
@@ -147,9 +154,8 @@ int wsr88d_load_sweep_into_volume(Wsr88d_sweep ws,
         ray_ptr->h.minute   = mm;
         ray_ptr->h.sec      = ss + fsec;
         ray_ptr->h.unam_rng = wsr88d_get_range   (ws.ray[i]);
-        ray_ptr->h.azimuth  = wsr88d_get_azimuth (ws.ray[i]);
 /* -180 to +180 is converted to 0 to 360 */
-        if (ray_ptr->h.azimuth < 0) ray_ptr->h.azimuth += 360;
+        ray_ptr->h.azimuth  = azim;
         ray_ptr->h.ray_num  = ws.ray[i]->ray_num;
         ray_ptr->h.elev       = wsr88d_get_elevation_angle(ws.ray[i]);
         ray_ptr->h.elev_num   = ws.ray[i]->elev_num;
@@ -215,52 +221,17 @@ int wsr88d_load_sweep_into_volume(Wsr88d_sweep ws,
 
 /**********************************************************************/
 /*                                                                    */
-/*                     RSL_wsr88d_to_radar                            */
+/*                        wsr88d_find_site                            */
+/*                                                                    */
+/*  The site named by 'call_or_first_tape_file'; see below.  NULL,    */
+/*  with a message, if there is no valid site info.                   */
 /*                                                                    */
-/*  By: John Merritt                                                  */
-/*      Space Applications Corporation                                */
-/*      March 3, 1994                                                 */
 /**********************************************************************/
-
-Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
-/*
- * Gets all volumes from the nexrad file.  Input file is 'infile'.
- * Site information is extracted from 'call_or_first_tape_file'; this
- * is typically a disk file called 'nex.file.1'.
- *
- *  -or-
- *
- * Uses the string in 'call_or_first_tape_file' as the 4 character call sign
- * for the sight.  All UPPERCASE characters.  Normally, this call sign
- * is extracted from the file 'nex.file.1'.
- *
- * Returns a pointer to a Radar structure; that contains the different
- * Volumes of data.
- */
+Wsr88d_site_info *wsr88d_find_site(char *call_or_first_tape_file)
 {
-  Radar *radar;
-  Volume *new_volume;
-  Wsr88d_file *wf;
-  Wsr88d_sweep wsr88d_sweep;
-  Wsr88d_file_header wsr88d_file_header;
-  Wsr88d_tape_header wsr88d_tape_header;
-  int n;
-  int nsweep;
-  int i;
-  int iv;
-  int nvolumes;
-  int volume_mask[] = {WSR88D_DZ, WSR88D_VR, WSR88D_SW};
-  char *field_str[] = {"Reflectivity", "Velocity", "Spectrum width"};
   Wsr88d_site_info *sitep;
+  Wsr88d_tape_header wsr88d_tape_header;
   char site_id_str[5];
-  char *the_file;
-  int expected_msgtype = 0;
-  char version[8];
-  int vnum;
-
-  extern int rsl_qfield[]; /* See RSL_select_fields in volume.c */
-  extern int *rsl_qsweep; /* See RSL_read_these_sweeps in volume.c */
-  extern int rsl_qsweep_max;
 
   sitep = NULL;
 /* Determine the site quasi automatically.  Here is the procedure:
@@ -288,27 +259,93 @@ Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
       fprintf(stderr,"wsr88d_to_radar: No valid site ID info found.\n");
         return(NULL);
   }
-    if (radar_verbose_flag)
+    if (rsl_verbose())
       fprintf(stderr,"SITE: %c%c%c%c\n", sitep->name[0], sitep->name[1],
              sitep->name[2], sitep->name[3]);
+  return sitep;
+}
 
-  
-  memset(&wsr88d_sweep, 0, sizeof(Wsr88d_sweep)); /* Initialize to 0 a 
-                                                   * heavily used variable.
-                                                   */
+/**********************************************************************/
+/*                                                                    */
+/*                     wsr88d_load_site_header                        */
+/*                                                                    */
+/**********************************************************************/
+void wsr88d_load_site_header(Radar *radar, Wsr88d_site_info *sitep)
+{
+    radar->h.number = sitep->number;
+    memcpy(&radar->h.name, sitep->name, sizeof(sitep->name));
+    memcpy(&radar->h.radar_name, sitep->name, sizeof(sitep->name)); /* Redundant */
+    memcpy(&radar->h.city, sitep->city, sizeof(sitep->city));
+    memcpy(&radar->h.state, sitep->state, sizeof(sitep->state));
+    strcpy(radar->h.radar_type, "wsr88d");
+    radar->h.latd = sitep->latd;
+    radar->h.latm = sitep->latm;
+    radar->h.lats = sitep->lats;
+    if (radar->h.latd < 0) { /* Degree/min/sec  all the same sign */
+      radar->h.latm *= -1;
+      radar->h.lats *= -1;
+    }
+    radar->h.lond = sitep->lond;
+    radar->h.lonm = sitep->lonm;
+    radar->h.lons = sitep->lons;
+    if (radar->h.lond < 0) { /* Degree/min/sec  all the same sign */
+      radar->h.lonm *= -1;
+      radar->h.lons *= -1;
+    }
+    radar->h.height = sitep->height;
+    radar->h.spulse = sitep->spulse;
+    radar->h.lpulse = sitep->lpulse;
+}
 
-/* 1. Open the input wsr88d file. */
-  if (infile == NULL) the_file = "stdin";  /* wsr88d.c understands this to
-                                            * mean read from stdin.
-                                            */
-  else the_file = infile;
+/**********************************************************************/
+/*                                                                    */
+/*                      wsr88d_finish_radar                           */
+/*                                                                    */
+/*  Set the date and time, merge split cuts and drop SAILS sweeps as  */
+/*  the reader asks, and trim the sweep and ray arrays to fit.        */
+/*                                                                    */
+/**********************************************************************/
+Radar *wsr88d_finish_radar(Radar *radar)
+{
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
 
-  if ((wf = wsr88d_open(the_file)) == NULL) {
-    wsr88d_perror(the_file);
-    return NULL;
+  radar_load_date_time(radar);  /* Magic :-) */
+  if (wsr88d_merge_split_cuts_is_set()) {
+      radar = wsr88d_merge_split_cuts(radar);
+      if ((radar->h.vcp == 12 || radar->h.vcp == 212) && !reader->keep_sails) 
+          wsr88d_remove_sails_sweep(radar);
   }
+  return RSL_shrink_radar(radar);
+}
 
+/**********************************************************************/
+/*                                                                    */
+/*                        wsr88d_to_radar                             */
+/*                                                                    */
+/*  Read the volume in 'wf' for the site 'sitep'.  Both are freed.    */
+/*                                                                    */
+/**********************************************************************/
+static Radar *wsr88d_to_radar(Wsr88d_file *wf, Wsr88d_site_info *sitep)
+{
+  Radar *radar;
+  Wsr88d_sweep wsr88d_sweep;
+  Wsr88d_file_header wsr88d_file_header;
+  int n;
+  int nsweep;
+  int i;
+  int iv;
+  int nvolumes;
+  int volume_mask[] = {WSR88D_DZ, WSR88D_VR, WSR88D_SW};
+  char *field_str[] = {"Reflectivity", "Velocity", "Spectrum width"};
+  int expected_msgtype = 0;
+  char version[8];
+  int vnum;
+
+  Rsl_reader *reader = rsl_reader(); /* See reader.c */
 
+  memset(&wsr88d_sweep, 0, sizeof(Wsr88d_sweep)); /* Initialize to 0 a 
+                                                   * heavily used variable.
+                                                   */
 
 /* 2. Read wsr88d headers. */
   /* Return # bytes, 0 or neg. on fail. */
@@ -336,24 +373,33 @@ Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
       fprintf(stderr,"Archive II header contains unknown version "
           ": '%s'\n", version);
       wsr88d_close(wf);
+      free(sitep);
       return NULL;
   }
 
-  if (radar_verbose_flag)
+  if (rsl_verbose())
     print_head(wsr88d_file_header);
 
 
   if (expected_msgtype == 31) {
       /* Get radar for message type 31. */
       radar = wsr88d_load_m31_into_radar(wf);
-      if (radar == NULL) return NULL;
+      if (radar == NULL) {
+        wsr88d_close(wf);
+        free(sitep);
+        return NULL;
+      }
   }
   else {
       /* Get radar for message type 1. */
       nvolumes = 3;
       /* Allocate all Volume pointers. */
       radar = RSL_new_radar(MAX_RADAR_VOLUMES);
-      if (radar == NULL) return NULL;
+      if (radar == NULL) {
+        wsr88d_close(wf);
+        free(sitep);
+        return NULL;
+      }
 
     /* Clear the sweep pointers. */
       clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
@@ -364,55 +410,60 @@ Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
      */ 
 
       for (iv=0; iv<nvolumes; iv++)
-        if (rsl_qfield[iv]) radar->v[iv] = RSL_new_volume(20);
+        if (reader->qfield[iv]) radar->v[iv] = RSL_new_volume(20);
 
 
     /* LOOP until EOF */
       nsweep = 0;
-      for (;(n = wsr88d_read_sweep(wf, &wsr88d_sweep)) > 0; nsweep++) {
-        if (rsl_qsweep != NULL) {
-          if (nsweep > rsl_qsweep_max) break;
-          if (rsl_qsweep[nsweep] == 0) continue;
+      for (;!rsl_sweeps_done(nsweep) &&
+            (n = wsr88d_read_sweep(wf, &wsr88d_sweep)) > 0; nsweep++) {
+        if (nsweep == 0) {
+          /* Get Volume Coverage Pattern number for radar header. */
+          i=0;
+          while (i < MAX_RAYS_IN_SWEEP && wsr88d_sweep.ray[i] == NULL) i++;
+          if (i < MAX_RAYS_IN_SWEEP) radar->h.vcp = wsr88d_get_volume_coverage(
+            wsr88d_sweep.ray[i]);
+        }
+        if (!rsl_want_sweep(nsweep)) {
+          free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
+          continue;
         }
-        if (radar_verbose_flag)  
+        if (rsl_verbose())  
         fprintf(stderr,"Processing for SWEEP # %d\n", nsweep);
 
           /*  wsr88d_print_sweep_info(&wsr88d_sweep); */
         
         for (iv=0; iv<nvolumes; iv++) {
-          if (rsl_qfield[iv]) {
-            /* Exceeded sweep limit.
-             * Allocate more sweeps.
-             * Copy all previous sweeps.
-             */
+          if (reader->qfield[iv]) {
+            /* Exceeded sweep limit.  Grow the sweep array. */
             if (nsweep >= radar->v[iv]->h.nsweeps) {
-              if (radar_verbose_flag)
+              if (rsl_verbose())
                 fprintf(stderr,"Exceeded sweep allocation of %d. "
-                    "Adding 20 more.\n", nsweep);
-              new_volume = RSL_new_volume(radar->v[iv]->h.nsweeps+20);
-              new_volume = copy_sweeps_into_volume(new_volume, radar->v[iv]);
-              radar->v[iv] = new_volume;
+                    "Adding more.\n", nsweep);
+              if (RSL_reserve_sweeps(radar->v[iv], nsweep+1) != 0) {
+                free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
+                wsr88d_close(wf);
+                free(sitep);
+                RSL_free_radar(radar);
+                return NULL;
+              }
+              radar->v[iv]->h.nsweeps = nsweep+1;
             }
             if (wsr88d_load_sweep_into_volume(wsr88d_sweep,
                radar->v[iv], nsweep, volume_mask[iv]) != 0) {
+              free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
+              wsr88d_close(wf);
+              free(sitep);
               RSL_free_radar(radar);
               return NULL;
             }
           }
         }
-        if (nsweep == 0) {
-          /* Get Volume Coverage Pattern number for radar header. */
-          i=0;
-          while (i < MAX_RAYS_IN_SWEEP && wsr88d_sweep.ray[i] == NULL) i++;
-          if (i < MAX_RAYS_IN_SWEEP) radar->h.vcp = wsr88d_get_volume_coverage(
-            wsr88d_sweep.ray[i]);
-        }
-
         free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
       }
 
       for (iv=0; iv<nvolumes; iv++) {
-        if (rsl_qfield[iv]) {
+        if (reader->qfield[iv]) {
           radar->v[iv]->h.type_str = strdup(field_str[iv]);
           radar->v[iv]->h.nsweeps = nsweep;
         }
@@ -424,38 +475,193 @@ Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
  * Here we will assign the Radar_header information.  Take most of it
  * from an existing volume's header.  
  */
-  radar_load_date_time(radar);  /* Magic :-) */
+  wsr88d_load_site_header(radar, sitep);
+  free(sitep);
 
-    radar->h.number = sitep->number;
-    memcpy(&radar->h.name, sitep->name, sizeof(sitep->name));
-    memcpy(&radar->h.radar_name, sitep->name, sizeof(sitep->name)); /* Redundant */
-    memcpy(&radar->h.city, sitep->city, sizeof(sitep->city));
-    memcpy(&radar->h.state, sitep->state, sizeof(sitep->state));
-    strcpy(radar->h.radar_type, "wsr88d");
-    radar->h.latd = sitep->latd;
-    radar->h.latm = sitep->latm;
-    radar->h.lats = sitep->lats;
-    if (radar->h.latd < 0) { /* Degree/min/sec  all the same sign */
-      radar->h.latm *= -1;
-      radar->h.lats *= -1;
-    }
-    radar->h.lond = sitep->lond;
-    radar->h.lonm = sitep->lonm;
-    radar->h.lons = sitep->lons;
-    if (radar->h.lond < 0) { /* Degree/min/sec  all the same sign */
-      radar->h.lonm *= -1;
-      radar->h.lons *= -1;
-    }
-    radar->h.height = sitep->height;
-    radar->h.spulse = sitep->spulse;
-    radar->h.lpulse = sitep->lpulse;
+  return wsr88d_finish_radar(radar);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_wsr88d_to_radar                            */
+/*                                                                    */
+/*  By: John Merritt                                                  */
+/*      Space Applications Corporation                                */
+/*      March 3, 1994                                                 */
+/**********************************************************************/
+
+Radar *RSL_wsr88d_to_radar(char *infile, char *call_or_first_tape_file)
+/*
+ * Gets all volumes from the nexrad file.  Input file is 'infile'.
+ * Site information is extracted from 'call_or_first_tape_file'; this
+ * is typically a disk file called 'nex.file.1'.
+ *
+ *  -or-
+ *
+ * Uses the string in 'call_or_first_tape_file' as the 4 character call sign
+ * for the sight.  All UPPERCASE characters.  Normally, this call sign
+ * is extracted from the file 'nex.file.1'.
+ *
+ * Returns a pointer to a Radar structure; that contains the different
+ * Volumes of data.
+ */
+{
+  Wsr88d_file *wf;
+  Wsr88d_site_info *sitep;
+  char *the_file;
 
+  sitep = wsr88d_find_site(call_or_first_tape_file);
+  if (sitep == NULL) return NULL;
+
+/* 1. Open the input wsr88d file. */
+  if (infile == NULL) the_file = "stdin";  /* wsr88d.c understands this to
+                                            * mean read from stdin.
+                                            */
+  else the_file = infile;
+
+  if ((wf = wsr88d_open(the_file)) == NULL) {
+    wsr88d_perror(the_file);
     free(sitep);
+    return NULL;
+  }
+  return wsr88d_to_radar(wf, sitep);
+}
 
-  if (wsr88d_merge_split_cuts_is_set()) {
-      radar = wsr88d_merge_split_cuts(radar);
-      if ((radar->h.vcp == 12 || radar->h.vcp == 212) && !keep_sails) 
-          wsr88d_remove_sails_sweep(radar);
+/**********************************************************************/
+/*                                                                    */
+/*                     RSL_wsr88d_to_radar_mem                        */
+/*                                                                    */
+/*  As RSL_wsr88d_to_radar, for the 'len' bytes at 'buf'.             */
+/*                                                                    */
+/**********************************************************************/
+Radar *RSL_wsr88d_to_radar_mem(char *buf, size_t len,
+                               char *call_or_first_tape_file)
+{
+  Wsr88d_file *wf;
+  Wsr88d_site_info *sitep;
+
+  sitep = wsr88d_find_site(call_or_first_tape_file);
+  if (sitep == NULL) return NULL;
+
+  if ((wf = wsr88d_open_mem(buf, len)) == NULL) {
+    wsr88d_perror("RSL_wsr88d_to_radar_mem");
+    free(sitep);
+    return NULL;
   }
-  return radar;
+  return wsr88d_to_radar(wf, sitep);
+}
+
+/**********************************************************************/
+/*                                                                    */
+/*                         wsr88d_probe                               */
+/*                                                                    */
+/*  Fill 'p' from the headers of the volume in 'wf', which is closed. */
+/*  The site is named as for RSL_wsr88d_to_radar; when                */
+/*  call_or_first_tape_file is NULL or "", the ICAO in the volume     */
+/*  header is used.  Returns 0, or -1 on error.  See RSL_probe.       */
+/*                                                                    */
+/**********************************************************************/
+int wsr88d_probe(Wsr88d_file *wf, char *call_or_first_tape_file,
+                 Rsl_probe *p)
+{
+  Wsr88d_file_header wsr88d_file_header;
+  Wsr88d_site_info *sitep;
+  Wsr88d_sweep wsr88d_sweep;
+  Wsr88d_ray *ray;
+  Rsl_probe_sweep *s;
+  char site_id_str[5];
+  char version[8];
+  int vnum, nsweep, i, n, rc;
+  int nrefl, ndop;
+  float elev;
+  int mon, day, year, hh, mm, ss;
+  float fsec;
+
+  vnum = -1;
+  n = wsr88d_read_file_header(wf, &wsr88d_file_header);
+  if (n > 0) {
+    strncpy(version, wsr88d_file_header.title.filename, 8);
+    if (strncmp(version,"AR2V",4) == 0) sscanf(version, "AR2V%4d", &vnum);
+    else if (strncmp(version,"ARCHIVE2",8) == 0) vnum = 0;
+  }
+  if (vnum < 0) {
+    fprintf(stderr,"wsr88d_probe: Not a WSR-88D Archive II file.\n");
+    wsr88d_close(wf);
+    return -1;
+  }
+
+  if (call_or_first_tape_file && strlen(call_or_first_tape_file) > 0) {
+    if ((sitep = wsr88d_find_site(call_or_first_tape_file)) == NULL) {
+      wsr88d_close(wf);
+      return -1;
+    }
+  } else {
+    memcpy(site_id_str, wsr88d_file_header.title.unused1, 4);
+    site_id_str[4] = '\0';
+    memcpy(p->name, site_id_str, 4);
+    sitep = wsr88d_get_site(site_id_str);
+  }
+  if (sitep) {
+    memcpy(p->name, sitep->name, sizeof(sitep->name));
+    p->lat = abs(sitep->latd) + sitep->latm/60.0 + sitep->lats/3600.0;
+    if (sitep->latd < 0) p->lat = -p->lat;
+    p->lon = abs(sitep->lond) + sitep->lonm/60.0 + sitep->lons/3600.0;
+    if (sitep->lond < 0) p->lon = -p->lon;
+    free(sitep);
+  }
+  strcpy(p->radar_type, "wsr88d");
+
+  if (vnum > 1) {
+    rc = wsr88d_probe_m31(wf, p);
+    wsr88d_close(wf);
+    return rc;
+  }
+
+  /* Message type 1.  The sweeps are read whole, as they are by
+   * RSL_wsr88d_to_radar, but not converted.
+   */
+  rc = 0;
+  memset(&wsr88d_sweep, 0, sizeof(Wsr88d_sweep));
+  for (nsweep = 0; wsr88d_read_sweep(wf, &wsr88d_sweep) > 0; nsweep++) {
+    if ((s = rsl_probe_sweep(p, nsweep)) == NULL) {
+      rc = -1;
+      break;
+    }
+    nrefl = ndop = n = 0;
+    elev = 0;
+    for (i=0; i<MAX_RAYS_IN_SWEEP; i++) {
+      if ((ray = wsr88d_sweep.ray[i]) == NULL) continue;
+      if (p->vcp == 0) p->vcp = wsr88d_get_volume_coverage(ray);
+      if (ray->num_refl > 0) {
+        /* The volume starts with the first reflectivity ray. */
+        if (nrefl++ == 0 && nsweep == 0) {
+          wsr88d_get_date(ray, &mon, &day, &year);
+          wsr88d_get_time(ray, &hh, &mm, &ss, &fsec);
+          p->year = year + 1900;
+          p->month = mon;
+          p->day = day;
+          p->hour = hh;
+          p->minute = mm;
+          p->sec = ss + fsec;
+        }
+      }
+      if (ray->num_dop > 0) ndop++;
+      if (ray->num_refl > 0 || ray->num_dop > 0) {
+        elev += wsr88d_get_elevation_angle(ray);
+        n++;
+      }
+    }
+    if (nrefl > 0) s->field[DZ_INDEX] = p->field[DZ_INDEX] = 1;
+    if (ndop > 0) {
+      s->field[VR_INDEX] = p->field[VR_INDEX] = 1;
+      s->field[SW_INDEX] = p->field[SW_INDEX] = 1;
+    }
+    s->nrays = nrefl > ndop ? nrefl : ndop;
+    /* The mean elevation, as RSL_wsr88d_to_radar has it. */
+    if (n > 0) s->fix_angle = elev / n;
+    free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
+  }
+  free_and_clear_sweep(&wsr88d_sweep, 0, MAX_RAYS_IN_SWEEP);
+  wsr88d_close(wf);
+  return rc;
 }